@@ -0,0 +1,61 @@
+// batch.h
+
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include <stdbool.h>
+#include "types.h"
+#include "memory_arena.h"
+
+/**
+ * @brief Builds the list of batch input files from the command line.
+ *
+ * Each argument is taken as a path, or on POSIX systems expanded with glob(3)
+ * if it contains wildcards (so a quoted pattern can name more files than the
+ * shell would accept). The lines of the --batch-list file, if given, are
+ * appended. Blank lines and lines starting with '#' are ignored.
+ *
+ * @param config The configuration; receives `batch_inputs`, `num_batch_inputs`
+ *               and the first input as `input_filename_arg`.
+ * @param num_args Number of non-option arguments.
+ * @param args The non-option arguments.
+ * @param arena The arena the list and its strings are allocated from.
+ * @return false if no input was given, a pattern matched nothing, or the list file could not be read.
+ */
+bool batch_collect_inputs(AppConfig* config, int num_args, const char** args, MemoryArena* arena);
+
+/**
+ * @brief Builds an output path from the --batch-output template.
+ *
+ * {name} is the input file name without directory and extension; {index} is
+ * the input's 1-based position, zero-padded to the width of `count` and to
+ * at least four digits, like segment numbers.
+ *
+ * @param template_str The --batch-output template.
+ * @param input_path The input file.
+ * @param index The input's 0-based position in the batch.
+ * @param count The number of inputs in the batch.
+ * @param out Receives the path.
+ * @param out_size Size of `out`.
+ * @return false if the path does not fit in `out`.
+ */
+bool batch_expand_output_template(const char* template_str, const char* input_path, int index, int count,
+                                  char* out, size_t out_size);
+
+/**
+ * @brief Processes every batch input file, running up to --batch-jobs pipelines at once.
+ *
+ * Each pipeline keeps its buffers and resampler from one file to the next.
+ * Inputs whose output file already exists are skipped, so an interrupted batch
+ * can be resumed by running the same command again. A file that cannot be
+ * opened or set up is reported and skipped; an error while processing stops
+ * the whole batch.
+ *
+ * @param config The validated configuration, shared by all files.
+ * @param resources The main resources; supplies the selected input module and
+ *                  the arena the per-pipeline state is allocated from.
+ * @return true if no file failed.
+ */
+bool batch_run(const AppConfig* config, AppResources* resources);
+
+#endif // BATCH_H_
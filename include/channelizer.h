@@ -0,0 +1,80 @@
+#ifndef CHANNELIZER_H_
+#define CHANNELIZER_H_
+
+#include "types.h" // For AppConfig, AppResources, SampleChunk and ChannelOutput
+#include <stdbool.h>
+
+/**
+ * @brief Creates one down-conversion chain per requested channel.
+ *
+ * Channels may have arbitrary centers and bandwidths, so each one gets its own
+ * NCO, resampler to the common output rate and band-limiting filter. All of
+ * them share the single read, conversion, DC block and I/Q correction pass.
+ *
+ * @param config The application configuration struct.
+ * @param resources The application resources struct that receives the channels.
+ * @param resample_ratio The output rate divided by the input rate.
+ * @return true on success (or if channelizer mode is off), false on failure.
+ */
+bool channelizer_create(AppConfig* config, AppResources* resources, float resample_ratio);
+
+/**
+ * @brief Opens every channel's output file and creates its I/O ring buffer.
+ *
+ * Channel files are named after the --file path with "_ch<N>" inserted before
+ * the extension. This replaces prepare_output_stream() in channelizer mode.
+ *
+ * @param config The application configuration struct.
+ * @param resources The application resources struct.
+ * @return true on success, false on failure.
+ */
+bool channelizer_open_outputs(AppConfig* config, AppResources* resources);
+
+/**
+ * @brief Extracts every channel from one pre-processed chunk and queues its output.
+ *
+ * The chunk's resampled, post-resample, scratch and final output buffers are
+ * reused for each channel in turn, which is possible because all channels
+ * share the output rate the buffers were sized for.
+ *
+ * @param config The application configuration struct.
+ * @param resources The application resources struct.
+ * @param item The chunk holding `frames_read` pre-processed input samples.
+ * @return true on success, false if the output conversion failed.
+ */
+bool channelizer_process_chunk(const AppConfig* config, AppResources* resources, SampleChunk* item);
+
+/**
+ * @brief Clears every channel's DSP state after a stream discontinuity.
+ * @param resources The application resources struct.
+ */
+void channelizer_reset(AppResources* resources);
+
+/**
+ * @brief Tells every channel's writer thread that no more data will arrive.
+ * @param resources The application resources struct.
+ */
+void channelizer_signal_end_of_stream(AppResources* resources);
+
+/**
+ * @brief Wakes every channel's writer thread for an immediate shutdown.
+ * @param resources The application resources struct.
+ */
+void channelizer_signal_shutdown(AppResources* resources);
+
+/**
+ * @brief Closes the channel outputs and destroys all channel DSP objects and buffers.
+ *
+ * The total size of all channel files is stored in `final_output_size_bytes`.
+ *
+ * @param resources The application resources struct.
+ */
+void channelizer_destroy(AppResources* resources);
+
+/**
+ * @brief Derives a channel's output path by inserting "_ch<N>" before the extension.
+ * @return false if the path does not fit in `buffer_size`.
+ */
+bool channelizer_make_channel_path(const char* base_path, unsigned int channel_number, char* buffer, size_t buffer_size);
+
+#endif // CHANNELIZER_H_
@@ -0,0 +1,50 @@
+// checkpoint.h
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <stdbool.h>
+#include "types.h"
+
+/**
+ * @brief Sets up checkpointing for the run and, with --resume, loads the checkpoint.
+ *
+ * Called once the output path is known and before the input is opened, since
+ * input_range_resolve() starts a resumed run where the kept output ends.
+ *
+ * @param config The configuration.
+ * @param resources The resources; `checkpoint` is filled in.
+ * @return false (with the reason logged) if --resume finds no usable checkpoint.
+ */
+bool checkpoint_init(const AppConfig* config, AppResources* resources);
+
+/**
+ * @brief Fixes the alignment grid and the configuration hash once every DSP stage exists.
+ *
+ * For a resumed run this checks the hash against the checkpoint, rounds the
+ * warm-up planned by input_range_plan_warmup() onto the grid and steps the
+ * NCOs to the phase the original run had where this run begins reading.
+ * Must run before the output is opened, which truncates it to the checkpoint.
+ *
+ * @param config The configuration.
+ * @param resources The resources, with the filters created and the warm-up planned.
+ * @return false (with the reason logged) if the checkpoint belongs to different options.
+ */
+bool checkpoint_prepare(const AppConfig* config, AppResources* resources);
+
+/**
+ * @brief Saves a checkpoint if one is due. Called by the main writer thread after each write.
+ */
+void checkpoint_on_output_written(AppResources* resources);
+
+/**
+ * @brief Saves a final checkpoint when the writer thread stops before the end of the input.
+ */
+void checkpoint_on_writer_exit(AppResources* resources);
+
+/**
+ * @brief Removes the checkpoint after the output has been completed and closed.
+ */
+void checkpoint_finish(AppResources* resources);
+
+#endif // CHECKPOINT_H_
@@ -0,0 +1,74 @@
+#ifndef CIC_DECIMATOR_H_
+#define CIC_DECIMATOR_H_
+
+#include "types.h" // For AppConfig, AppResources, complex_float_t
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Sets up the CIC decimator front end if the run benefits from it.
+ *
+ * The front end is used for large decimation ratios on integer input, when
+ * nothing before the resampler needs the full input rate (no pre-resample
+ * frequency shift, pre-resample filter, channelizer or additional outputs).
+ * It decimates the raw integer samples by an integer factor with a CIC filter,
+ * then flattens the CIC's passband droop with a short FIR. The resampler only
+ * covers the remaining fractional ratio, so `resample_ratio` is updated.
+ *
+ * Must be called after the frequency shifter is created and before the DC
+ * blocker and resampler, which run at the CIC output rate.
+ *
+ * @param config The application configuration struct.
+ * @param resources The application resources struct.
+ * @param resample_ratio In: the full output/input ratio. Out: the resampler's ratio.
+ * @return true on success (including when the front end is not used), false on failure.
+ */
+bool cic_decimator_create(AppConfig* config, AppResources* resources, float* resample_ratio);
+
+/**
+ * @brief Returns the factor the front end would decimate by if the stage plan allows it.
+ *
+ * Checks everything but the stage placement: the input format, the rates,
+ * passthrough, channels and additional outputs. The stage planner uses it to
+ * cost plans that keep the shift and filter after the resampler.
+ *
+ * @param config The application configuration struct.
+ * @param resources The application resources struct, with the input opened.
+ * @return The decimation factor, or 0 if the front end cannot be used.
+ */
+unsigned int cic_decimator_plan_factor(const AppConfig* config, const AppResources* resources);
+
+/**
+ * @brief Returns the sample rate the pre-processor produces, after any CIC decimation.
+ * @param resources The application resources struct.
+ * @return The pre-resample sample rate in Hz.
+ */
+double cic_decimator_output_rate(const AppResources* resources);
+
+/**
+ * @brief Decimates raw input samples and converts them to normalized, gain-adjusted complex floats.
+ *
+ * Takes the place of convert_raw_to_cf32() when the front end is in use. State
+ * carries across calls, so a chunk can be processed in any number of pieces.
+ *
+ * @param resources The application resources struct.
+ * @param input_buffer Raw input samples in the input format.
+ * @param num_frames Number of input frames (I/Q pairs).
+ * @param output_buffer Receives the decimated, droop-compensated samples.
+ * @return The number of output frames written.
+ */
+size_t cic_decimator_process(AppResources* resources, const void* input_buffer, size_t num_frames, complex_float_t* output_buffer);
+
+/**
+ * @brief Clears the CIC and compensation filter state after a stream discontinuity.
+ * @param resources The application resources struct.
+ */
+void cic_decimator_reset(AppResources* resources);
+
+/**
+ * @brief Frees the resources of the CIC decimator front end.
+ * @param resources The application resources struct.
+ */
+void cic_decimator_destroy(AppResources* resources);
+
+#endif // CIC_DECIMATOR_H_
@@ -17,6 +17,18 @@
  */
 bool parse_arguments(int argc, char *argv[], AppConfig *config, MemoryArena* arena);
 
+/**
+ * @brief Runs the option validation that follows argument parsing.
+ *
+ * Used by parse_arguments() and by the job server, which validates each job's
+ * configuration (a copy of the server's own, before validation) the same way.
+ *
+ * @param config The configuration to validate and resolve in place.
+ * @param arena Pointer to the memory arena (needed for the module list).
+ * @return true if the options are valid, false otherwise (the reason is logged).
+ */
+bool cli_validate_options(AppConfig *config, MemoryArena* arena);
+
 /**
  * @brief Prints detailed usage instructions for the application to stderr.
  *
@@ -12,6 +12,41 @@
  */
 bool validate_output_destination(AppConfig *config);
 
+/**
+ * @brief Validates the batch options and points the output at the --batch-output template.
+ * @param config The application configuration struct.
+ * @return true if valid (or batch mode is not requested), false otherwise.
+ */
+bool validate_batch_options(AppConfig *config);
+
+/**
+ * @brief Validates the options given with --serve and enables server mode.
+ * @param config The application configuration struct.
+ * @return true if valid, false otherwise.
+ */
+bool validate_server_options(AppConfig *config);
+
+/**
+ * @brief Parses --start and --duration, which select a time range of a file input.
+ * @param config The application configuration struct.
+ * @return true if valid (or no range is requested), false otherwise.
+ */
+bool validate_input_range_options(AppConfig *config);
+
+/**
+ * @brief Validates the output segmentation options (--segment-size, --segment-duration).
+ * @param config The application configuration struct.
+ * @return true if valid (or segmentation is not requested), false otherwise.
+ */
+bool validate_segment_options(AppConfig *config);
+
+/**
+ * @brief Checks that --checkpoint and --resume are used with one file input and one output file.
+ * @param config The application configuration struct.
+ * @return true if valid (or neither option is given), false otherwise.
+ */
+bool validate_checkpoint_options(AppConfig *config);
+
 /**
  * @brief Resolves presets and validates the final output format choices.
  * @param config The application configuration struct.
@@ -40,6 +75,27 @@ bool resolve_frequency_shift_options(AppConfig *config);
  */
 bool validate_iq_correction_options(AppConfig *config);
 
+/**
+ * @brief Parses the --channels list and checks it against the other options.
+ * @param config The application configuration struct.
+ * @return true if valid (or channelizer mode is not requested), false otherwise.
+ */
+bool validate_channel_options(AppConfig *config);
+
+/**
+ * @brief Resolves the container and sample format of each additional output (--file-2 ... --file-5).
+ * @param config The application configuration struct.
+ * @return true if valid, false otherwise.
+ */
+bool validate_extra_output_options(AppConfig *config);
+
+/**
+ * @brief Parses --stage-order and --shift-after-resample into per-stage placement requests.
+ * @param config The application configuration struct.
+ * @return true if valid, false otherwise.
+ */
+bool validate_stage_order_option(AppConfig *config);
+
 /**
  * @brief Performs high-level validation, checking for logical conflicts between different options.
  * @param config The application configuration struct.
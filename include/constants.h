@@ -20,10 +20,30 @@
 #define APP_NAME "iq_resample_tool"
 #define PRESETS_FILENAME "iq_resample_tool_presets.conf"
 
+// The FFTW planner wisdom file, stored in the same directory as the presets file.
+#define FFTW_WISDOM_FILENAME "iq_resample_tool_fftw_wisdom.dat"
+
+// Subdirectory of the per-user cache directory that holds designed filter taps.
+#define FILTER_CACHE_DIRNAME "filter_taps"
+
 // Defines the interval in seconds for printing progress updates to the console.
 // Set to 0 to disable progress updates entirely.
 #define PROGRESS_UPDATE_INTERVAL_SECONDS 1
 
+// Job server (--serve): jobs queued or running at once; further clients are told the server is busy.
+#define SERVER_MAX_PENDING_JOBS 64
+// A client has this long to send its job description before the connection is dropped.
+#define SERVER_REQUEST_TIMEOUT_SECONDS 10
+// Upper bound on the size of one job description.
+#define SERVER_MAX_REQUEST_BYTES (16 * 1024)
+// How often the accept loop checks for a shutdown request.
+#define SERVER_POLL_INTERVAL_MS 250
+
+// Checkpoints (--checkpoint): the file is written next to the output with this suffix appended.
+#define CHECKPOINT_FILE_SUFFIX ".ckpt"
+// Seconds of processing between two checkpoints.
+#define CHECKPOINT_INTERVAL_SECONDS 30
+
 
 // =============================================================================
 // == Tier 2: Core Memory & Pipeline Architecture
@@ -74,6 +94,109 @@
  */
 #define IO_FILE_WRITER_CHUNK_SIZE (1024 * 1024) // 1 MB
 
+/**
+ * @def IO_ZERO_COPY_SLICE_BYTES
+ * @brief The most bytes a zero-copy passthrough moves per system call.
+ *
+ * The copy itself never enters user space; the slice only bounds how long
+ * the reader goes between progress updates and shutdown checks.
+ */
+#define IO_ZERO_COPY_SLICE_BYTES (8 * 1024 * 1024) // 8 MB
+
+/**
+ * @def IO_MMAP_INPUT_MIN_BYTES
+ * @brief Input files with at least this much sample data are memory-mapped.
+ *
+ * Smaller files are read with ordinary buffered reads, since the mapping setup would
+ * cost more than the copies it saves.
+ */
+#define IO_MMAP_INPUT_MIN_BYTES (16LL * 1024 * 1024) // 16 MB
+
+/**
+ * @def IO_MMAP_RELEASE_STEP_BYTES
+ * @brief How much consumed input a memory-mapped reader releases at a time.
+ */
+#define IO_MMAP_RELEASE_STEP_BYTES (32 * 1024 * 1024) // 32 MB
+
+/**
+ * @def WAV_HEADER_SCAN_BYTES
+ * @brief How much of a WAV input file is read at a time while looking for its chunks.
+ *
+ * The header chunks of ordinary files (including SDR metadata) fit in the
+ * first read, whatever the size of the sample data.
+ */
+#define WAV_HEADER_SCAN_BYTES (64 * 1024) // 64 KB
+
+/**
+ * @def IO_READ_AHEAD_DEFAULT_MB
+ * @brief Default amount of file input kept prefetched ahead of the reader (--read-ahead).
+ */
+#define IO_READ_AHEAD_DEFAULT_MB 32
+
+/**
+ * @def IO_READ_AHEAD_MAX_MB
+ * @brief Largest read-ahead window accepted by --read-ahead.
+ */
+#define IO_READ_AHEAD_MAX_MB 4096
+
+/**
+ * @def IO_READ_AHEAD_STEP_BYTES
+ * @brief How much input the read-ahead thread loads per request.
+ *
+ * Small enough that stopping the thread never waits long on a slow device.
+ */
+#define IO_READ_AHEAD_STEP_BYTES (1024 * 1024) // 1 MB
+
+/**
+ * @def DIRECT_IO_ALIGNMENT
+ * @brief Buffer address, length and file offset alignment for O_DIRECT writes.
+ *
+ * 4096 covers the logical block size of current disks; 512-byte devices accept it too.
+ */
+#define DIRECT_IO_ALIGNMENT 4096
+
+/**
+ * @def DIRECT_IO_BUFFER_BYTES
+ * @brief Size of each write issued by the direct I/O output writer.
+ */
+#define DIRECT_IO_BUFFER_BYTES (4 * 1024 * 1024) // 4 MB
+
+/**
+ * @def DIRECT_IO_NUM_BUFFERS
+ * @brief Number of aligned buffers per direct I/O output.
+ *
+ * Must exceed DIRECT_IO_NUM_THREADS, so the writer thread can keep filling a
+ * buffer while every worker has a write in flight.
+ */
+#define DIRECT_IO_NUM_BUFFERS 8
+
+/**
+ * @def DIRECT_IO_NUM_THREADS
+ * @brief Number of writes a direct I/O output keeps in flight.
+ */
+#define DIRECT_IO_NUM_THREADS 4
+
+/**
+ * @def IO_PREALLOC_HEADER_RESERVE_BYTES
+ * @brief Space preallocated for an output file's container header, on top of its sample data.
+ */
+#define IO_PREALLOC_HEADER_RESERVE_BYTES 4096
+
+/**
+ * @def WAV_MAX_DATA_BYTES
+ * @brief Largest data chunk a plain (non-RF64) WAV file can describe, leaving room for the header.
+ */
+#define WAV_MAX_DATA_BYTES (0xFFFFFFFFLL - IO_PREALLOC_HEADER_RESERVE_BYTES)
+
+/**
+ * @def IO_OUTPUT_SINK_BUFFER_BYTES
+ * @brief The size of the ring buffer of each secondary output (channels and extra outputs).
+ *
+ * Every secondary output has its own buffer and writer thread, so each gets
+ * less headroom than the single main output buffer to bound total memory use.
+ */
+#define IO_OUTPUT_SINK_BUFFER_BYTES (128 * 1024 * 1024) // 128 MB
+
 /**
  * @def PIPELINE_NUM_CHUNKS
  * @brief The number of "work trays" (SampleChunks) in the processing pipeline.
@@ -119,6 +242,25 @@
 // A smaller value results in a sharper, higher-quality (but more CPU-intensive) filter.
 #define DEFAULT_FILTER_TRANSITION_FACTOR 0.25f
 
+// The largest integer decimation factor for which the user filter is merged into
+// a single polyphase decimator. Above this, the merged prototype grows so long that
+// the multi-stage msresamp resampler followed by a separate filter is cheaper.
+#define MERGED_DECIMATOR_MAX_FACTOR 16
+
+// --- CIC Decimator Front End ---
+// For very large decimation ratios, integer input is first decimated by a CIC filter
+// on the raw samples, so only a few integer adds per sample run at the input rate.
+#define CIC_STAGES 4
+// Smallest and largest CIC decimation factors. The largest keeps the worst-case
+// register growth (CIC_STAGES * log2(factor) bits on top of 33-bit input) within 64 bits.
+#define CIC_MIN_DECIMATION 4
+#define CIC_MAX_DECIMATION 64
+// The CIC output rate is kept at least this many times the final output rate, which
+// bounds both its passband droop and the aliasing it folds into the kept band.
+#define CIC_MIN_OVERSAMPLE 4
+// Length of the droop compensation FIR run at the CIC output rate. Must be odd.
+#define CIC_COMPENSATION_TAPS 15
+
 // The number of separate components in a complex sample (I and Q).
 // Used for sizing buffers that handle de-interleaved data.
 #define COMPLEX_SAMPLE_COMPONENTS 2
@@ -126,10 +268,56 @@
 // The cutoff frequency for the DC blocking high-pass filter.
 #define DC_BLOCK_CUTOFF_HZ 10.0f
 
+// Samples per step of the DC blocker's block-parallel recursion. Must be a power of two.
+#define DC_BLOCK_SCAN_BLOCK 16
+
+// Samples converted and conditioned (DC block, I/Q correction) per pass while still in cache.
+#define PRE_PROCESS_TILE_SAMPLES 4096
+
+// --- Input Range (--start) Warm-Up ---
+// Input read ahead of --start so the filters have settled when the range begins; the output
+// it produces is dropped. The length of the user or channel filter is added to this.
+#define INPUT_RANGE_WARMUP_MIN_FRAMES 4096
+// With the DC blocker, this many of its time constants are added as well.
+#define INPUT_RANGE_WARMUP_DC_BLOCK_TIME_CONSTANTS 3.0
+// Checkpoints fall on input frames that are a multiple of this (and of the decimation factors)
+// from where the run began, so the resampler's half-band stages restart in the same phase.
+#define CHECKPOINT_ALIGN_MIN_FRAMES 64
+// Rates without a common period this short (in seconds of input) get positions rounded to the nearest frame instead.
+#define CHECKPOINT_ALIGN_MAX_SECONDS 1.0
+
 // --- Filter Design & Analysis Tuning ---
 #define FILTER_MINIMUM_TAPS 21
 #define FILTER_GAIN_ZERO_THRESHOLD 1e-9f
-#define FILTER_FREQ_RESPONSE_POINTS 2048
+#define FILTER_FREQ_RESPONSE_POINTS 2048 // Minimum FFT size used to find a filter's peak gain
+#define FILTER_FFT_CONVOLVE_MIN_TAPS 64  // Chain stages shorter than this are convolved directly
+
+// Real multiply-accumulates per point per FFT stage, for filter cost estimates.
+#define FILTER_FFT_MACS_PER_POINT_LOG2 2.0
+
+// --- Stage Planner Cost Model ---
+// Estimated real multiply-accumulates per complex sample of the fixed-cost stages.
+#define PLANNER_DC_BLOCK_MACS_PER_SAMPLE  4.0
+#define PLANNER_NCO_MACS_PER_SAMPLE       6.0
+// The msresamp cascade, per sample at the higher of the input and output rates.
+#define PLANNER_RESAMPLER_MACS_PER_SAMPLE 24.0
+// CIC front end: I and Q adds per integrator stage (per input sample) and per comb
+// stage (per decimated sample), plus the real-tap droop compensator at the decimated rate.
+#define PLANNER_CIC_ADDS_PER_SAMPLE       (2.0 * CIC_STAGES)
+#define PLANNER_CIC_COMPENSATOR_MACS      (2.0 * CIC_COMPENSATION_TAPS)
+// Fraction of the lower of the two rates the resampler passes without attenuation.
+// A shift is only moved after the resampler if the band of interest fits in it.
+#define PLANNER_RESAMPLER_USABLE_BANDWIDTH 0.9
+
+// --- FFT Filter Worker Pool ---
+#define FILTER_POOL_MAX_WORKERS 8          // Upper bound on worker threads chosen automatically
+#define FILTER_POOL_MIN_SEGMENT_WARMUPS 4  // A segment must be this many times its warm-up length
+
+// --- FFTW Overlap-Save Engine Tuning (WITH_FFTW builds only) ---
+#define FFTW_FILTER_MIN_FFT_SIZE       64 // Smallest transform considered by the size search
+#define FFTW_FILTER_SEARCH_SPAN        8  // Search sizes from the minimum up to this multiple of it
+#define FFTW_FILTER_MAX_CANDIDATES     16 // Upper bound on the number of sizes planned and timed
+#define FFTW_FILTER_BENCHMARK_RUNS     4  // Timed executions per candidate plan
 
 // --- I/Q Correction Algorithm Tuning ---
 #define IQ_CORRECTION_FFT_SIZE           1024
@@ -138,6 +326,8 @@
 #define IQ_MAX_PASSES                    25      // Iterations per optimization run
 #define IQ_CORRECTION_PEAK_THRESHOLD_DB -60.0f   // Signal power threshold to trigger optimization
 #define IQ_CORRECTION_SMOOTHING_FACTOR   0.05f   // Smoothing factor for updating correction params
+#define IQ_CORRECTION_SNAPSHOT_POOL_SIZE 4       // Snapshot buffers in flight between pre-processor and optimizer
+#define IQ_CORRECTION_STATS_MIN_POWER    1e-6f   // Mean I/Q power (-60 dBFS) below which the stats estimator skips a snapshot
 
 
 // =============================================================================
@@ -190,10 +380,13 @@
 #define MAX_ACCEPTABLE_RATIO      1000.0f
 #define SHIFT_FACTOR_LIMIT        5.0
 #define MAX_FILTER_CHAIN          5
+#define MAX_CHANNELS              16
+#define MAX_EXTRA_OUTPUTS         4
 #define MAX_PRESETS               128
 #define MAX_LINE_LENGTH           1024
 #define MAX_SUMMARY_ITEMS         16
 #define MAX_ALLOWED_FFT_BLOCK_SIZE (1024 * 1024)
 #define MAX_PATH_BUFFER           4096
+#define BATCH_MAX_JOBS            16    // Concurrent pipelines in batch mode; each holds its own I/O ring buffer
 
 #endif // CONSTANTS_H_
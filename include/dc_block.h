@@ -7,12 +7,12 @@
 /**
  * @brief Initializes the DC block module.
  *
- * This function sets up the necessary liquid-dsp IIR filter object
- * for DC offset removal.
+ * This function computes the coefficients of the first-order DC blocker
+ * and resets the state of the selected DC removal mode.
  *
  * @param config Pointer to the application configuration.
  * @param resources Pointer to the application resources.
- * @return true on success, false on failure (e.g., filter creation).
+ * @return true on success, false on failure (e.g., an invalid cutoff).
  */
 bool dc_block_init(AppConfig* config, AppResources* resources);
 
@@ -20,8 +20,10 @@ bool dc_block_init(AppConfig* config, AppResources* resources);
  * @brief Applies the DC block filter to a block of samples.
  *
  * This function processes the input samples in-place to remove DC offsets.
+ * State carries across calls, so it can be applied to a chunk in any number of
+ * consecutive pieces, such as the tiles of the pre-processor's conversion pass.
  *
- * @param resources Pointer to the application resources (to get the filter object).
+ * @param resources Pointer to the application resources (to get the filter state).
  * @param samples Pointer to the complex float samples (modified in-place).
  * @param num_samples The number of complex samples in the block.
  */
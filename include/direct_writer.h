@@ -0,0 +1,68 @@
+#ifndef DIRECT_WRITER_H_
+#define DIRECT_WRITER_H_
+
+#include "types.h" // For MemoryArena
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief An output file written with O_DIRECT by a small pool of pwrite() threads.
+ *
+ * Data is gathered into page-aligned buffers. Each full buffer is handed to a
+ * worker, which writes it at its own offset, so several writes are in flight
+ * at once and nothing passes through the page cache. Only available on Linux.
+ */
+typedef struct DirectWriter DirectWriter;
+
+/**
+ * @brief Creates (or truncates) the file at `path` and starts the write threads.
+ *
+ * Returns NULL, with a debug message, if the filesystem does not accept
+ * O_DIRECT. The caller can then fall back to buffered writes.
+ *
+ * @param path Path of the output file.
+ * @param arena The memory arena for the writer's bookkeeping.
+ * @return The writer, or NULL.
+ */
+DirectWriter* direct_writer_open(const char* path, MemoryArena* arena);
+
+/**
+ * @brief Reserves disk space for the expected file size without changing the file size.
+ *        direct_writer_finish() releases whatever is not used.
+ * @param writer The writer.
+ * @param bytes Bytes to reserve.
+ */
+void direct_writer_preallocate(DirectWriter* writer, long long bytes);
+
+/**
+ * @brief Appends data to the file.
+ *
+ * Blocks only when every buffer is already waiting to be written.
+ *
+ * @return `bytes`, or 0 with errno set if an earlier write failed.
+ */
+size_t direct_writer_write(DirectWriter* writer, const void* data, size_t bytes);
+
+/**
+ * @brief Writes out the last partial buffer, waits for every write and trims the file to its real size.
+ *
+ * Afterwards the file is in normal (buffered) mode, so headers can be patched
+ * with direct_writer_pwrite().
+ *
+ * @return true if every write succeeded.
+ */
+bool direct_writer_finish(DirectWriter* writer);
+
+/**
+ * @brief Writes at a fixed offset, e.g. to patch a header. Only valid after direct_writer_finish().
+ * @return true on success.
+ */
+bool direct_writer_pwrite(DirectWriter* writer, long long offset, const void* data, size_t bytes);
+
+/**
+ * @brief Finishes the file if needed, stops the threads and closes it.
+ * @return true if every write succeeded.
+ */
+bool direct_writer_close(DirectWriter* writer);
+
+#endif // DIRECT_WRITER_H_
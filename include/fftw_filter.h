@@ -0,0 +1,81 @@
+#ifndef FFTW_FILTER_H_
+#define FFTW_FILTER_H_
+
+#include "types.h" // For complex_float_t
+#include <stdbool.h>
+
+/**
+ * @brief An opaque handle to an FFTW-backed overlap-save FIR filter.
+ *
+ * The filter consumes and produces a fixed number of samples per call (the
+ * block size), mirroring the contract of liquid-dsp's fftfilt objects so it
+ * can be driven by the same stream-oriented block logic.
+ */
+typedef struct FftwFilter FftwFilter;
+
+/**
+ * @brief Creates an overlap-save filter, selecting the fastest transform layout.
+ *
+ * If `fft_size` is zero, a set of power-of-two and mixed-radix (3, 5) transform
+ * sizes is planned with FFTW_MEASURE and timed, and the one with the lowest cost
+ * per output sample is kept. For real taps, a batched real-to-complex layout
+ * (filtering I and Q as two real streams) is measured against a plain complex
+ * transform. Planner wisdom is imported from and exported to `wisdom_dir` so the
+ * measurement cost is only paid on the first run.
+ *
+ * @param taps          The filter coefficients.
+ * @param taps_len      The number of coefficients.
+ * @param taps_are_real True if all coefficients have a zero imaginary part.
+ * @param fft_size      A fixed transform size to use, or 0 to search for the best one.
+ * @param wisdom_dir    Directory for the persistent wisdom file, or NULL to disable persistence.
+ * @return A new filter object, or NULL on failure.
+ */
+FftwFilter* fftw_filter_create(const complex_float_t* taps, unsigned int taps_len, bool taps_are_real,
+                               unsigned int fft_size, const char* wisdom_dir);
+
+/**
+ * @brief Creates an independent filter with the same transform layout and taps.
+ *
+ * The planner reuses the wisdom gathered for the original, so no sizes are
+ * re-measured. The copy starts with a cleared history.
+ *
+ * @param filter The filter to copy.
+ * @return A new filter object, or NULL on failure.
+ */
+FftwFilter* fftw_filter_clone(const FftwFilter* filter);
+
+/**
+ * @brief Gets the number of samples consumed and produced by each execute call.
+ * @param filter The filter object.
+ * @return The block size in samples.
+ */
+unsigned int fftw_filter_get_block_size(const FftwFilter* filter);
+
+/**
+ * @brief Gets the transform size selected for the filter.
+ * @param filter The filter object.
+ * @return The FFT size in samples.
+ */
+unsigned int fftw_filter_get_fft_size(const FftwFilter* filter);
+
+/**
+ * @brief Filters exactly one block of samples.
+ * @param filter The filter object.
+ * @param input Pointer to `block_size` input samples.
+ * @param output Pointer to storage for `block_size` output samples. May alias `input`.
+ */
+void fftw_filter_execute(FftwFilter* filter, const complex_float_t* input, complex_float_t* output);
+
+/**
+ * @brief Clears the filter's internal history.
+ * @param filter The filter object.
+ */
+void fftw_filter_reset(FftwFilter* filter);
+
+/**
+ * @brief Destroys the filter and frees its FFTW plans and buffers.
+ * @param filter The filter object.
+ */
+void fftw_filter_destroy(FftwFilter* filter);
+
+#endif // FFTW_FILTER_H_
@@ -31,6 +31,16 @@ FileWriteBuffer* file_write_buffer_create(size_t capacity);
  */
 void file_write_buffer_destroy(FileWriteBuffer* iob);
 
+/**
+ * @brief Empties the buffer and clears its end-of-stream and shutdown flags.
+ *
+ * Lets a buffer be used for another stream without reallocating it. No thread
+ * may be using the buffer while it is reset.
+ *
+ * @param iob The I/O buffer.
+ */
+void file_write_buffer_reset(FileWriteBuffer* iob);
+
 /**
  * @brief Writes data to the I/O buffer. (Producer-side Function)
  *
@@ -18,4 +18,10 @@
  */
 bool file_writer_init(FileWriterContext* ctx, const AppConfig* config);
 
+/**
+ * @brief Builds the path of output segment `number` by inserting "_<NNNN>" before the extension.
+ * @return false if the path does not fit in `buffer_size`.
+ */
+bool file_writer_make_segment_path(const char* base_path, unsigned int number, char* buffer, size_t buffer_size);
+
 #endif // FILE_WRITER_H_
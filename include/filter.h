@@ -17,6 +17,49 @@
  */
 bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* arena);
 
+/**
+ * @brief Checks whether the configured filter chain needs complex (asymmetric) taps.
+ * @param config The application configuration struct.
+ * @return true if any stage is an offset pass-band, false otherwise.
+ */
+bool filter_chain_is_complex(const AppConfig* config);
+
+/**
+ * @brief Estimates the cost of the configured filter chain without designing it.
+ *
+ * Uses the same tap-length rules and implementation choice as filter_create().
+ *
+ * @param config The application configuration struct.
+ * @param sample_rate The rate the filter would run at, in Hz.
+ * @param decimation_factor Non-zero to cost the filter merged into a polyphase
+ *                          decimator of this factor.
+ * @return Estimated real multiply-accumulates per sample consumed by the filter.
+ */
+double filter_estimate_macs_per_sample(const AppConfig* config, double sample_rate, unsigned int decimation_factor);
+
+/**
+ * @brief Checks whether a filter implementation processes fixed-size blocks.
+ * @param type The filter implementation type.
+ * @return true for the FFT-based engines, false otherwise.
+ */
+bool filter_is_block_based(FilterImplementationType type);
+
+/**
+ * @brief Filters exactly one block of samples with a block-based filter.
+ * @param filter_object The filter object created by filter_create().
+ * @param type The filter implementation type.
+ * @param input Pointer to one block of input samples.
+ * @param output Pointer to storage for one block of output samples. May alias `input`.
+ */
+void filter_execute_block(void* filter_object, FilterImplementationType type, complex_float_t* input, complex_float_t* output);
+
+/**
+ * @brief Clears the internal state of the user filter after a stream discontinuity.
+ * @param filter_object The filter object created by filter_create().
+ * @param type The filter implementation type.
+ */
+void filter_reset(void* filter_object, FilterImplementationType type);
+
 /**
  * @brief Destroys all FIR filter objects and frees associated memory.
  * @param resources The application resources struct.
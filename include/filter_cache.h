@@ -0,0 +1,63 @@
+#ifndef FILTER_CACHE_H_
+#define FILTER_CACHE_H_
+
+#include "types.h" // For FilterRequest, complex_float_t and MAX_FILTER_CHAIN
+#include <stdbool.h>
+
+/**
+ * @brief Every parameter that influences the designed filter taps.
+ *
+ * Two configurations with equal keys produce identical taps, so the key's
+ * hash names the cache file and the full key is stored in it to reject
+ * hash collisions.
+ */
+typedef struct {
+    double sample_rate_hz;
+    int num_requests;
+    FilterRequest requests[MAX_FILTER_CHAIN];
+    int filter_taps;
+    float attenuation_db;
+    float transition_width_hz;
+    unsigned int decimation_factor;
+} FilterCacheKey;
+
+/**
+ * @brief A read-only view of cached taps, valid until filter_cache_release().
+ */
+typedef struct {
+    const complex_float_t* taps;
+    unsigned int taps_len;
+    bool is_complex;
+    float normalization_gain;
+
+    // Private: the backing file mapping.
+    void* mapping;
+    size_t mapping_size;
+} FilterCacheEntry;
+
+/**
+ * @brief Looks up previously designed taps and memory-maps them on a hit.
+ * @param key The design parameters.
+ * @param entry Receives the cached taps on success.
+ * @return true on a cache hit, false on a miss or any error.
+ */
+bool filter_cache_lookup(const FilterCacheKey* key, FilterCacheEntry* entry);
+
+/**
+ * @brief Stores designed taps in the cache. Failures are logged and ignored.
+ * @param key The design parameters.
+ * @param taps The final, normalized filter taps.
+ * @param taps_len The number of taps.
+ * @param is_complex True if the taps have a non-zero imaginary part.
+ * @param normalization_gain The gain factor the taps were divided by.
+ */
+void filter_cache_store(const FilterCacheKey* key, const complex_float_t* taps, unsigned int taps_len,
+                        bool is_complex, float normalization_gain);
+
+/**
+ * @brief Releases the mapping behind a cache entry. Safe to call on an empty entry.
+ * @param entry The entry returned by filter_cache_lookup().
+ */
+void filter_cache_release(FilterCacheEntry* entry);
+
+#endif // FILTER_CACHE_H_
@@ -0,0 +1,54 @@
+#ifndef FILTER_POOL_H_
+#define FILTER_POOL_H_
+
+#include "types.h" // For complex_float_t and FilterImplementationType
+#include <stdbool.h>
+
+/**
+ * @brief An opaque pool of worker threads for block-based (FFT) user filters.
+ *
+ * Overlap-save blocks only depend on the `history_len` input samples that
+ * precede them. A pass over many blocks is therefore split into contiguous
+ * segments: the calling thread filters the first segment with the primary
+ * filter object, and each worker filters a later segment with its own replica
+ * after warming it up on the blocks just before its segment.
+ */
+typedef struct FilterPool FilterPool;
+
+/**
+ * @brief Starts a filter worker pool.
+ * @param replicas      Array of filter objects identical to the primary one, one per worker.
+ *                      The pool swaps entries with the primary object, so the caller keeps
+ *                      ownership of the array and must destroy whichever objects it holds.
+ * @param num_replicas  Number of replicas, and therefore worker threads.
+ * @param type          The filter implementation type (must be block-based).
+ * @param block_size    Samples consumed and produced per filter_execute_block() call.
+ * @param history_len   Input samples each output block depends on beyond its own (taps - 1).
+ * @return A new pool, or NULL on failure.
+ */
+FilterPool* filter_pool_create(void** replicas, unsigned int num_replicas, FilterImplementationType type,
+                               unsigned int block_size, unsigned int history_len);
+
+/**
+ * @brief Filters `num_blocks` contiguous blocks, fanning them out across the pool.
+ *
+ * The output is identical to calling filter_execute_block() on each block in turn
+ * with the primary object. Passes too short to split are run on the calling thread.
+ *
+ * @param pool          The pool.
+ * @param primary_slot  Pointer to the primary filter object. On return it points to the
+ *                      object whose state continues the stream, which may be a former replica.
+ * @param input         `num_blocks * block_size` input samples.
+ * @param num_blocks    Number of blocks to filter.
+ * @param output        Storage for `num_blocks * block_size` output samples. Must not alias `input`.
+ */
+void filter_pool_execute(FilterPool* pool, void** primary_slot, complex_float_t* input,
+                         unsigned int num_blocks, complex_float_t* output);
+
+/**
+ * @brief Stops the worker threads and frees the pool. The replicas are not destroyed.
+ * @param pool The pool.
+ */
+void filter_pool_destroy(FilterPool* pool);
+
+#endif // FILTER_POOL_H_
@@ -5,6 +5,18 @@
 #include "types.h"
 #include <stdbool.h>
 
+/**
+ * @brief Works out the required frequency shift and stores it in `resources->actual_nco_shift_hz`.
+ *
+ * The shift comes from --target-freq (using the input's center frequency
+ * metadata) or --shift. No NCO is created.
+ *
+ * @param config Pointer to the application configuration.
+ * @param resources Pointer to the application resources.
+ * @return true on success, false if --target-freq is used without center frequency metadata.
+ */
+bool freq_shift_resolve(const AppConfig *config, AppResources *resources);
+
 /**
  * @brief Creates and configures the NCOs (frequency shifters) based on user arguments.
  *
@@ -35,6 +47,15 @@ void freq_shift_apply(nco_crcf nco, double shift_hz, complex_float_t* input_buff
  */
 void freq_shift_reset_nco(nco_crcf nco);
 
+/**
+ * @brief Moves a freshly reset NCO to the phase it would have after mixing `num_frames` samples.
+ * @param nco The NCO object to advance (NULL is ignored).
+ * @param shift_hz The frequency shift the NCO was created for.
+ * @param rate The sample rate the NCO runs at.
+ * @param num_frames The number of samples to step over.
+ */
+void freq_shift_advance_nco(nco_crcf nco, double shift_hz, double rate, unsigned long long num_frames);
+
 /**
  * @brief Destroys the NCO objects if they were created.
  * @param resources Pointer to the application resources containing the NCOs.
@@ -0,0 +1,57 @@
+#ifndef INPUT_MMAP_H_
+#define INPUT_MMAP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief A read-only memory mapping of the sample data of an input file.
+ *
+ * The reader hands out consecutive slices of the mapping instead of copying
+ * the file into chunk buffers, and the pre-processor converts straight from
+ * the mapped pages. The kernel is told the access is sequential, and pages
+ * the pipeline can no longer be reading are released behind the cursor.
+ */
+typedef struct {
+    void* map_base;                 // Page-aligned start of the mapping
+    size_t map_length;
+    const unsigned char* data;      // First byte of sample data within the mapping
+    size_t data_length;
+    size_t cursor;                  // Offset of the next slice, relative to `data`
+    size_t released;                // Sample data before this offset has been released
+    size_t release_lag;             // How far behind the cursor pages may still be in use
+} MappedInput;
+
+/**
+ * @brief Maps the sample data of an input file.
+ *
+ * Returns false, without logging an error, whenever mapping is not possible
+ * or not worthwhile (unsupported platform, small file, mmap failure). The
+ * caller then reads the file the usual way.
+ *
+ * @param mapped The mapping to initialize.
+ * @param path Path of the input file.
+ * @param data_offset Byte offset of the first sample in the file.
+ * @param data_length Number of sample bytes.
+ * @param release_lag Bytes behind the cursor that must stay resident, because
+ *                    chunks handed out earlier may still be waiting to be converted.
+ * @return true if the data is mapped.
+ */
+bool input_mmap_open(MappedInput* mapped, const char* path, long long data_offset, long long data_length, size_t release_lag);
+
+/**
+ * @brief Returns the next slice of mapped sample data and advances the cursor.
+ * @param mapped The mapping.
+ * @param max_bytes Largest slice to return. Should be a whole number of frames.
+ * @param out_data Receives a pointer to the slice.
+ * @return The slice length in bytes, or 0 at the end of the data.
+ */
+size_t input_mmap_next(MappedInput* mapped, size_t max_bytes, const void** out_data);
+
+/**
+ * @brief Unmaps the input. Safe to call on a mapping that was never opened.
+ * @param mapped The mapping.
+ */
+void input_mmap_close(MappedInput* mapped);
+
+#endif // INPUT_MMAP_H_
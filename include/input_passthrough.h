@@ -0,0 +1,31 @@
+#ifndef INPUT_PASSTHROUGH_H_
+#define INPUT_PASSTHROUGH_H_
+
+#include "input_source.h" // For InputSourceContext
+#include <stdbool.h>
+
+/**
+ * @brief Copies a file input's sample bytes straight to the output for --raw-passthrough.
+ *
+ * On Linux, with a raw output container and matching input and output
+ * formats, the byte range is handed to the output writer's copy_from_fd op
+ * (copy_file_range() or sendfile()), so the samples never pass through the
+ * pipeline's buffers. On completion the end-of-stream marker is sent down the
+ * pipeline as usual.
+ *
+ * @param ctx The input source context.
+ * @param data_offset Byte offset of the first sample in the input file.
+ * @param data_length Number of sample bytes to copy.
+ * @param out_handled Set to true if the input was consumed here. If false, the
+ *                    caller must stream the input through its normal read loop.
+ * @return true on success or fallback, false on a fatal error (already reported).
+ */
+bool input_passthrough_zero_copy(InputSourceContext* ctx, long long data_offset, long long data_length, bool* out_handled);
+
+/**
+ * @brief Sends an empty chunk marked as the last one down the pipeline.
+ * @param resources The application resources struct.
+ */
+void input_passthrough_send_end_of_stream(AppResources* resources);
+
+#endif // INPUT_PASSTHROUGH_H_
@@ -0,0 +1,65 @@
+#ifndef INPUT_PREFETCH_H_
+#define INPUT_PREFETCH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+/**
+ * @brief A background read-ahead stage for file inputs.
+ *
+ * A dedicated thread keeps a window of the input file ahead of the reader
+ * loaded into the page cache, so a latency spike on the storage (network
+ * filesystems, spinning disks) is absorbed by the prefetch thread instead of
+ * stalling the reader and, through it, the whole pipeline. The reader reports
+ * its progress with input_prefetch_advance(); the thread never runs more than
+ * the window ahead of it.
+ */
+typedef struct {
+    pthread_t thread;
+    bool thread_started;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool sync_initialized;
+
+    int fd;                         // Private descriptor, so hints don't affect the reader's
+    long long data_end;             // File offset just past the sample data
+    long long window_bytes;
+    long long consumed;             // File offset the reader has reached
+    long long prefetched;           // File offset the prefetch thread has loaded up to
+    bool stop_requested;
+
+    unsigned char* scratch;         // Read target when the kernel read-ahead call is unavailable
+} InputPrefetcher;
+
+/**
+ * @brief Starts prefetching the sample data of an input file.
+ *
+ * Returns false, without logging an error, whenever prefetching is disabled
+ * or not possible (zero window, unsupported platform, the file can't be
+ * opened). The caller reads the file the same way either way.
+ *
+ * @param prefetcher The prefetcher to initialize.
+ * @param path Path of the input file.
+ * @param data_offset Byte offset of the first sample in the file.
+ * @param data_length Number of sample bytes.
+ * @param window_bytes How far ahead of the reader to keep the data loaded.
+ * @return true if the prefetch thread is running.
+ */
+bool input_prefetch_start(InputPrefetcher* prefetcher, const char* path, long long data_offset, long long data_length, long long window_bytes);
+
+/**
+ * @brief Reports that the reader has consumed more sample data.
+ * @param prefetcher The prefetcher. Ignored if it was never started.
+ * @param bytes Number of sample bytes read since the last call.
+ */
+void input_prefetch_advance(InputPrefetcher* prefetcher, long long bytes);
+
+/**
+ * @brief Stops the prefetch thread and releases its resources.
+ *        Safe to call more than once, and on a prefetcher that was never started.
+ * @param prefetcher The prefetcher.
+ */
+void input_prefetch_stop(InputPrefetcher* prefetcher);
+
+#endif // INPUT_PREFETCH_H_
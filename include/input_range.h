@@ -0,0 +1,60 @@
+// input_range.h
+
+#ifndef INPUT_RANGE_H_
+#define INPUT_RANGE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+/**
+ * @brief Parses a --start or --duration value.
+ *
+ * Accepted forms are seconds (`90`, `90.5`, `90s`), clock time
+ * (`1:30`, `1:02:03.5`), and a sample count (`4800000smp` or `4800000samples`).
+ *
+ * @param str The option value.
+ * @param out Receives the parsed value.
+ * @return false if the value is malformed or negative.
+ */
+bool input_range_parse_time(const char* str, InputTimeSpec* out);
+
+/**
+ * @brief Applies --start and --duration to a file input that has just been opened.
+ *
+ * Sets `input_range_start_frame` and narrows `source_info.frames` to the
+ * selected range, so the expected output size and progress refer to the
+ * range only. Without either option the whole file is selected. A resumed
+ * run (--resume) selects the rest of the range after its checkpoint.
+ *
+ * @param config The configuration.
+ * @param resources The resources; `source_info` must hold the rate and the file's length.
+ * @return false (with the reason logged) if the range starts past the end of the file.
+ */
+bool input_range_resolve(const AppConfig* config, AppResources* resources);
+
+/**
+ * @brief Decides how much input is read ahead of the range to let the filters settle.
+ *
+ * Called once every filter has been created. The margin is limited to the
+ * input before the range, and the output it produces is dropped again by
+ * each output (see input_range_warmup_output_frames()).
+ *
+ * @param config The configuration.
+ * @param resources The resources, with the filters and the channelizer already created.
+ */
+void input_range_plan_warmup(const AppConfig* config, AppResources* resources);
+
+/**
+ * @brief Returns the number of frames an output running at `output_rate` drops at its start.
+ */
+unsigned long long input_range_warmup_output_frames(const AppResources* resources, double output_rate);
+
+/**
+ * @brief Returns how many of `frames` just read lie inside the range, for the input frame count.
+ *
+ * Called by the reader thread only.
+ */
+int64_t input_range_count_frames(AppResources* resources, int64_t frames);
+
+#endif // INPUT_RANGE_H_
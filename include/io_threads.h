@@ -22,6 +22,14 @@ void* reader_thread_func(void* arg);
  */
 void* writer_thread_func(void* arg);
 
+/**
+ * @brief The main function of a secondary output's writer thread.
+ *        Writes one channel's or output branch's data from its ring buffer to its own file.
+ * @param arg A void pointer to the OutputSink struct.
+ * @return NULL.
+ */
+void* output_sink_writer_thread_func(void* arg);
+
 /**
  * @brief The dedicated SDR capture thread's main function (buffered mode only).
  *        This thread's only job is to run the SDR hardware's blocking read loop,
@@ -27,6 +27,19 @@ bool iq_correct_init(AppConfig* config, AppResources* resources, MemoryArena* ar
  */
 void iq_correct_apply(AppResources* resources, complex_float_t* samples, int num_samples);
 
+/**
+ * @brief Feeds uncorrected samples to the optimizer thread.
+ *
+ * Every IQ_CORRECTION_DEFAULT_PERIOD samples, a contiguous IQ_CORRECTION_FFT_SIZE
+ * snapshot is copied into a buffer from the small snapshot pool and queued for
+ * the optimizer. This never blocks: if no buffer is free, the snapshot is skipped.
+ *
+ * @param resources Pointer to the application resources.
+ * @param samples Pointer to the complex float samples, before correction is applied.
+ * @param num_samples The number of complex samples in the block.
+ */
+void iq_correct_feed_optimizer(AppResources* resources, const complex_float_t* samples, int num_samples);
+
 /**
  * @brief Runs the I/Q imbalance optimization algorithm on a block of samples.
  *
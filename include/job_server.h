@@ -0,0 +1,39 @@
+// job_server.h
+
+#ifndef JOB_SERVER_H_
+#define JOB_SERVER_H_
+
+#include <stdbool.h>
+#include "types.h"
+
+/**
+ * @brief Runs the job server until a shutdown is requested (POSIX only).
+ *
+ * Listens on the UNIX socket given with --serve. A client connects, sends a
+ * job as `key=value` lines ended by a blank line (or by closing its side of
+ * the connection), and reads the replies on the same connection:
+ *
+ *   input=/data/capture.wav         (required)
+ *   output=/data/capture_8M.wav     (required)
+ *   preset=NAME, output-rate=HZ, output-sample-format=FMT,
+ *   output-container=TYPE, gain-multiplier=X, start=TIME, duration=TIME,
+ *   overwrite=yes                   (optional)
+ *
+ * Replies are single lines: `OK <job id>` once the job has been set up, then
+ * `PROGRESS <frames> <expected frames or -1> <bytes>` while it runs, and
+ * finally one of `DONE <frames> <bytes> <seconds>`, `CANCELLED` or
+ * `ERROR <reason>`. Options not given by the job are those the server was
+ * started with.
+ *
+ * Up to --batch-jobs jobs run at once, each on a pipeline that keeps its
+ * buffers and resampler between jobs. An error in one job does not stop the
+ * others or the server.
+ *
+ * @param config The validated server configuration.
+ * @param resources The main resources; supplies the selected input module and
+ *                  the arena the server state is allocated from.
+ * @return false if the socket could not be set up.
+ */
+bool job_server_run(const AppConfig* config, AppResources* resources);
+
+#endif // JOB_SERVER_H_
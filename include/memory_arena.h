@@ -22,6 +22,13 @@ bool mem_arena_init(MemoryArena* arena, size_t capacity);
  */
 void* mem_arena_alloc(MemoryArena* arena, size_t size);
 
+/**
+ * @brief Discards every allocation made from the arena, keeping its memory block.
+ * Pointers previously returned by mem_arena_alloc() must no longer be used.
+ * @param arena Pointer to the initialized MemoryArena.
+ */
+void mem_arena_reset(MemoryArena* arena);
+
 /**
  * @brief Destroys a memory arena, freeing its main memory block.
  * @param arena Pointer to the MemoryArena to destroy.
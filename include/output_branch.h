@@ -0,0 +1,90 @@
+#ifndef OUTPUT_BRANCH_H_
+#define OUTPUT_BRANCH_H_
+
+#include "types.h" // For AppConfig, AppResources, SampleChunk and OutputBranch
+#include <stdbool.h>
+
+/**
+ * @brief Creates the resampler, buffers and input queue of each additional output.
+ *
+ * Every branch receives the pre-processor's chunks by reference, alongside the
+ * main resampler, and only resamples and converts them to its own rate and
+ * format. Must be called after allocate_processing_buffers(), which sizes the
+ * chunks the branches read from.
+ *
+ * @param config The application configuration struct.
+ * @param resources The application resources struct that receives the branches.
+ * @return true on success (or if there are no additional outputs), false on failure.
+ */
+bool output_branches_create(AppConfig* config, AppResources* resources);
+
+/**
+ * @brief Opens every additional output's file and creates its I/O ring buffer.
+ * @param resources The application resources struct.
+ * @return true on success, false on failure.
+ */
+bool output_branches_open(AppResources* resources);
+
+/**
+ * @brief Hands a pre-processed chunk to every branch and then to the main resampler.
+ *
+ * The chunk's reference count is set so that it only returns to the free queue
+ * once the main pipeline and every branch have released it. The end-of-stream
+ * marker only goes to the main resampler, because the post-processor may reuse
+ * it for flushed data; branches are ended with output_branches_end_of_input().
+ *
+ * @param resources The application resources struct.
+ * @param item The chunk to forward.
+ * @return true on success. On failure the caller still holds the main pipeline's
+ *         reference and must release it with output_branch_release_chunk().
+ */
+bool output_branch_fan_out(AppResources* resources, SampleChunk* item);
+
+/**
+ * @brief Tells every branch that the pre-processor will send no more chunks.
+ *
+ * Each branch thread drains the chunks already queued to it, then ends its
+ * output's stream.
+ *
+ * @param resources The application resources struct.
+ */
+void output_branches_end_of_input(AppResources* resources);
+
+/**
+ * @brief Drops one reference to a chunk, returning it to the free queue with the last one.
+ * @param resources The application resources struct.
+ * @param item The chunk to release.
+ */
+void output_branch_release_chunk(AppResources* resources, SampleChunk* item);
+
+/**
+ * @brief Resamples and converts one chunk for a branch and queues it for the branch's writer.
+ *
+ * The chunk's pre-resample data is only read, as the main pipeline and other
+ * branches may be reading it at the same time.
+ *
+ * @param branch The output branch.
+ * @param item The shared chunk.
+ * @return true on success, false if the output conversion failed.
+ */
+bool output_branch_process_chunk(OutputBranch* branch, const SampleChunk* item);
+
+/**
+ * @brief Clears a branch's resampler state after a stream discontinuity.
+ * @param branch The output branch.
+ */
+void output_branch_reset(OutputBranch* branch);
+
+/**
+ * @brief Wakes every branch thread and branch writer thread for an immediate shutdown.
+ * @param resources The application resources struct.
+ */
+void output_branches_signal_shutdown(AppResources* resources);
+
+/**
+ * @brief Closes the additional outputs and frees all branch resources.
+ * @param resources The application resources struct.
+ */
+void output_branches_destroy(AppResources* resources);
+
+#endif // OUTPUT_BRANCH_H_
@@ -0,0 +1,48 @@
+#ifndef OUTPUT_SINK_H_
+#define OUTPUT_SINK_H_
+
+#include "types.h" // For AppConfig, AppResources and OutputSink
+#include <stdbool.h>
+
+/**
+ * @brief Opens a secondary output file and creates its I/O ring buffer.
+ *
+ * The file at `sink->path` is opened with the container and sample format of
+ * `sink_config`, a copy of the application config describing this output.
+ * Its effective output path is pointed at the sink's path before opening.
+ *
+ * @param sink The sink, with `path`, `index` and `resources` already set.
+ * @param sink_config The config copy that describes this output. Modified.
+ * @param buffer_bytes Capacity of the sink's ring buffer.
+ * @return true on success, false on failure.
+ */
+bool output_sink_open(OutputSink* sink, AppConfig* sink_config, size_t buffer_bytes);
+
+/**
+ * @brief Queues processed output for the sink's writer thread.
+ * @param sink The sink.
+ * @param data The samples, already converted to the sink's output format.
+ * @param num_frames Number of complex frames in `data`.
+ */
+void output_sink_write(OutputSink* sink, const void* data, unsigned int num_frames);
+
+/**
+ * @brief Tells the sink's writer thread that no more data will arrive.
+ * @param sink The sink.
+ */
+void output_sink_signal_end_of_stream(OutputSink* sink);
+
+/**
+ * @brief Wakes the sink's writer thread for an immediate shutdown.
+ * @param sink The sink.
+ */
+void output_sink_signal_shutdown(OutputSink* sink);
+
+/**
+ * @brief Closes the sink's file and frees its ring buffer. Safe on a sink that never opened.
+ * @param sink The sink.
+ * @return The number of bytes written to the sink's file.
+ */
+long long output_sink_close(OutputSink* sink);
+
+#endif // OUTPUT_SINK_H_
@@ -37,4 +37,12 @@ void* post_processor_thread_func(void* arg);
  */
 void* iq_optimization_thread_func(void* arg);
 
+/**
+ * @brief The main function of an additional output's branch thread.
+ *        Resamples the shared pre-processed chunks to the output's rate and converts them to its format.
+ * @param arg A void pointer to the OutputBranch struct.
+ * @return NULL.
+ */
+void* output_branch_thread_func(void* arg);
+
 #endif // PROCESSING_THREADS_H_
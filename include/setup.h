@@ -8,10 +8,14 @@
 // --- Function Declarations for Setup Steps ---
 bool initialize_application(AppConfig *config, AppResources *resources);
 void cleanup_application(AppConfig *config, AppResources *resources);
+bool run_processing_pipeline(AppConfig *config, AppResources *resources);
+void pipeline_resources_reset(AppResources *resources);
+void pipeline_reuse_release(PipelineReuse *reuse);
+bool pipeline_find_existing_output(const AppConfig *config, char *found, size_t found_size);
+void pipeline_remove_outputs(const AppConfig *config);
 
 bool resolve_file_paths(AppConfig *config);
 bool calculate_and_validate_resample_ratio(AppConfig *config, AppResources *resources, float *out_ratio);
-bool validate_and_configure_filter_stage(AppConfig *config, AppResources *resources);
 bool allocate_processing_buffers(AppConfig *config, AppResources *resources, float resample_ratio);
 bool create_threading_components(AppResources *resources);
 void destroy_threading_components(AppResources *resources);
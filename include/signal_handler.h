@@ -44,12 +44,25 @@ void reset_shutdown_flag(void);
  */
 void request_shutdown(void);
 
+/**
+ * @brief Registers or unregisters an additional pipeline to be woken on shutdown.
+ *
+ * The resources passed to setup_signal_handlers() are always signalled. Batch
+ * mode runs several pipelines at once and registers each one here while its
+ * threads are running. Unregister before the pipeline's queues are destroyed.
+ *
+ * @param resources The pipeline's resources.
+ * @param track true to register, false to unregister.
+ */
+void signal_handler_track_resources(AppResources *resources, bool track);
+
 /**
  * @brief Handles a fatal error that occurs within a thread.
  *
  * This is the central, thread-safe function for reporting a fatal error.
  * It ensures the error is logged, a global error flag is set, and a
- * graceful shutdown is initiated via request_shutdown().
+ * graceful shutdown is initiated via request_shutdown(). If the resources have
+ * `isolate_errors` set, only that pipeline is stopped.
  *
  * @param context_msg A descriptive error message string.
  * @param resources A pointer to the main AppResources struct.
@@ -0,0 +1,58 @@
+#ifndef STAGE_PLANNER_H_
+#define STAGE_PLANNER_H_
+
+#include "types.h" // For AppConfig, AppResources, StagePlan, StagePlacement
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Parses a --stage-order list into per-stage placement requests.
+ *
+ * The list names stages in processing order, e.g. "dc,shift,resample,filter".
+ * It must contain "resample" once. Stages listed before it are pinned before
+ * the resampler, stages listed after it are pinned after, and unlisted stages
+ * are left to the planner. The DC block, shift and filter always run in that
+ * order relative to each other, so the list must respect it.
+ *
+ * @param order_str The comma-separated stage list.
+ * @param out_requests Receives one placement per PlanStage.
+ * @return true on success, false (with an error logged) if the list is invalid.
+ */
+bool stage_planner_parse_order(const char* order_str, StagePlacement out_requests[PLAN_STAGE_COUNT]);
+
+/**
+ * @brief Chooses where the resampler runs among the DC block, shift and filter.
+ *
+ * Every placement that gives the same result for the band of interest is
+ * costed from the actual rates and estimated tap counts, and the cheapest one
+ * is applied, including the CIC front end that plans with no shift or filter
+ * before the resampler allow. Placements pinned on the command line are
+ * honored. Sets `resources->stage_plan` and `resources->merged_decimation_factor`;
+ * the configuration is only read.
+ *
+ * Must be called after the resample ratio is known and before any DSP stage is created.
+ *
+ * @param config The application configuration struct.
+ * @param resources The application resources struct.
+ * @return true on success, false if the configuration cannot be planned.
+ */
+bool stage_planner_plan(const AppConfig* config, AppResources* resources);
+
+/**
+ * @brief Checks whether a stage runs after the resampler in a plan.
+ * @param plan The stage plan.
+ * @param stage The stage to check.
+ * @return true if the stage runs after the resampler.
+ */
+bool stage_plan_is_post_resample(const StagePlan* plan, PlanStage stage);
+
+/**
+ * @brief Formats the active stages of the plan in processing order, e.g. "DC Block -> Resample -> Shift".
+ * @param config The application configuration struct.
+ * @param resources The application resources struct.
+ * @param buffer Receives the description.
+ * @param buffer_size Size of `buffer`.
+ */
+void stage_planner_describe(const AppConfig* config, const AppResources* resources, char* buffer, size_t buffer_size);
+
+#endif // STAGE_PLANNER_H_
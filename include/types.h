@@ -37,6 +37,7 @@ struct FileWriterContext;
 struct AppResources;
 // MODIFIED: Added forward declaration for MemoryArena
 struct MemoryArena;
+struct FilterPool;
 
 // --- Centralized Core Type Definitions ---
 
@@ -71,7 +72,7 @@ typedef struct Queue {
 
 typedef enum {
     FORMAT_UNKNOWN, S8, U8, S16, U16, S32, U32, F32,
-    CS8, CU8, CS16, CU16, CS32, CU32, CF32, SC16Q11
+    CS8, CU8, CS16, CU16, CS32, CU32, CF32, SC16Q11, CS12
 } format_t;
 
 typedef enum {
@@ -101,7 +102,11 @@ typedef enum {
     FILTER_IMPL_FIR_SYMMETRIC,
     FILTER_IMPL_FIR_ASYMMETRIC,
     FILTER_IMPL_FFT_SYMMETRIC,
-    FILTER_IMPL_FFT_ASYMMETRIC
+    FILTER_IMPL_FFT_ASYMMETRIC,
+    FILTER_IMPL_DECIM_SYMMETRIC,  // User filter merged into a polyphase decimator (real taps)
+    FILTER_IMPL_DECIM_ASYMMETRIC, // User filter merged into a polyphase decimator (complex taps)
+    FILTER_IMPL_FFTW_SYMMETRIC,   // FFTW overlap-save engine (real taps, WITH_FFTW builds)
+    FILTER_IMPL_FFTW_ASYMMETRIC   // FFTW overlap-save engine (complex taps, WITH_FFTW builds)
 } FilterImplementationType;
 
 typedef enum {
@@ -110,6 +115,19 @@ typedef enum {
     FILTER_TYPE_FFT   // Value 2
 } FilterTypeRequest;
 
+typedef enum {
+    STAGE_PLACEMENT_AUTO,           // Left to the stage planner
+    STAGE_PLACEMENT_PRE_RESAMPLE,
+    STAGE_PLACEMENT_POST_RESAMPLE
+} StagePlacement;
+
+// The movable DSP stages, in the order they are always applied relative to each other.
+typedef enum {
+    PLAN_STAGE_DC_BLOCK,
+    PLAN_STAGE_SHIFT,
+    PLAN_STAGE_FILTER,
+    PLAN_STAGE_COUNT
+} PlanStage;
 
 typedef enum {
     PIPELINE_MODE_REALTIME_SDR,
@@ -226,6 +244,11 @@ typedef struct {
     size_t (*write)(struct FileWriterContext* ctx, const void* buffer, size_t bytes_to_write);
     void (*close)(struct FileWriterContext* ctx);
     long long (*get_total_bytes_written)(const struct FileWriterContext* ctx);
+    // Optional: copies bytes from a file descriptor inside the kernel. NULL if the writer can't.
+    // Returns the bytes copied, or -1 with errno set (EOPNOTSUPP if the descriptors don't support it).
+    long long (*copy_from_fd)(struct FileWriterContext* ctx, int in_fd, long long in_offset, size_t length);
+    // Optional: flushes everything written so far to stable storage. NULL if the writer can't.
+    bool (*sync)(struct FileWriterContext* ctx);
 } FileWriterOps;
 
 typedef struct FileWriterContext {
@@ -234,12 +257,26 @@ typedef struct FileWriterContext {
     long long total_bytes_written;
 } FileWriterContext;
 
+typedef enum {
+    IQ_CORRECTION_METHOD_SEARCH,    // Random-walk search minimizing spectral image power
+    IQ_CORRECTION_METHOD_STATS      // Closed-form estimate from second-order statistics
+} IqCorrectionMethod;
+
 typedef struct {
     bool enable;
+    const char* method_str_arg;
+    IqCorrectionMethod method;
 } IqCorrectionConfig;
 
+typedef enum {
+    DC_BLOCK_MODE_IIR,      // First-order DC-blocking high-pass filter
+    DC_BLOCK_MODE_MEAN      // Subtract a slowly updated per-block mean
+} DcBlockMode;
+
 typedef struct {
     bool enable;
+    const char* mode_str_arg;
+    DcBlockMode mode;
 } DcBlockConfig;
 
 typedef enum {
@@ -259,6 +296,31 @@ typedef struct {
     float freq2_hz;
 } FilterRequest;
 
+typedef struct {
+    double offset_hz;       // Channel center, relative to the input's center frequency
+    double bandwidth_hz;
+} ChannelRequest;
+
+/**
+ * @brief A position or length in the input, given to --start or --duration.
+ */
+typedef struct {
+    bool provided;
+    bool in_samples;        // `samples` holds the value; otherwise `seconds` does
+    double seconds;
+    long long samples;
+} InputTimeSpec;
+
+typedef struct {
+    const char* filename_arg;
+    const char* output_type_name;
+    const char* sample_type_name;
+    float target_rate_arg;
+
+    OutputType output_type;
+    format_t output_format;
+} ExtraOutputConfig;
+
 typedef struct AppConfig {
     char *input_type_str;
     char *input_filename_arg;
@@ -267,6 +329,16 @@ typedef struct AppConfig {
     char *output_type_name;
     bool output_type_provided;
     bool output_to_stdout;
+    bool direct_io;             // Write output files with O_DIRECT (Linux only)
+    int read_ahead_mb;          // File input kept prefetched ahead of the reader (0 disables)
+    const char* start_arg;      // File input: process from this point on
+    const char* duration_arg;   // File input: process only this much
+    InputTimeSpec range_start;
+    InputTimeSpec range_duration;
+    bool checkpoint;            // Save <output>.ckpt periodically so the run can be resumed
+    bool resume;                // Continue the output from its checkpoint
+    float segment_size_mb_arg;      // Roll to a new output file after this many MB (0 = off)
+    float segment_duration_sec_arg; // Roll to a new output file after this many seconds of output (0 = off)
     char *preset_name;
     float gain;
     bool gain_provided;
@@ -291,7 +363,9 @@ typedef struct AppConfig {
     FilterRequest filter_requests[MAX_FILTER_CHAIN];
     int num_filter_requests;
 
-    bool apply_user_filter_post_resample;
+    // Stage placement overrides from --stage-order (and --shift-after-resample).
+    const char* stage_order_str_arg;
+    StagePlacement stage_placement_request[PLAN_STAGE_COUNT];
 
     // Filter arguments
     float lowpass_cutoff_hz_arg[MAX_FILTER_CHAIN];
@@ -305,6 +379,30 @@ typedef struct AppConfig {
     FilterTypeRequest filter_type_request;
     const char* filter_type_str_arg;
     int filter_fft_size_arg;
+    bool no_filter_cache;
+    int filter_threads_arg;
+
+    // Channelizer mode: extract several channels in one pass, one output file each.
+    const char* channels_str_arg;
+    ChannelRequest channel_requests[MAX_CHANNELS];
+    int num_channels;
+
+    // Additional outputs (--file-2 ... --file-5) sharing the input and pre-processing.
+    ExtraOutputConfig extra_outputs[MAX_EXTRA_OUTPUTS];
+    int num_extra_outputs;
+
+    // Batch mode: many input files, each written to a path built from a template.
+    const char* batch_output_template_arg;
+    const char* batch_list_arg;
+    int batch_jobs_arg;
+    bool batch_mode;
+    const char** batch_inputs;
+    int num_batch_inputs;
+
+    // Server mode: jobs arrive on a UNIX socket and each is validated from this copy of the options.
+    const char* serve_socket_arg;
+    bool server_mode;
+    const struct AppConfig* server_base_config;
 
 #if defined(ANY_SDR_SUPPORT_ENABLED)
     struct {
@@ -339,11 +437,16 @@ typedef struct AppConfig {
 
     PresetDefinition* presets;
     int num_presets;
+
+    // Directory holding the loaded presets file (NULL if none was found).
+    // Other persistent state, such as planner wisdom, is kept alongside it.
+    const char* presets_dir;
 } AppConfig;
 
 typedef struct SampleChunk {
     // --- Buffers ---
     void* raw_input_data;
+    const void* mapped_input_data;      // If set, the raw samples are read from here (a memory-mapped input) instead
     complex_float_t* complex_pre_resample_data;
     complex_float_t* complex_resampled_data;
     complex_float_t* complex_post_resample_data;
@@ -361,6 +464,10 @@ typedef struct SampleChunk {
     bool is_last_chunk;
     bool stream_discontinuity_event;
     size_t input_bytes_per_sample_pair;
+
+    // Holders beyond the main pipeline while the chunk is fanned out to output
+    // branches. Protected by AppResources.chunk_ref_mutex.
+    int ref_count;
 } SampleChunk;
 
 typedef void (*ProgressUpdateFn)(unsigned long long current_output_frames, long long total_output_frames, unsigned long long current_bytes_written, void* udata);
@@ -380,14 +487,147 @@ typedef struct {
     float* window_coeffs;
     float average_power;
     float power_range;
-    complex_float_t* optimization_accum_buffer;
-    int samples_in_accum;
+
+    // Running second-order statistics for the closed-form estimator.
+    double moment_ii;
+    double moment_qq;
+    double moment_iq;
+    bool have_moments;
+
+    // Snapshot feed from the pre-processor to the optimizer thread.
+    complex_float_t* snapshot_pool;            // IQ_CORRECTION_SNAPSHOT_POOL_SIZE buffers of IQ_CORRECTION_FFT_SIZE samples
+    complex_float_t* pending_snapshot;         // Buffer being filled by the pre-processor, or NULL
+    unsigned int pending_snapshot_fill;
+    unsigned long long samples_until_snapshot;
 } IqCorrectionResources;
 
 typedef struct {
-    iirfilt_crcf dc_block_filter;
+    // IIR mode: y[n] = gain * v[n], v[n] = pole * v[n-1] + (x[n] - x[n-1])
+    float pole;
+    float gain;
+    float pole_powers[DC_BLOCK_SCAN_BLOCK + 1];   // pole^k, for the block-parallel scan
+    complex_float_t prev_input;
+    complex_float_t prev_state;
+
+    // Mean mode: exponentially smoothed per-block mean.
+    float mean_rate_per_sample;
+    complex_float_t dc_estimate;
+    bool have_estimate;
 } DcBlockResources;
 
+/**
+ * @struct StagePlan
+ * @brief Where the stage planner put the resampler among the DC block, shift and filter.
+ */
+typedef struct {
+    int stages_before_resample;         // How many of the PlanStage stages, in order, run before the resampler
+    bool filter_merged;                 // The post-resample filter is folded into a polyphase decimator
+    bool forced;                        // At least one placement was fixed on the command line
+    bool shift_post_resample;           // The frequency shift runs after the resampler
+    bool filter_post_resample;          // The user filter runs after the resampler (or in a merged decimator)
+    double estimated_macs_per_sample;   // Estimated real multiply-accumulates per input sample
+} StagePlan;
+
+typedef struct {
+    unsigned int decimation_factor;             // 0 when the CIC front end is not in use
+    unsigned int phase;                         // Input samples integrated since the last output
+    uint64_t integrators[CIC_STAGES][2];        // [stage][I/Q], wrapping two's complement
+    uint64_t comb_delays[CIC_STAGES][2];
+    int64_t* widened;                           // Scratch for one tile of widened I/Q integers
+    float output_scale;                         // Normalizer * gain / factor^CIC_STAGES
+    firfilt_crcf compensator;
+} CicDecimatorResources;
+
+/**
+ * @struct OutputSink
+ * @brief A secondary output file with its own writer context, I/O ring buffer and writer thread.
+ */
+typedef struct OutputSink {
+    char path[MAX_PATH_BUFFER];
+    FileWriterContext writer_ctx;
+    FileWriteBuffer* write_buffer;
+    void* writer_local_buffer;
+    size_t bytes_per_sample_pair;
+    pthread_t writer_thread_handle;
+    unsigned long long frames_written;
+    unsigned long long warmup_frames_to_drop; // Output of the input read ahead of --start
+    bool counts_toward_totals;      // Adds its frames to the run's output totals and progress
+    unsigned int index;
+    struct AppResources* resources; // Back-pointer for the sink's writer thread
+} OutputSink;
+
+/**
+ * @struct ChannelOutput
+ * @brief One channel of the channelizer: its down-conversion chain and its own output.
+ */
+typedef struct ChannelOutput {
+    double offset_hz;
+    double bandwidth_hz;
+    nco_crcf nco;
+    msresamp_crcf resampler;        // NULL when the output rate equals the input rate
+    firfilt_crcf channel_filter;    // Band-limits the channel at the output rate
+    unsigned int channel_filter_taps;
+    OutputSink sink;
+} ChannelOutput;
+
+/**
+ * @struct OutputBranch
+ * @brief An additional output fed the same pre-processed chunks as the main output.
+ */
+typedef struct OutputBranch {
+    struct AppConfig* config;       // Copy of the main config carrying this output's settings
+    msresamp_crcf resampler;        // NULL when the branch runs at the input rate
+    complex_float_t* resampled_buffer;
+    unsigned char* output_buffer;
+    Queue* input_queue;
+    pthread_t thread_handle;
+    OutputSink sink;
+} OutputBranch;
+
+/**
+ * @struct CheckpointState
+ * @brief --checkpoint/--resume: where this run's output sits in the output it continues.
+ *
+ * Saved positions lie on a grid of `align_input_frames` input frames, which
+ * produce exactly `align_output_frames` output frames, counted from the first
+ * frame the original run read. A resumed run starts on the same grid, so its
+ * resampler and decimators are in the phase the original run had there.
+ */
+typedef struct {
+    bool enabled;
+    bool resuming;                          // Loaded from an existing checkpoint
+    bool aligned;                           // False if the rates have no short common period; positions are then rounded
+    char path[MAX_PATH_BUFFER];
+    uint64_t config_hash;
+    int64_t origin_frame;                   // First input frame the original run read
+    int64_t resume_input_frame;             // Loaded: the input frame the kept output ends at
+    unsigned long long resume_output_frames; // Loaded: output frames kept from earlier runs
+    long long resume_output_bytes;          // Loaded: sample bytes kept, not counting a WAV header
+    long long align_input_frames;
+    long long align_output_frames;
+    int64_t run_first_frame;                // First input frame this run reads, warm-up included
+    unsigned long long run_warmup_output_frames; // Output frames this run drops for its warm-up
+    time_t last_save_time;                  // Writer thread only
+    bool saved;                             // A checkpoint of this output exists on disk
+} CheckpointState;
+
+/**
+ * @struct PipelineReuse
+ * @brief Objects kept between the files of a batch instead of being freed.
+ *
+ * cleanup_application() hands them over here when `enabled` is set, and the
+ * next initialize_application() on the same resources takes them back if
+ * they still fit.
+ */
+typedef struct {
+    bool enabled;
+    void* chunk_data_pool;
+    size_t chunk_data_pool_bytes;
+    FileWriteBuffer* file_write_buffer;
+    msresamp_crcf resampler;
+    float resampler_ratio;
+} PipelineReuse;
+
 typedef struct AppResources {
     const struct AppConfig* config;
     msresamp_crcf resampler;
@@ -397,6 +637,8 @@ typedef struct AppResources {
     bool is_passthrough;
     IqCorrectionResources iq_correction;
     DcBlockResources dc_block;
+    CicDecimatorResources cic;
+    StagePlan stage_plan;
     struct InputSourceOps* selected_input_ops;
     InputSourceInfo source_info;
     format_t input_format;
@@ -409,10 +651,30 @@ typedef struct AppResources {
     FilterImplementationType user_filter_type_actual;
     void* user_fir_filter_object;
     unsigned int user_filter_block_size;
+    unsigned int user_filter_num_taps;
+
+    // Non-zero when the user filter is folded into a single integer-factor
+    // polyphase decimator that replaces the msresamp resampler.
+    unsigned int merged_decimation_factor;
+    complex_float_t* decimator_remainder_buffer;
+
+    // Worker threads and their filter replicas for splitting FFT filter passes.
+    struct FilterPool* user_filter_pool;
+    void** user_filter_replicas;
+    unsigned int user_filter_num_replicas;
 
     complex_float_t* pre_fft_remainder_buffer;
     complex_float_t* post_fft_remainder_buffer;
 
+    // Channelizer mode: one down-conversion chain and writer per requested channel.
+    ChannelOutput* channels;
+    int num_channels;
+
+    // Additional outputs fed the pre-processed chunks by reference.
+    OutputBranch* output_branches;
+    int num_output_branches;
+    pthread_mutex_t chunk_ref_mutex;
+
     void* input_module_private_data;
 
     // Memory Arena for all setup-time allocations
@@ -420,8 +682,15 @@ typedef struct AppResources {
 
     // Consolidated pipeline buffer pool for cache locality
     void* pipeline_chunk_data_pool;
+    size_t pipeline_chunk_data_pool_bytes;
     SampleChunk* sample_chunk_pool;
 
+    // Batch mode: pools and DSP objects carried over from the previous file.
+    PipelineReuse reuse;
+    bool batch_quiet;       // Skip the per-file configuration summary and start message
+    bool isolate_errors;    // A fatal error stops only this pipeline instead of the whole process
+    int concurrent_pipelines; // Pipelines running side by side (batch/server); 0 or 1 when alone
+
     // Pre-allocated buffer for real-time deserializer
     void* sdr_deserializer_temp_buffer;
     size_t sdr_deserializer_buffer_size;
@@ -448,6 +717,7 @@ typedef struct AppResources {
     Queue* pre_process_to_resampler_queue;
     Queue* resampler_to_post_process_queue;
     Queue* iq_optimization_data_queue;
+    Queue* iq_snapshot_free_queue;
     Queue* stdout_queue;
 
     FileWriteBuffer* file_write_buffer;
@@ -461,6 +731,14 @@ typedef struct AppResources {
     _Atomic unsigned long long sdr_chunks_dropped_since_last_log;
 
     unsigned long long total_frames_read;
+
+    // --start/--duration: the range is source_info.frames long from this frame.
+    // The reader starts input_warmup_frames earlier so the filters have settled
+    // by the start of the range; each output drops what those frames produce.
+    int64_t input_range_start_frame;
+    int64_t input_warmup_frames;
+    int64_t input_warmup_frames_uncounted; // Reader side: warm-up frames not yet read
+    CheckpointState checkpoint;
     unsigned long long total_output_frames;
     long long final_output_size_bytes;
     long long expected_total_output_frames;
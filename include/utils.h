@@ -71,4 +71,10 @@ bool utils_check_nyquist_warning(double freq_to_check_hz, double sample_rate_hz,
  */
 bool utils_check_file_exists(const char* full_path);
 
+/**
+ * @brief Gets the number of online logical processors.
+ * @return The processor count, or 1 if it cannot be determined.
+ */
+unsigned int utils_get_cpu_count(void);
+
 #endif // UTILS_H_
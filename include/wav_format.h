@@ -0,0 +1,101 @@
+#ifndef WAV_FORMAT_H_
+#define WAV_FORMAT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @def WAV_HEADER_MAX_BYTES
+ * @brief Upper bound on the header produced by wav_header_build().
+ */
+#define WAV_HEADER_MAX_BYTES 256
+
+/**
+ * @brief Describes the header of a stereo (I/Q) PCM WAV or RF64 file.
+ *
+ * The layout is the same whatever the data size: RIFF/RF64, a 28-byte
+ * JUNK/ds64 chunk, fmt, an optional auxi chunk, then data. A plain WAV file
+ * that outgrows 4 GB can therefore be turned into RF64 by rewriting the
+ * header in place.
+ */
+typedef struct {
+    uint32_t sample_rate;
+    uint16_t bits_per_sample;   // 8 (unsigned) or 16 (signed)
+    bool rf64;                  // Always RF64, instead of only when the data outgrows RIFF
+
+    // SDR metadata for an 'auxi' chunk (SpectraVue/SDR Console layout)
+    bool has_auxi;
+    double center_freq_hz;
+    bool start_time_present;
+    time_t start_time;
+} WavHeaderInfo;
+
+/**
+ * @brief Returns the size of the header described by `info`. This is also the offset of the first sample.
+ */
+size_t wav_header_size(const WavHeaderInfo* info);
+
+/**
+ * @brief Serializes the header for a file holding `data_bytes` of samples.
+ *
+ * Called with 0 when the file is created and again with the final size at
+ * close; both produce headers of the same length.
+ *
+ * @param info The header description.
+ * @param data_bytes Size of the sample data.
+ * @param out Buffer of at least WAV_HEADER_MAX_BYTES.
+ * @param out_is_rf64 Optional. Receives whether the header is RF64.
+ * @return The header length in bytes.
+ */
+size_t wav_header_build(const WavHeaderInfo* info, long long data_bytes, unsigned char* out, bool* out_is_rf64);
+
+/**
+ * @brief Where things are in an existing WAV or RF64 file, as found by wav_scan_chunks().
+ */
+typedef struct {
+    // From the 'fmt ' chunk
+    bool fmt_found;
+    uint16_t format_tag;        // WAVE_FORMAT_EXTENSIBLE is resolved to its subformat
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+
+    bool rf64;
+    long long file_size;
+    long long data_offset;      // 0 until the 'data' chunk is found
+    long long data_length;      // Clamped to the end of the file
+    bool data_length_clamped;   // The header promised more data than the file holds
+    long long auxi_offset;      // 0 if there is no 'auxi' chunk (so far)
+    uint32_t auxi_length;
+
+    long long next_chunk_offset; // Where the scan stopped; 0 before the first call
+    uint64_t ds64_data_size;
+} WavFileLayout;
+
+/**
+ * @def WAV_FORMAT_TAG_PCM
+ * @brief The 'fmt ' format tag of integer PCM data.
+ */
+#define WAV_FORMAT_TAG_PCM 1
+
+/**
+ * @brief Walks the chunk list of a WAV or RF64 file within one region of it.
+ *
+ * Only chunk headers are looked at; chunk contents are skipped by their size,
+ * so a single read of the start of the file is normally enough to locate
+ * 'fmt ', 'ds64', 'auxi' and 'data', however large the data is. Chunks after
+ * the data can be found by calling again with a region that starts at
+ * `layout->next_chunk_offset`.
+ *
+ * @param layout Zero it and set `file_size` before the first call.
+ * @param region File bytes starting at `region_offset`.
+ * @param region_bytes Number of bytes in `region`.
+ * @param region_offset File offset of `region`. The first call must start at 0.
+ * @return false if the file is not a WAV/RF64 file or a chunk header is malformed.
+ */
+bool wav_scan_chunks(WavFileLayout* layout, const unsigned char* region, size_t region_bytes, long long region_offset);
+
+#endif // WAV_FORMAT_H_
@@ -0,0 +1,400 @@
+// batch.c
+
+#include "batch.h"
+#include "constants.h"
+#include "setup.h"
+#include "signal_handler.h"
+#include "utils.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <glob.h>
+#endif
+
+extern pthread_mutex_t g_console_mutex;
+
+#define BATCH_INDEX_MIN_DIGITS 4
+
+typedef struct {
+    const AppConfig* base_config;
+    struct InputSourceOps* input_ops;
+    int num_pipelines;
+
+    // Guards the fields below. Also held while a pipeline is set up or torn
+    // down, as FFTW planning and liquid-dsp object creation are not thread-safe
+    // and an overwrite or Nyquist prompt must not interleave with another.
+    pthread_mutex_t mutex;
+    int next_input;
+    int num_completed;
+    int num_skipped;
+    int num_failed;
+    long long total_output_bytes;
+} BatchState;
+
+typedef struct {
+    BatchState* batch;
+    AppConfig config;
+    AppResources resources;
+    char output_path[MAX_PATH_BUFFER];
+    pthread_t thread;
+} BatchWorker;
+
+
+static char* _arena_strdup(MemoryArena* arena, const char* str) {
+    size_t len = strlen(str) + 1;
+    char* copy = (char*)mem_arena_alloc(arena, len);
+    if (copy) memcpy(copy, str, len);
+    return copy;
+}
+
+static bool _has_wildcards(const char* path) {
+    return strpbrk(path, "*?[") != NULL;
+}
+
+/**
+ * @brief Reads the next non-blank, non-comment line of a list file, without its line ending.
+ */
+static bool _read_list_line(FILE* fp, char* line, size_t line_size) {
+    while (fgets(line, (int)line_size, fp)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] != '\0' && line[0] != '#') return true;
+    }
+    return false;
+}
+
+bool batch_collect_inputs(AppConfig* config, int num_args, const char** args, MemoryArena* arena) {
+    bool success = false;
+    FILE* list_fp = NULL;
+    char line[MAX_PATH_BUFFER];
+    size_t num_literal = 0;
+    size_t num_listed = 0;
+    size_t num_matched = 0;
+#ifndef _WIN32
+    glob_t matches;
+    bool glob_used = false;
+    memset(&matches, 0, sizeof(matches));
+    size_t* pattern_matches = NULL;
+    if (num_args > 0) {
+        pattern_matches = (size_t*)mem_arena_alloc(arena, (size_t)num_args * sizeof(size_t));
+        if (!pattern_matches) return false;
+    }
+#endif
+
+    // First pass: count, so the list can be allocated from the arena in one piece.
+    for (int i = 0; i < num_args; i++) {
+        if (!_has_wildcards(args[i])) {
+            num_literal++;
+            continue;
+        }
+#ifndef _WIN32
+        size_t matched_before = glob_used ? matches.gl_pathc : 0;
+        int result = glob(args[i], glob_used ? GLOB_APPEND : 0, NULL, &matches);
+        glob_used = true;
+        if (result == GLOB_NOMATCH) {
+            log_fatal("No input files match '%s'.", args[i]);
+            goto cleanup;
+        }
+        if (result != 0) {
+            log_fatal("Failed to expand '%s'.", args[i]);
+            goto cleanup;
+        }
+        pattern_matches[i] = matches.gl_pathc - matched_before;
+#else
+        log_fatal("Wildcards in '%s' are not expanded on Windows. List the files with --batch-list instead.", args[i]);
+        goto cleanup;
+#endif
+    }
+#ifndef _WIN32
+    num_matched = glob_used ? matches.gl_pathc : 0;
+#endif
+
+    if (config->batch_list_arg) {
+        list_fp = fopen(config->batch_list_arg, "r");
+        if (!list_fp) {
+            log_fatal("Failed to open batch list '%s': %s", config->batch_list_arg, strerror(errno));
+            goto cleanup;
+        }
+        while (_read_list_line(list_fp, line, sizeof(line))) {
+            num_listed++;
+        }
+        rewind(list_fp);
+    }
+
+    size_t total = num_literal + num_matched + num_listed;
+    if (total == 0) {
+        log_fatal("Batch mode needs at least one input file, given as arguments or with --batch-list.");
+        goto cleanup;
+    }
+    if (total > INT_MAX) {
+        log_fatal("Too many batch input files.");
+        goto cleanup;
+    }
+
+    const char** inputs = (const char**)mem_arena_alloc(arena, total * sizeof(const char*));
+    if (!inputs) goto cleanup;
+
+    // Second pass: keep the command-line order. With GLOB_APPEND the matches of
+    // each pattern follow those of the previous one, each group sorted by glob().
+    size_t count = 0;
+    size_t next_match = 0;
+    for (int i = 0; i < num_args; i++) {
+        if (!_has_wildcards(args[i])) {
+            inputs[count++] = args[i];
+            continue;
+        }
+#ifndef _WIN32
+        for (size_t m = 0; m < pattern_matches[i]; m++, next_match++) {
+            inputs[count] = _arena_strdup(arena, matches.gl_pathv[next_match]);
+            if (!inputs[count]) goto cleanup;
+            count++;
+        }
+#endif
+    }
+    if (list_fp) {
+        while (count < total && _read_list_line(list_fp, line, sizeof(line))) {
+            inputs[count] = _arena_strdup(arena, line);
+            if (!inputs[count]) goto cleanup;
+            count++;
+        }
+    }
+
+    config->batch_mode = true;
+    config->batch_inputs = inputs;
+    config->num_batch_inputs = (int)count;
+    config->input_filename_arg = (char*)inputs[0];
+    success = true;
+
+cleanup:
+    if (list_fp) fclose(list_fp);
+#ifndef _WIN32
+    if (glob_used) globfree(&matches);
+#endif
+    return success;
+}
+
+bool batch_expand_output_template(const char* template_str, const char* input_path, int index, int count,
+                                  char* out, size_t out_size) {
+    const char* base = input_path;
+    for (const char* p = input_path; *p; p++) {
+#ifdef _WIN32
+        if (*p == '/' || *p == '\\' || *p == ':') base = p + 1;
+#else
+        if (*p == '/') base = p + 1;
+#endif
+    }
+    const char* dot = strrchr(base, '.');
+    size_t name_len = (dot && dot != base) ? (size_t)(dot - base) : strlen(base);
+
+    int digits = 1;
+    for (int n = count; n >= 10 && digits < 10; n /= 10) digits++;
+    if (digits < BATCH_INDEX_MIN_DIGITS) digits = BATCH_INDEX_MIN_DIGITS;
+
+    size_t pos = 0;
+    for (const char* t = template_str; *t; ) {
+        const char* piece = t;
+        size_t piece_len = 1;
+        char index_buf[24];
+        if (strncmp(t, "{name}", 6) == 0) {
+            piece = base;
+            piece_len = name_len;
+            t += 6;
+        } else if (strncmp(t, "{index}", 7) == 0) {
+            snprintf(index_buf, sizeof(index_buf), "%0*u", digits, (unsigned int)index + 1u);
+            piece = index_buf;
+            piece_len = strlen(index_buf);
+            t += 7;
+        } else {
+            t++;
+        }
+        if (pos + piece_len >= out_size) return false;
+        memcpy(out + pos, piece, piece_len);
+        pos += piece_len;
+    }
+    out[pos] = '\0';
+    return true;
+}
+
+static void _process_file(BatchWorker* worker, int index) {
+    BatchState* batch = worker->batch;
+    const AppConfig* base = batch->base_config;
+    const char* input_path = base->batch_inputs[index];
+    const int count = base->num_batch_inputs;
+
+    if (!batch_expand_output_template(base->batch_output_template_arg, input_path, index, count,
+                                      worker->output_path, sizeof(worker->output_path))) {
+        log_error("[%d/%d] %s: output path is too long, skipping.", index + 1, count, input_path);
+        pthread_mutex_lock(&batch->mutex);
+        batch->num_failed++;
+        pthread_mutex_unlock(&batch->mutex);
+        return;
+    }
+
+    // A fresh copy of the validated configuration, pointed at this file.
+    AppConfig* config = &worker->config;
+    *config = *base;
+    config->input_filename_arg = (char*)input_path;
+    config->output_filename_arg = worker->output_path;
+
+    AppResources* resources = &worker->resources;
+    pipeline_resources_reset(resources);
+    resources->selected_input_ops = batch->input_ops;
+    resources->batch_quiet = (index > 0);
+    resources->concurrent_pipelines = batch->num_pipelines;
+
+    pthread_mutex_lock(&batch->mutex);
+    // Checked under the lock, so two inputs mapping to the same output can't both claim it.
+    char existing_path[MAX_PATH_BUFFER];
+    if (pipeline_find_existing_output(config, existing_path, sizeof(existing_path))) {
+        batch->num_skipped++;
+        pthread_mutex_unlock(&batch->mutex);
+        log_warn("[%d/%d] %s already exists, skipping.", index + 1, count, existing_path);
+        return;
+    }
+    bool ready = initialize_application(config, resources);
+    if (ready) {
+        signal_handler_track_resources(resources, true);
+    } else {
+        cleanup_application(config, resources);
+        // Anything written is removed, so a rerun of the batch redoes this file.
+        pipeline_remove_outputs(config);
+        batch->num_failed++;
+    }
+    pthread_mutex_unlock(&batch->mutex);
+
+    if (!ready) {
+        log_error("[%d/%d] %s: could not be set up, skipping.", index + 1, count, input_path);
+        return;
+    }
+
+    resources->start_time = time(NULL);
+    bool processing_ok = run_processing_pipeline(config, resources);
+
+    pthread_mutex_lock(&batch->mutex);
+    signal_handler_track_resources(resources, false);
+    cleanup_application(config, resources);
+    bool completed = processing_ok && resources->end_of_stream_reached;
+    if (completed) {
+        batch->num_completed++;
+        batch->total_output_bytes += resources->final_output_size_bytes;
+    } else {
+        pipeline_remove_outputs(config);
+        if (!processing_ok) batch->num_failed++;
+    }
+    pthread_mutex_unlock(&batch->mutex);
+
+    if (completed) {
+        char size_buf[40];
+        format_file_size(resources->final_output_size_bytes, size_buf, sizeof(size_buf));
+        log_info("[%d/%d] %s -> %s (%s)", index + 1, count, input_path, worker->output_path, size_buf);
+    } else if (!processing_ok) {
+        log_error("[%d/%d] %s: processing failed, stopping the batch.", index + 1, count, input_path);
+    } else {
+        log_warn("[%d/%d] %s: cancelled, partial output removed.", index + 1, count, input_path);
+    }
+}
+
+static void* _batch_worker_thread(void* arg) {
+    BatchWorker* worker = (BatchWorker*)arg;
+    BatchState* batch = worker->batch;
+
+    for (;;) {
+        pthread_mutex_lock(&batch->mutex);
+        int index = -1;
+        if (!is_shutdown_requested() && batch->next_input < batch->base_config->num_batch_inputs) {
+            index = batch->next_input++;
+        }
+        pthread_mutex_unlock(&batch->mutex);
+
+        if (index < 0) break;
+        _process_file(worker, index);
+    }
+    return NULL;
+}
+
+static void _print_batch_summary(const BatchState* batch, double duration_secs) {
+    const int label_width = 32;
+    char size_buf[40];
+    char duration_buf[40];
+
+    format_file_size(batch->total_output_bytes, size_buf, sizeof(size_buf));
+    format_duration(duration_secs, duration_buf, sizeof(duration_buf));
+
+    const char* status = (batch->num_failed > 0) ? "Completed With Errors" :
+                         is_shutdown_requested() ? "Cancelled by User" : "Completed Successfully";
+
+    fprintf(stderr, "\n--- Batch Summary ---\n");
+    fprintf(stderr, "%-*s %s\n", label_width, "Status:", status);
+    fprintf(stderr, "%-*s %d / %d\n", label_width, "Files Processed:", batch->num_completed, batch->base_config->num_batch_inputs);
+    fprintf(stderr, "%-*s %d\n", label_width, "Files Skipped (Output Exists):", batch->num_skipped);
+    fprintf(stderr, "%-*s %d\n", label_width, "Files Failed:", batch->num_failed);
+    fprintf(stderr, "%-*s %s\n", label_width, "Total Output Size:", size_buf);
+    fprintf(stderr, "%-*s %s\n", label_width, "Processing Duration:", duration_buf);
+}
+
+bool batch_run(const AppConfig* config, AppResources* resources) {
+    BatchState batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.base_config = config;
+    batch.input_ops = resources->selected_input_ops;
+    if (pthread_mutex_init(&batch.mutex, NULL) != 0) {
+        log_fatal("Failed to initialize batch mutex: %s", strerror(errno));
+        return false;
+    }
+
+    int num_jobs = (config->batch_jobs_arg > 0) ? config->batch_jobs_arg : 1;
+    if (num_jobs > config->num_batch_inputs) num_jobs = config->num_batch_inputs;
+    batch.num_pipelines = num_jobs;
+
+    BatchWorker* workers = (BatchWorker*)mem_arena_alloc(&resources->setup_arena, (size_t)num_jobs * sizeof(BatchWorker));
+    if (!workers) {
+        pthread_mutex_destroy(&batch.mutex);
+        return false;
+    }
+
+    log_info("Processing %d files with %d pipeline%s...", config->num_batch_inputs, num_jobs, (num_jobs == 1) ? "" : "s");
+    time_t start_time = time(NULL);
+
+    int workers_started = 0;
+    for (int i = 0; i < num_jobs; i++) {
+        BatchWorker* worker = &workers[i];
+        worker->batch = &batch;
+        worker->resources.reuse.enabled = true;
+        if (!mem_arena_init(&worker->resources.setup_arena, MEM_ARENA_SIZE_BYTES)) {
+            break;
+        }
+        if (pthread_create(&worker->thread, NULL, _batch_worker_thread, worker) != 0) {
+            log_error("Failed to start batch pipeline %d, continuing with %d.", i + 1, workers_started);
+            mem_arena_destroy(&worker->resources.setup_arena);
+            break;
+        }
+        workers_started++;
+    }
+    if (workers_started == 0) {
+        log_fatal("Failed to start any batch pipeline.");
+        pthread_mutex_destroy(&batch.mutex);
+        return false;
+    }
+
+    for (int i = 0; i < workers_started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        pipeline_reuse_release(&workers[i].resources.reuse);
+        mem_arena_destroy(&workers[i].resources.setup_arena);
+    }
+
+    pthread_mutex_lock(&g_console_mutex);
+    _print_batch_summary(&batch, difftime(time(NULL), start_time));
+    pthread_mutex_unlock(&g_console_mutex);
+
+    bool success = (batch.num_failed == 0);
+    pthread_mutex_destroy(&batch.mutex);
+    return success;
+}
@@ -0,0 +1,235 @@
+// channelizer.c
+
+#include "channelizer.h"
+#include "constants.h"
+#include "log.h"
+#include "output_sink.h"
+#include "frequency_shift.h"
+#include "sample_convert.h"
+#include "memory_arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <liquid.h>
+#else
+#include <liquid/liquid.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+bool channelizer_make_channel_path(const char* base_path, unsigned int channel_number, char* buffer, size_t buffer_size) {
+    const char* last_sep = strrchr(base_path, '/');
+#ifdef _WIN32
+    const char* last_backslash = strrchr(base_path, '\\');
+    if (last_backslash && (!last_sep || last_backslash > last_sep)) last_sep = last_backslash;
+#endif
+    const char* name = last_sep ? last_sep + 1 : base_path;
+    const char* ext = strrchr(name, '.');
+    if (!ext || ext == name) ext = base_path + strlen(base_path);
+
+    int written = snprintf(buffer, buffer_size, "%.*s_ch%u%s", (int)(ext - base_path), base_path, channel_number, ext);
+    return (written > 0 && (size_t)written < buffer_size);
+}
+
+/**
+ * @brief Designs the channel's band-limiting low-pass filter at the output rate.
+ *
+ * Honors the global --transition-width, --filter-taps and --attenuation options
+ * the same way the user filter does, with the channel's half-bandwidth as cutoff.
+ */
+static firfilt_crcf _create_channel_filter(const AppConfig* config, double bandwidth_hz, double output_rate, unsigned int* out_taps_len) {
+    float cutoff_hz = (float)(bandwidth_hz / 2.0);
+    float attenuation_db = (config->attenuation_db_arg > 0.0f) ? config->attenuation_db_arg : RESAMPLER_QUALITY_ATTENUATION_DB;
+
+    unsigned int taps_len;
+    if (config->filter_taps_arg > 0) {
+        taps_len = (unsigned int)config->filter_taps_arg;
+    } else {
+        float transition_width_hz = (config->transition_width_hz_arg > 0.0f) ? config->transition_width_hz_arg
+                                                                             : cutoff_hz * DEFAULT_FILTER_TRANSITION_FACTOR;
+        if (transition_width_hz < 1.0f) transition_width_hz = 1.0f;
+        taps_len = estimate_req_filter_len(transition_width_hz / (float)output_rate, attenuation_db);
+        if (taps_len % 2 == 0) taps_len++;
+        if (taps_len < FILTER_MINIMUM_TAPS) taps_len = FILTER_MINIMUM_TAPS;
+    }
+
+    float* taps = (float*)malloc(taps_len * sizeof(float));
+    if (!taps) return NULL;
+    liquid_firdes_kaiser(taps_len, cutoff_hz / (float)output_rate, attenuation_db, 0.0f, taps);
+
+    // Unity gain in the passband, matching the user filter's low-pass normalization.
+    double dc_gain = 0.0;
+    for (unsigned int i = 0; i < taps_len; i++) dc_gain += taps[i];
+    if (fabs(dc_gain) < FILTER_GAIN_ZERO_THRESHOLD) dc_gain = 1.0;
+    for (unsigned int i = 0; i < taps_len; i++) taps[i] = (float)(taps[i] / dc_gain);
+
+    firfilt_crcf filter = firfilt_crcf_create(taps, taps_len);
+    free(taps);
+    *out_taps_len = taps_len;
+    return filter;
+}
+
+bool channelizer_create(AppConfig* config, AppResources* resources, float resample_ratio) {
+    resources->channels = NULL;
+    resources->num_channels = 0;
+    if (config->num_channels == 0) return true;
+
+    double input_rate = (double)resources->source_info.samplerate;
+    double output_rate = config->target_rate;
+
+    resources->channels = (ChannelOutput*)mem_arena_alloc(&resources->setup_arena, (size_t)config->num_channels * sizeof(ChannelOutput));
+    if (!resources->channels) return false;
+
+    for (int i = 0; i < config->num_channels; i++) {
+        const ChannelRequest* req = &config->channel_requests[i];
+        ChannelOutput* ch = &resources->channels[i];
+        ch->offset_hz = req->offset_hz;
+        ch->bandwidth_hz = req->bandwidth_hz;
+        ch->sink.resources = resources;
+        ch->sink.index = (unsigned int)i;
+        ch->sink.counts_toward_totals = true;
+        // Count each channel as soon as it exists, so a failure part-way is fully cleaned up.
+        resources->num_channels = i + 1;
+
+        if (fabs(req->offset_hz) + req->bandwidth_hz / 2.0 > input_rate / 2.0) {
+            log_fatal("Channel %d (%.0f Hz, BW %.0f Hz) extends beyond the input bandwidth of +/-%.0f Hz.",
+                      i + 1, req->offset_hz, req->bandwidth_hz, input_rate / 2.0);
+            return false;
+        }
+        if (req->bandwidth_hz > output_rate) {
+            log_fatal("Channel %d bandwidth (%.0f Hz) exceeds the output rate of %.0f Hz.", i + 1, req->bandwidth_hz, output_rate);
+            return false;
+        }
+
+        if (fabs(req->offset_hz) > 1e-9) {
+            ch->nco = nco_crcf_create(LIQUID_NCO);
+            if (!ch->nco) {
+                log_fatal("Failed to create the NCO for channel %d.", i + 1);
+                return false;
+            }
+            nco_crcf_set_frequency(ch->nco, (float)(2.0 * M_PI * fabs(req->offset_hz) / input_rate));
+        }
+
+        if (!resources->is_passthrough) {
+            ch->resampler = msresamp_crcf_create(resample_ratio, RESAMPLER_QUALITY_ATTENUATION_DB);
+            if (!ch->resampler) {
+                log_fatal("Failed to create the resampler for channel %d.", i + 1);
+                return false;
+            }
+        }
+
+        ch->channel_filter = _create_channel_filter(config, req->bandwidth_hz, output_rate, &ch->channel_filter_taps);
+        if (!ch->channel_filter) {
+            log_fatal("Failed to create the band-limiting filter for channel %d.", i + 1);
+            return false;
+        }
+        log_debug("Channel %d: offset %.0f Hz, bandwidth %.0f Hz, %u filter taps.",
+                  i + 1, req->offset_hz, req->bandwidth_hz, ch->channel_filter_taps);
+    }
+    return true;
+}
+
+bool channelizer_open_outputs(AppConfig* config, AppResources* resources) {
+    if (!config->output_filename_arg) {
+        log_fatal("Option --channels requires an output file (--file) to derive the channel file names from.");
+        return false;
+    }
+
+    // All channels share the main output settings; only the file path differs.
+    AppConfig* channel_config = (AppConfig*)mem_arena_alloc(&resources->setup_arena, sizeof(AppConfig));
+    if (!channel_config) return false;
+
+    for (int i = 0; i < resources->num_channels; i++) {
+        ChannelOutput* ch = &resources->channels[i];
+
+        if (!channelizer_make_channel_path(config->output_filename_arg, ch->sink.index + 1, ch->sink.path, sizeof(ch->sink.path))) {
+            log_fatal("Output path for channel %d is too long.", i + 1);
+            return false;
+        }
+
+        *channel_config = *config;
+        if (!output_sink_open(&ch->sink, channel_config, IO_OUTPUT_SINK_BUFFER_BYTES)) return false;
+    }
+    return true;
+}
+
+bool channelizer_process_chunk(const AppConfig* config, AppResources* resources, SampleChunk* item) {
+    unsigned int frames_in = (unsigned int)item->frames_read;
+
+    for (int i = 0; i < resources->num_channels; i++) {
+        ChannelOutput* ch = &resources->channels[i];
+
+        // Stage 1: Bring the channel to DC. The pre-processed input is left intact for the next channel.
+        complex_float_t* mixed = item->complex_pre_resample_data;
+        if (ch->nco) {
+            freq_shift_apply(ch->nco, -ch->offset_hz, item->complex_pre_resample_data, item->complex_scratch_data, frames_in);
+            mixed = item->complex_scratch_data;
+        }
+
+        // Stage 2: Resample to the common output rate.
+        complex_float_t* resampled = mixed;
+        unsigned int frames_out = frames_in;
+        if (ch->resampler) {
+            msresamp_crcf_execute(ch->resampler, (liquid_float_complex*)mixed, frames_in, (liquid_float_complex*)item->complex_resampled_data, &frames_out);
+            resampled = item->complex_resampled_data;
+        }
+        if (frames_out == 0) continue;
+
+        // Stage 3: Band-limit to the channel and convert to the output format.
+        firfilt_crcf_execute_block(ch->channel_filter, resampled, frames_out, item->complex_post_resample_data);
+        if (!convert_cf32_to_block(item->complex_post_resample_data, item->final_output_data, frames_out, config->output_format)) {
+            return false;
+        }
+        output_sink_write(&ch->sink, item->final_output_data, frames_out);
+    }
+    return true;
+}
+
+void channelizer_reset(AppResources* resources) {
+    for (int i = 0; i < resources->num_channels; i++) {
+        ChannelOutput* ch = &resources->channels[i];
+        freq_shift_reset_nco(ch->nco);
+        if (ch->resampler) msresamp_crcf_reset(ch->resampler);
+        if (ch->channel_filter) firfilt_crcf_reset(ch->channel_filter);
+    }
+}
+
+void channelizer_signal_end_of_stream(AppResources* resources) {
+    for (int i = 0; i < resources->num_channels; i++) {
+        output_sink_signal_end_of_stream(&resources->channels[i].sink);
+    }
+}
+
+void channelizer_signal_shutdown(AppResources* resources) {
+    for (int i = 0; i < resources->num_channels; i++) {
+        output_sink_signal_shutdown(&resources->channels[i].sink);
+    }
+}
+
+void channelizer_destroy(AppResources* resources) {
+    if (!resources->channels) return;
+
+    long long total_bytes = 0;
+    for (int i = 0; i < resources->num_channels; i++) {
+        ChannelOutput* ch = &resources->channels[i];
+        total_bytes += output_sink_close(&ch->sink);
+        if (ch->nco) {
+            nco_crcf_destroy(ch->nco);
+            ch->nco = NULL;
+        }
+        if (ch->resampler) {
+            msresamp_crcf_destroy(ch->resampler);
+            ch->resampler = NULL;
+        }
+        if (ch->channel_filter) {
+            firfilt_crcf_destroy(ch->channel_filter);
+            ch->channel_filter = NULL;
+        }
+    }
+    resources->final_output_size_bytes = total_bytes;
+}
@@ -0,0 +1,436 @@
+// checkpoint.c
+
+#include "checkpoint.h"
+#include "constants.h"
+#include "log.h"
+#include "input_range.h"
+#include "frequency_shift.h"
+#include "signal_handler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define CHECKPOINT_FORMAT_VERSION   2
+#define CHECKPOINT_HASH_MAX_BYTES   512
+
+#define APPEND_HASH_FIELD(buf, pos, value) \
+    do { \
+        memcpy((buf) + (pos), &(value), sizeof(value)); \
+        (pos) += sizeof(value); \
+    } while (0)
+
+static const char* _output_path(const AppConfig* config) {
+#ifdef _WIN32
+    return config->effective_output_filename_utf8;
+#else
+    return config->effective_output_filename;
+#endif
+}
+
+static long long _gcd(long long a, long long b) {
+    while (b != 0) {
+        long long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static long long _lcm(long long a, long long b) {
+    return a / _gcd(a, b) * b;
+}
+
+/**
+ * @brief Gets the input file's size and modification time, so a different or modified file is noticed.
+ */
+static void _input_identity(const AppConfig* config, int64_t* size, int64_t* mtime) {
+    *size = -1;
+    *mtime = -1;
+#ifdef _WIN32
+    struct __stat64 st;
+    if (_wstat64(config->effective_input_filename_w, &st) == 0) {
+#else
+    struct stat st;
+    if (config->effective_input_filename && stat(config->effective_input_filename, &st) == 0) {
+#endif
+        *size = (int64_t)st.st_size;
+        *mtime = (int64_t)st.st_mtime;
+    }
+}
+
+/**
+ * @brief Serializes everything that shapes the output, field by field, and hashes it (64-bit FNV-1a).
+ */
+static uint64_t _config_hash(const AppConfig* config, const AppResources* resources) {
+    unsigned char buf[CHECKPOINT_HASH_MAX_BYTES];
+    size_t pos = 0;
+
+    int64_t input_size;
+    int64_t input_mtime;
+    _input_identity(config, &input_size, &input_mtime);
+    APPEND_HASH_FIELD(buf, pos, input_size);
+    APPEND_HASH_FIELD(buf, pos, input_mtime);
+    int32_t sample_rate = resources->source_info.samplerate;
+    int32_t input_format = (int32_t)resources->input_format;
+    int64_t end_frame = resources->input_range_start_frame + resources->source_info.frames;
+    APPEND_HASH_FIELD(buf, pos, sample_rate);
+    APPEND_HASH_FIELD(buf, pos, input_format);
+    APPEND_HASH_FIELD(buf, pos, end_frame);
+    const InputTimeSpec* specs[2] = { &config->range_start, &config->range_duration };
+    for (int i = 0; i < 2; i++) {
+        uint8_t provided = specs[i]->provided;
+        uint8_t in_samples = specs[i]->in_samples;
+        int64_t samples = specs[i]->samples;
+        APPEND_HASH_FIELD(buf, pos, provided);
+        APPEND_HASH_FIELD(buf, pos, in_samples);
+        APPEND_HASH_FIELD(buf, pos, specs[i]->seconds);
+        APPEND_HASH_FIELD(buf, pos, samples);
+    }
+
+    int32_t output_format = (int32_t)config->output_format;
+    int32_t output_type = (int32_t)config->output_type;
+    uint8_t shift_after_resample = resources->stage_plan.shift_post_resample;
+    uint8_t no_resample = config->no_resample;
+    APPEND_HASH_FIELD(buf, pos, config->target_rate);
+    APPEND_HASH_FIELD(buf, pos, output_format);
+    APPEND_HASH_FIELD(buf, pos, output_type);
+    APPEND_HASH_FIELD(buf, pos, config->gain);
+    APPEND_HASH_FIELD(buf, pos, resources->actual_nco_shift_hz);
+    APPEND_HASH_FIELD(buf, pos, shift_after_resample);
+    APPEND_HASH_FIELD(buf, pos, no_resample);
+
+    uint8_t dc_block = config->dc_block.enable;
+    int32_t dc_block_mode = (int32_t)config->dc_block.mode;
+    uint8_t iq_correction = config->iq_correction.enable;
+    int32_t iq_correction_method = (int32_t)config->iq_correction.method;
+    APPEND_HASH_FIELD(buf, pos, dc_block);
+    APPEND_HASH_FIELD(buf, pos, dc_block_mode);
+    APPEND_HASH_FIELD(buf, pos, iq_correction);
+    APPEND_HASH_FIELD(buf, pos, iq_correction_method);
+
+    int32_t num_filter_requests = config->num_filter_requests;
+    APPEND_HASH_FIELD(buf, pos, num_filter_requests);
+    for (int i = 0; i < config->num_filter_requests && i < MAX_FILTER_CHAIN; i++) {
+        int32_t type = (int32_t)config->filter_requests[i].type;
+        APPEND_HASH_FIELD(buf, pos, type);
+        APPEND_HASH_FIELD(buf, pos, config->filter_requests[i].freq1_hz);
+        APPEND_HASH_FIELD(buf, pos, config->filter_requests[i].freq2_hz);
+    }
+    int32_t filter_taps = config->filter_taps_arg;
+    int32_t filter_type_request = (int32_t)config->filter_type_request;
+    int32_t filter_fft_size = config->filter_fft_size_arg;
+    APPEND_HASH_FIELD(buf, pos, filter_taps);
+    APPEND_HASH_FIELD(buf, pos, config->attenuation_db_arg);
+    APPEND_HASH_FIELD(buf, pos, config->transition_width_hz_arg);
+    APPEND_HASH_FIELD(buf, pos, filter_type_request);
+    APPEND_HASH_FIELD(buf, pos, filter_fft_size);
+
+    // What setup made of the options.
+    uint32_t user_filter_taps = resources->user_filter_num_taps;
+    int32_t user_filter_type = (int32_t)resources->user_filter_type_actual;
+    uint32_t merged_factor = resources->merged_decimation_factor;
+    uint32_t cic_factor = resources->cic.decimation_factor;
+    int32_t stages_before_resample = resources->stage_plan.stages_before_resample;
+    uint8_t filter_post_resample = resources->stage_plan.filter_post_resample;
+    uint8_t aligned = resources->checkpoint.aligned;
+    int64_t align_input_frames = resources->checkpoint.align_input_frames;
+    APPEND_HASH_FIELD(buf, pos, user_filter_taps);
+    APPEND_HASH_FIELD(buf, pos, user_filter_type);
+    APPEND_HASH_FIELD(buf, pos, merged_factor);
+    APPEND_HASH_FIELD(buf, pos, cic_factor);
+    APPEND_HASH_FIELD(buf, pos, stages_before_resample);
+    APPEND_HASH_FIELD(buf, pos, filter_post_resample);
+    APPEND_HASH_FIELD(buf, pos, aligned);
+    APPEND_HASH_FIELD(buf, pos, align_input_frames);
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < pos; i++) {
+        hash ^= buf[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Picks the grid that saved positions lie on.
+ *
+ * Every input_rate/gcd input frames produce exactly output_rate/gcd output
+ * frames; the period is widened to a multiple of the decimation factors and
+ * CHECKPOINT_ALIGN_MIN_FRAMES so those stages restart in phase too.
+ */
+static void _plan_alignment(const AppConfig* config, AppResources* resources) {
+    CheckpointState* ckpt = &resources->checkpoint;
+    long long input_rate = resources->source_info.samplerate;
+    double output_rate = config->target_rate;
+    ckpt->aligned = false;
+    ckpt->align_input_frames = 1;
+    ckpt->align_output_frames = 1;
+
+    if (input_rate > 0 && output_rate >= 1.0 && output_rate == floor(output_rate) && output_rate < 1e12) {
+        long long output_rate_int = (long long)output_rate;
+        long long gcd = _gcd(input_rate, output_rate_int);
+        long long period = _lcm(input_rate / gcd, CHECKPOINT_ALIGN_MIN_FRAMES);
+        if (resources->cic.decimation_factor > 0) period = _lcm(period, resources->cic.decimation_factor);
+        if (resources->merged_decimation_factor > 0) period = _lcm(period, resources->merged_decimation_factor);
+        if ((double)period <= CHECKPOINT_ALIGN_MAX_SECONDS * (double)input_rate) {
+            ckpt->aligned = true;
+            ckpt->align_input_frames = period;
+            ckpt->align_output_frames = period / (input_rate / gcd) * (output_rate_int / gcd);
+            log_debug("Checkpoints fall every %lld input frames (%lld output frames).", ckpt->align_input_frames, ckpt->align_output_frames);
+            return;
+        }
+    }
+    log_warn("The input and output rates have no short common period; a resumed output may be offset by a fraction of a sample where it continues.");
+}
+
+static bool _load(CheckpointState* ckpt) {
+    FILE* fp = fopen(ckpt->path, "r");
+    if (!fp) {
+        log_fatal("Cannot resume: no checkpoint could be read from '%s': %s", ckpt->path, strerror(errno));
+        return false;
+    }
+
+    int version = 0;
+    int fields = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char key[64];
+        char value[128];
+        if (line[0] == '#' || sscanf(line, " %63[^= ] = %127s", key, value) != 2) continue;
+
+        if (strcmp(key, "version") == 0) {
+            version = atoi(value);
+        } else if (strcmp(key, "config_hash") == 0) {
+            ckpt->config_hash = (uint64_t)strtoull(value, NULL, 16);
+            fields++;
+        } else if (strcmp(key, "origin_frame") == 0) {
+            ckpt->origin_frame = (int64_t)strtoll(value, NULL, 10);
+            fields++;
+        } else if (strcmp(key, "input_frame") == 0) {
+            ckpt->resume_input_frame = (int64_t)strtoll(value, NULL, 10);
+            fields++;
+        } else if (strcmp(key, "output_frames") == 0) {
+            ckpt->resume_output_frames = strtoull(value, NULL, 10);
+            fields++;
+        } else if (strcmp(key, "output_bytes") == 0) {
+            ckpt->resume_output_bytes = strtoll(value, NULL, 10);
+            fields++;
+        }
+    }
+    fclose(fp);
+
+    if (version != CHECKPOINT_FORMAT_VERSION || fields != 5 || ckpt->origin_frame < 0 ||
+        ckpt->resume_input_frame < ckpt->origin_frame || ckpt->resume_output_bytes < 0) {
+        log_fatal("The checkpoint '%s' is damaged or from another version of %s.", ckpt->path, APP_NAME);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the checkpoint to a temporary file, syncs it and renames it over the old one.
+ */
+static bool _store(const CheckpointState* ckpt, int64_t input_frame, unsigned long long output_frames, long long output_bytes) {
+    char temp_path[MAX_PATH_BUFFER + 8];
+    int written = snprintf(temp_path, sizeof(temp_path), "%s.tmp", ckpt->path);
+    if (written < 0 || (size_t)written >= sizeof(temp_path)) return false;
+
+    FILE* fp = fopen(temp_path, "w");
+    if (!fp) return false;
+    fprintf(fp, "# %s checkpoint. To continue, run the same command again with --resume.\n", APP_NAME);
+    fprintf(fp, "version=%d\n", CHECKPOINT_FORMAT_VERSION);
+    fprintf(fp, "config_hash=%016llx\n", (unsigned long long)ckpt->config_hash);
+    fprintf(fp, "origin_frame=%lld\n", (long long)ckpt->origin_frame);
+    fprintf(fp, "input_frame=%lld\n", (long long)input_frame);
+    fprintf(fp, "output_frames=%llu\n", output_frames);
+    fprintf(fp, "output_bytes=%lld\n", output_bytes);
+
+    bool ok = (fflush(fp) == 0);
+#ifdef _WIN32
+    if (ok && _commit(_fileno(fp)) != 0) ok = false;
+#else
+    if (ok && fsync(fileno(fp)) != 0) ok = false;
+#endif
+    if (fclose(fp) != 0) ok = false;
+
+#ifdef _WIN32
+    if (ok && !MoveFileExA(temp_path, ckpt->path, MOVEFILE_REPLACE_EXISTING)) ok = false;
+#else
+    if (ok && rename(temp_path, ckpt->path) != 0) ok = false;
+#endif
+    if (!ok) {
+        remove(temp_path);
+    }
+    return ok;
+}
+
+/**
+ * @brief Saves the last grid position the output has passed, after syncing the output up to it.
+ *
+ * Output written beyond that position is cut off again by the resume.
+ */
+static bool _save_current(AppResources* resources) {
+    CheckpointState* ckpt = &resources->checkpoint;
+    FileWriterContext* writer = &resources->writer_ctx;
+    if (!writer->ops.get_total_bytes_written || resources->output_bytes_per_sample_pair == 0) return false;
+
+    unsigned long long frames = (unsigned long long)writer->ops.get_total_bytes_written(writer) / resources->output_bytes_per_sample_pair;
+    // Output frames since this run's first input frame, counting those dropped for the warm-up.
+    unsigned long long grid_frames = ckpt->run_warmup_output_frames + frames;
+    int64_t input_frame;
+    if (ckpt->aligned) {
+        unsigned long long periods = grid_frames / (unsigned long long)ckpt->align_output_frames;
+        unsigned long long grid_point = periods * (unsigned long long)ckpt->align_output_frames;
+        if (grid_point < ckpt->run_warmup_output_frames) return false;
+        frames = grid_point - ckpt->run_warmup_output_frames;
+        input_frame = ckpt->run_first_frame + (int64_t)periods * ckpt->align_input_frames;
+    } else {
+        double frames_per_output_frame = (double)resources->source_info.samplerate / resources->config->target_rate;
+        input_frame = ckpt->run_first_frame + (int64_t)llround((double)grid_frames * frames_per_output_frame);
+    }
+
+    if (!writer->ops.sync || !writer->ops.sync(writer)) {
+        log_warn("Could not flush the output to disk (%s); keeping the previous checkpoint.", strerror(errno));
+        return false;
+    }
+    unsigned long long output_frames = ckpt->resume_output_frames + frames;
+    if (!_store(ckpt, input_frame, output_frames, (long long)(output_frames * resources->output_bytes_per_sample_pair))) {
+        log_warn("Could not write the checkpoint '%s': %s", ckpt->path, strerror(errno));
+        return false;
+    }
+    ckpt->saved = true;
+    log_debug("Checkpoint: %llu output frames, input frame %lld.", output_frames, (long long)input_frame);
+    return true;
+}
+
+bool checkpoint_init(const AppConfig* config, AppResources* resources) {
+    CheckpointState* ckpt = &resources->checkpoint;
+    memset(ckpt, 0, sizeof(*ckpt));
+    if (!config->checkpoint && !config->resume) {
+        return true;
+    }
+
+    ckpt->enabled = true;
+    int written = snprintf(ckpt->path, sizeof(ckpt->path), "%s%s", _output_path(config), CHECKPOINT_FILE_SUFFIX);
+    if (written < 0 || (size_t)written >= sizeof(ckpt->path)) {
+        log_fatal("The output path is too long to name its checkpoint file.");
+        return false;
+    }
+
+    if (!config->resume) {
+        FILE* existing = fopen(ckpt->path, "r");
+        if (existing) {
+            fclose(existing);
+            log_warn("Replacing the checkpoint of an earlier run; use --resume to continue that run instead.");
+        }
+        return true;
+    }
+
+    if (!_load(ckpt)) {
+        return false;
+    }
+    ckpt->resuming = true;
+    ckpt->saved = true;
+    log_info("Resuming from '%s': keeping %llu output frames, continuing from input frame %lld.",
+             ckpt->path, ckpt->resume_output_frames, (long long)ckpt->resume_input_frame);
+    return true;
+}
+
+bool checkpoint_prepare(const AppConfig* config, AppResources* resources) {
+    CheckpointState* ckpt = &resources->checkpoint;
+    if (!ckpt->enabled) {
+        return true;
+    }
+
+    _plan_alignment(config, resources);
+    uint64_t hash = _config_hash(config, resources);
+
+    if (!ckpt->resuming) {
+        ckpt->config_hash = hash;
+        ckpt->origin_frame = resources->input_range_start_frame - resources->input_warmup_frames;
+    } else {
+        if (hash != ckpt->config_hash) {
+            log_fatal("The checkpoint '%s' was saved for a different input or different processing options.", ckpt->path);
+            return false;
+        }
+        int64_t available = resources->input_range_start_frame - ckpt->origin_frame;
+        if (ckpt->aligned && available % ckpt->align_input_frames != 0) {
+            log_fatal("The checkpoint '%s' is damaged.", ckpt->path);
+            return false;
+        }
+        // The planned warm-up, rounded up onto the grid. It may reach back to where the original run began.
+        int64_t warmup = resources->input_warmup_frames;
+        if (ckpt->aligned) {
+            warmup = (warmup + ckpt->align_input_frames - 1) / ckpt->align_input_frames * ckpt->align_input_frames;
+        }
+        if (warmup > available) {
+            warmup = available;
+        }
+        resources->input_warmup_frames = warmup;
+        resources->input_warmup_frames_uncounted = warmup;
+    }
+
+    ckpt->run_first_frame = resources->input_range_start_frame - resources->input_warmup_frames;
+    ckpt->run_warmup_output_frames = input_range_warmup_output_frames(resources, config->target_rate);
+
+    if (ckpt->resuming) {
+        // The shifters continue in the phase the original run had at this run's first frame.
+        unsigned long long input_frames = (unsigned long long)(ckpt->run_first_frame - ckpt->origin_frame);
+        unsigned long long output_frames = ckpt->aligned
+            ? input_frames / (unsigned long long)ckpt->align_input_frames * (unsigned long long)ckpt->align_output_frames
+            : (unsigned long long)llround((double)input_frames * config->target_rate / (double)resources->source_info.samplerate);
+        freq_shift_advance_nco(resources->pre_resample_nco, resources->actual_nco_shift_hz,
+                               (double)resources->source_info.samplerate, input_frames);
+        freq_shift_advance_nco(resources->post_resample_nco, resources->actual_nco_shift_hz,
+                               config->target_rate, output_frames);
+    }
+    return true;
+}
+
+void checkpoint_on_output_written(AppResources* resources) {
+    CheckpointState* ckpt = &resources->checkpoint;
+    if (!ckpt->enabled) {
+        return;
+    }
+    // The first write saves straight away, replacing any checkpoint of an earlier run.
+    time_t now = time(NULL);
+    if (ckpt->last_save_time != 0 && difftime(now, ckpt->last_save_time) < CHECKPOINT_INTERVAL_SECONDS) {
+        return;
+    }
+    ckpt->last_save_time = now;
+    _save_current(resources);
+}
+
+void checkpoint_on_writer_exit(AppResources* resources) {
+    CheckpointState* ckpt = &resources->checkpoint;
+    if (!ckpt->enabled || (!is_shutdown_requested() && !resources->error_occurred)) {
+        return;
+    }
+    _save_current(resources);
+    if (ckpt->saved) {
+        log_info("Run the same command with --resume to continue this output.");
+    }
+}
+
+void checkpoint_finish(AppResources* resources) {
+    CheckpointState* ckpt = &resources->checkpoint;
+    if (!ckpt->enabled || !resources->end_of_stream_reached || resources->error_occurred || is_shutdown_requested()) {
+        return;
+    }
+    if (remove(ckpt->path) != 0 && errno != ENOENT) {
+        log_warn("Could not remove the checkpoint '%s': %s", ckpt->path, strerror(errno));
+    }
+}
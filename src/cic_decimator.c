@@ -0,0 +1,250 @@
+// cic_decimator.c
+
+#include "cic_decimator.h"
+#include "constants.h"
+#include "log.h"
+#include "memory_arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <liquid.h>
+#else
+#include <liquid/liquid.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Frequency grid used to design the droop compensation filter.
+#define CIC_COMPENSATION_DESIGN_POINTS 512
+
+/**
+ * @brief Returns the factor that maps a widened input integer to [-1.0, 1.0], or 0 if
+ *        the format is not integer I/Q. Unsigned samples are doubled when widened, so
+ *        their midpoint lands exactly on zero, and get half the normalizer.
+ */
+static double _input_normalizer(format_t format) {
+    switch (format) {
+        case CS8:     return 1.0 / 128.0;
+        case CU8:     return 1.0 / 256.0;
+        case CS16:    return 1.0 / 32768.0;
+        case CU16:    return 1.0 / 65536.0;
+        case SC16Q11: return 1.0 / 2048.0;
+        case CS12:    return 1.0 / 2048.0;
+        case CS32:    return 1.0 / 2147483648.0;
+        case CU32:    return 1.0 / 4294967296.0;
+        default:      return 0.0;
+    }
+}
+
+/**
+ * @brief Widens raw interleaved I/Q samples to signed 64-bit integers, centering unsigned formats.
+ */
+static void _widen_input(const void* input_buffer, size_t num_values, format_t format, int64_t* out) {
+    size_t i;
+    switch (format) {
+        case CS8: {
+            const int8_t* in = (const int8_t*)input_buffer;
+            for (i = 0; i < num_values; ++i) out[i] = in[i];
+            break;
+        }
+        case CU8: {
+            const uint8_t* in = (const uint8_t*)input_buffer;
+            for (i = 0; i < num_values; ++i) out[i] = 2 * (int64_t)in[i] - UINT8_MAX;
+            break;
+        }
+        case CS16:
+        case SC16Q11: {
+            const int16_t* in = (const int16_t*)input_buffer;
+            for (i = 0; i < num_values; ++i) out[i] = in[i];
+            break;
+        }
+        case CU16: {
+            const uint16_t* in = (const uint16_t*)input_buffer;
+            for (i = 0; i < num_values; ++i) out[i] = 2 * (int64_t)in[i] - UINT16_MAX;
+            break;
+        }
+        case CS12: {
+            // Two values per 3 bytes; see sample_convert.c for the layout.
+            const uint8_t* in = (const uint8_t*)input_buffer;
+            for (i = 0; i + 1 < num_values; i += 2) {
+                const uint8_t* p = in + (i / 2) * 3;
+                int64_t i_bits = (int64_t)p[0] | ((int64_t)(p[1] & 0x0F) << 8);
+                int64_t q_bits = (int64_t)(p[1] >> 4) | ((int64_t)p[2] << 4);
+                out[i]     = (i_bits ^ 0x800) - 0x800;
+                out[i + 1] = (q_bits ^ 0x800) - 0x800;
+            }
+            break;
+        }
+        case CS32: {
+            const int32_t* in = (const int32_t*)input_buffer;
+            for (i = 0; i < num_values; ++i) out[i] = in[i];
+            break;
+        }
+        case CU32: {
+            const uint32_t* in = (const uint32_t*)input_buffer;
+            for (i = 0; i < num_values; ++i) out[i] = 2 * (int64_t)in[i] - (int64_t)UINT32_MAX;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Magnitude response of the CIC at frequency `f`, in cycles per output sample.
+ */
+static double _cic_response(double f, unsigned int factor) {
+    if (f < 1e-12) return 1.0;
+    double ratio = sin(M_PI * f) / ((double)factor * sin(M_PI * f / (double)factor));
+    return pow(fabs(ratio), CIC_STAGES);
+}
+
+/**
+ * @brief Designs the FIR that inverts the CIC's droop up to `passband_edge`.
+ *
+ * The target response is 1/H(f) across the passband and is held at its edge
+ * value above it, where the resampler removes everything anyway. Taps come from
+ * the Hamming-windowed inverse transform of that target, normalized to unity DC gain.
+ */
+static firfilt_crcf _design_compensator(unsigned int factor, double passband_edge) {
+    float taps[CIC_COMPENSATION_TAPS];
+    double center = (CIC_COMPENSATION_TAPS - 1) / 2.0;
+    double df = 0.5 / CIC_COMPENSATION_DESIGN_POINTS;
+    double dc_gain = 0.0;
+
+    for (unsigned int n = 0; n < CIC_COMPENSATION_TAPS; n++) {
+        double acc = 0.0;
+        for (unsigned int k = 0; k < CIC_COMPENSATION_DESIGN_POINTS; k++) {
+            double f = (k + 0.5) * df;
+            double target = 1.0 / _cic_response(fmin(f, passband_edge), factor);
+            acc += target * cos(2.0 * M_PI * f * ((double)n - center));
+        }
+        double window = 0.54 - 0.46 * cos(2.0 * M_PI * n / (CIC_COMPENSATION_TAPS - 1));
+        taps[n] = (float)(2.0 * acc * df * window);
+        dc_gain += taps[n];
+    }
+
+    if (fabs(dc_gain) < FILTER_GAIN_ZERO_THRESHOLD) dc_gain = 1.0;
+    for (unsigned int n = 0; n < CIC_COMPENSATION_TAPS; n++) {
+        taps[n] = (float)(taps[n] / dc_gain);
+    }
+    return firfilt_crcf_create(taps, CIC_COMPENSATION_TAPS);
+}
+
+unsigned int cic_decimator_plan_factor(const AppConfig* config, const AppResources* resources) {
+    if (resources->is_passthrough || config->num_channels > 0 || config->num_extra_outputs > 0 ||
+        _input_normalizer(resources->input_format) == 0.0 || config->target_rate <= 0.0) {
+        return 0;
+    }
+    double factor_d = floor((double)resources->source_info.samplerate / (config->target_rate * CIC_MIN_OVERSAMPLE));
+    if (factor_d < CIC_MIN_DECIMATION) return 0;
+    if (factor_d > CIC_MAX_DECIMATION) factor_d = CIC_MAX_DECIMATION;
+    return (unsigned int)factor_d;
+}
+
+bool cic_decimator_create(AppConfig* config, AppResources* resources, float* resample_ratio) {
+    CicDecimatorResources* cic = &resources->cic;
+    memset(cic, 0, sizeof(*cic));
+
+    // Everything ahead of the resampler that needs the full input rate rules the front end out.
+    if (resources->pre_resample_nco || resources->merged_decimation_factor > 0 ||
+        (config->num_filter_requests > 0 && !resources->stage_plan.filter_post_resample)) {
+        return true;
+    }
+    unsigned int factor = cic_decimator_plan_factor(config, resources);
+    if (factor == 0) return true;
+
+    double normalizer = _input_normalizer(resources->input_format);
+    double input_rate = (double)resources->source_info.samplerate;
+
+    double cic_rate = input_rate / factor;
+    double passband_edge = (config->target_rate / 2.0) / cic_rate;
+
+    cic->compensator = _design_compensator(factor, passband_edge);
+    if (!cic->compensator) {
+        log_fatal("CIC: Failed to create the droop compensation filter.");
+        return false;
+    }
+    cic->widened = (int64_t*)mem_arena_alloc(&resources->setup_arena, PRE_PROCESS_TILE_SAMPLES * 2 * sizeof(int64_t));
+    if (!cic->widened) return false;
+
+    cic->output_scale = (float)(normalizer * config->gain / pow((double)factor, CIC_STAGES));
+    cic->decimation_factor = factor;
+    *resample_ratio = (float)(config->target_rate / cic_rate);
+
+    log_info("CIC front end enabled: decimating by %u before resampling.", factor);
+    log_debug("CIC: %d stages, %.1f Hz intermediate rate, %.2f dB droop at the passband edge, resampler ratio %.6f.",
+              CIC_STAGES, cic_rate, 20.0 * log10(_cic_response(passband_edge, factor)), *resample_ratio);
+    return true;
+}
+
+double cic_decimator_output_rate(const AppResources* resources) {
+    double input_rate = (double)resources->source_info.samplerate;
+    return (resources->cic.decimation_factor > 0) ? input_rate / resources->cic.decimation_factor : input_rate;
+}
+
+size_t cic_decimator_process(AppResources* resources, const void* input_buffer, size_t num_frames, complex_float_t* output_buffer) {
+    CicDecimatorResources* cic = &resources->cic;
+    const unsigned char* raw = (const unsigned char*)input_buffer;
+    const unsigned int factor = cic->decimation_factor;
+    const float scale = cic->output_scale;
+    size_t produced = 0;
+
+    for (size_t block_start = 0; block_start < num_frames; block_start += PRE_PROCESS_TILE_SAMPLES) {
+        size_t block_len = num_frames - block_start;
+        if (block_len > PRE_PROCESS_TILE_SAMPLES) block_len = PRE_PROCESS_TILE_SAMPLES;
+        _widen_input(raw + block_start * resources->input_bytes_per_sample_pair, block_len * 2, resources->input_format, cic->widened);
+
+        // Unsigned arithmetic wraps without undefined behavior. The integrators may
+        // overflow, but the comb output is exact as long as it fits in 64 bits.
+        for (size_t i = 0; i < block_len; i++) {
+            cic->integrators[0][0] += (uint64_t)cic->widened[i * 2];
+            cic->integrators[0][1] += (uint64_t)cic->widened[i * 2 + 1];
+            for (int s = 1; s < CIC_STAGES; s++) {
+                cic->integrators[s][0] += cic->integrators[s - 1][0];
+                cic->integrators[s][1] += cic->integrators[s - 1][1];
+            }
+            if (++cic->phase < factor) continue;
+            cic->phase = 0;
+
+            uint64_t vi = cic->integrators[CIC_STAGES - 1][0];
+            uint64_t vq = cic->integrators[CIC_STAGES - 1][1];
+            for (int s = 0; s < CIC_STAGES; s++) {
+                uint64_t prev_i = cic->comb_delays[s][0];
+                uint64_t prev_q = cic->comb_delays[s][1];
+                cic->comb_delays[s][0] = vi;
+                cic->comb_delays[s][1] = vq;
+                vi -= prev_i;
+                vq -= prev_q;
+            }
+            output_buffer[produced++] = ((float)(int64_t)vi * scale) + I * ((float)(int64_t)vq * scale);
+        }
+    }
+
+    if (produced > 0) {
+        firfilt_crcf_execute_block(cic->compensator, output_buffer, (unsigned int)produced, output_buffer);
+    }
+    return produced;
+}
+
+void cic_decimator_reset(AppResources* resources) {
+    CicDecimatorResources* cic = &resources->cic;
+    if (cic->decimation_factor == 0) return;
+    cic->phase = 0;
+    memset(cic->integrators, 0, sizeof(cic->integrators));
+    memset(cic->comb_delays, 0, sizeof(cic->comb_delays));
+    firfilt_crcf_reset(cic->compensator);
+}
+
+void cic_decimator_destroy(AppResources* resources) {
+    CicDecimatorResources* cic = &resources->cic;
+    if (cic->compensator) {
+        firfilt_crcf_destroy(cic->compensator);
+        cic->compensator = NULL;
+    }
+    cic->decimation_factor = 0;
+}
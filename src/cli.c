@@ -17,6 +17,7 @@
 #include "argparse.h"
 #include "input_manager.h"
 #include "memory_arena.h"
+#include "batch.h"
 
 #ifdef _WIN32
 #define strcasecmp _stricmp
@@ -27,7 +28,7 @@
 extern AppConfig g_config;
 
 // MODIFIED: Moved these definitions to file scope to be accessible by all functions.
-#define MAX_STATIC_OPTIONS 128
+#define MAX_STATIC_OPTIONS 160
 #define MAX_TOTAL_OPTIONS (MAX_STATIC_OPTIONS + MAX_PRESETS)
 
 // --- Forward Declarations ---
@@ -42,6 +43,7 @@ void print_usage(const char *prog_name, AppConfig *config, MemoryArena* arena) {
     struct argparse_option all_options[MAX_TOTAL_OPTIONS];
     const char *const usages[] = {
         "iq_resample_tool -i <type> [input_file] [options]",
+        "iq_resample_tool -i <type> --batch-output <template> [input_files...] [options]",
         NULL,
     };
 
@@ -69,6 +71,11 @@ static int version_cb(struct argparse *self, const struct argparse_option *optio
 static int build_cli_options(struct argparse_option* options_buffer, int max_options, AppConfig* config, MemoryArena* arena) {
     int total_opts = 0;
 
+    #define DEFINE_EXTRA_OUTPUT_OPTIONS(suffix, idx) \
+        OPT_STRING(0, "file" suffix,                 &g_config.extra_outputs[idx].filename_arg, NULL, NULL, 0, 0), \
+        OPT_STRING(0, "output-container" suffix,     &g_config.extra_outputs[idx].output_type_name, NULL, NULL, 0, 0), \
+        OPT_STRING(0, "output-sample-format" suffix, &g_config.extra_outputs[idx].sample_type_name, NULL, NULL, 0, 0), \
+        OPT_FLOAT( 0, "output-rate" suffix,          &g_config.extra_outputs[idx].target_rate_arg, NULL, NULL, 0, 0)
     static const struct argparse_option generic_options[] = {
         OPT_GROUP("Required Input & Output"),
         OPT_STRING('i', "input", &g_config.input_type_str, "Specifies the input type {wav|raw-file|rtlsdr|sdrplay|hackrf|bladerf}", NULL, 0, 0),
@@ -77,16 +84,41 @@ static int build_cli_options(struct argparse_option* options_buffer, int max_opt
         OPT_GROUP("Output Options"),
         OPT_STRING(0, "output-container", &g_config.output_type_name, "Specifies the output file container format {raw|wav|wav-rf64}", NULL, 0, 0),
         OPT_STRING(0, "output-sample-format", &g_config.sample_type_name, "Sample format for output data {cs8|cu8|cs16|...}", NULL, 0, 0),
+        OPT_BOOLEAN(0, "direct-io", &g_config.direct_io, "(Linux) Write output files with O_DIRECT, bypassing the page cache.", NULL, 0, 0),
+        OPT_FLOAT(0, "segment-size", &g_config.segment_size_mb_arg, "Split the output into numbered files (<name>_0001.wav, ...) of at most <MB> megabytes.", NULL, 0, 0),
+        OPT_FLOAT(0, "segment-duration", &g_config.segment_duration_sec_arg, "Split the output into numbered files of at most <sec> seconds each.", NULL, 0, 0),
+        OPT_GROUP("Additional Outputs (Up to 4 more files from the same input, using suffixes -2 to -5, e.g., --file-2 archive.wav --output-sample-format-2 cs16)"),
+        OPT_STRING(0, "file-2", &g_config.extra_outputs[0].filename_arg, "Write an additional output file.", NULL, 0, 0),
+        OPT_STRING(0, "output-container-2", &g_config.extra_outputs[0].output_type_name, "Container for the additional output {raw|wav|wav-rf64}. (Default: wav-rf64)", NULL, 0, 0),
+        OPT_STRING(0, "output-sample-format-2", &g_config.extra_outputs[0].sample_type_name, "Sample format for the additional output. (Default: cs16)", NULL, 0, 0),
+        OPT_FLOAT(0, "output-rate-2", &g_config.extra_outputs[0].target_rate_arg, "Sample rate of the additional output in Hz. (Default: main output rate)", NULL, 0, 0),
+        DEFINE_EXTRA_OUTPUT_OPTIONS("-3", 1),
+        DEFINE_EXTRA_OUTPUT_OPTIONS("-4", 2),
+        DEFINE_EXTRA_OUTPUT_OPTIONS("-5", 3),
+        OPT_GROUP("Batch Processing (Many input files, one output each; inputs are given as arguments, wildcards allowed)"),
+        OPT_STRING(0, "batch-output", &g_config.batch_output_template_arg, "Output path template using {name} (input name without extension) and/or {index}, e.g. 'out/{name}.wav'.", NULL, 0, 0),
+        OPT_STRING(0, "batch-list", &g_config.batch_list_arg, "Also read input files from a list, one path per line.", NULL, 0, 0),
+        OPT_INTEGER(0, "batch-jobs", &g_config.batch_jobs_arg, "Number of files processed at the same time (also for --serve). Default: 1.", NULL, 0, 0),
+        OPT_STRING(0, "serve", &g_config.serve_socket_arg, "(POSIX) Run as a job server on this UNIX socket path. Jobs name their input and output files.", NULL, 0, 0),
         OPT_GROUP("Processing Options"),
         OPT_FLOAT(0, "output-rate", &g_config.user_defined_target_rate_arg, "Output sample rate in Hz. (Required if no preset or --no-resample is used)", NULL, 0, 0),
         OPT_FLOAT(0, "gain-multiplier", &g_config.gain, "Apply a linear gain multiplier to the samples", NULL, 0, 0),
         OPT_FLOAT(0, "freq-shift", &g_config.freq_shift_hz_arg, "Apply a direct frequency shift in Hz (e.g., -100e3)", NULL, 0, 0),
-        OPT_BOOLEAN(0, "shift-after-resample", &g_config.shift_after_resample, "Apply frequency shift AFTER resampling (default is before)", NULL, 0, 0),
+        OPT_BOOLEAN(0, "shift-after-resample", &g_config.shift_after_resample, "Force the frequency shift AFTER resampling (default: chosen by the stage planner)", NULL, 0, 0),
+        OPT_STRING(0, "stage-order", &g_config.stage_order_str_arg, "Pin stage placement, e.g. 'dc,shift,resample,filter'. Unlisted stages are placed automatically.", NULL, 0, 0),
         OPT_BOOLEAN(0, "no-resample", &g_config.no_resample, "Process at native input rate. Bypasses the resampler but applies all other DSP.", NULL, 0, 0),
         OPT_BOOLEAN(0, "raw-passthrough", &g_config.raw_passthrough, "Bypass all processing. Copies raw input bytes directly to output.", NULL, 0, 0),
+        OPT_INTEGER(0, "read-ahead", &g_config.read_ahead_mb, "MB of file input to keep prefetched ahead of the reader (0 disables). Default: 32.", NULL, 0, 0),
+        OPT_STRING(0, "start", &g_config.start_arg, "(File input) Start this far into the input: seconds, [hh:]mm:ss, or samples with 'smp' (e.g. 4800000smp).", NULL, 0, 0),
+        OPT_STRING(0, "duration", &g_config.duration_arg, "(File input) Process only this much of the input, in the same units as --start.", NULL, 0, 0),
+        OPT_BOOLEAN(0, "checkpoint", &g_config.checkpoint, "(File input) Save progress to <file>.ckpt every 30 s so an interrupted run can be resumed.", NULL, 0, 0),
+        OPT_BOOLEAN(0, "resume", &g_config.resume, "Continue an interrupted --checkpoint run: repeat its command with --resume added.", NULL, 0, 0),
         OPT_BOOLEAN(0, "iq-correction", &g_config.iq_correction.enable, "(Optional) Enable automatic I/Q imbalance correction.", NULL, 0, 0),
+        OPT_STRING(0, "iq-correction-method", &g_config.iq_correction.method_str_arg, "I/Q estimator: 'search' (spectral random walk) or 'stats' (closed-form). Default: search.", NULL, 0, 0),
         OPT_BOOLEAN(0, "dc-block", &g_config.dc_block.enable, "(Optional) Enable DC offset removal (high-pass filter).", NULL, 0, 0),
+        OPT_STRING(0, "dc-block-mode", &g_config.dc_block.mode_str_arg, "DC removal method: 'iir' (high-pass filter) or 'mean' (cheaper block-mean subtraction). Default: iir.", NULL, 0, 0),
         OPT_STRING(0, "preset", &g_config.preset_name, "Use a preset for a common target.", NULL, 0, 0),
+        OPT_STRING(0, "channels", &g_config.channels_str_arg, "Extract channels in one pass, one file each (<file>_chN). Format: 'offset_hz:bandwidth_hz[,...]'.", NULL, 0, 0),
     };
 
     #define DEFINE_CHAINABLE_FLOAT_OPTION(name, var, help_text) \
@@ -114,6 +146,8 @@ static int build_cli_options(struct argparse_option* options_buffer, int max_opt
         OPT_GROUP("Filter Implementation Options (Advanced)"),
         OPT_STRING(0, "filter-type", &g_config.filter_type_str_arg, "Set filter implementation {fir|fft}. (Default: auto).", NULL, 0, 0),
         OPT_INTEGER(0, "filter-fft-size", &g_config.filter_fft_size_arg, "Set FFT size for 'fft' filter type. Must be a power of 2.", NULL, 0, 0),
+        OPT_INTEGER(0, "filter-threads", &g_config.filter_threads_arg, "Threads for FFT filtering (0 = one per core, 1 = single-threaded). Default: 0.", NULL, 0, 0),
+        OPT_BOOLEAN(0, "no-filter-cache", &g_config.no_filter_cache, "Always redesign filter taps instead of loading them from the on-disk cache.", NULL, 0, 0),
     };
 
     #if defined(ANY_SDR_SUPPORT_ENABLED)
@@ -191,7 +225,8 @@ bool parse_arguments(int argc, char *argv[], AppConfig *config, MemoryArena* are
     }
 
     struct argparse argparse;
-    const char *const usages[] = { "iq_resample_tool -i <type> [input_file] [options]", NULL, };
+    const char *const usages[] = { "iq_resample_tool -i <type> [input_file] [options]",
+                                   "iq_resample_tool -i <type> --batch-output <template> [input_files...] [options]", NULL, };
     argparse_init(&argparse, all_options, usages, 0);
     argparse_describe(&argparse, "\nResamples an I/Q file or a stream from an SDR device to a specified format and sample rate.", NULL);
     int non_opt_argc = argparse_parse(&argparse, argc, (const char **)argv);
@@ -220,7 +255,30 @@ static bool validate_and_process_args(AppConfig *config, int non_opt_argc, const
     bool is_file_input = (strcasecmp(config->input_type_str, "wav") == 0 ||
                           strcasecmp(config->input_type_str, "raw-file") == 0);
 
-    if (is_file_input) {
+    if (config->serve_socket_arg) {
+        if (!is_file_input) {
+            log_fatal("Server mode requires file input ('--input wav' or '--input raw-file').");
+            return false;
+        }
+        if (non_opt_argc > 0) {
+            log_fatal("Unexpected argument '%s': in server mode each job names its own input file.", non_opt_argv[0]);
+            return false;
+        }
+        if (!validate_server_options(config)) return false;
+        // Each job starts from the options as given, before validation resolves them.
+        AppConfig* base = (AppConfig*)mem_arena_alloc(arena, sizeof(AppConfig));
+        if (!base) return false;
+        *base = *config;
+        config->server_base_config = base;
+        // Validate once now, so a bad option is reported at startup instead of by every job.
+        config->output_filename_arg = (char*)"job-output";
+    } else if (config->batch_output_template_arg || config->batch_list_arg) {
+        if (!is_file_input) {
+            log_fatal("Batch mode requires file input ('--input wav' or '--input raw-file').");
+            return false;
+        }
+        if (!batch_collect_inputs(config, non_opt_argc, non_opt_argv, arena)) return false;
+    } else if (is_file_input) {
         if (non_opt_argc == 0) {
             log_fatal("Missing <file_path> argument for '--input %s'.", config->input_type_str);
             return false;
@@ -237,6 +295,16 @@ static bool validate_and_process_args(AppConfig *config, int non_opt_argc, const
         }
     }
 
+    return cli_validate_options(config, arena);
+}
+
+bool cli_validate_options(AppConfig *config, MemoryArena* arena) {
+    InputSourceOps* selected_ops = get_input_ops_by_name(config->input_type_str, arena);
+    if (!selected_ops) {
+        log_fatal("Invalid input type '%s'.", config->input_type_str);
+        return false;
+    }
+
     // 3. Post-process SDR arguments
     config->frequency_shift_request.type = FREQUENCY_SHIFT_REQUEST_NONE;
 
@@ -253,12 +321,19 @@ static bool validate_and_process_args(AppConfig *config, int non_opt_argc, const
 
     // 4. Call all validation functions from the config module in the correct order
     if (selected_ops->validate_options && !selected_ops->validate_options(config)) return false;
+    if (!validate_batch_options(config)) return false;
     if (!validate_output_destination(config)) return false;
     if (!validate_output_type_and_sample_format(config)) return false;
+    if (!validate_segment_options(config)) return false;
+    if (!validate_input_range_options(config)) return false;
     if (selected_ops->validate_generic_options && !selected_ops->validate_generic_options(config)) return false;
     if (!validate_filter_options(config)) return false;
     if (!resolve_frequency_shift_options(config)) return false;
     if (!validate_iq_correction_options(config)) return false;
+    if (!validate_channel_options(config)) return false;
+    if (!validate_extra_output_options(config)) return false;
+    if (!validate_checkpoint_options(config)) return false;
+    if (!validate_stage_order_option(config)) return false;
     if (!validate_logical_consistency(config)) return false;
 
     return true;
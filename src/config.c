@@ -4,6 +4,8 @@
 #include "constants.h"
 #include "log.h"
 #include "utils.h"
+#include "stage_planner.h"
+#include "input_range.h"
 #include <string.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -71,6 +73,160 @@ bool validate_output_destination(AppConfig *config) {
         log_fatal("Must specify an output destination: --stdout or --file <file>.");
         return false;
     }
+    if (config->direct_io) {
+#ifndef __linux__
+        log_fatal("Option --direct-io is only supported on Linux.");
+        return false;
+#else
+        if (config->output_to_stdout) {
+            log_fatal("Option --direct-io cannot be used with --stdout.");
+            return false;
+        }
+#endif
+    }
+    return true;
+}
+
+/**
+ * @brief Checks the options shared by batch and server mode, which write one output per input file.
+ */
+static bool _validate_multi_file_options(const AppConfig *config, const char* mode_name) {
+    for (int i = 0; i < MAX_EXTRA_OUTPUTS; i++) {
+        if (config->extra_outputs[i].filename_arg) {
+            log_fatal("Additional outputs (--file-%d) cannot be used in %s.", i + 2, mode_name);
+            return false;
+        }
+    }
+    if (config->channels_str_arg || config->segment_size_mb_arg != 0.0f || config->segment_duration_sec_arg != 0.0f) {
+        log_fatal("Options --channels, --segment-size and --segment-duration cannot be used in %s.", mode_name);
+        return false;
+    }
+    if (config->batch_jobs_arg < 0 || config->batch_jobs_arg > BATCH_MAX_JOBS) {
+        log_fatal("Option --batch-jobs must be between 1 and %d.", BATCH_MAX_JOBS);
+        return false;
+    }
+    return true;
+}
+
+bool validate_batch_options(AppConfig *config) {
+    if (!config->batch_mode) {
+        return true;
+    }
+    if (!config->batch_output_template_arg) {
+        log_fatal("Batch mode requires --batch-output <template> to name the output files.");
+        return false;
+    }
+    if (!strstr(config->batch_output_template_arg, "{name}") && !strstr(config->batch_output_template_arg, "{index}")) {
+        log_fatal("The --batch-output template must contain {name} or {index}, so each input gets its own output file.");
+        return false;
+    }
+    if (config->output_filename_arg || config->output_to_stdout) {
+        log_fatal("Options --file and --stdout cannot be used in batch mode; outputs are named by --batch-output.");
+        return false;
+    }
+    if (!_validate_multi_file_options(config, "batch mode")) {
+        return false;
+    }
+    // The template stands in for the output file during validation; it has the same extension.
+    config->output_filename_arg = (char*)config->batch_output_template_arg;
+    return true;
+}
+
+bool validate_server_options(AppConfig *config) {
+#ifdef _WIN32
+    log_fatal("Option --serve is not supported on Windows.");
+    return false;
+#else
+    if (config->batch_output_template_arg || config->batch_list_arg) {
+        log_fatal("Option --serve cannot be combined with --batch-output or --batch-list.");
+        return false;
+    }
+    if (config->output_filename_arg || config->output_to_stdout) {
+        log_fatal("Options --file and --stdout cannot be used with --serve; each job names its output file.");
+        return false;
+    }
+    if (!_validate_multi_file_options(config, "server mode")) {
+        return false;
+    }
+    config->server_mode = true;
+    return true;
+#endif
+}
+
+bool validate_input_range_options(AppConfig *config) {
+    memset(&config->range_start, 0, sizeof(config->range_start));
+    memset(&config->range_duration, 0, sizeof(config->range_duration));
+    if (!config->start_arg && !config->duration_arg) {
+        return true;
+    }
+
+    if (strcasecmp(config->input_type_str, "wav") != 0 && strcasecmp(config->input_type_str, "raw-file") != 0) {
+        log_fatal("Options --start and --duration require file input ('--input wav' or '--input raw-file').");
+        return false;
+    }
+    if (config->start_arg && !input_range_parse_time(config->start_arg, &config->range_start)) {
+        log_fatal("Invalid value for --start: '%s'. Use seconds (90.5), a clock time (1:30) or a sample count (4800000smp).", config->start_arg);
+        return false;
+    }
+    if (config->duration_arg) {
+        if (!input_range_parse_time(config->duration_arg, &config->range_duration)) {
+            log_fatal("Invalid value for --duration: '%s'. Use seconds (90.5), a clock time (1:30) or a sample count (4800000smp).", config->duration_arg);
+            return false;
+        }
+        if (config->range_duration.seconds == 0.0 && config->range_duration.samples == 0) {
+            log_fatal("Option --duration must be greater than zero.");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool validate_checkpoint_options(AppConfig *config) {
+    if (!config->checkpoint && !config->resume) {
+        return true;
+    }
+    if (config->batch_mode || config->serve_socket_arg) {
+        log_fatal("Options --checkpoint and --resume cannot be used in batch or server mode.");
+        return false;
+    }
+    if (strcasecmp(config->input_type_str, "wav") != 0 && strcasecmp(config->input_type_str, "raw-file") != 0) {
+        log_fatal("Options --checkpoint and --resume require file input ('--input wav' or '--input raw-file').");
+        return false;
+    }
+    if (config->output_to_stdout) {
+        log_fatal("Options --checkpoint and --resume require file output (--file).");
+        return false;
+    }
+    if (config->num_channels > 0 || config->num_extra_outputs > 0 ||
+        config->segment_size_mb_arg > 0.0f || config->segment_duration_sec_arg > 0.0f) {
+        log_fatal("Options --checkpoint and --resume need a single output file; they cannot be combined with --channels, --file-2 ... or segments.");
+        return false;
+    }
+    if (config->raw_passthrough || config->direct_io) {
+        log_fatal("Options --checkpoint and --resume cannot be combined with --raw-passthrough or --direct-io.");
+        return false;
+    }
+    // A resumed run keeps saving checkpoints, so it can be interrupted again.
+    config->checkpoint = true;
+    return true;
+}
+
+bool validate_segment_options(AppConfig *config) {
+    if (config->segment_size_mb_arg == 0.0f && config->segment_duration_sec_arg == 0.0f) {
+        return true;
+    }
+    if (config->segment_size_mb_arg < 0.0f || config->segment_duration_sec_arg < 0.0f) {
+        log_fatal("Options --segment-size and --segment-duration must be positive.");
+        return false;
+    }
+    if (config->output_to_stdout) {
+        log_fatal("Options --segment-size and --segment-duration require file output (--file).");
+        return false;
+    }
+    if (config->direct_io) {
+        log_fatal("Option --direct-io cannot be combined with --segment-size or --segment-duration.");
+        return false;
+    }
     return true;
 }
 
@@ -274,10 +430,214 @@ bool validate_iq_correction_options(AppConfig *config) {
             return false;
         }
     }
+
+    config->iq_correction.method = IQ_CORRECTION_METHOD_SEARCH;
+    if (config->iq_correction.method_str_arg) {
+        if (!config->iq_correction.enable) {
+            log_fatal("Option --iq-correction-method requires --iq-correction.");
+            return false;
+        }
+        if (strcasecmp(config->iq_correction.method_str_arg, "search") == 0) {
+            config->iq_correction.method = IQ_CORRECTION_METHOD_SEARCH;
+        } else if (strcasecmp(config->iq_correction.method_str_arg, "stats") == 0) {
+            config->iq_correction.method = IQ_CORRECTION_METHOD_STATS;
+        } else {
+            log_fatal("Invalid value for --iq-correction-method: '%s'. Must be 'search' or 'stats'.", config->iq_correction.method_str_arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool validate_channel_options(AppConfig *config) {
+    config->num_channels = 0;
+    if (!config->channels_str_arg) return true;
+
+    char list_buf[MAX_LINE_LENGTH];
+    if (strlen(config->channels_str_arg) >= sizeof(list_buf)) {
+        log_fatal("The --channels list is too long.");
+        return false;
+    }
+    strcpy(list_buf, config->channels_str_arg);
+
+    char* next_entry = list_buf;
+    while (next_entry) {
+        char* entry = next_entry;
+        char* comma = strchr(entry, ',');
+        if (comma) {
+            *comma = '\0';
+            next_entry = comma + 1;
+        } else {
+            next_entry = NULL;
+        }
+        if (config->num_channels >= MAX_CHANNELS) {
+            log_fatal("Too many channels in --channels. At most %d are supported.", MAX_CHANNELS);
+            return false;
+        }
+        char* endptr;
+        double offset_hz = strtod(entry, &endptr);
+        if (endptr == entry || *endptr != ':') {
+            log_fatal("Invalid channel '%s' in --channels. Expected 'offset_hz:bandwidth_hz'.", entry);
+            return false;
+        }
+        char* bw_str = endptr + 1;
+        double bandwidth_hz = strtod(bw_str, &endptr);
+        if (endptr == bw_str || *endptr != '\0') {
+            log_fatal("Invalid channel '%s' in --channels. Expected 'offset_hz:bandwidth_hz'.", entry);
+            return false;
+        }
+        if (!isfinite(offset_hz) || !isfinite(bandwidth_hz) || bandwidth_hz <= 0.0) {
+            log_fatal("Invalid channel '%s' in --channels. The bandwidth must be a positive value.", entry);
+            return false;
+        }
+        config->channel_requests[config->num_channels].offset_hz = offset_hz;
+        config->channel_requests[config->num_channels].bandwidth_hz = bandwidth_hz;
+        config->num_channels++;
+    }
+
+    if (config->num_channels == 0) {
+        log_fatal("Option --channels requires at least one 'offset_hz:bandwidth_hz' entry.");
+        return false;
+    }
+
+    // Each channel gets its own file, tuning and band-limiting, so the
+    // single-output options that do the same job cannot be combined with it.
+    if (config->output_to_stdout) {
+        log_fatal("Option --channels writes one file per channel and cannot be used with --stdout.");
+        return false;
+    }
+    if (config->raw_passthrough) {
+        log_fatal("Option --channels cannot be used with --raw-passthrough.");
+        return false;
+    }
+    if (config->num_filter_requests > 0) {
+        log_fatal("Option --channels cannot be used with filtering options. Each channel is filtered to its own bandwidth.");
+        return false;
+    }
+    if (config->freq_shift_requested) {
+        log_fatal("Option --channels cannot be used with frequency shifting options. Set each channel's offset instead.");
+        return false;
+    }
+    return true;
+}
+
+bool validate_extra_output_options(AppConfig *config) {
+    config->num_extra_outputs = 0;
+
+    for (int i = 0; i < MAX_EXTRA_OUTPUTS; i++) {
+        ExtraOutputConfig extra = config->extra_outputs[i];
+        int output_number = i + 2;
+
+        if (!extra.filename_arg) {
+            if (extra.output_type_name || extra.sample_type_name || extra.target_rate_arg != 0.0f) {
+                log_fatal("Options for output %d were given without --file-%d.", output_number, output_number);
+                return false;
+            }
+            continue;
+        }
+
+        extra.output_type = OUTPUT_TYPE_WAV_RF64;
+        if (extra.output_type_name) {
+            if (strcasecmp(extra.output_type_name, "raw") == 0) extra.output_type = OUTPUT_TYPE_RAW;
+            else if (strcasecmp(extra.output_type_name, "wav") == 0) extra.output_type = OUTPUT_TYPE_WAV;
+            else if (strcasecmp(extra.output_type_name, "wav-rf64") == 0) extra.output_type = OUTPUT_TYPE_WAV_RF64;
+            else {
+                log_fatal("Invalid output type '%s' for --output-container-%d. Must be 'raw', 'wav', or 'wav-rf64'.", extra.output_type_name, output_number);
+                return false;
+            }
+        }
+
+        if (!extra.sample_type_name) {
+            extra.sample_type_name = "cs16";
+        }
+        extra.output_format = utils_get_format_from_string(extra.sample_type_name);
+        if (extra.output_format == FORMAT_UNKNOWN) {
+            log_fatal("Invalid sample format '%s' for --output-sample-format-%d. See --help for valid formats.", extra.sample_type_name, output_number);
+            return false;
+        }
+        if ((extra.output_type == OUTPUT_TYPE_WAV || extra.output_type == OUTPUT_TYPE_WAV_RF64) &&
+            extra.output_format != CS16 && extra.output_format != CU8) {
+            log_fatal("Invalid sample format '%s' for the WAV container of output %d. Only 'cs16' and 'cu8' are supported for WAV output.", extra.sample_type_name, output_number);
+            return false;
+        }
+
+        if (extra.target_rate_arg < 0.0f) {
+            log_fatal("--output-rate-%d must be a positive value.", output_number);
+            return false;
+        }
+
+        // Compact the used outputs so they are contiguous.
+        config->extra_outputs[config->num_extra_outputs++] = extra;
+    }
+
+    if (config->num_extra_outputs == 0) return true;
+
+    // Additional outputs only share the stages before the resampler.
+    if (config->num_channels > 0) {
+        log_fatal("Additional outputs (--file-2 ...) cannot be used with --channels.");
+        return false;
+    }
+    if (config->raw_passthrough) {
+        log_fatal("Additional outputs (--file-2 ...) cannot be used with --raw-passthrough.");
+        return false;
+    }
+    if (config->shift_after_resample) {
+        log_fatal("Additional outputs (--file-2 ...) cannot be used with --shift-after-resample.");
+        return false;
+    }
+    return true;
+}
+
+bool validate_stage_order_option(AppConfig *config) {
+    for (int k = 0; k < PLAN_STAGE_COUNT; k++) {
+        config->stage_placement_request[k] = STAGE_PLACEMENT_AUTO;
+    }
+
+    if (config->stage_order_str_arg) {
+        if (config->raw_passthrough) {
+            log_fatal("Option --stage-order cannot be used with --raw-passthrough.");
+            return false;
+        }
+        if (!stage_planner_parse_order(config->stage_order_str_arg, config->stage_placement_request)) {
+            return false;
+        }
+    }
+
+    // --shift-after-resample is shorthand for pinning the shift after the resampler.
+    if (config->shift_after_resample) {
+        if (config->stage_placement_request[PLAN_STAGE_SHIFT] == STAGE_PLACEMENT_PRE_RESAMPLE) {
+            log_fatal("Option --shift-after-resample conflicts with --stage-order '%s'.", config->stage_order_str_arg);
+            return false;
+        }
+        config->stage_placement_request[PLAN_STAGE_SHIFT] = STAGE_PLACEMENT_POST_RESAMPLE;
+    }
+
+    // Channels and additional outputs are taken from the stream before the resampler.
+    if (config->num_channels > 0 || config->num_extra_outputs > 0) {
+        for (int k = 0; k < PLAN_STAGE_COUNT; k++) {
+            if (config->stage_placement_request[k] == STAGE_PLACEMENT_POST_RESAMPLE) {
+                log_fatal("Option --stage-order cannot place stages after 'resample' with --channels or additional outputs.");
+                return false;
+            }
+        }
+    }
     return true;
 }
 
 bool validate_logical_consistency(AppConfig *config) {
+    // --- Validate DC Block Options ---
+    config->dc_block.mode = DC_BLOCK_MODE_IIR;
+    if (config->dc_block.mode_str_arg) {
+        if (strcasecmp(config->dc_block.mode_str_arg, "iir") == 0) {
+            config->dc_block.mode = DC_BLOCK_MODE_IIR;
+        } else if (strcasecmp(config->dc_block.mode_str_arg, "mean") == 0) {
+            config->dc_block.mode = DC_BLOCK_MODE_MEAN;
+        } else {
+            log_fatal("Invalid value for --dc-block-mode: '%s'. Must be 'iir' or 'mean'.", config->dc_block.mode_str_arg);
+            return false;
+        }
+    }
+
     // --- Validate Filter Implementation Options ---
     if (config->filter_type_str_arg) {
         if (strcasecmp(config->filter_type_str_arg, "fir") == 0) {
@@ -315,6 +675,11 @@ bool validate_logical_consistency(AppConfig *config) {
         }
     }
 
+    if (config->filter_threads_arg < 0) {
+        log_fatal("--filter-threads must be zero (automatic) or a positive integer.");
+        return false;
+    }
+
     // Perform a preliminary check for FFT size vs. taps to fail fast.
     if (config->filter_type_request == FILTER_TYPE_FFT && config->filter_taps_arg > 0 && config->filter_fft_size_arg > 0) {
         long adjusted_taps = (config->filter_taps_arg % 2 == 0) 
@@ -368,6 +733,11 @@ bool validate_logical_consistency(AppConfig *config) {
         }
     }
 
+    if (config->read_ahead_mb < 0 || config->read_ahead_mb > IO_READ_AHEAD_MAX_MB) {
+        log_fatal("Invalid value for --read-ahead: %d. Must be between 0 and %d MB.", config->read_ahead_mb, IO_READ_AHEAD_MAX_MB);
+        return false;
+    }
+
     // --- Validate Required Arguments ---
     if (config->target_rate <= 0 && !config->no_resample) {
         log_fatal("Missing required argument: you must specify an --output-rate or use a preset.");
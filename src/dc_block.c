@@ -2,6 +2,8 @@
 #include "constants.h"
 #include "log.h"
 #include "config.h" // For DC_BLOCK_CUTOFF_HZ
+#include "cic_decimator.h"
+#include "stage_planner.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>   // For M_PI, fabs
@@ -11,25 +13,23 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-#ifdef _WIN32
-#include <liquid.h>
-#else
-#include <liquid/liquid.h>
-#endif
-
 bool dc_block_init(AppConfig* config, AppResources* resources) {
+    DcBlockResources* dc = &resources->dc_block;
+    memset(dc, 0, sizeof(*dc));
+
     if (!config->dc_block.enable) {
-        resources->dc_block.dc_block_filter = NULL; // Ensure no filter if disabled
         return true;
     }
 
-    // Calculate normalized cutoff frequency based on the input sample rate.
-    // This assumes the DC block is applied before resampling, so it uses the source_info.samplerate.
-    // liquid-dsp's iirfilt_crcf_create_dc_blocker expects a normalized bandwidth (alpha)
-    // where alpha = 2 * pi * fc / Fs.
-    // The documentation for iirfilt_crcf_create_dc_blocker states it creates a first-order
-    // DC-blocking filter with transfer function H(z) = (1 - z^-1) / (1 - (1-alpha)z^-1).
-    float normalized_alpha = (float)(2.0 * M_PI * DC_BLOCK_CUTOFF_HZ / resources->source_info.samplerate);
+    // Calculate normalized cutoff frequency based on the rate the block runs at: the
+    // output rate if the stage plan puts it after the resampler, otherwise the input
+    // rate, or the CIC front end's output rate if it has already decimated.
+    double block_rate = stage_plan_is_post_resample(&resources->stage_plan, PLAN_STAGE_DC_BLOCK) ?
+                        config->target_rate : cic_decimator_output_rate(resources);
+    // The filter is the classic first-order DC blocker
+    // H(z) = g * (1 - z^-1) / (1 - (1-alpha)z^-1), with alpha = 2 * pi * fc / Fs
+    // and g = 1 - alpha/2 for unity gain at Nyquist.
+    float normalized_alpha = (float)(2.0 * M_PI * DC_BLOCK_CUTOFF_HZ / block_rate);
 
     // Ensure alpha is within a reasonable range (e.g., small positive value)
     // A very small alpha means a very narrow notch at DC, a larger alpha means wider.
@@ -38,48 +38,127 @@ bool dc_block_init(AppConfig* config, AppResources* resources) {
         log_fatal("DC Block: Calculated normalized alpha (%.6f) is invalid. Ensure DC_BLOCK_CUTOFF_HZ > 0.", normalized_alpha);
         return false;
     }
-    // Cap alpha to avoid excessively wide bandwidth for a DC block, though liquid-dsp handles it.
+    // Cap alpha to avoid excessively wide bandwidth for a DC block.
     if (normalized_alpha > 1.0f) { // Arbitrary upper bound for sanity, 1.0f is ~Fs/(2*pi)
         log_warn("DC Block: Calculated normalized alpha (%.6f) is very large. Consider reducing DC_BLOCK_CUTOFF_HZ.", normalized_alpha);
-        // It's not a fatal error, but a warning. Continue.
+        normalized_alpha = 1.0f;
     }
 
-    // Create the IIR filter object.
-    // Corrected function name: iirfilt_crcf_create_dc_blocker
-    // NOTE: iirfilt_crcf_create_dc_blocker always creates a 1st-order filter,
-    // regardless of the DC_BLOCK_FILTER_ORDER constant in config.h.
-    // If a higher-order DC block were needed, a more general filter design
-    // function (e.g., iirfilt_crcf_create_prototype with LIQUID_IIRDES_HIGHPASS)
-    // would be required. For typical DC removal, 1st order is often sufficient.
-    resources->dc_block.dc_block_filter = iirfilt_crcf_create_dc_blocker(normalized_alpha);
-
-    if (!resources->dc_block.dc_block_filter) {
-        log_fatal("Failed to create liquid-dsp DC block filter.");
-        return false;
+    dc->pole = 1.0f - normalized_alpha;
+    dc->gain = 1.0f - normalized_alpha / 2.0f;
+    dc->pole_powers[0] = 1.0f;
+    for (int k = 1; k <= DC_BLOCK_SCAN_BLOCK; k++) {
+        dc->pole_powers[k] = dc->pole_powers[k - 1] * dc->pole;
     }
 
-    log_info("DC Block enabled");
-    log_debug("DC Block: Initialized with normalized_alpha = %.6f", normalized_alpha);
+    // The mean tracker has the same time constant as the IIR filter.
+    dc->mean_rate_per_sample = normalized_alpha;
 
+    log_info("DC Block enabled (%s)", config->dc_block.mode == DC_BLOCK_MODE_MEAN ? "block mean" : "IIR");
+    log_debug("DC Block: Initialized with normalized_alpha = %.6f", normalized_alpha);
 
     return true;
 }
 
+/**
+ * @brief Runs the first-order DC blocker, DC_BLOCK_SCAN_BLOCK samples at a time.
+ *
+ * Within each block the recursion v[k] = p * v[k-1] + d[k] is solved with a
+ * log-step (Hillis-Steele) prefix scan over the zero-state response, and the
+ * carried-in state is added back as p^(k+1) * v[-1]. Every step is a
+ * fixed-length loop with no serial dependency, so the compiler can vectorize it.
+ */
+static void _dc_block_iir(DcBlockResources* dc, complex_float_t* samples, int num_samples) {
+    const float* pole_powers = dc->pole_powers;
+    const float gain = dc->gain;
+    complex_float_t prev_input = dc->prev_input;
+    complex_float_t state = dc->prev_state;
+    int pos = 0;
+
+    for (; pos + DC_BLOCK_SCAN_BLOCK <= num_samples; pos += DC_BLOCK_SCAN_BLOCK) {
+        complex_float_t* x = samples + pos;
+        complex_float_t z[DC_BLOCK_SCAN_BLOCK];
+        complex_float_t t[DC_BLOCK_SCAN_BLOCK];
+
+        // First differences (the FIR half of the filter).
+        z[0] = x[0] - prev_input;
+        for (int k = 1; k < DC_BLOCK_SCAN_BLOCK; k++) {
+            z[k] = x[k] - x[k - 1];
+        }
+        prev_input = x[DC_BLOCK_SCAN_BLOCK - 1];
+
+        // Zero-state response of the pole, as a parallel prefix scan.
+        for (int stride = 1; stride < DC_BLOCK_SCAN_BLOCK; stride *= 2) {
+            const float p = pole_powers[stride];
+            memcpy(t, z, sizeof(z));
+            for (int k = stride; k < DC_BLOCK_SCAN_BLOCK; k++) {
+                z[k] = t[k] + p * t[k - stride];
+            }
+        }
+
+        // Add the response to the state carried in from the previous block.
+        for (int k = 0; k < DC_BLOCK_SCAN_BLOCK; k++) {
+            x[k] = gain * (z[k] + pole_powers[k + 1] * state);
+        }
+        state = z[DC_BLOCK_SCAN_BLOCK - 1] + pole_powers[DC_BLOCK_SCAN_BLOCK] * state;
+    }
+
+    // Scalar tail.
+    for (; pos < num_samples; pos++) {
+        complex_float_t in = samples[pos];
+        state = dc->pole * state + (in - prev_input);
+        prev_input = in;
+        samples[pos] = gain * state;
+    }
+
+    dc->prev_input = prev_input;
+    dc->prev_state = state;
+}
+
+/**
+ * @brief Subtracts a DC estimate updated once per block from the block's mean.
+ *
+ * The estimate moves toward each block's mean with a weight matching the IIR
+ * filter's time constant. Cost is one sum and one subtraction per sample.
+ */
+static void _dc_block_mean(DcBlockResources* dc, complex_float_t* samples, int num_samples) {
+    if (num_samples <= 0) return;
+
+    float sum_i = 0.0f, sum_q = 0.0f;
+    for (int k = 0; k < num_samples; k++) {
+        sum_i += crealf(samples[k]);
+        sum_q += cimagf(samples[k]);
+    }
+    complex_float_t block_mean = (sum_i / (float)num_samples) + I * (sum_q / (float)num_samples);
+
+    if (dc->have_estimate) {
+        float weight = dc->mean_rate_per_sample * (float)num_samples;
+        if (weight > 1.0f) weight = 1.0f;
+        dc->dc_estimate += weight * (block_mean - dc->dc_estimate);
+    } else {
+        dc->dc_estimate = block_mean;
+        dc->have_estimate = true;
+    }
+
+    const complex_float_t dc_estimate = dc->dc_estimate;
+    for (int k = 0; k < num_samples; k++) {
+        samples[k] -= dc_estimate;
+    }
+}
+
 void dc_block_apply(AppResources* resources, complex_float_t* samples, int num_samples) {
-    if (!resources->config->dc_block.enable || !resources->dc_block.dc_block_filter) {
-        return; // DC block is disabled or not initialized
+    if (!resources->config->dc_block.enable) {
+        return; // DC block is disabled
     }
 
-    // Apply the filter in-place
-    iirfilt_crcf_execute_block(resources->dc_block.dc_block_filter,
-                               (liquid_float_complex*)samples,
-                               num_samples,
-                               (liquid_float_complex*)samples);
+    if (resources->config->dc_block.mode == DC_BLOCK_MODE_MEAN) {
+        _dc_block_mean(&resources->dc_block, samples, num_samples);
+    } else {
+        _dc_block_iir(&resources->dc_block, samples, num_samples);
+    }
 }
 
 void dc_block_cleanup(AppResources* resources) {
-    if (resources->dc_block.dc_block_filter) {
-        iirfilt_crcf_destroy(resources->dc_block.dc_block_filter);
-        resources->dc_block.dc_block_filter = NULL;
-    }
+    // All state lives in AppResources; nothing to free.
+    memset(&resources->dc_block, 0, sizeof(resources->dc_block));
 }
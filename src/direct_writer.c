@@ -0,0 +1,289 @@
+// direct_writer.c
+
+#ifdef __linux__
+#define _GNU_SOURCE // For O_DIRECT and fallocate()
+#endif
+
+#include "direct_writer.h"
+#include "constants.h"
+#include "log.h"
+#include "queue.h"
+#include "memory_arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+typedef struct {
+    unsigned char* data;    // DIRECT_IO_ALIGNMENT-aligned, DIRECT_IO_BUFFER_BYTES long
+    size_t length;          // Bytes to write, a multiple of DIRECT_IO_ALIGNMENT
+    off_t offset;
+} DirectWriteBuffer;
+
+struct DirectWriter {
+    int fd;
+    DirectWriteBuffer buffers[DIRECT_IO_NUM_BUFFERS];
+    Queue free_buffers;
+    Queue pending_writes;
+    pthread_t workers[DIRECT_IO_NUM_THREADS];
+    int num_workers;
+
+    DirectWriteBuffer* current;     // Buffer being filled by the caller, or NULL
+    size_t current_fill;
+    long long logical_size;         // Bytes appended so far
+    bool finished;
+
+    pthread_mutex_t error_mutex;
+    int first_error;                // errno of the first failed write, or 0
+};
+
+static void _record_error(DirectWriter* writer, int error) {
+    pthread_mutex_lock(&writer->error_mutex);
+    if (writer->first_error == 0) writer->first_error = error;
+    pthread_mutex_unlock(&writer->error_mutex);
+}
+
+static int _current_error(DirectWriter* writer) {
+    pthread_mutex_lock(&writer->error_mutex);
+    int error = writer->first_error;
+    pthread_mutex_unlock(&writer->error_mutex);
+    return error;
+}
+
+static void* _direct_writer_worker(void* arg) {
+    DirectWriter* writer = (DirectWriter*)arg;
+    DirectWriteBuffer* buffer;
+    while ((buffer = (DirectWriteBuffer*)queue_dequeue(&writer->pending_writes)) != NULL) {
+        size_t done = 0;
+        while (done < buffer->length) {
+            ssize_t n = pwrite(writer->fd, buffer->data + done, buffer->length - done, buffer->offset + (off_t)done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                _record_error(writer, (n < 0) ? errno : EIO);
+                break;
+            }
+            done += (size_t)n;
+        }
+        queue_enqueue(&writer->free_buffers, buffer);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Queues the current buffer for writing, zero-padding it to the alignment.
+ */
+static void _submit_current(DirectWriter* writer) {
+    DirectWriteBuffer* buffer = writer->current;
+    size_t padded = (writer->current_fill + DIRECT_IO_ALIGNMENT - 1) & ~((size_t)DIRECT_IO_ALIGNMENT - 1);
+    memset(buffer->data + writer->current_fill, 0, padded - writer->current_fill);
+    buffer->length = padded;
+    buffer->offset = (off_t)(writer->logical_size - (long long)writer->current_fill);
+    writer->current = NULL;
+    writer->current_fill = 0;
+    queue_enqueue(&writer->pending_writes, buffer);
+}
+
+/**
+ * @brief Stops the workers and frees the buffers. Does not close the file.
+ */
+static void _stop_workers(DirectWriter* writer) {
+    queue_signal_shutdown(&writer->pending_writes);
+    for (int i = 0; i < writer->num_workers; i++) {
+        pthread_join(writer->workers[i], NULL);
+    }
+    writer->num_workers = 0;
+    for (int i = 0; i < DIRECT_IO_NUM_BUFFERS; i++) {
+        free(writer->buffers[i].data);
+        writer->buffers[i].data = NULL;
+    }
+    queue_destroy(&writer->pending_writes);
+    queue_destroy(&writer->free_buffers);
+    pthread_mutex_destroy(&writer->error_mutex);
+}
+
+DirectWriter* direct_writer_open(const char* path, MemoryArena* arena) {
+    DirectWriter* writer = (DirectWriter*)mem_arena_alloc(arena, sizeof(DirectWriter));
+    if (!writer) return NULL;
+
+    writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT | O_CLOEXEC, 0644);
+    if (writer->fd < 0) {
+        log_debug("O_DIRECT open of '%s' failed (%s), using buffered writes.", path, strerror(errno));
+        return NULL;
+    }
+
+    if (!queue_init(&writer->free_buffers, DIRECT_IO_NUM_BUFFERS, arena) ||
+        !queue_init(&writer->pending_writes, DIRECT_IO_NUM_BUFFERS, arena)) {
+        close(writer->fd);
+        return NULL;
+    }
+    pthread_mutex_init(&writer->error_mutex, NULL);
+
+    for (int i = 0; i < DIRECT_IO_NUM_BUFFERS; i++) {
+        void* data = NULL;
+        if (posix_memalign(&data, DIRECT_IO_ALIGNMENT, DIRECT_IO_BUFFER_BYTES) != 0) {
+            log_fatal("Failed to allocate aligned output buffers.");
+            _stop_workers(writer);
+            close(writer->fd);
+            return NULL;
+        }
+        writer->buffers[i].data = (unsigned char*)data;
+        queue_enqueue(&writer->free_buffers, &writer->buffers[i]);
+    }
+
+    for (int i = 0; i < DIRECT_IO_NUM_THREADS; i++) {
+        if (pthread_create(&writer->workers[i], NULL, _direct_writer_worker, writer) != 0) {
+            log_fatal("Failed to create output write threads.");
+            _stop_workers(writer);
+            close(writer->fd);
+            return NULL;
+        }
+        writer->num_workers++;
+    }
+
+    log_debug("Writing '%s' with O_DIRECT, %d writes in flight.", path, DIRECT_IO_NUM_THREADS);
+    return writer;
+}
+
+void direct_writer_preallocate(DirectWriter* writer, long long bytes) {
+    if (bytes <= 0) return;
+    if (fallocate(writer->fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)bytes) != 0) {
+        log_debug("Could not preallocate %lld bytes of output: %s", bytes, strerror(errno));
+    }
+}
+
+size_t direct_writer_write(DirectWriter* writer, const void* data, size_t bytes) {
+    int error = _current_error(writer);
+    if (error != 0 || writer->finished) {
+        errno = (error != 0) ? error : EBADF;
+        return 0;
+    }
+
+    const unsigned char* src = (const unsigned char*)data;
+    size_t remaining = bytes;
+    while (remaining > 0) {
+        if (!writer->current) {
+            writer->current = (DirectWriteBuffer*)queue_dequeue(&writer->free_buffers);
+            if (!writer->current) {
+                errno = EIO;
+                return 0;
+            }
+        }
+        size_t space = DIRECT_IO_BUFFER_BYTES - writer->current_fill;
+        size_t n = (remaining < space) ? remaining : space;
+        memcpy(writer->current->data + writer->current_fill, src, n);
+        writer->current_fill += n;
+        writer->logical_size += (long long)n;
+        src += n;
+        remaining -= n;
+        if (writer->current_fill == DIRECT_IO_BUFFER_BYTES) {
+            _submit_current(writer);
+        }
+    }
+    return bytes;
+}
+
+bool direct_writer_finish(DirectWriter* writer) {
+    if (writer->finished) return _current_error(writer) == 0;
+    writer->finished = true;
+
+    // The tail is written padded to the alignment, then trimmed by ftruncate().
+    if (writer->current && writer->current_fill > 0) {
+        _submit_current(writer);
+    } else if (writer->current) {
+        queue_enqueue(&writer->free_buffers, writer->current);
+        writer->current = NULL;
+    }
+
+    // Every buffer is back in the free queue once all writes have completed.
+    DirectWriteBuffer* drained[DIRECT_IO_NUM_BUFFERS];
+    for (int i = 0; i < DIRECT_IO_NUM_BUFFERS; i++) {
+        drained[i] = (DirectWriteBuffer*)queue_dequeue(&writer->free_buffers);
+    }
+    for (int i = 0; i < DIRECT_IO_NUM_BUFFERS; i++) {
+        if (drained[i]) queue_enqueue(&writer->free_buffers, drained[i]);
+    }
+
+    if (ftruncate(writer->fd, (off_t)writer->logical_size) != 0) {
+        _record_error(writer, errno);
+    }
+    // Leave direct mode so small, unaligned header patches are possible.
+    int flags = fcntl(writer->fd, F_GETFL);
+    if (flags >= 0) {
+        fcntl(writer->fd, F_SETFL, flags & ~O_DIRECT);
+    }
+
+    int error = _current_error(writer);
+    if (error != 0) {
+        log_error("Direct I/O write failed: %s", strerror(error));
+        return false;
+    }
+    return true;
+}
+
+bool direct_writer_pwrite(DirectWriter* writer, long long offset, const void* data, size_t bytes) {
+    if (!writer->finished) {
+        errno = EINVAL;
+        return false;
+    }
+    const unsigned char* src = (const unsigned char*)data;
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t n = pwrite(writer->fd, src + done, bytes - done, (off_t)(offset + (long long)done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+bool direct_writer_close(DirectWriter* writer) {
+    if (!writer) return true;
+    bool ok = direct_writer_finish(writer);
+    _stop_workers(writer);
+    if (close(writer->fd) != 0) ok = false;
+    writer->fd = -1;
+    return ok;
+}
+#else
+DirectWriter* direct_writer_open(const char* path, MemoryArena* arena) {
+    (void)path;
+    (void)arena;
+    return NULL;
+}
+
+void direct_writer_preallocate(DirectWriter* writer, long long bytes) {
+    (void)writer;
+    (void)bytes;
+}
+
+size_t direct_writer_write(DirectWriter* writer, const void* data, size_t bytes) {
+    (void)writer;
+    (void)data;
+    (void)bytes;
+    errno = ENOSYS;
+    return 0;
+}
+
+bool direct_writer_finish(DirectWriter* writer) {
+    (void)writer;
+    return false;
+}
+
+bool direct_writer_pwrite(DirectWriter* writer, long long offset, const void* data, size_t bytes) {
+    (void)writer;
+    (void)offset;
+    (void)data;
+    (void)bytes;
+    return false;
+}
+
+bool direct_writer_close(DirectWriter* writer) {
+    (void)writer;
+    return true;
+}
+#endif
@@ -0,0 +1,312 @@
+// fftw_filter.c
+
+#include "fftw_filter.h"
+#include "constants.h"
+#include "log.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Included after <complex.h> (via types.h) so fftwf_complex is the C99 complex type.
+#include <fftw3.h>
+
+struct FftwFilter {
+    unsigned int fft_size;
+    unsigned int block_size;      // New samples consumed per transform: fft_size - history_len
+    unsigned int history_len;     // Samples carried between blocks: taps_len - 1
+    bool use_real_transforms;     // Batched r2c/c2r over the interleaved I and Q streams
+    unsigned int num_bins;        // fft_size (complex) or fft_size / 2 + 1 (real)
+
+    complex_float_t* time_buffer;   // [history | new block], fft_size samples
+    complex_float_t* output_buffer; // Inverse transform output, fft_size samples
+    complex_float_t* freq_buffer;   // num_bins bins, twice over for the real layout
+    complex_float_t* taps_spectrum; // num_bins bins, pre-scaled by 1 / fft_size
+
+    fftwf_plan forward_plan;
+    fftwf_plan inverse_plan;
+};
+
+/**
+ * @brief Allocates buffers and plans an overlap-save filter for one transform layout.
+ *
+ * Planning uses FFTW_MEASURE, which overwrites the buffers, so they are zeroed
+ * afterwards. The taps spectrum is left empty for the caller to fill.
+ */
+static FftwFilter* _fftw_filter_alloc(unsigned int fft_size, unsigned int history_len, bool use_real_transforms) {
+    FftwFilter* filter = (FftwFilter*)calloc(1, sizeof(FftwFilter));
+    if (!filter) return NULL;
+
+    filter->fft_size = fft_size;
+    filter->history_len = history_len;
+    filter->block_size = fft_size - history_len;
+    filter->use_real_transforms = use_real_transforms;
+    filter->num_bins = use_real_transforms ? (fft_size / 2 + 1) : fft_size;
+
+    // FFTW's allocator guarantees the SIMD alignment the arena cannot.
+    size_t time_bytes = fft_size * sizeof(complex_float_t);
+    size_t freq_bytes = filter->num_bins * sizeof(complex_float_t) * (use_real_transforms ? 2 : 1);
+    filter->time_buffer = (complex_float_t*)fftwf_malloc(time_bytes);
+    filter->output_buffer = (complex_float_t*)fftwf_malloc(time_bytes);
+    filter->freq_buffer = (complex_float_t*)fftwf_malloc(freq_bytes);
+    filter->taps_spectrum = (complex_float_t*)fftwf_malloc(filter->num_bins * sizeof(complex_float_t));
+    if (!filter->time_buffer || !filter->output_buffer || !filter->freq_buffer || !filter->taps_spectrum) {
+        fftw_filter_destroy(filter);
+        return NULL;
+    }
+
+    int n = (int)fft_size;
+    if (use_real_transforms) {
+        // Interleaved I/Q is two real streams with stride 2, one sample apart.
+        int bins = (int)filter->num_bins;
+        filter->forward_plan = fftwf_plan_many_dft_r2c(1, &n, 2,
+                                                       (float*)filter->time_buffer, NULL, 2, 1,
+                                                       (fftwf_complex*)filter->freq_buffer, NULL, 1, bins,
+                                                       FFTW_MEASURE);
+        filter->inverse_plan = fftwf_plan_many_dft_c2r(1, &n, 2,
+                                                       (fftwf_complex*)filter->freq_buffer, NULL, 1, bins,
+                                                       (float*)filter->output_buffer, NULL, 2, 1,
+                                                       FFTW_MEASURE);
+    } else {
+        filter->forward_plan = fftwf_plan_dft_1d(n, (fftwf_complex*)filter->time_buffer,
+                                                 (fftwf_complex*)filter->freq_buffer, FFTW_FORWARD, FFTW_MEASURE);
+        filter->inverse_plan = fftwf_plan_dft_1d(n, (fftwf_complex*)filter->freq_buffer,
+                                                 (fftwf_complex*)filter->output_buffer, FFTW_BACKWARD, FFTW_MEASURE);
+    }
+    if (!filter->forward_plan || !filter->inverse_plan) {
+        fftw_filter_destroy(filter);
+        return NULL;
+    }
+
+    memset(filter->time_buffer, 0, time_bytes);
+    memset(filter->output_buffer, 0, time_bytes);
+    memset(filter->freq_buffer, 0, freq_bytes);
+    memset(filter->taps_spectrum, 0, filter->num_bins * sizeof(complex_float_t));
+    return filter;
+}
+
+/**
+ * @brief Computes the scaled frequency response of the taps for the filter's layout.
+ */
+static bool _fftw_filter_load_taps(FftwFilter* filter, const complex_float_t* taps, unsigned int taps_len) {
+    int n = (int)filter->fft_size;
+    fftwf_plan plan;
+
+    // The output buffer is free at this point and serves as the zero-padded input.
+    memset(filter->output_buffer, 0, filter->fft_size * sizeof(complex_float_t));
+    if (filter->use_real_transforms) {
+        float* real_taps = (float*)filter->output_buffer;
+        for (unsigned int i = 0; i < taps_len; i++) {
+            real_taps[i] = crealf(taps[i]);
+        }
+        plan = fftwf_plan_dft_r2c_1d(n, real_taps, (fftwf_complex*)filter->taps_spectrum, FFTW_ESTIMATE);
+    } else {
+        memcpy(filter->output_buffer, taps, taps_len * sizeof(complex_float_t));
+        plan = fftwf_plan_dft_1d(n, (fftwf_complex*)filter->output_buffer,
+                                 (fftwf_complex*)filter->taps_spectrum, FFTW_FORWARD, FFTW_ESTIMATE);
+    }
+    if (!plan) return false;
+    fftwf_execute(plan);
+    fftwf_destroy_plan(plan);
+
+    // Fold the inverse transform's 1/N normalization into the taps.
+    float scale = 1.0f / (float)filter->fft_size;
+    for (unsigned int i = 0; i < filter->num_bins; i++) {
+        filter->taps_spectrum[i] *= scale;
+    }
+    memset(filter->output_buffer, 0, filter->fft_size * sizeof(complex_float_t));
+    return true;
+}
+
+/**
+ * @brief Times a planned filter and returns its cost in seconds per output sample.
+ */
+static double _fftw_filter_benchmark(FftwFilter* filter) {
+    complex_float_t* scratch = (complex_float_t*)calloc(filter->block_size, sizeof(complex_float_t));
+    if (!scratch) return -1.0;
+
+    // One untimed run to warm the caches.
+    fftw_filter_execute(filter, scratch, scratch);
+
+    double start = get_monotonic_time_sec();
+    for (int i = 0; i < FFTW_FILTER_BENCHMARK_RUNS; i++) {
+        fftw_filter_execute(filter, scratch, scratch);
+    }
+    double elapsed = get_monotonic_time_sec() - start;
+
+    free(scratch);
+    fftw_filter_reset(filter);
+    return elapsed / ((double)FFTW_FILTER_BENCHMARK_RUNS * (double)filter->block_size);
+}
+
+/**
+ * @brief Fills `sizes` with candidate transform sizes in ascending order.
+ *
+ * Candidates are 2^k, 3*2^k and 5*2^k, for which FFTW has fast codelets,
+ * from `min_size` up to FFTW_FILTER_SEARCH_SPAN times that.
+ */
+static unsigned int _collect_candidate_sizes(unsigned int min_size, unsigned int history_len, unsigned int* sizes) {
+    static const unsigned int radices[] = { 1, 3, 5 };
+    unsigned int count = 0;
+    unsigned long long max_size = (unsigned long long)min_size * FFTW_FILTER_SEARCH_SPAN;
+
+    for (size_t r = 0; r < sizeof(radices) / sizeof(radices[0]); r++) {
+        for (unsigned long long size = radices[r]; size <= max_size; size *= 2) {
+            if (size < min_size) continue;
+            if (size - history_len > MAX_ALLOWED_FFT_BLOCK_SIZE) break;
+            if (count == FFTW_FILTER_MAX_CANDIDATES) break;
+
+            // Insertion sort keeps the list ascending.
+            unsigned int pos = count++;
+            while (pos > 0 && sizes[pos - 1] > size) {
+                sizes[pos] = sizes[pos - 1];
+                pos--;
+            }
+            sizes[pos] = (unsigned int)size;
+        }
+    }
+    return count;
+}
+
+FftwFilter* fftw_filter_create(const complex_float_t* taps, unsigned int taps_len, bool taps_are_real,
+                               unsigned int fft_size, const char* wisdom_dir) {
+    if (!taps || taps_len == 0) return NULL;
+
+    unsigned int history_len = taps_len - 1;
+    char wisdom_path[MAX_PATH_BUFFER];
+    bool have_wisdom_path = false;
+
+    if (wisdom_dir) {
+        int written = snprintf(wisdom_path, sizeof(wisdom_path), "%s/%s", wisdom_dir, FFTW_WISDOM_FILENAME);
+        have_wisdom_path = (written > 0 && (size_t)written < sizeof(wisdom_path));
+    }
+    if (have_wisdom_path) {
+        if (fftwf_import_wisdom_from_filename(wisdom_path)) {
+            log_debug("Imported FFTW wisdom from '%s'.", wisdom_path);
+        } else {
+            log_debug("No usable FFTW wisdom at '%s'; plans will be measured.", wisdom_path);
+        }
+    }
+
+    unsigned int sizes[FFTW_FILTER_MAX_CANDIDATES];
+    unsigned int num_sizes;
+    if (fft_size > 0) {
+        if (fft_size <= history_len) {
+            log_error("FFT size %u is too small for a filter with %u taps.", fft_size, taps_len);
+            return NULL;
+        }
+        sizes[0] = fft_size;
+        num_sizes = 1;
+    } else {
+        unsigned int min_size = history_len * 2;
+        if (min_size < FFTW_FILTER_MIN_FFT_SIZE) min_size = FFTW_FILTER_MIN_FFT_SIZE;
+        num_sizes = _collect_candidate_sizes(min_size, history_len, sizes);
+    }
+
+    FftwFilter* best = NULL;
+    double best_cost = 0.0;
+    int num_layouts = taps_are_real ? 2 : 1;
+
+    for (unsigned int i = 0; i < num_sizes; i++) {
+        for (int layout = 0; layout < num_layouts; layout++) {
+            bool use_real = (layout == 1);
+            FftwFilter* candidate = _fftw_filter_alloc(sizes[i], history_len, use_real);
+            if (!candidate) continue;
+
+            double cost = _fftw_filter_benchmark(candidate);
+            if (cost < 0.0) {
+                fftw_filter_destroy(candidate);
+                continue;
+            }
+            log_debug("FFTW candidate: size %u (%s), %.3f ns per sample.",
+                      sizes[i], use_real ? "real" : "complex", cost * 1e9);
+
+            if (!best || cost < best_cost) {
+                fftw_filter_destroy(best);
+                best = candidate;
+                best_cost = cost;
+            } else {
+                fftw_filter_destroy(candidate);
+            }
+        }
+    }
+
+    if (have_wisdom_path && best) {
+        if (!fftwf_export_wisdom_to_filename(wisdom_path)) {
+            log_debug("Could not save FFTW wisdom to '%s'.", wisdom_path);
+        }
+    }
+
+    if (!best) {
+        log_error("Failed to plan any FFTW transform for the filter.");
+        return NULL;
+    }
+    if (!_fftw_filter_load_taps(best, taps, taps_len)) {
+        log_error("Failed to compute the filter's frequency response with FFTW.");
+        fftw_filter_destroy(best);
+        return NULL;
+    }
+
+    log_info("Using FFTW overlap-save filter: FFT size %u, block size %u, %s transforms.",
+             best->fft_size, best->block_size, best->use_real_transforms ? "real" : "complex");
+    return best;
+}
+
+FftwFilter* fftw_filter_clone(const FftwFilter* filter) {
+    if (!filter) return NULL;
+    FftwFilter* copy = _fftw_filter_alloc(filter->fft_size, filter->history_len, filter->use_real_transforms);
+    if (!copy) return NULL;
+    memcpy(copy->taps_spectrum, filter->taps_spectrum, filter->num_bins * sizeof(complex_float_t));
+    return copy;
+}
+
+unsigned int fftw_filter_get_block_size(const FftwFilter* filter) {
+    return filter ? filter->block_size : 0;
+}
+
+unsigned int fftw_filter_get_fft_size(const FftwFilter* filter) {
+    return filter ? filter->fft_size : 0;
+}
+
+void fftw_filter_execute(FftwFilter* filter, const complex_float_t* input, complex_float_t* output) {
+    // Stage 1: Append the new block after the retained history and transform.
+    memcpy(filter->time_buffer + filter->history_len, input, filter->block_size * sizeof(complex_float_t));
+    fftwf_execute(filter->forward_plan);
+
+    // Stage 2: The last (taps - 1) inputs become the history for the next block.
+    memmove(filter->time_buffer, filter->time_buffer + filter->block_size, filter->history_len * sizeof(complex_float_t));
+
+    // Stage 3: Apply the filter's frequency response.
+    complex_float_t* restrict freq = filter->freq_buffer;
+    const complex_float_t* restrict h = filter->taps_spectrum;
+    unsigned int bins = filter->num_bins;
+    for (unsigned int i = 0; i < bins; i++) {
+        freq[i] *= h[i];
+    }
+    if (filter->use_real_transforms) {
+        for (unsigned int i = 0; i < bins; i++) {
+            freq[bins + i] *= h[i];
+        }
+    }
+
+    // Stage 4: Inverse transform and discard the circularly wrapped samples.
+    fftwf_execute(filter->inverse_plan);
+    memcpy(output, filter->output_buffer + filter->history_len, filter->block_size * sizeof(complex_float_t));
+}
+
+void fftw_filter_reset(FftwFilter* filter) {
+    if (filter) {
+        memset(filter->time_buffer, 0, filter->fft_size * sizeof(complex_float_t));
+    }
+}
+
+void fftw_filter_destroy(FftwFilter* filter) {
+    if (!filter) return;
+    if (filter->forward_plan) fftwf_destroy_plan(filter->forward_plan);
+    if (filter->inverse_plan) fftwf_destroy_plan(filter->inverse_plan);
+    if (filter->time_buffer) fftwf_free(filter->time_buffer);
+    if (filter->output_buffer) fftwf_free(filter->output_buffer);
+    if (filter->freq_buffer) fftwf_free(filter->freq_buffer);
+    if (filter->taps_spectrum) fftwf_free(filter->taps_spectrum);
+    free(filter);
+}
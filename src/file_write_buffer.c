@@ -60,6 +60,17 @@ void file_write_buffer_destroy(FileWriteBuffer* iob) {
     free(iob);
 }
 
+void file_write_buffer_reset(FileWriteBuffer* iob) {
+    if (!iob) return;
+
+    pthread_mutex_lock(&iob->mutex);
+    iob->write_pos = 0;
+    iob->read_pos = 0;
+    iob->end_of_stream = false;
+    iob->shutting_down = false;
+    pthread_mutex_unlock(&iob->mutex);
+}
+
 size_t file_write_buffer_write(FileWriteBuffer* iob, const void* data, size_t bytes) {
     if (!iob || !data || bytes == 0) return 0;
 
@@ -1,29 +1,60 @@
 // file_writer.c
 
+#ifdef __linux__
+#define _GNU_SOURCE // For copy_file_range() and fallocate()
+#endif
+
 #include "file_writer.h"
 #include "log.h"
 #include "platform.h"
 #include "utils.h"
 // MODIFIED: Include memory_arena.h for mem_arena_alloc
 #include "memory_arena.h"
-#include <sndfile.h>
+#include "direct_writer.h"
+#include "constants.h"
+#include "sample_convert.h"
+#include "wav_format.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
 
 #ifndef _WIN32
 #include <unistd.h> // For access()
+#include <sys/stat.h>
+#else
+#include <io.h>
+#endif
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
 #endif
 
 // --- Private Data Structs ---
+typedef enum {
+    ZERO_COPY_FILE_RANGE,   // copy_file_range(): regular file to regular file, can share extents
+    ZERO_COPY_SENDFILE,     // sendfile(): regular file to anything, including pipes and sockets
+    ZERO_COPY_UNSUPPORTED
+} ZeroCopyMethod;
+
 typedef struct {
     FILE* handle;
+    DirectWriter* direct;       // Set instead of `handle` when writing with O_DIRECT
+    ZeroCopyMethod zero_copy_method;
+    bool preallocated;          // Disk space is reserved past the data; the excess is released at close
 } RawWriterData;
 
 typedef struct {
-    SNDFILE* handle;
+    RawWriterData payload;      // The file itself; header and samples go through the raw write path
+    WavHeaderInfo header;
+    long long data_bytes;       // Sample bytes written after the header
 } WavWriterData;
 
 
@@ -36,7 +67,11 @@ static bool prompt_for_overwrite(const char* path_for_messages);
 static bool raw_open(FileWriterContext* ctx, const AppConfig* config, AppResources* resources, MemoryArena* arena);
 static size_t raw_write(FileWriterContext* ctx, const void* buffer, size_t bytes_to_write);
 static void raw_close(FileWriterContext* ctx);
+static bool raw_sync(FileWriterContext* ctx);
 static long long generic_get_total_bytes_written(const FileWriterContext* ctx);
+#ifdef __linux__
+static long long raw_copy_from_fd(FileWriterContext* ctx, int in_fd, long long in_offset, size_t length);
+#endif
 
 
 // --- Forward Declarations for WAV Writer Operations ---
@@ -44,6 +79,13 @@ static long long generic_get_total_bytes_written(const FileWriterContext* ctx);
 static bool wav_open(FileWriterContext* ctx, const AppConfig* config, AppResources* resources, MemoryArena* arena);
 static size_t wav_write(FileWriterContext* ctx, const void* buffer, size_t bytes_to_write);
 static void wav_close(FileWriterContext* ctx);
+static bool wav_sync(FileWriterContext* ctx);
+
+
+// --- Forward Declarations for Segmented Writer Operations ---
+static bool segmented_open(FileWriterContext* ctx, const AppConfig* config, AppResources* resources, MemoryArena* arena);
+static size_t segmented_write(FileWriterContext* ctx, const void* buffer, size_t bytes_to_write);
+static void segmented_close(FileWriterContext* ctx);
 
 
 // --- Helper Functions ---
@@ -74,12 +116,218 @@ static long long generic_get_total_bytes_written(const FileWriterContext* ctx) {
     return ctx->total_bytes_written;
 }
 
+/**
+ * @brief Returns how many sample bytes an output file is expected to receive, or 0 if unknown.
+ *
+ * Additional outputs may run at their own rate, so the main output's expected
+ * frame count is scaled by the ratio of the two rates.
+ */
+static long long _expected_output_bytes(const AppConfig* config, const AppResources* resources) {
+    if (!resources || !resources->config || resources->expected_total_output_frames <= 0 || resources->config->target_rate <= 0.0) {
+        return 0;
+    }
+    double frames = (double)resources->expected_total_output_frames * (config->target_rate / resources->config->target_rate);
+    return (long long)ceil(frames) * (long long)get_bytes_per_sample(config->output_format);
+}
+
+/**
+ * @brief Returns the checkpoint a resumed run continues the main output from, or NULL.
+ */
+static const CheckpointState* _resume_checkpoint(const AppConfig* config, const AppResources* resources) {
+    if (!resources || config != resources->config || !resources->checkpoint.resuming) {
+        return NULL;
+    }
+    return &resources->checkpoint;
+}
+
+#ifdef __linux__
+/**
+ * @brief Reserves disk space for an output file up front, so the filesystem can lay
+ *        it out contiguously instead of allocating extents as the writer appends.
+ *
+ * The file size is left alone (FALLOC_FL_KEEP_SIZE), so a reader of a file
+ * still being written never sees the zero-filled reservation as data.
+ */
+static bool _preallocate_fd(int fd, long long bytes) {
+    if (bytes <= 0) return false;
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)bytes) != 0) {
+        log_debug("Could not preallocate %lld bytes of output: %s", bytes, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Frees whatever part of a reservation lies beyond the end of the written data.
+ */
+static void _release_preallocation(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && ftruncate(fd, st.st_size) != 0) {
+        log_debug("Could not release preallocated output space: %s", strerror(errno));
+    }
+}
+#endif
+
+#ifdef _WIN32
+static bool _utf8_to_wide_path(const char* path, wchar_t* buffer, int buffer_chars) {
+    return MultiByteToWideChar(CP_UTF8, 0, path, -1, buffer, buffer_chars) > 0;
+}
+#endif
+
+/**
+ * @brief Creates an output file and reserves space for `expected_bytes`.
+ *
+ * With `direct_io` (and an arena for the writer's buffers), the file is
+ * written with O_DIRECT if the filesystem allows it. Returns false with errno
+ * set if the file can't be created; the caller reports the error.
+ */
+static bool _payload_open(RawWriterData* data, const char* path, bool direct_io, long long expected_bytes, MemoryArena* arena) {
+#ifdef _WIN32
+    (void)direct_io;
+    (void)expected_bytes;
+    (void)arena;
+    wchar_t path_w[MAX_PATH_BUFFER];
+    if (!_utf8_to_wide_path(path, path_w, MAX_PATH_BUFFER)) {
+        errno = EINVAL;
+        return false;
+    }
+    data->handle = _wfopen(path_w, L"wb");
+#else
+    if (direct_io && arena) {
+        data->direct = direct_writer_open(path, arena);
+        if (data->direct) {
+            direct_writer_preallocate(data->direct, expected_bytes);
+            data->zero_copy_method = ZERO_COPY_UNSUPPORTED;
+            return true;
+        }
+        log_warn("Direct I/O is not supported for %s, using buffered writes.", path);
+    }
+    data->handle = fopen(path, "wb");
+#endif
+    if (!data->handle) {
+        return false;
+    }
+
+    data->zero_copy_method = ZERO_COPY_FILE_RANGE;
+#ifdef __linux__
+    data->preallocated = _preallocate_fd(fileno(data->handle), expected_bytes);
+#endif
+    return true;
+}
+
+/**
+ * @brief Opens an existing output file (--resume) and cuts it back to `keep_bytes`, to be continued from there.
+ *
+ * Output written after the checkpoint was saved is dropped. Reports its own errors.
+ */
+static bool _payload_reopen(RawWriterData* data, const char* path, long long keep_bytes, long long expected_bytes) {
+#ifdef _WIN32
+    (void)expected_bytes;
+    wchar_t path_w[MAX_PATH_BUFFER];
+    if (!_utf8_to_wide_path(path, path_w, MAX_PATH_BUFFER)) {
+        log_fatal("Invalid output path %s.", path);
+        return false;
+    }
+    data->handle = _wfopen(path_w, L"r+b");
+#else
+    data->handle = fopen(path, "r+b");
+#endif
+    if (!data->handle) {
+        log_fatal("Cannot resume output file %s: %s", path, strerror(errno));
+        return false;
+    }
+
+#ifdef _WIN32
+    bool long_enough = _fseeki64(data->handle, 0, SEEK_END) == 0 && _ftelli64(data->handle) >= keep_bytes;
+    bool ok = long_enough && _chsize_s(_fileno(data->handle), keep_bytes) == 0 && _fseeki64(data->handle, keep_bytes, SEEK_SET) == 0;
+#else
+    struct stat st;
+    bool long_enough = fstat(fileno(data->handle), &st) == 0 && (long long)st.st_size >= keep_bytes;
+    bool ok = long_enough && ftruncate(fileno(data->handle), (off_t)keep_bytes) == 0 && fseeko(data->handle, (off_t)keep_bytes, SEEK_SET) == 0;
+#endif
+    if (!ok) {
+        if (!long_enough) {
+            log_fatal("Output file %s is shorter than its checkpoint records; it cannot be resumed.", path);
+        } else {
+            log_fatal("Cannot resume output file %s: %s", path, strerror(errno));
+        }
+        fclose(data->handle);
+        data->handle = NULL;
+        return false;
+    }
+
+    data->zero_copy_method = ZERO_COPY_FILE_RANGE;
+#ifdef __linux__
+    data->preallocated = _preallocate_fd(fileno(data->handle), (expected_bytes > 0) ? keep_bytes + expected_bytes : 0);
+#endif
+    return true;
+}
+
+static size_t _payload_write(RawWriterData* data, const void* buffer, size_t bytes_to_write) {
+    if (data->direct) {
+        return direct_writer_write(data->direct, buffer, bytes_to_write);
+    }
+    if (data->handle) {
+        return fwrite(buffer, 1, bytes_to_write, data->handle);
+    }
+    return 0;
+}
+
+/**
+ * @brief Overwrites bytes already written, e.g. a header. No more data may be appended afterwards.
+ */
+static bool _payload_patch(RawWriterData* data, long long offset, const void* buffer, size_t bytes) {
+    if (data->direct) {
+        return direct_writer_finish(data->direct) && direct_writer_pwrite(data->direct, offset, buffer, bytes);
+    }
+    if (!data->handle || fflush(data->handle) != 0 || fseek(data->handle, (long)offset, SEEK_SET) != 0) {
+        return false;
+    }
+    return fwrite(buffer, 1, bytes, data->handle) == bytes;
+}
+
+/**
+ * @brief Flushes what has been written so far to stable storage.
+ */
+static bool _payload_sync(RawWriterData* data) {
+    if (!data->handle) {
+        errno = EOPNOTSUPP;
+        return false;
+    }
+    if (fflush(data->handle) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(data->handle)) == 0;
+#else
+    return fsync(fileno(data->handle)) == 0;
+#endif
+}
+
+static void _payload_close(RawWriterData* data) {
+    if (data->direct) {
+        if (!direct_writer_close(data->direct)) {
+            log_error("Output file may be incomplete.");
+        }
+        data->direct = NULL;
+    }
+    if (data->handle && data->handle != stdout) {
+#ifdef __linux__
+        if (data->preallocated) {
+            fflush(data->handle);
+            _release_preallocation(fileno(data->handle));
+        }
+#endif
+        fclose(data->handle);
+    }
+    data->handle = NULL;
+}
+
+
 
 // --- RAW Writer Implementation ---
 // MODIFIED: Signature updated to accept MemoryArena
 static bool raw_open(FileWriterContext* ctx, const AppConfig* config, AppResources* resources, MemoryArena* arena) {
-    (void)resources;
-
     if (config->output_to_stdout) {
         #ifdef _WIN32
         if (!set_stdout_binary()) return false;
@@ -91,6 +339,18 @@ static bool raw_open(FileWriterContext* ctx, const AppConfig* config, AppResourc
             return false;
         }
         data->handle = stdout;
+        data->zero_copy_method = ZERO_COPY_SENDFILE;
+#ifdef __linux__
+        // Stdout redirected to a file can take the same fast path as a named output file.
+        struct stat st;
+        int fd_flags = fcntl(fileno(stdout), F_GETFL);
+        if (fd_flags >= 0 && (fd_flags & O_APPEND)) {
+            // Neither copy_file_range() nor sendfile() writes to a file opened for append (`>>`).
+            data->zero_copy_method = ZERO_COPY_UNSUPPORTED;
+        } else if (fstat(fileno(stdout), &st) == 0 && S_ISREG(st.st_mode)) {
+            data->zero_copy_method = ZERO_COPY_FILE_RANGE;
+        }
+#endif
         ctx->private_data = data;
         return true;
     }
@@ -113,7 +373,8 @@ static bool raw_open(FileWriterContext* ctx, const AppConfig* config, AppResourc
     }
     #endif
 
-    if (file_exists) {
+    const CheckpointState* checkpoint = _resume_checkpoint(config, resources);
+    if (file_exists && !checkpoint) {
         if (!prompt_for_overwrite(out_path)) {
             return false;
         }
@@ -125,13 +386,11 @@ static bool raw_open(FileWriterContext* ctx, const AppConfig* config, AppResourc
         return false;
     }
 
-    #ifdef _WIN32
-    data->handle = _wfopen(config->effective_output_filename_w, L"wb");
-    #else
-    data->handle = fopen(out_path, "wb");
-    #endif
-
-    if (!data->handle) {
+    if (checkpoint) {
+        if (!_payload_reopen(data, out_path, checkpoint->resume_output_bytes, _expected_output_bytes(config, resources))) {
+            return false;
+        }
+    } else if (!_payload_open(data, out_path, config->direct_io, _expected_output_bytes(config, resources), arena)) {
         log_fatal("Error opening output file %s: %s", out_path, strerror(errno));
         // REMOVED: free(data); - Memory is now managed by the arena
         return false;
@@ -143,31 +402,159 @@ static bool raw_open(FileWriterContext* ctx, const AppConfig* config, AppResourc
 
 static size_t raw_write(FileWriterContext* ctx, const void* buffer, size_t bytes_to_write) {
     RawWriterData* data = (RawWriterData*)ctx->private_data;
-    if (!data || !data->handle) return 0;
+    if (!data) return 0;
 
-    size_t written = fwrite(buffer, 1, bytes_to_write, data->handle);
+    size_t written = _payload_write(data, buffer, bytes_to_write);
     if (written > 0) {
         ctx->total_bytes_written += written;
     }
     return written;
 }
 
-static void raw_close(FileWriterContext* ctx) {
-    if (!ctx || !ctx->private_data) return;
+#ifdef __linux__
+/**
+ * @brief Copies input bytes to the output without passing them through user space.
+ *
+ * copy_file_range() is tried first, since it lets filesystems that support it
+ * share extents instead of copying data. If the kernel or filesystem refuses,
+ * the writer drops to sendfile() for the rest of the run.
+ */
+static long long raw_copy_from_fd(FileWriterContext* ctx, int in_fd, long long in_offset, size_t length) {
     RawWriterData* data = (RawWriterData*)ctx->private_data;
-    if (data->handle && data->handle != stdout) {
-        fclose(data->handle);
+    if (!data || data->zero_copy_method == ZERO_COPY_UNSUPPORTED) {
+        errno = EOPNOTSUPP;
+        return -1;
     }
+    if (!data->handle) {
+        errno = EBADF;
+        return -1;
+    }
+    // Anything already buffered by stdio must land before the copied bytes.
+    if (fflush(data->handle) != 0) return -1;
+    int out_fd = fileno(data->handle);
+
+    ssize_t copied = -1;
+    if (data->zero_copy_method == ZERO_COPY_FILE_RANGE) {
+        loff_t offset = (loff_t)in_offset;
+        copied = copy_file_range(in_fd, &offset, out_fd, NULL, length, 0);
+        if (copied < 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL || errno == EBADF)) {
+            log_debug("copy_file_range() is not available here (%s), using sendfile().", strerror(errno));
+            data->zero_copy_method = ZERO_COPY_SENDFILE;
+        }
+    }
+    if (data->zero_copy_method == ZERO_COPY_SENDFILE) {
+        off_t offset = (off_t)in_offset;
+        copied = sendfile(out_fd, in_fd, &offset, length);
+        if (copied < 0 && (errno == ENOSYS || errno == EINVAL)) {
+            data->zero_copy_method = ZERO_COPY_UNSUPPORTED;
+        }
+    }
+    if (data->zero_copy_method == ZERO_COPY_UNSUPPORTED) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+
+    if (copied > 0) {
+        ctx->total_bytes_written += copied;
+    }
+    return (long long)copied;
+}
+#endif
+
+static bool raw_sync(FileWriterContext* ctx) {
+    RawWriterData* data = (RawWriterData*)ctx->private_data;
+    return data && _payload_sync(data);
+}
+
+static void raw_close(FileWriterContext* ctx) {
+    if (!ctx || !ctx->private_data) return;
+    _payload_close((RawWriterData*)ctx->private_data);
     // REMOVED: free(data); - Memory is now managed by the arena
     ctx->private_data = NULL;
 }
 
 
 // --- WAV Writer Implementation ---
+//
+// WAV and RF64 files are written natively: the header is written once when
+// the file is created, the samples follow through the raw write path (buffered
+// or O_DIRECT), and the sizes are patched into the header at close.
+
+/**
+ * @brief Describes the header for an output file, including the SDR metadata of the main output.
+ */
+static bool _wav_header_init(WavHeaderInfo* header, const AppConfig* config, const AppResources* resources) {
+    memset(header, 0, sizeof(WavHeaderInfo));
+    header->sample_rate = (uint32_t)config->target_rate;
+    header->rf64 = (config->output_type == OUTPUT_TYPE_WAV_RF64);
+
+    switch (config->output_format) {
+        case CS16: header->bits_per_sample = 16; break;
+        case CU8:  header->bits_per_sample = 8;  break;
+        // CS8 is intentionally not handled here as it's invalid for WAV
+        // and already validated in cli.c
+        default:
+            log_fatal("Internal Error: Cannot create WAV file for invalid sample type '%s'.", config->sample_type_name);
+            return false;
+    }
+
+    // Additional outputs may be tuned elsewhere, so only the main output gets an auxi chunk.
+    if (!resources || config != resources->config) {
+        return true;
+    }
+    if (resources->sdr_info.center_freq_hz_present) {
+        header->has_auxi = true;
+        header->center_freq_hz = resources->sdr_info.center_freq_hz - resources->actual_nco_shift_hz;
+        header->start_time_present = resources->sdr_info.timestamp_unix_present;
+        header->start_time = resources->sdr_info.timestamp_unix;
+    }
+#if defined(ANY_SDR_SUPPORT_ENABLED)
+    else if (config->sdr.rf_freq_provided) {
+        header->has_auxi = true;
+        header->center_freq_hz = config->sdr.rf_freq_hz - resources->actual_nco_shift_hz;
+        header->start_time_present = true;
+        header->start_time = time(NULL);
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Creates the file and writes its header. The sample data follows it.
+ */
+static bool _wav_begin(WavWriterData* data, const char* path, bool direct_io, long long expected_data_bytes, MemoryArena* arena) {
+    unsigned char header[WAV_HEADER_MAX_BYTES];
+    size_t header_bytes = wav_header_build(&data->header, 0, header, NULL);
+    long long expected_bytes = (expected_data_bytes > 0) ? expected_data_bytes + (long long)header_bytes : 0;
+
+    if (!_payload_open(&data->payload, path, direct_io, expected_bytes, arena)) {
+        return false;
+    }
+    if (_payload_write(&data->payload, header, header_bytes) != header_bytes) {
+        int saved_errno = errno;
+        _payload_close(&data->payload);
+        errno = saved_errno;
+        return false;
+    }
+    data->data_bytes = 0;
+    return true;
+}
+
+/**
+ * @brief Reopens a file to continue it after `kept_data_bytes` of samples (--resume). The header is rewritten at close.
+ */
+static bool _wav_resume(WavWriterData* data, const char* path, long long kept_data_bytes, long long expected_data_bytes) {
+    unsigned char header[WAV_HEADER_MAX_BYTES];
+    size_t header_bytes = wav_header_build(&data->header, 0, header, NULL);
+    if (!_payload_reopen(&data->payload, path, (long long)header_bytes + kept_data_bytes, expected_data_bytes)) {
+        return false;
+    }
+    data->data_bytes = kept_data_bytes;
+    return true;
+}
+
 // MODIFIED: Signature updated to accept MemoryArena
 static bool wav_open(FileWriterContext* ctx, const AppConfig* config, AppResources* resources, MemoryArena* arena) {
-    (void)resources;
-
 #ifdef _WIN32
     const char* out_path = config->effective_output_filename_utf8;
 #else
@@ -186,54 +573,28 @@ static bool wav_open(FileWriterContext* ctx, const AppConfig* config, AppResourc
     }
     #endif
 
-    if (file_exists) {
+    const CheckpointState* checkpoint = _resume_checkpoint(config, resources);
+    if (file_exists && !checkpoint) {
         if (!prompt_for_overwrite(out_path)) {
             return false;
         }
     }
 
-    SF_INFO sfinfo;
-    memset(&sfinfo, 0, sizeof(SF_INFO));
-    sfinfo.samplerate = (int)config->target_rate;
-    sfinfo.channels = 2;
-
-    int format;
-    if (config->output_type == OUTPUT_TYPE_WAV) {
-        format = SF_FORMAT_WAV;
-    } else { // This handles OUTPUT_TYPE_WAV_RF64
-        format = SF_FORMAT_RF64;
-    }
-
-    switch (config->output_format) {
-        case CS16: format |= SF_FORMAT_PCM_16; break;
-        case CU8:  format |= SF_FORMAT_PCM_U8; break;
-        // CS8 is intentionally not handled here as it's invalid for WAV
-        // and already validated in cli.c
-        default:
-            log_fatal("Internal Error: Cannot create WAV file for invalid sample type '%s'.", config->sample_type_name);
-            return false;
-    }
-    sfinfo.format = format;
-
-    if (!sf_format_check(&sfinfo)) {
-        log_fatal("libsndfile does not support the requested WAV format (Rate: %d, Format: 0x%08X).", sfinfo.samplerate, sfinfo.format);
-        return false;
-    }
-
     // MODIFIED: Allocate from arena instead of malloc
     WavWriterData* data = (WavWriterData*)mem_arena_alloc(arena, sizeof(WavWriterData));
     if (!data) {
         return false;
     }
 
-    #ifdef _WIN32
-    data->handle = sf_wchar_open(config->effective_output_filename_w, SFM_WRITE, &sfinfo);
-    #else
-    data->handle = sf_open(out_path, SFM_WRITE, &sfinfo);
-    #endif
-
-    if (!data->handle) {
-        log_fatal("Error opening output WAV file %s: %s", out_path, sf_strerror(NULL));
+    if (!_wav_header_init(&data->header, config, resources)) {
+        return false;
+    }
+    if (checkpoint) {
+        if (!_wav_resume(data, out_path, checkpoint->resume_output_bytes, _expected_output_bytes(config, resources))) {
+            return false;
+        }
+    } else if (!_wav_begin(data, out_path, config->direct_io, _expected_output_bytes(config, resources), arena)) {
+        log_fatal("Error opening output WAV file %s: %s", out_path, strerror(errno));
         // REMOVED: free(data); - Memory is now managed by the arena
         return false;
     }
@@ -244,27 +605,384 @@ static bool wav_open(FileWriterContext* ctx, const AppConfig* config, AppResourc
 
 static size_t wav_write(FileWriterContext* ctx, const void* buffer, size_t bytes_to_write) {
     WavWriterData* data = (WavWriterData*)ctx->private_data;
-    if (!data || !data->handle || bytes_to_write == 0) return 0;
+    if (!data || bytes_to_write == 0) return 0;
 
-    sf_count_t bytes_written = sf_write_raw(data->handle, buffer, bytes_to_write);
-
-    if (bytes_written > 0) {
-        ctx->total_bytes_written += bytes_written;
+    size_t written = _payload_write(&data->payload, buffer, bytes_to_write);
+    if (written > 0) {
+        data->data_bytes += (long long)written;
+        ctx->total_bytes_written += written;
     }
-    return (size_t)bytes_written;
+    return written;
+}
+
+static bool wav_sync(FileWriterContext* ctx) {
+    WavWriterData* data = (WavWriterData*)ctx->private_data;
+    return data && _payload_sync(&data->payload);
 }
 
 static void wav_close(FileWriterContext* ctx) {
     if (!ctx || !ctx->private_data) return;
     WavWriterData* data = (WavWriterData*)ctx->private_data;
-    if (data->handle) {
-        sf_close(data->handle);
+
+    // The header has the same length whatever the sizes, so it is rewritten in place.
+    unsigned char header[WAV_HEADER_MAX_BYTES];
+    bool is_rf64 = false;
+    size_t header_bytes = wav_header_build(&data->header, data->data_bytes, header, &is_rf64);
+    if (!_payload_patch(&data->payload, 0, header, header_bytes)) {
+        log_error("Could not finalize the WAV header: %s", strerror(errno));
+    } else if (is_rf64 && !data->header.rf64) {
+        log_warn("Output exceeded the 4 GB WAV limit and was written as RF64.");
     }
+
+    _payload_close(&data->payload);
     // REMOVED: free(data); - Memory is now managed by the arena
     ctx->private_data = NULL;
 }
 
 
+// --- Segmented Writer Implementation (--segment-size / --segment-duration) ---
+//
+// The output is split into numbered files (<name>_0001.wav, <name>_0002.wav, ...),
+// each a complete raw or WAV/RF64 file of its own. A worker thread opens and
+// preallocates the next segment ahead of time and closes full segments (which
+// for WAV means rewriting the header), so a rotation on the writer thread is
+// just a pointer swap.
+
+#define SEGMENT_NUM_SLOTS 3 // Active, next (being prepared), previous (being closed)
+
+typedef enum {
+    SEGMENT_SLOT_FREE,
+    SEGMENT_SLOT_PREPARE,   // Requested; the worker opens the file
+    SEGMENT_SLOT_READY,     // Open and preallocated, waiting to become active
+    SEGMENT_SLOT_FAILED,    // The worker could not open the file
+    SEGMENT_SLOT_ACTIVE,    // Being written by the writer thread
+    SEGMENT_SLOT_CLOSING    // Full; the worker closes it
+} SegmentSlotState;
+
+typedef struct {
+    FileWriterContext inner;
+    union {
+        RawWriterData raw;
+        WavWriterData wav;
+    } storage;
+    unsigned int number;    // Segment number, from 1
+    SegmentSlotState state;
+} SegmentSlot;
+
+typedef struct {
+    const AppConfig* config;
+    char base_path[MAX_PATH_BUFFER];
+    long long segment_bytes;        // Whole frames per segment
+    long long current_bytes;        // Written to the active segment so far
+    WavHeaderInfo header;           // Header of the first WAV segment; later ones start later
+    SegmentSlot slots[SEGMENT_NUM_SLOTS];
+    int current;
+
+    pthread_t worker;
+    bool worker_started;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool stop_requested;
+} SegmentedWriterData;
+
+bool file_writer_make_segment_path(const char* base_path, unsigned int number, char* buffer, size_t buffer_size) {
+    const char* last_sep = strrchr(base_path, '/');
+#ifdef _WIN32
+    const char* last_backslash = strrchr(base_path, '\\');
+    if (last_backslash && (!last_sep || last_backslash > last_sep)) last_sep = last_backslash;
+#endif
+    const char* name = last_sep ? last_sep + 1 : base_path;
+    const char* ext = strrchr(name, '.');
+    if (!ext || ext == name) ext = base_path + strlen(base_path);
+
+    int written = snprintf(buffer, buffer_size, "%.*s_%04u%s", (int)(ext - base_path), base_path, number, ext);
+    return (written > 0 && (size_t)written < buffer_size);
+}
+
+static bool _segment_path_exists(const char* path) {
+#ifdef _WIN32
+    wchar_t path_w[MAX_PATH_BUFFER];
+    if (!_utf8_to_wide_path(path, path_w, MAX_PATH_BUFFER)) return false;
+    DWORD attrs = GetFileAttributesW(path_w);
+    return (attrs != INVALID_FILE_ATTRIBUTES && !(attrs & FILE_ATTRIBUTE_DIRECTORY));
+#else
+    return access(path, F_OK) == 0;
+#endif
+}
+
+static void _segment_remove_file(const char* path) {
+#ifdef _WIN32
+    wchar_t path_w[MAX_PATH_BUFFER];
+    if (_utf8_to_wide_path(path, path_w, MAX_PATH_BUFFER)) _wremove(path_w);
+#else
+    remove(path);
+#endif
+}
+
+/**
+ * @brief Opens the file for a segment slot. Runs on the worker thread, except for the first segment.
+ */
+static bool _segment_open_slot(SegmentedWriterData* seg, SegmentSlot* slot) {
+    char path[MAX_PATH_BUFFER];
+    if (!file_writer_make_segment_path(seg->base_path, slot->number, path, sizeof(path))) {
+        log_error("Output path for segment %u is too long.", slot->number);
+        return false;
+    }
+
+    memset(&slot->inner, 0, sizeof(slot->inner));
+    memset(&slot->storage, 0, sizeof(slot->storage));
+    slot->inner.ops.get_total_bytes_written = generic_get_total_bytes_written;
+
+    if (seg->config->output_type == OUTPUT_TYPE_RAW) {
+        RawWriterData* data = &slot->storage.raw;
+        if (!_payload_open(data, path, false, seg->segment_bytes, NULL)) {
+            log_error("Error opening output segment %s: %s", path, strerror(errno));
+            return false;
+        }
+        data->zero_copy_method = ZERO_COPY_UNSUPPORTED;
+        slot->inner.ops.write = raw_write;
+        slot->inner.ops.close = raw_close;
+        slot->inner.private_data = data;
+    } else {
+        WavWriterData* data = &slot->storage.wav;
+        data->header = seg->header;
+        if (data->header.start_time_present) {
+            double bytes_per_second = (double)get_bytes_per_sample(seg->config->output_format) * seg->config->target_rate;
+            data->header.start_time += (time_t)((double)(slot->number - 1) * (double)seg->segment_bytes / bytes_per_second);
+        }
+        if (!_wav_begin(data, path, false, seg->segment_bytes, NULL)) {
+            log_error("Error opening output segment %s: %s", path, strerror(errno));
+            return false;
+        }
+        slot->inner.ops.write = wav_write;
+        slot->inner.ops.close = wav_close;
+        slot->inner.private_data = data;
+    }
+
+    log_debug("Output segment %s opened.", path);
+    return true;
+}
+
+static void* _segment_worker_func(void* arg) {
+    SegmentedWriterData* seg = (SegmentedWriterData*)arg;
+
+    pthread_mutex_lock(&seg->mutex);
+    while (true) {
+        // Closing comes first: it frees the slot the next rotation will need.
+        SegmentSlot* job = NULL;
+        for (int k = 0; k < SEGMENT_NUM_SLOTS && !job; k++) {
+            if (seg->slots[k].state == SEGMENT_SLOT_CLOSING) job = &seg->slots[k];
+        }
+        for (int k = 0; k < SEGMENT_NUM_SLOTS && !job && !seg->stop_requested; k++) {
+            if (seg->slots[k].state == SEGMENT_SLOT_PREPARE) job = &seg->slots[k];
+        }
+        if (!job) {
+            if (seg->stop_requested) break;
+            pthread_cond_wait(&seg->cond, &seg->mutex);
+            continue;
+        }
+
+        SegmentSlotState job_state = job->state;
+        pthread_mutex_unlock(&seg->mutex);
+
+        SegmentSlotState result;
+        if (job_state == SEGMENT_SLOT_CLOSING) {
+            job->inner.ops.close(&job->inner);
+            result = SEGMENT_SLOT_FREE;
+        } else {
+            result = _segment_open_slot(seg, job) ? SEGMENT_SLOT_READY : SEGMENT_SLOT_FAILED;
+        }
+
+        pthread_mutex_lock(&seg->mutex);
+        job->state = result;
+        pthread_cond_broadcast(&seg->cond);
+    }
+    pthread_mutex_unlock(&seg->mutex);
+    return NULL;
+}
+
+/**
+ * @brief Makes the prepared segment active and hands the full one to the worker.
+ *        Only waits if the worker has fallen a whole segment behind.
+ */
+static bool _segment_rotate(SegmentedWriterData* seg) {
+    SegmentSlot* full = &seg->slots[seg->current];
+    int next = (seg->current + 1) % SEGMENT_NUM_SLOTS;
+    SegmentSlot* incoming = &seg->slots[next];
+    SegmentSlot* after = &seg->slots[(next + 1) % SEGMENT_NUM_SLOTS];
+
+    pthread_mutex_lock(&seg->mutex);
+    while (incoming->state == SEGMENT_SLOT_PREPARE) {
+        pthread_cond_wait(&seg->cond, &seg->mutex);
+    }
+    if (incoming->state != SEGMENT_SLOT_READY) {
+        pthread_mutex_unlock(&seg->mutex);
+        log_error("Could not open output segment %u.", incoming->number);
+        return false;
+    }
+
+    full->state = SEGMENT_SLOT_CLOSING;
+    incoming->state = SEGMENT_SLOT_ACTIVE;
+    seg->current = next;
+    seg->current_bytes = 0;
+
+    // The slot after the new segment held the one closed at the previous rotation.
+    while (after->state == SEGMENT_SLOT_CLOSING) {
+        pthread_cond_wait(&seg->cond, &seg->mutex);
+    }
+    after->number = incoming->number + 1;
+    after->state = SEGMENT_SLOT_PREPARE;
+    pthread_cond_broadcast(&seg->cond);
+    pthread_mutex_unlock(&seg->mutex);
+
+    log_debug("Output rolled over to segment %u.", incoming->number);
+    return true;
+}
+
+static bool segmented_open(FileWriterContext* ctx, const AppConfig* config, AppResources* resources, MemoryArena* arena) {
+#ifdef _WIN32
+    const char* out_path = config->effective_output_filename_utf8;
+#else
+    const char* out_path = config->effective_output_filename;
+#endif
+
+    // A segment ends after whichever limit is reached first, on a whole frame.
+    long long bytes_per_frame = (long long)get_bytes_per_sample(config->output_format);
+    long long segment_frames = LLONG_MAX;
+    if (config->segment_size_mb_arg > 0.0f) {
+        segment_frames = (long long)((double)config->segment_size_mb_arg * 1024.0 * 1024.0) / bytes_per_frame;
+    }
+    if (config->segment_duration_sec_arg > 0.0f) {
+        long long duration_frames = (long long)((double)config->segment_duration_sec_arg * config->target_rate);
+        if (duration_frames < segment_frames) segment_frames = duration_frames;
+    }
+    if (segment_frames < 1) {
+        log_fatal("Output segments must hold at least one sample.");
+        return false;
+    }
+    long long segment_bytes = segment_frames * bytes_per_frame;
+    if (config->output_type == OUTPUT_TYPE_WAV && segment_bytes > WAV_MAX_DATA_BYTES) {
+        log_fatal("WAV segments are limited to 4 GB. Use a smaller segment or --output-container wav-rf64.");
+        return false;
+    }
+
+    SegmentedWriterData* seg = (SegmentedWriterData*)mem_arena_alloc(arena, sizeof(SegmentedWriterData));
+    if (!seg) {
+        return false;
+    }
+    seg->config = config;
+    seg->segment_bytes = segment_bytes;
+    if (config->output_type != OUTPUT_TYPE_RAW && !_wav_header_init(&seg->header, config, resources)) {
+        return false;
+    }
+    if ((size_t)snprintf(seg->base_path, sizeof(seg->base_path), "%s", out_path) >= sizeof(seg->base_path)) {
+        log_fatal("Output path %s is too long.", out_path);
+        return false;
+    }
+
+    // Ask once, for the first segment; later segments with the same base name are replaced.
+    char first_path[MAX_PATH_BUFFER];
+    if (!file_writer_make_segment_path(seg->base_path, 1, first_path, sizeof(first_path))) {
+        log_fatal("Output path %s is too long.", out_path);
+        return false;
+    }
+    if (_segment_path_exists(first_path) && !prompt_for_overwrite(first_path)) {
+        return false;
+    }
+
+    seg->slots[0].number = 1;
+    if (!_segment_open_slot(seg, &seg->slots[0])) {
+        return false;
+    }
+    seg->slots[0].state = SEGMENT_SLOT_ACTIVE;
+    seg->slots[1].number = 2;
+    seg->slots[1].state = SEGMENT_SLOT_PREPARE;
+
+    if (pthread_mutex_init(&seg->mutex, NULL) != 0) {
+        log_fatal("Failed to initialize the output segment worker.");
+        goto close_first_segment;
+    }
+    if (pthread_cond_init(&seg->cond, NULL) != 0) {
+        log_fatal("Failed to initialize the output segment worker.");
+        pthread_mutex_destroy(&seg->mutex);
+        goto close_first_segment;
+    }
+    if (pthread_create(&seg->worker, NULL, _segment_worker_func, seg) != 0) {
+        log_fatal("Failed to start the output segment worker thread.");
+        pthread_cond_destroy(&seg->cond);
+        pthread_mutex_destroy(&seg->mutex);
+        goto close_first_segment;
+    }
+    seg->worker_started = true;
+    ctx->private_data = seg;
+    return true;
+
+close_first_segment:
+    // Nothing has been written yet, so the first segment's file is removed too.
+    seg->slots[0].inner.ops.close(&seg->slots[0].inner);
+    seg->slots[0].state = SEGMENT_SLOT_FREE;
+    _segment_remove_file(first_path);
+    return false;
+}
+
+static size_t segmented_write(FileWriterContext* ctx, const void* buffer, size_t bytes_to_write) {
+    SegmentedWriterData* seg = (SegmentedWriterData*)ctx->private_data;
+    if (!seg) return 0;
+
+    const unsigned char* bytes = (const unsigned char*)buffer;
+    size_t done = 0;
+    while (done < bytes_to_write) {
+        if (seg->current_bytes >= seg->segment_bytes && !_segment_rotate(seg)) {
+            break;
+        }
+        SegmentSlot* slot = &seg->slots[seg->current];
+        size_t room = (size_t)(seg->segment_bytes - seg->current_bytes);
+        size_t take = (bytes_to_write - done < room) ? bytes_to_write - done : room;
+
+        size_t written = slot->inner.ops.write(&slot->inner, bytes + done, take);
+        seg->current_bytes += (long long)written;
+        done += written;
+        if (written < take) break;
+    }
+
+    ctx->total_bytes_written += done;
+    return done;
+}
+
+static void segmented_close(FileWriterContext* ctx) {
+    if (!ctx || !ctx->private_data) return;
+    SegmentedWriterData* seg = (SegmentedWriterData*)ctx->private_data;
+
+    if (seg->worker_started) {
+        // The worker finishes any pending close before it exits.
+        pthread_mutex_lock(&seg->mutex);
+        seg->stop_requested = true;
+        pthread_cond_broadcast(&seg->cond);
+        pthread_mutex_unlock(&seg->mutex);
+        pthread_join(seg->worker, NULL);
+        seg->worker_started = false;
+        pthread_cond_destroy(&seg->cond);
+        pthread_mutex_destroy(&seg->mutex);
+    }
+
+    for (int k = 0; k < SEGMENT_NUM_SLOTS; k++) {
+        SegmentSlot* slot = &seg->slots[k];
+        if (slot->state == SEGMENT_SLOT_ACTIVE) {
+            slot->inner.ops.close(&slot->inner);
+        } else if (slot->state == SEGMENT_SLOT_READY) {
+            // Opened ahead of time but never needed.
+            char path[MAX_PATH_BUFFER];
+            slot->inner.ops.close(&slot->inner);
+            if (file_writer_make_segment_path(seg->base_path, slot->number, path, sizeof(path))) {
+                _segment_remove_file(path);
+            }
+        }
+        slot->state = SEGMENT_SLOT_FREE;
+    }
+    ctx->private_data = NULL;
+}
+
+
 // --- Public Factory Function ---
 bool file_writer_init(FileWriterContext* ctx, const AppConfig* config) {
     memset(ctx, 0, sizeof(FileWriterContext));
@@ -275,6 +993,10 @@ bool file_writer_init(FileWriterContext* ctx, const AppConfig* config) {
             ctx->ops.write = raw_write;
             ctx->ops.close = raw_close;
             ctx->ops.get_total_bytes_written = generic_get_total_bytes_written;
+            ctx->ops.sync = raw_sync;
+#ifdef __linux__
+            ctx->ops.copy_from_fd = raw_copy_from_fd;
+#endif
             break;
         case OUTPUT_TYPE_WAV:
         case OUTPUT_TYPE_WAV_RF64:
@@ -282,10 +1004,20 @@ bool file_writer_init(FileWriterContext* ctx, const AppConfig* config) {
             ctx->ops.write = wav_write;
             ctx->ops.close = wav_close;
             ctx->ops.get_total_bytes_written = generic_get_total_bytes_written;
+            ctx->ops.sync = wav_sync;
             break;
         default:
             log_fatal("Internal Error: Unknown output type specified.");
             return false;
     }
+
+    // Segmented output wraps either writer; the segments are opened with the same settings.
+    if (config->segment_size_mb_arg > 0.0f || config->segment_duration_sec_arg > 0.0f) {
+        ctx->ops.open = segmented_open;
+        ctx->ops.write = segmented_write;
+        ctx->ops.close = segmented_close;
+        ctx->ops.copy_from_fd = NULL;
+        ctx->ops.sync = NULL;
+    }
     return true;
 }
@@ -3,6 +3,12 @@
 #include "log.h"
 #include "config.h"
 #include "memory_arena.h"
+#include "filter_cache.h"
+#include "filter_pool.h"
+#include "utils.h"
+#ifdef WITH_FFTW
+#include "fftw_filter.h"
+#endif
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -17,6 +23,66 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+static unsigned int next_power_of_two(unsigned int n) {
+    unsigned int p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+/**
+ * @brief Convolves two tap sets by multiplying their spectra.
+ *
+ * The scratch buffers can be far larger than the setup arena is sized for, so
+ * they are heap-allocated and released before returning.
+ */
+static bool fft_convolve_taps(const liquid_float_complex* h1, int len1,
+                              const liquid_float_complex* h2, int len2,
+                              liquid_float_complex* result, int result_len)
+{
+    bool success = false;
+    unsigned int nfft = next_power_of_two((unsigned int)result_len);
+    liquid_float_complex* a = (liquid_float_complex*)calloc(nfft, sizeof(liquid_float_complex));
+    liquid_float_complex* b = (liquid_float_complex*)calloc(nfft, sizeof(liquid_float_complex));
+    fftplan plan_a = NULL, plan_b = NULL, plan_inv = NULL;
+    if (!a || !b) {
+        log_fatal("Failed to allocate %u-point buffers for filter convolution.", nfft);
+        goto cleanup;
+    }
+
+    memcpy(a, h1, (size_t)len1 * sizeof(liquid_float_complex));
+    memcpy(b, h2, (size_t)len2 * sizeof(liquid_float_complex));
+
+    plan_a = fft_create_plan(nfft, a, a, LIQUID_FFT_FORWARD, 0);
+    plan_b = fft_create_plan(nfft, b, b, LIQUID_FFT_FORWARD, 0);
+    plan_inv = fft_create_plan(nfft, a, a, LIQUID_FFT_BACKWARD, 0);
+    if (!plan_a || !plan_b || !plan_inv) {
+        log_fatal("Failed to create FFT plans for filter convolution.");
+        goto cleanup;
+    }
+
+    fft_execute(plan_a);
+    fft_execute(plan_b);
+    for (unsigned int i = 0; i < nfft; i++) {
+        a[i] *= b[i];
+    }
+    fft_execute(plan_inv);
+
+    // liquid-dsp's inverse transform is unscaled.
+    float scale = 1.0f / (float)nfft;
+    for (int i = 0; i < result_len; i++) {
+        result[i] = a[i] * scale;
+    }
+    success = true;
+
+cleanup:
+    if (plan_a) fft_destroy_plan(plan_a);
+    if (plan_b) fft_destroy_plan(plan_b);
+    if (plan_inv) fft_destroy_plan(plan_inv);
+    free(a);
+    free(b);
+    return success;
+}
+
 static liquid_float_complex* convolve_complex_taps(
     const liquid_float_complex* h1, int len1,
     const liquid_float_complex* h2, int len2,
@@ -28,38 +94,159 @@ static liquid_float_complex* convolve_complex_taps(
         return NULL;
     }
 
-    for (int i = 0; i < *out_len; i++) {
-        for (int j = 0; j < len2; j++) {
-            if (i - j >= 0 && i - j < len1) {
-                result[i] += h1[i - j] * h2[j];
+    // Direct convolution wins for short stages, including the initial unit tap.
+    if (len1 < FILTER_FFT_CONVOLVE_MIN_TAPS || len2 < FILTER_FFT_CONVOLVE_MIN_TAPS) {
+        for (int i = 0; i < *out_len; i++) {
+            for (int j = 0; j < len2; j++) {
+                if (i - j >= 0 && i - j < len1) {
+                    result[i] += h1[i - j] * h2[j];
+                }
             }
         }
+        return result;
+    }
+
+    if (!fft_convolve_taps(h1, len1, h2, len2, result, *out_len)) {
+        return NULL;
     }
     return result;
 }
 
-bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* arena) {
-    bool success = false;
-    liquid_float_complex* master_taps = NULL;
+/**
+ * @brief Finds the peak magnitude response of a filter from one zero-padded FFT.
+ *
+ * The transform is at least FILTER_FREQ_RESPONSE_POINTS long and never shorter
+ * than the filter, so the frequency grid is at least as dense as the old
+ * point-by-point evaluation.
+ *
+ * @return The peak gain, or a negative value on allocation failure.
+ */
+static float compute_peak_gain(const liquid_float_complex* taps, int taps_len) {
+    unsigned int nfft = next_power_of_two((unsigned int)taps_len);
+    if (nfft < FILTER_FREQ_RESPONSE_POINTS) nfft = FILTER_FREQ_RESPONSE_POINTS;
 
-    resources->user_fir_filter_object = NULL;
-    resources->user_filter_type_actual = FILTER_IMPL_NONE;
-    resources->user_filter_block_size = 0;
+    liquid_float_complex* spectrum = (liquid_float_complex*)calloc(nfft, sizeof(liquid_float_complex));
+    if (!spectrum) return -1.0f;
+    memcpy(spectrum, taps, (size_t)taps_len * sizeof(liquid_float_complex));
 
-    if (config->num_filter_requests == 0) {
-        return true;
+    fftplan plan = fft_create_plan(nfft, spectrum, spectrum, LIQUID_FFT_FORWARD, 0);
+    if (!plan) {
+        free(spectrum);
+        return -1.0f;
+    }
+    fft_execute(plan);
+    fft_destroy_plan(plan);
+
+    float max_mag = 0.0f;
+    for (unsigned int i = 0; i < nfft; i++) {
+        float mag = cabsf(spectrum[i]);
+        if (mag > max_mag) max_mag = mag;
+    }
+    free(spectrum);
+    return max_mag;
+}
+
+/**
+ * @brief Returns the length of one requested filter stage designed at `sample_rate`.
+ */
+static unsigned int request_taps_len(const AppConfig* config, const FilterRequest* req, double sample_rate) {
+    if (config->filter_taps_arg > 0) {
+        return (unsigned int)config->filter_taps_arg;
+    }
+
+    float attenuation_db = (config->attenuation_db_arg > 0.0f) ? config->attenuation_db_arg : RESAMPLER_QUALITY_ATTENUATION_DB;
+    float transition_width_hz;
+    if (config->transition_width_hz_arg > 0.0f) {
+        transition_width_hz = config->transition_width_hz_arg;
+    } else {
+        float reference_freq = (req->type == FILTER_TYPE_LOWPASS || req->type == FILTER_TYPE_HIGHPASS) ? req->freq1_hz : req->freq2_hz;
+        transition_width_hz = fabsf(reference_freq) * DEFAULT_FILTER_TRANSITION_FACTOR;
+    }
+    if (transition_width_hz < 1.0f) transition_width_hz = 1.0f;
+    float normalized_tw = transition_width_hz / (float)sample_rate;
+    unsigned int taps_len = estimate_req_filter_len(normalized_tw, attenuation_db);
+    if (taps_len % 2 == 0) taps_len++;
+    if (taps_len < FILTER_MINIMUM_TAPS) taps_len = FILTER_MINIMUM_TAPS;
+    return taps_len;
+}
+
+/**
+ * @brief Returns the length of the anti-alias prototype for an integer-factor decimator.
+ */
+static unsigned int decimator_prototype_taps_len(unsigned int factor) {
+    float transition_width = (0.5f / (float)factor) * DEFAULT_FILTER_TRANSITION_FACTOR;
+    unsigned int taps_len = estimate_req_filter_len(transition_width, RESAMPLER_QUALITY_ATTENUATION_DB);
+    if (taps_len % 2 == 0) taps_len++;
+    if (taps_len < FILTER_MINIMUM_TAPS) taps_len = FILTER_MINIMUM_TAPS;
+    return taps_len;
+}
+
+/**
+ * @brief Returns the block size of the liquid-dsp FFT filter for a filter of `taps_len` taps.
+ */
+static unsigned int fft_block_size(const AppConfig* config, unsigned int taps_len) {
+    if (config->filter_fft_size_arg > 0) {
+        return (unsigned int)config->filter_fft_size_arg / 2;
+    }
+    unsigned int block_size = 1;
+    while (block_size < taps_len - 1) {
+        block_size *= 2;
+    }
+    if (block_size < taps_len * 2) {
+        block_size *= 2;
+    }
+    return block_size;
+}
+
+/**
+ * @brief Designs the anti-alias prototype for an integer-factor decimator.
+ *
+ * The stopband edge is placed at the output Nyquist frequency so that nothing
+ * above it can alias back into the decimated band. The taps are normalized to
+ * unity DC gain so the merged filter keeps the user filter's normalization.
+ */
+static liquid_float_complex* design_decimator_prototype(unsigned int factor, int* out_len, MemoryArena* arena) {
+    float output_nyquist_norm = 0.5f / (float)factor;
+    float transition_width = output_nyquist_norm * DEFAULT_FILTER_TRANSITION_FACTOR;
+    float cutoff = output_nyquist_norm - (transition_width / 2.0f);
+
+    unsigned int taps_len = decimator_prototype_taps_len(factor);
+
+    float* real_taps = (float*)mem_arena_alloc(arena, taps_len * sizeof(float));
+    liquid_float_complex* taps = (liquid_float_complex*)mem_arena_alloc(arena, taps_len * sizeof(liquid_float_complex));
+    if (!real_taps || !taps) return NULL;
+
+    liquid_firdes_kaiser(taps_len, cutoff, RESAMPLER_QUALITY_ATTENUATION_DB, 0.0f, real_taps);
+
+    double dc_gain = 0.0;
+    for (unsigned int i = 0; i < taps_len; i++) dc_gain += real_taps[i];
+    if (fabs(dc_gain) < FILTER_GAIN_ZERO_THRESHOLD) dc_gain = 1.0;
+
+    for (unsigned int i = 0; i < taps_len; i++) {
+        taps[i] = (float)(real_taps[i] / dc_gain) + 0.0f * I;
     }
+    *out_len = (int)taps_len;
+    return taps;
+}
 
+/**
+ * @brief Designs the final combined filter taps for the configured filter chain.
+ *
+ * Each requested stage is designed with a Kaiser window and convolved into a
+ * single set of taps, which is then normalized to unity peak (or DC) gain. For a
+ * merged decimator, the result is additionally convolved with the decimator's
+ * anti-alias prototype.
+ *
+ * @return true on success, false on failure.
+ */
+static bool design_filter_taps(const AppConfig* config, double sample_rate_for_design, unsigned int decimation_factor,
+                               bool is_final_filter_complex, MemoryArena* arena,
+                               liquid_float_complex** out_taps, int* out_len, float* out_normalization_gain) {
     int master_taps_len = 1;
-    master_taps = (liquid_float_complex*)mem_arena_alloc(arena, sizeof(liquid_float_complex));
-    if (!master_taps) goto cleanup;
+    liquid_float_complex* master_taps = (liquid_float_complex*)mem_arena_alloc(arena, sizeof(liquid_float_complex));
+    if (!master_taps) return false;
     master_taps[0] = 1.0f + 0.0f * I;
 
-    double sample_rate_for_design = config->apply_user_filter_post_resample
-                                      ? config->target_rate
-                                      : (double)resources->source_info.samplerate;
-
-    bool is_final_filter_complex = false;
     bool normalize_by_peak = false;
 
     // --- MODIFIED: Unconditional warning message for consistency ---
@@ -72,37 +259,17 @@ bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* aren
             normalize_by_peak = true;
         }
         
-        unsigned int current_taps_len;
         float attenuation_db = (config->attenuation_db_arg > 0.0f) ? config->attenuation_db_arg : RESAMPLER_QUALITY_ATTENUATION_DB;
-
-        if (config->filter_taps_arg > 0) {
-            current_taps_len = (unsigned int)config->filter_taps_arg;
-        } else {
-            float transition_width_hz;
-            if (config->transition_width_hz_arg > 0.0f) {
-                transition_width_hz = config->transition_width_hz_arg;
-            } else {
-                float reference_freq = (req->type == FILTER_TYPE_LOWPASS || req->type == FILTER_TYPE_HIGHPASS) ? req->freq1_hz : req->freq2_hz;
-                transition_width_hz = fabsf(reference_freq) * DEFAULT_FILTER_TRANSITION_FACTOR;
-            }
-            if (transition_width_hz < 1.0f) transition_width_hz = 1.0f;
-            float normalized_tw = transition_width_hz / (float)sample_rate_for_design;
-            current_taps_len = estimate_req_filter_len(normalized_tw, attenuation_db);
-            if (current_taps_len % 2 == 0) current_taps_len++;
-            if (current_taps_len < FILTER_MINIMUM_TAPS) current_taps_len = FILTER_MINIMUM_TAPS;
-        }
+        unsigned int current_taps_len = request_taps_len(config, req, sample_rate_for_design);
 
         liquid_float_complex* current_taps = (liquid_float_complex*)mem_arena_alloc(arena, current_taps_len * sizeof(liquid_float_complex));
-        if (!current_taps) goto cleanup;
+        if (!current_taps) return false;
 
         bool is_current_stage_complex = (req->type == FILTER_TYPE_PASSBAND && fabsf(req->freq1_hz) > 1e-9f);
-        if (is_current_stage_complex) {
-            is_final_filter_complex = true;
-        }
 
         if (is_current_stage_complex) {
             float* real_taps = (float*)mem_arena_alloc(arena, current_taps_len * sizeof(float));
-            if (!real_taps) goto cleanup;
+            if (!real_taps) return false;
             float half_bw_norm = (req->freq2_hz / 2.0f) / (float)sample_rate_for_design;
             liquid_firdes_kaiser(current_taps_len, half_bw_norm, attenuation_db, 0.0f, real_taps);
             float fc_norm = req->freq1_hz / (float)sample_rate_for_design;
@@ -116,7 +283,7 @@ bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* aren
             nco_crcf_destroy(shifter);
         } else {
             float* real_taps = (float*)mem_arena_alloc(arena, current_taps_len * sizeof(float));
-            if (!real_taps) goto cleanup;
+            if (!real_taps) return false;
             float fc, bw;
             switch (req->type) {
                 case FILTER_TYPE_LOWPASS:
@@ -149,7 +316,7 @@ bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* aren
         int new_master_len;
         liquid_float_complex* new_master_taps = convolve_complex_taps(master_taps, master_taps_len, current_taps, current_taps_len, &new_master_len, arena);
 
-        if (!new_master_taps) goto cleanup;
+        if (!new_master_taps) return false;
 
         master_taps = new_master_taps;
         master_taps_len = new_master_len;
@@ -157,36 +324,18 @@ bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* aren
 
     log_info("Final combined filter requires %d taps.", master_taps_len);
 
-    // Determine filter complexity BEFORE normalization
-    for (int i = 0; i < config->num_filter_requests; ++i) {
-        const FilterRequest* req = &config->filter_requests[i];
-        if (req->type == FILTER_TYPE_PASSBAND && fabsf(req->freq1_hz) > 1e-9f) {
-            is_final_filter_complex = true;
-            break;
-        }
-    }
-
-    if (is_final_filter_complex) {
-        log_info("Asymmetric filter detected.");
-    }
-
+    float normalization_gain = 1.0f;
     if (normalize_by_peak || is_final_filter_complex) {
-        log_info("Normalizing filter gain (this may be slow for large filters)...");
-        float max_mag = 0.0f;
-        firfilt_cccf temp_filter = firfilt_cccf_create(master_taps, master_taps_len);
-        if (temp_filter) {
-            for (int i = 0; i < FILTER_FREQ_RESPONSE_POINTS; i++) {
-                liquid_float_complex H;
-                float freq = ((float)i / (float)FILTER_FREQ_RESPONSE_POINTS) - 0.5f;
-                firfilt_cccf_freqresponse(temp_filter, freq, &H);
-                float mag = cabsf(H);
-                if (mag > max_mag) max_mag = mag;
-            }
-            firfilt_cccf_destroy(temp_filter);
+        log_info("Normalizing filter gain...");
+        float max_mag = compute_peak_gain(master_taps, master_taps_len);
+        if (max_mag < 0.0f) {
+            log_fatal("Failed to allocate memory for the filter frequency response.");
+            return false;
         }
         if (max_mag > FILTER_GAIN_ZERO_THRESHOLD) {
             log_debug("Normalizing filter taps by peak gain factor of %f.", max_mag);
             for (int i = 0; i < master_taps_len; i++) master_taps[i] /= max_mag;
+            normalization_gain = max_mag;
         }
     } else {
         double gain_correction = 0.0;
@@ -196,9 +345,186 @@ bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* aren
         if (fabs(gain_correction) > FILTER_GAIN_ZERO_THRESHOLD) {
             log_debug("Normalizing filter taps by DC gain factor of %f.", gain_correction);
             for (int i = 0; i < master_taps_len; i++) master_taps[i] /= (float)gain_correction;
+            normalization_gain = (float)gain_correction;
         }
     }
 
+    if (decimation_factor > 0) {
+        log_info("Merging filter into a polyphase decimator (factor %u)...", decimation_factor);
+
+        int prototype_len;
+        liquid_float_complex* prototype = design_decimator_prototype(decimation_factor, &prototype_len, arena);
+        if (!prototype) return false;
+
+        int merged_len;
+        liquid_float_complex* merged_taps = convolve_complex_taps(master_taps, master_taps_len, prototype, prototype_len, &merged_len, arena);
+        if (!merged_taps) return false;
+
+        master_taps = merged_taps;
+        master_taps_len = merged_len;
+    }
+
+    *out_taps = master_taps;
+    *out_len = master_taps_len;
+    *out_normalization_gain = normalization_gain;
+    return true;
+}
+
+/**
+ * @brief Creates another block-based filter object identical to the primary one.
+ */
+static void* create_block_filter_replica(const AppResources* resources, liquid_float_complex* taps, int taps_len, float* real_taps) {
+    switch (resources->user_filter_type_actual) {
+        case FILTER_IMPL_FFT_SYMMETRIC:
+            return (void*)fftfilt_crcf_create(real_taps, (unsigned int)taps_len, resources->user_filter_block_size);
+        case FILTER_IMPL_FFT_ASYMMETRIC:
+            return (void*)fftfilt_cccf_create(taps, (unsigned int)taps_len, resources->user_filter_block_size);
+#ifdef WITH_FFTW
+        case FILTER_IMPL_FFTW_SYMMETRIC:
+        case FILTER_IMPL_FFTW_ASYMMETRIC:
+            return (void*)fftw_filter_clone((const FftwFilter*)resources->user_fir_filter_object);
+#endif
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * @brief Starts the worker pool that splits FFT filter passes across cores.
+ *
+ * With --filter-threads N, N - 1 workers join the pre- or post-processor thread.
+ * The default (0) uses every online core, up to FILTER_POOL_MAX_WORKERS workers,
+ * shared out between the pipelines of a batch or server run.
+ *
+ * @return false only on a hard failure; running without a pool is not an error.
+ */
+static bool create_filter_pool(const AppConfig* config, AppResources* resources,
+                               liquid_float_complex* taps, int taps_len, float* real_taps, MemoryArena* arena) {
+    unsigned int num_workers;
+    if (config->filter_threads_arg > 0) {
+        num_workers = (unsigned int)config->filter_threads_arg - 1;
+    } else {
+        unsigned int cores = utils_get_cpu_count();
+        if (resources->concurrent_pipelines > 1) cores /= (unsigned int)resources->concurrent_pipelines;
+        num_workers = (cores > 1) ? cores - 1 : 0;
+        if (num_workers > FILTER_POOL_MAX_WORKERS) num_workers = FILTER_POOL_MAX_WORKERS;
+    }
+    if (num_workers == 0) {
+        return true;
+    }
+
+    void** replicas = (void**)mem_arena_alloc(arena, num_workers * sizeof(void*));
+    if (!replicas) return false;
+
+    for (unsigned int i = 0; i < num_workers; i++) {
+        replicas[i] = create_block_filter_replica(resources, taps, taps_len, real_taps);
+        if (!replicas[i]) {
+            log_fatal("Failed to create filter replica for worker thread %u.", i);
+            resources->user_filter_replicas = replicas;
+            resources->user_filter_num_replicas = i;
+            return false;
+        }
+    }
+    resources->user_filter_replicas = replicas;
+    resources->user_filter_num_replicas = num_workers;
+
+    resources->user_filter_pool = filter_pool_create(replicas, num_workers, resources->user_filter_type_actual,
+                                                     resources->user_filter_block_size, (unsigned int)taps_len - 1);
+    if (!resources->user_filter_pool) {
+        log_fatal("Failed to start the filter worker pool.");
+        return false;
+    }
+    return true;
+}
+
+bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* arena) {
+    bool success = false;
+    FilterCacheEntry cache_entry;
+    memset(&cache_entry, 0, sizeof(cache_entry));
+
+    resources->user_fir_filter_object = NULL;
+    resources->user_filter_type_actual = FILTER_IMPL_NONE;
+    resources->user_filter_block_size = 0;
+    resources->user_filter_num_taps = 0;
+    resources->user_filter_pool = NULL;
+    resources->user_filter_replicas = NULL;
+    resources->user_filter_num_replicas = 0;
+
+    if (config->num_filter_requests == 0) {
+        return true;
+    }
+
+    // A merged decimator runs the user filter at the input rate, ahead of the decimation.
+    bool is_merged_decimator = (resources->merged_decimation_factor > 0);
+    double sample_rate_for_design = (resources->stage_plan.filter_post_resample && !is_merged_decimator)
+                                      ? config->target_rate
+                                      : (double)resources->source_info.samplerate;
+
+    // Determine filter complexity BEFORE normalization
+    bool is_final_filter_complex = filter_chain_is_complex(config);
+
+    // The cache key covers every input of design_filter_taps().
+    FilterCacheKey cache_key;
+    memset(&cache_key, 0, sizeof(cache_key));
+    cache_key.sample_rate_hz = sample_rate_for_design;
+    cache_key.num_requests = config->num_filter_requests;
+    memcpy(cache_key.requests, config->filter_requests, sizeof(cache_key.requests));
+    cache_key.filter_taps = config->filter_taps_arg;
+    cache_key.attenuation_db = config->attenuation_db_arg;
+    cache_key.transition_width_hz = config->transition_width_hz_arg;
+    cache_key.decimation_factor = resources->merged_decimation_factor;
+
+    liquid_float_complex* master_taps = NULL;
+    int master_taps_len = 0;
+
+    if (!config->no_filter_cache && filter_cache_lookup(&cache_key, &cache_entry)) {
+        // liquid-dsp and FFTW copy the taps, so the read-only mapping is only needed during setup.
+        master_taps = (liquid_float_complex*)cache_entry.taps;
+        master_taps_len = (int)cache_entry.taps_len;
+        log_info("Loaded %d filter taps from cache.", master_taps_len);
+        log_debug("Cached taps were normalized by a gain factor of %f.", cache_entry.normalization_gain);
+    } else {
+        float normalization_gain;
+        if (!design_filter_taps(config, sample_rate_for_design, resources->merged_decimation_factor,
+                                is_final_filter_complex, arena, &master_taps, &master_taps_len, &normalization_gain)) {
+            goto cleanup;
+        }
+        if (!config->no_filter_cache) {
+            filter_cache_store(&cache_key, master_taps, (unsigned int)master_taps_len, is_final_filter_complex, normalization_gain);
+        }
+    }
+
+    resources->user_filter_num_taps = (unsigned int)master_taps_len;
+
+    if (is_final_filter_complex) {
+        log_info("Asymmetric filter detected.");
+    }
+
+    if (is_merged_decimator) {
+        unsigned int factor = resources->merged_decimation_factor;
+        log_info("Merged decimator requires %d taps, evaluated once per %u input samples.", master_taps_len, factor);
+
+        if (is_final_filter_complex) {
+            resources->user_fir_filter_object = (void*)firdecim_cccf_create(factor, master_taps, (unsigned int)master_taps_len);
+            resources->user_filter_type_actual = FILTER_IMPL_DECIM_ASYMMETRIC;
+        } else {
+            float* final_real_taps = (float*)mem_arena_alloc(arena, master_taps_len * sizeof(float));
+            if (!final_real_taps) goto cleanup;
+            for (int i = 0; i < master_taps_len; i++) {
+                final_real_taps[i] = crealf(master_taps[i]);
+            }
+            resources->user_fir_filter_object = (void*)firdecim_crcf_create(factor, final_real_taps, (unsigned int)master_taps_len);
+            resources->user_filter_type_actual = FILTER_IMPL_DECIM_SYMMETRIC;
+        }
+
+        if (!resources->user_fir_filter_object) {
+            log_fatal("Failed to create merged polyphase decimator object.");
+            goto cleanup;
+        }
+        success = true;
+        goto cleanup;
+    }
+
     FilterTypeRequest final_choice;
     if (config->filter_type_str_arg != NULL) {
         final_choice = config->filter_type_request;
@@ -214,33 +540,44 @@ bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* aren
 
     if (final_choice == FILTER_TYPE_FFT) {
         log_info("Preparing FFT-based filter object (this may take a moment)...");
-        
-        unsigned int block_size;
+
+        if (config->filter_fft_size_arg > 0 &&
+            (unsigned int)config->filter_fft_size_arg / 2 < (unsigned int)master_taps_len - 1) {
+            log_fatal("The specified --filter-fft-size of %d is too small for a filter with %d taps.", config->filter_fft_size_arg, master_taps_len);
+            log_error("A block size (_n) of at least %d is required, meaning an FFT size of at least %d.", master_taps_len - 1, (master_taps_len - 1) * 2);
+            goto cleanup;
+        }
+
+#ifdef WITH_FFTW
+        // Prefer the FFTW overlap-save engine; fall back to liquid-dsp if planning fails.
+        FftwFilter* fftw_filter = fftw_filter_create(master_taps, (unsigned int)master_taps_len, !is_final_filter_complex,
+                                                     (unsigned int)(config->filter_fft_size_arg > 0 ? config->filter_fft_size_arg : 0),
+                                                     config->presets_dir);
+        if (fftw_filter) {
+            resources->user_fir_filter_object = (void*)fftw_filter;
+            resources->user_filter_block_size = fftw_filter_get_block_size(fftw_filter);
+            resources->user_filter_type_actual = is_final_filter_complex ? FILTER_IMPL_FFTW_ASYMMETRIC : FILTER_IMPL_FFTW_SYMMETRIC;
+            if (!create_filter_pool(config, resources, master_taps, master_taps_len, NULL, arena)) goto cleanup;
+            success = true;
+            goto cleanup;
+        }
+        log_warn("FFTW filter engine unavailable, falling back to the liquid-dsp FFT filter.");
+#endif
+
+        unsigned int block_size = fft_block_size(config, (unsigned int)master_taps_len);
         if (config->filter_fft_size_arg > 0) {
-            block_size = (unsigned int)config->filter_fft_size_arg / 2;
             log_info("Using user-specified FFT size of %u (block size: %u).", config->filter_fft_size_arg, block_size);
-            if (block_size < (unsigned int)master_taps_len - 1) {
-                log_fatal("The specified --filter-fft-size of %d is too small for a filter with %d taps.", config->filter_fft_size_arg, master_taps_len);
-                log_error("A block size (_n) of at least %d is required, meaning an FFT size of at least %d.", master_taps_len - 1, (master_taps_len - 1) * 2);
-                goto cleanup;
-            }
         } else {
-            block_size = 1;
-            while (block_size < (unsigned int)master_taps_len - 1) {
-                block_size *= 2;
-            }
-            if (block_size < (unsigned int)master_taps_len * 2) {
-                 block_size *= 2;
-            }
             log_info("Using automatically calculated block size of %u (FFT size: %u) for filter.", block_size, block_size * 2);
         }
         resources->user_filter_block_size = block_size;
 
+        float* final_real_taps = NULL;
         if (is_final_filter_complex) {
             resources->user_fir_filter_object = (void*)fftfilt_cccf_create(master_taps, master_taps_len, resources->user_filter_block_size);
             resources->user_filter_type_actual = FILTER_IMPL_FFT_ASYMMETRIC;
         } else {
-            float* final_real_taps = (float*)mem_arena_alloc(arena, master_taps_len * sizeof(float));
+            final_real_taps = (float*)mem_arena_alloc(arena, master_taps_len * sizeof(float));
             if (!final_real_taps) goto cleanup;
             for(int i=0; i<master_taps_len; i++) {
                 final_real_taps[i] = crealf(master_taps[i]);
@@ -248,6 +585,10 @@ bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* aren
             resources->user_fir_filter_object = (void*)fftfilt_crcf_create(final_real_taps, master_taps_len, resources->user_filter_block_size);
             resources->user_filter_type_actual = FILTER_IMPL_FFT_SYMMETRIC;
         }
+        if (resources->user_fir_filter_object &&
+            !create_filter_pool(config, resources, master_taps, master_taps_len, final_real_taps, arena)) {
+            goto cleanup;
+        }
     } else { 
         log_info("Preparing FIR (time-domain) filter object...");
         if (is_final_filter_complex) {
@@ -272,27 +613,136 @@ bool filter_create(AppConfig* config, AppResources* resources, MemoryArena* aren
     success = true;
 
 cleanup:
+    filter_cache_release(&cache_entry);
     return success;
 }
 
+bool filter_chain_is_complex(const AppConfig* config) {
+    for (int i = 0; i < config->num_filter_requests; ++i) {
+        const FilterRequest* req = &config->filter_requests[i];
+        if (req->type == FILTER_TYPE_PASSBAND && fabsf(req->freq1_hz) > 1e-9f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double filter_estimate_macs_per_sample(const AppConfig* config, double sample_rate, unsigned int decimation_factor) {
+    if (config->num_filter_requests == 0) return 0.0;
+
+    // The chain's stages are convolved into one filter, so their lengths add up.
+    unsigned int taps_len = 1;
+    for (int i = 0; i < config->num_filter_requests; ++i) {
+        taps_len += request_taps_len(config, &config->filter_requests[i], sample_rate) - 1;
+    }
+    bool is_complex = filter_chain_is_complex(config);
+    double macs_per_tap = is_complex ? 4.0 : 2.0; // Complex or real taps on complex samples
+
+    if (decimation_factor > 0) {
+        taps_len += decimator_prototype_taps_len(decimation_factor) - 1;
+        return macs_per_tap * taps_len / decimation_factor;
+    }
+
+    bool use_fft = (config->filter_type_str_arg != NULL) ? (config->filter_type_request == FILTER_TYPE_FFT) : is_complex;
+    if (!use_fft) {
+        return macs_per_tap * taps_len;
+    }
+
+    // Overlap-save: a forward and an inverse FFT of twice the block size, plus one
+    // complex multiply per bin, yield one block of output.
+    double block_size = (double)fft_block_size(config, taps_len);
+    double fft_size = 2.0 * block_size;
+    double macs_per_block = 2.0 * FILTER_FFT_MACS_PER_POINT_LOG2 * fft_size * log2(fft_size) + 4.0 * fft_size;
+    return macs_per_block / block_size;
+}
+
+bool filter_is_block_based(FilterImplementationType type) {
+    return type == FILTER_IMPL_FFT_SYMMETRIC || type == FILTER_IMPL_FFT_ASYMMETRIC ||
+           type == FILTER_IMPL_FFTW_SYMMETRIC || type == FILTER_IMPL_FFTW_ASYMMETRIC;
+}
+
+void filter_execute_block(void* filter_object, FilterImplementationType type, complex_float_t* input, complex_float_t* output) {
+    switch (type) {
+        case FILTER_IMPL_FFT_SYMMETRIC:
+            fftfilt_crcf_execute((fftfilt_crcf)filter_object, input, output);
+            break;
+        case FILTER_IMPL_FFT_ASYMMETRIC:
+            fftfilt_cccf_execute((fftfilt_cccf)filter_object, input, output);
+            break;
+#ifdef WITH_FFTW
+        case FILTER_IMPL_FFTW_SYMMETRIC:
+        case FILTER_IMPL_FFTW_ASYMMETRIC:
+            fftw_filter_execute((FftwFilter*)filter_object, input, output);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void filter_reset(void* filter_object, FilterImplementationType type) {
+    if (!filter_object) return;
+    switch (type) {
+        case FILTER_IMPL_FIR_SYMMETRIC: firfilt_crcf_reset((firfilt_crcf)filter_object); break;
+        case FILTER_IMPL_FIR_ASYMMETRIC: firfilt_cccf_reset((firfilt_cccf)filter_object); break;
+        case FILTER_IMPL_FFT_SYMMETRIC: fftfilt_crcf_reset((fftfilt_crcf)filter_object); break;
+        case FILTER_IMPL_FFT_ASYMMETRIC: fftfilt_cccf_reset((fftfilt_cccf)filter_object); break;
+        case FILTER_IMPL_DECIM_SYMMETRIC: firdecim_crcf_reset((firdecim_crcf)filter_object); break;
+        case FILTER_IMPL_DECIM_ASYMMETRIC: firdecim_cccf_reset((firdecim_cccf)filter_object); break;
+#ifdef WITH_FFTW
+        case FILTER_IMPL_FFTW_SYMMETRIC:
+        case FILTER_IMPL_FFTW_ASYMMETRIC:
+            fftw_filter_reset((FftwFilter*)filter_object);
+            break;
+#endif
+        default: break;
+    }
+}
+
+static void destroy_filter_object(void* filter_object, FilterImplementationType type) {
+    switch (type) {
+        case FILTER_IMPL_FIR_SYMMETRIC:
+            firfilt_crcf_destroy((firfilt_crcf)filter_object);
+            break;
+        case FILTER_IMPL_FIR_ASYMMETRIC:
+            firfilt_cccf_destroy((firfilt_cccf)filter_object);
+            break;
+        case FILTER_IMPL_FFT_SYMMETRIC:
+            fftfilt_crcf_destroy((fftfilt_crcf)filter_object);
+            break;
+        case FILTER_IMPL_FFT_ASYMMETRIC:
+            fftfilt_cccf_destroy((fftfilt_cccf)filter_object);
+            break;
+        case FILTER_IMPL_DECIM_SYMMETRIC:
+            firdecim_crcf_destroy((firdecim_crcf)filter_object);
+            break;
+        case FILTER_IMPL_DECIM_ASYMMETRIC:
+            firdecim_cccf_destroy((firdecim_cccf)filter_object);
+            break;
+#ifdef WITH_FFTW
+        case FILTER_IMPL_FFTW_SYMMETRIC:
+        case FILTER_IMPL_FFTW_ASYMMETRIC:
+            fftw_filter_destroy((FftwFilter*)filter_object);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
 void filter_destroy(AppResources* resources) {
+    // Stop the workers before destroying the replicas they use.
+    filter_pool_destroy(resources->user_filter_pool);
+    resources->user_filter_pool = NULL;
+
+    for (unsigned int i = 0; i < resources->user_filter_num_replicas; i++) {
+        destroy_filter_object(resources->user_filter_replicas[i], resources->user_filter_type_actual);
+    }
+    resources->user_filter_replicas = NULL;
+    resources->user_filter_num_replicas = 0;
+
     if (resources->user_fir_filter_object) {
-        switch (resources->user_filter_type_actual) {
-            case FILTER_IMPL_FIR_SYMMETRIC:
-                firfilt_crcf_destroy((firfilt_crcf)resources->user_fir_filter_object);
-                break;
-            case FILTER_IMPL_FIR_ASYMMETRIC:
-                firfilt_cccf_destroy((firfilt_cccf)resources->user_fir_filter_object);
-                break;
-            case FILTER_IMPL_FFT_SYMMETRIC:
-                fftfilt_crcf_destroy((fftfilt_crcf)resources->user_fir_filter_object);
-                break;
-            case FILTER_IMPL_FFT_ASYMMETRIC:
-                fftfilt_cccf_destroy((fftfilt_cccf)resources->user_fir_filter_object);
-                break;
-            default:
-                break;
-        }
+        destroy_filter_object(resources->user_fir_filter_object, resources->user_filter_type_actual);
         resources->user_fir_filter_object = NULL;
     }
 }
@@ -0,0 +1,270 @@
+// filter_cache.c
+
+#include "filter_cache.h"
+#include "constants.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#define FILTER_CACHE_MAGIC          "IQRTAPS"
+#define FILTER_CACHE_FORMAT_VERSION 2
+#define FILTER_CACHE_KEY_MAX_BYTES  256
+
+// On-disk layout: header | serialized key | padding | taps (interleaved float I/Q).
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t key_size;
+    uint32_t taps_len;
+    uint32_t is_complex;
+    float normalization_gain;
+    uint32_t taps_offset;
+} FilterCacheFileHeader;
+
+#define APPEND_KEY_FIELD(buf, pos, value) \
+    do { \
+        memcpy((buf) + (pos), &(value), sizeof(value)); \
+        (pos) += sizeof(value); \
+    } while (0)
+
+/**
+ * @brief Serializes the key field by field, so struct padding never reaches the hash.
+ */
+static size_t _serialize_key(const FilterCacheKey* key, unsigned char* buf) {
+    size_t pos = 0;
+    int32_t num_requests = key->num_requests;
+    APPEND_KEY_FIELD(buf, pos, key->sample_rate_hz);
+    APPEND_KEY_FIELD(buf, pos, num_requests);
+    for (int i = 0; i < key->num_requests && i < MAX_FILTER_CHAIN; i++) {
+        int32_t type = (int32_t)key->requests[i].type;
+        APPEND_KEY_FIELD(buf, pos, type);
+        APPEND_KEY_FIELD(buf, pos, key->requests[i].freq1_hz);
+        APPEND_KEY_FIELD(buf, pos, key->requests[i].freq2_hz);
+    }
+    int32_t filter_taps = key->filter_taps;
+    uint32_t decimation_factor = key->decimation_factor;
+    APPEND_KEY_FIELD(buf, pos, filter_taps);
+    APPEND_KEY_FIELD(buf, pos, key->attenuation_db);
+    APPEND_KEY_FIELD(buf, pos, key->transition_width_hz);
+    APPEND_KEY_FIELD(buf, pos, decimation_factor);
+
+#ifdef LIQUID_VERSION
+    // A different liquid-dsp release may design slightly different taps.
+    const char* liquid_version_str = LIQUID_VERSION;
+    size_t version_len = strlen(liquid_version_str);
+    if (pos + version_len <= FILTER_CACHE_KEY_MAX_BYTES) {
+        memcpy(buf + pos, liquid_version_str, version_len);
+        pos += version_len;
+    }
+#endif
+    return pos;
+}
+
+/**
+ * @brief 64-bit FNV-1a hash of the serialized key.
+ */
+static uint64_t _hash_bytes(const unsigned char* data, size_t len) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool _make_directory(const char* path) {
+#ifdef _WIN32
+    if (_mkdir(path) == 0 || errno == EEXIST) return true;
+#else
+    if (mkdir(path, 0755) == 0 || errno == EEXIST) return true;
+#endif
+    log_debug("Could not create cache directory '%s': %s", path, strerror(errno));
+    return false;
+}
+
+/**
+ * @brief Resolves (and creates, if requested) the per-user filter cache directory.
+ *
+ * POSIX uses $XDG_CACHE_HOME, falling back to ~/.cache. Windows uses %LOCALAPPDATA%.
+ */
+static bool _get_cache_dir(char* buffer, size_t buffer_size, bool create) {
+    char base[MAX_PATH_BUFFER];
+#ifdef _WIN32
+    const char* local_appdata = getenv("LOCALAPPDATA");
+    if (!local_appdata || local_appdata[0] == '\0') return false;
+    snprintf(base, sizeof(base), "%s", local_appdata);
+#else
+    const char* xdg_cache_home = getenv("XDG_CACHE_HOME");
+    if (xdg_cache_home && xdg_cache_home[0] != '\0') {
+        snprintf(base, sizeof(base), "%s", xdg_cache_home);
+    } else {
+        const char* home_dir = getenv("HOME");
+        if (!home_dir || home_dir[0] == '\0') return false;
+        snprintf(base, sizeof(base), "%s/.cache", home_dir);
+        if (create && !_make_directory(base)) return false;
+    }
+#endif
+
+    char app_dir[MAX_PATH_BUFFER];
+    int written = snprintf(app_dir, sizeof(app_dir), "%s/%s", base, APP_NAME);
+    if (written < 0 || (size_t)written >= sizeof(app_dir)) return false;
+    if (create && !_make_directory(app_dir)) return false;
+
+    written = snprintf(buffer, buffer_size, "%s/%s", app_dir, FILTER_CACHE_DIRNAME);
+    if (written < 0 || (size_t)written >= buffer_size) return false;
+    if (create && !_make_directory(buffer)) return false;
+    return true;
+}
+
+static bool _get_cache_file_path(const unsigned char* key_bytes, size_t key_size, char* buffer, size_t buffer_size, bool create_dir) {
+    char dir[MAX_PATH_BUFFER];
+    if (!_get_cache_dir(dir, sizeof(dir), create_dir)) return false;
+    unsigned long long hash = (unsigned long long)_hash_bytes(key_bytes, key_size);
+    int written = snprintf(buffer, buffer_size, "%s/%016llx.taps", dir, hash);
+    return (written > 0 && (size_t)written < buffer_size);
+}
+
+bool filter_cache_lookup(const FilterCacheKey* key, FilterCacheEntry* entry) {
+    memset(entry, 0, sizeof(*entry));
+
+    unsigned char key_bytes[FILTER_CACHE_KEY_MAX_BYTES];
+    size_t key_size = _serialize_key(key, key_bytes);
+    char path[MAX_PATH_BUFFER];
+    if (!_get_cache_file_path(key_bytes, key_size, path, sizeof(path), false)) return false;
+
+    void* mapping = NULL;
+    size_t mapping_size = 0;
+
+#ifdef _WIN32
+    // No mmap on Windows; a single read of the file is the closest equivalent.
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+    if (fseek(fp, 0, SEEK_END) == 0) {
+        long file_size = ftell(fp);
+        if (file_size > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+            mapping = malloc((size_t)file_size);
+            if (mapping && fread(mapping, 1, (size_t)file_size, fp) == (size_t)file_size) {
+                mapping_size = (size_t)file_size;
+            } else {
+                free(mapping);
+                mapping = NULL;
+            }
+        }
+    }
+    fclose(fp);
+    if (!mapping) return false;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(FilterCacheFileHeader)) {
+        close(fd);
+        return false;
+    }
+    mapping_size = (size_t)st.st_size;
+    mapping = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+#endif
+
+    entry->mapping = mapping;
+    entry->mapping_size = mapping_size;
+
+    // Validate everything before trusting the contents.
+    const FilterCacheFileHeader* header = (const FilterCacheFileHeader*)mapping;
+    const unsigned char* base = (const unsigned char*)mapping;
+    if (mapping_size < sizeof(FilterCacheFileHeader) ||
+        memcmp(header->magic, FILTER_CACHE_MAGIC, sizeof(FILTER_CACHE_MAGIC)) != 0 ||
+        header->version != FILTER_CACHE_FORMAT_VERSION ||
+        header->key_size != key_size ||
+        sizeof(FilterCacheFileHeader) + key_size > mapping_size ||
+        memcmp(base + sizeof(FilterCacheFileHeader), key_bytes, key_size) != 0 ||
+        header->taps_len == 0 ||
+        header->taps_offset % sizeof(float) != 0 ||
+        (size_t)header->taps_offset + (size_t)header->taps_len * sizeof(complex_float_t) != mapping_size) {
+        log_debug("Ignoring stale or mismatched filter cache file '%s'.", path);
+        filter_cache_release(entry);
+        return false;
+    }
+
+    entry->taps = (const complex_float_t*)(base + header->taps_offset);
+    entry->taps_len = header->taps_len;
+    entry->is_complex = (header->is_complex != 0);
+    entry->normalization_gain = header->normalization_gain;
+    log_debug("Filter cache hit: '%s'.", path);
+    return true;
+}
+
+void filter_cache_store(const FilterCacheKey* key, const complex_float_t* taps, unsigned int taps_len,
+                        bool is_complex, float normalization_gain) {
+    unsigned char key_bytes[FILTER_CACHE_KEY_MAX_BYTES];
+    size_t key_size = _serialize_key(key, key_bytes);
+    char path[MAX_PATH_BUFFER];
+    char temp_path[MAX_PATH_BUFFER];
+    if (!_get_cache_file_path(key_bytes, key_size, path, sizeof(path), true)) return;
+
+    int written = snprintf(temp_path, sizeof(temp_path), "%s.%ld.tmp", path, (long)getpid());
+    if (written < 0 || (size_t)written >= sizeof(temp_path)) return;
+
+    FilterCacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FILTER_CACHE_MAGIC, sizeof(FILTER_CACHE_MAGIC));
+    header.version = FILTER_CACHE_FORMAT_VERSION;
+    header.key_size = (uint32_t)key_size;
+    header.taps_len = taps_len;
+    header.is_complex = is_complex ? 1 : 0;
+    header.normalization_gain = normalization_gain;
+    size_t unaligned_offset = sizeof(header) + key_size;
+    header.taps_offset = (uint32_t)((unaligned_offset + 7) & ~(size_t)7);
+
+    static const unsigned char padding[8] = {0};
+    FILE* fp = fopen(temp_path, "wb");
+    if (!fp) {
+        log_debug("Could not write filter cache file '%s': %s", temp_path, strerror(errno));
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(key_bytes, 1, key_size, fp) == key_size &&
+              fwrite(padding, 1, header.taps_offset - unaligned_offset, fp) == header.taps_offset - unaligned_offset &&
+              fwrite(taps, sizeof(complex_float_t), taps_len, fp) == taps_len;
+    if (fclose(fp) != 0) ok = false;
+
+    // Publish atomically so a concurrent run never maps a half-written file.
+#ifdef _WIN32
+    if (ok && !MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING)) ok = false;
+#else
+    if (ok && rename(temp_path, path) != 0) ok = false;
+#endif
+    if (!ok) {
+        log_debug("Failed to store filter taps in cache '%s'.", path);
+        remove(temp_path);
+        return;
+    }
+    log_debug("Stored %u filter taps in cache '%s'.", taps_len, path);
+}
+
+void filter_cache_release(FilterCacheEntry* entry) {
+    if (!entry || !entry->mapping) return;
+#ifdef _WIN32
+    free(entry->mapping);
+#else
+    munmap(entry->mapping, entry->mapping_size);
+#endif
+    memset(entry, 0, sizeof(*entry));
+}
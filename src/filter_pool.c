@@ -0,0 +1,216 @@
+// filter_pool.c
+
+#include "filter_pool.h"
+#include "filter.h"
+#include "constants.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+typedef struct {
+    pthread_t thread;
+    bool thread_started;
+    struct FilterPool* pool;
+    unsigned int index;
+    complex_float_t* warmup_output; // Discarded output of the warm-up blocks
+
+    // The current job, written by the dispatching thread under the pool mutex.
+    complex_float_t* input;
+    complex_float_t* output;
+    unsigned int num_blocks;
+} FilterPoolWorker;
+
+struct FilterPool {
+    void** replicas;
+    unsigned int num_workers;
+    FilterImplementationType type;
+    unsigned int block_size;
+    unsigned int warmup_blocks;
+    FilterPoolWorker* workers;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    unsigned long long generation;
+    unsigned int pending;
+    bool shutdown;
+};
+
+/**
+ * @brief Filters one segment with a worker's replica.
+ *
+ * The replica is reset and then fed the blocks immediately preceding the
+ * segment, which reproduces the history the primary object would have had.
+ */
+static void _run_segment(FilterPool* pool, FilterPoolWorker* worker) {
+    void* replica = pool->replicas[worker->index];
+    unsigned int block_size = pool->block_size;
+
+    filter_reset(replica, pool->type);
+    for (unsigned int b = pool->warmup_blocks; b > 0; b--) {
+        filter_execute_block(replica, pool->type, worker->input - (size_t)b * block_size, worker->warmup_output);
+    }
+    for (unsigned int b = 0; b < worker->num_blocks; b++) {
+        size_t offset = (size_t)b * block_size;
+        filter_execute_block(replica, pool->type, worker->input + offset, worker->output + offset);
+    }
+}
+
+static void* _filter_pool_worker_func(void* arg) {
+    FilterPoolWorker* worker = (FilterPoolWorker*)arg;
+    FilterPool* pool = worker->pool;
+    unsigned long long seen_generation = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen_generation) {
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        }
+        if (pool->shutdown) break;
+        seen_generation = pool->generation;
+
+        bool has_job = (worker->num_blocks > 0);
+        pthread_mutex_unlock(&pool->mutex);
+
+        if (has_job) {
+            _run_segment(pool, worker);
+        }
+
+        pthread_mutex_lock(&pool->mutex);
+        if (has_job && --pool->pending == 0) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+FilterPool* filter_pool_create(void** replicas, unsigned int num_replicas, FilterImplementationType type,
+                               unsigned int block_size, unsigned int history_len) {
+    if (!replicas || num_replicas == 0 || block_size == 0 || !filter_is_block_based(type)) {
+        return NULL;
+    }
+
+    FilterPool* pool = (FilterPool*)calloc(1, sizeof(FilterPool));
+    if (!pool) return NULL;
+
+    pool->replicas = replicas;
+    pool->num_workers = num_replicas;
+    pool->type = type;
+    pool->block_size = block_size;
+    pool->warmup_blocks = (history_len + block_size - 1) / block_size;
+    if (pool->warmup_blocks == 0) pool->warmup_blocks = 1;
+
+    pool->workers = (FilterPoolWorker*)calloc(num_replicas, sizeof(FilterPoolWorker));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    for (unsigned int i = 0; i < num_replicas; i++) {
+        FilterPoolWorker* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->warmup_output = (complex_float_t*)malloc(block_size * sizeof(complex_float_t));
+        if (!worker->warmup_output) {
+            log_fatal("Failed to allocate filter worker buffers.");
+            filter_pool_destroy(pool);
+            return NULL;
+        }
+        if (pthread_create(&worker->thread, NULL, _filter_pool_worker_func, worker) != 0) {
+            log_fatal("Failed to start filter worker thread %u.", i);
+            filter_pool_destroy(pool);
+            return NULL;
+        }
+        worker->thread_started = true;
+    }
+
+    log_info("Started %u filter worker threads.", num_replicas);
+    return pool;
+}
+
+void filter_pool_execute(FilterPool* pool, void** primary_slot, complex_float_t* input,
+                         unsigned int num_blocks, complex_float_t* output) {
+    unsigned int block_size = pool->block_size;
+
+    // Each segment repeats `warmup_blocks` of work, so only split passes long enough to amortize it.
+    unsigned int num_segments = num_blocks / (pool->warmup_blocks * FILTER_POOL_MIN_SEGMENT_WARMUPS);
+    if (num_segments > pool->num_workers + 1) num_segments = pool->num_workers + 1;
+
+    if (num_segments < 2) {
+        for (unsigned int b = 0; b < num_blocks; b++) {
+            size_t offset = (size_t)b * block_size;
+            filter_execute_block(*primary_slot, pool->type, input + offset, output + offset);
+        }
+        return;
+    }
+
+    unsigned int base_len = num_blocks / num_segments;
+    unsigned int extra = num_blocks % num_segments;
+    unsigned int first_len = base_len + (extra > 0 ? 1 : 0);
+
+    pthread_mutex_lock(&pool->mutex);
+    unsigned int start = first_len;
+    for (unsigned int i = 0; i < pool->num_workers; i++) {
+        FilterPoolWorker* worker = &pool->workers[i];
+        unsigned int segment = i + 1;
+        if (segment < num_segments) {
+            unsigned int len = base_len + (segment < extra ? 1 : 0);
+            worker->input = input + (size_t)start * block_size;
+            worker->output = output + (size_t)start * block_size;
+            worker->num_blocks = len;
+            start += len;
+        } else {
+            worker->num_blocks = 0;
+        }
+    }
+    pool->pending = num_segments - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    // The primary object carries the stream's history into the first segment.
+    for (unsigned int b = 0; b < first_len; b++) {
+        size_t offset = (size_t)b * block_size;
+        filter_execute_block(*primary_slot, pool->type, input + offset, output + offset);
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    // The replica that filtered the last segment now holds the stream's state.
+    unsigned int last = num_segments - 2;
+    void* previous_primary = *primary_slot;
+    *primary_slot = pool->replicas[last];
+    pool->replicas[last] = previous_primary;
+}
+
+void filter_pool_destroy(FilterPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (unsigned int i = 0; i < pool->num_workers; i++) {
+        if (pool->workers[i].thread_started) {
+            pthread_join(pool->workers[i].thread, NULL);
+        }
+        free(pool->workers[i].warmup_output);
+    }
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->workers);
+    free(pool);
+}
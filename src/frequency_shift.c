@@ -14,13 +14,20 @@
 #endif
 
 /**
- * @brief Creates and configures the NCOs (frequency shifters) based on user arguments.
+ * @brief The frequency handed to nco_crcf_set_frequency() for a shift at a given rate.
+ *
+ * A shift of a whole multiple of the rate is no shift at all, so it is taken
+ * modulo the rate here, in double precision, rather than by the NCO in float.
  */
-bool freq_shift_create_ncos(AppConfig *config, AppResources *resources) {
-    if (!config || !resources) return false;
+static float _nco_frequency(double shift_hz, double rate) {
+    return (float)(2.0 * M_PI * fmod(fabs(shift_hz), rate) / rate);
+}
 
-    resources->pre_resample_nco = NULL;
-    resources->post_resample_nco = NULL;
+/**
+ * @brief Works out the frequency shift the run needs from the user arguments.
+ */
+bool freq_shift_resolve(const AppConfig *config, AppResources *resources) {
+    if (!config || !resources) return false;
 
     double required_shift_hz = 0.0;
     if (config->set_center_frequency_target_hz) {
@@ -34,6 +41,21 @@ bool freq_shift_create_ncos(AppConfig *config, AppResources *resources) {
     }
 
     resources->actual_nco_shift_hz = required_shift_hz;
+    return true;
+}
+
+/**
+ * @brief Creates and configures the NCOs (frequency shifters) based on user arguments.
+ */
+bool freq_shift_create_ncos(AppConfig *config, AppResources *resources) {
+    if (!config || !resources) return false;
+
+    resources->pre_resample_nco = NULL;
+    resources->post_resample_nco = NULL;
+
+    if (!freq_shift_resolve(config, resources)) {
+        return false;
+    }
 
     // If no shift is needed, we're done.
     if (fabs(resources->actual_nco_shift_hz) < 1e-9) {
@@ -41,7 +63,7 @@ bool freq_shift_create_ncos(AppConfig *config, AppResources *resources) {
     }
 
     // --- Create Pre-Resample NCO ---
-    if (!config->shift_after_resample) {
+    if (!resources->stage_plan.shift_post_resample) {
         double rate_for_nco = (double)resources->source_info.samplerate;
         if (fabs(resources->actual_nco_shift_hz) > (SHIFT_FACTOR_LIMIT * rate_for_nco)) {
             log_error("Requested frequency shift %.2f Hz exceeds sanity limit for the pre-resample rate of %.1f Hz.", resources->actual_nco_shift_hz, rate_for_nco);
@@ -52,12 +74,12 @@ bool freq_shift_create_ncos(AppConfig *config, AppResources *resources) {
             log_error("Failed to create pre-resample NCO (frequency shifter).");
             return false;
         }
-        float nco_freq_rad_per_sample = (float)(2.0 * M_PI * fabs(resources->actual_nco_shift_hz) / rate_for_nco);
+        float nco_freq_rad_per_sample = _nco_frequency(resources->actual_nco_shift_hz, rate_for_nco);
         nco_crcf_set_frequency(resources->pre_resample_nco, nco_freq_rad_per_sample);
     }
 
     // --- Create Post-Resample NCO ---
-    if (config->shift_after_resample) {
+    if (resources->stage_plan.shift_post_resample) {
         double rate_for_nco = config->target_rate;
          if (fabs(resources->actual_nco_shift_hz) > (SHIFT_FACTOR_LIMIT * rate_for_nco)) {
             log_error("Requested frequency shift %.2f Hz exceeds sanity limit for the post-resample rate of %.1f Hz.", resources->actual_nco_shift_hz, rate_for_nco);
@@ -69,7 +91,7 @@ bool freq_shift_create_ncos(AppConfig *config, AppResources *resources) {
             freq_shift_destroy_ncos(resources); // Clean up pre-resample NCO if it was created
             return false;
         }
-        float nco_freq_rad_per_sample = (float)(2.0 * M_PI * fabs(resources->actual_nco_shift_hz) / rate_for_nco);
+        float nco_freq_rad_per_sample = _nco_frequency(resources->actual_nco_shift_hz, rate_for_nco);
         nco_crcf_set_frequency(resources->post_resample_nco, nco_freq_rad_per_sample);
     }
 
@@ -102,6 +124,22 @@ void freq_shift_reset_nco(nco_crcf nco) {
     }
 }
 
+/**
+ * @brief Moves a freshly reset NCO to the phase it would have after mixing `num_frames` samples.
+ *
+ * liquid-dsp keeps the phase as a 32-bit integer that wraps, advanced by a
+ * fixed integer step per sample. The step is rebuilt from the same float
+ * frequency the NCO was given, so the product below is the exact phase.
+ */
+void freq_shift_advance_nco(nco_crcf nco, double shift_hz, double rate, unsigned long long num_frames) {
+    if (!nco || rate <= 0.0) {
+        return;
+    }
+    uint32_t step = (uint32_t)llround((double)_nco_frequency(shift_hz, rate) / (2.0 * M_PI) * 4294967296.0);
+    uint32_t phase = step * (uint32_t)num_frames; // Both wrap modulo 2^32, as the accumulator does
+    nco_crcf_set_phase(nco, (float)((double)phase * (2.0 * M_PI / 4294967296.0)));
+}
+
 /**
  * @brief Destroys the NCO objects if they were created.
  */
@@ -0,0 +1,118 @@
+// input_mmap.c
+
+#ifdef __linux__
+#define _DEFAULT_SOURCE // For madvise() and MADV_DONTNEED
+#endif
+
+#include "input_mmap.h"
+#include "constants.h"
+#include "log.h"
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifndef _WIN32
+bool input_mmap_open(MappedInput* mapped, const char* path, long long data_offset, long long data_length, size_t release_lag) {
+    memset(mapped, 0, sizeof(*mapped));
+    if (data_offset < 0 || data_length < IO_MMAP_INPUT_MIN_BYTES) return false;
+    if ((unsigned long long)data_length > (unsigned long long)SIZE_MAX) return false;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (long long)st.st_size < data_offset + data_length) {
+        close(fd);
+        return false;
+    }
+
+    // mmap() offsets must be page-aligned, so map from the page holding the first sample.
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0) page_size = 4096;
+    off_t map_offset = (off_t)(data_offset - (data_offset % page_size));
+    size_t lead = (size_t)(data_offset - (long long)map_offset);
+    size_t map_length = lead + (size_t)data_length;
+
+    void* base = mmap(NULL, map_length, PROT_READ, MAP_PRIVATE, fd, map_offset);
+    close(fd); // The mapping keeps its own reference to the file.
+    if (base == MAP_FAILED) {
+        log_debug("mmap of input failed (%s), using buffered reads.", strerror(errno));
+        return false;
+    }
+
+    posix_madvise(base, map_length, POSIX_MADV_SEQUENTIAL);
+    posix_madvise(base, map_length, POSIX_MADV_WILLNEED);
+
+    mapped->map_base = base;
+    mapped->map_length = map_length;
+    mapped->data = (const unsigned char*)base + lead;
+    mapped->data_length = (size_t)data_length;
+    mapped->release_lag = release_lag;
+    log_debug("Input data memory-mapped (%zu bytes).", mapped->data_length);
+    return true;
+}
+
+size_t input_mmap_next(MappedInput* mapped, size_t max_bytes, const void** out_data) {
+    size_t remaining = mapped->data_length - mapped->cursor;
+    size_t slice = (remaining < max_bytes) ? remaining : max_bytes;
+    *out_data = mapped->data + mapped->cursor;
+    mapped->cursor += slice;
+
+#ifdef __linux__
+    // Drop whole pages that are far enough behind the cursor that no queued
+    // chunk can still point into them, so a long file doesn't fill the page
+    // tables and resident set. Pages are released in large steps to keep the
+    // syscall rate low.
+    if (mapped->cursor > mapped->release_lag) {
+        size_t release_to = mapped->cursor - mapped->release_lag;
+        if (release_to - mapped->released >= IO_MMAP_RELEASE_STEP_BYTES) {
+            long page_size = sysconf(_SC_PAGESIZE);
+            if (page_size <= 0) page_size = 4096;
+            uintptr_t start = (uintptr_t)(mapped->data + mapped->released);
+            uintptr_t end = (uintptr_t)(mapped->data + release_to);
+            start = (start + (uintptr_t)page_size - 1) & ~((uintptr_t)page_size - 1);
+            end &= ~((uintptr_t)page_size - 1);
+            if (end > start) {
+                madvise((void*)start, end - start, MADV_DONTNEED);
+                mapped->released = (size_t)(end - (uintptr_t)mapped->data);
+            }
+        }
+    }
+#endif
+    return slice;
+}
+
+void input_mmap_close(MappedInput* mapped) {
+    if (mapped->map_base) {
+        munmap(mapped->map_base, mapped->map_length);
+    }
+    memset(mapped, 0, sizeof(*mapped));
+}
+#else
+bool input_mmap_open(MappedInput* mapped, const char* path, long long data_offset, long long data_length, size_t release_lag) {
+    (void)path;
+    (void)data_offset;
+    (void)data_length;
+    (void)release_lag;
+    memset(mapped, 0, sizeof(*mapped));
+    return false;
+}
+
+size_t input_mmap_next(MappedInput* mapped, size_t max_bytes, const void** out_data) {
+    (void)mapped;
+    (void)max_bytes;
+    *out_data = NULL;
+    return 0;
+}
+
+void input_mmap_close(MappedInput* mapped) {
+    memset(mapped, 0, sizeof(*mapped));
+}
+#endif
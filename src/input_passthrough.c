@@ -0,0 +1,110 @@
+// input_passthrough.c
+
+#include "input_passthrough.h"
+#include "constants.h"
+#include "log.h"
+#include "signal_handler.h"
+#include "queue.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+void input_passthrough_send_end_of_stream(AppResources* resources) {
+    SampleChunk* last_item = (SampleChunk*)queue_dequeue(resources->free_sample_chunk_queue);
+    if (!last_item) return; // Shutdown signaled
+
+    last_item->stream_discontinuity_event = false;
+    last_item->is_last_chunk = true;
+    last_item->frames_read = 0;
+    if (!queue_enqueue(resources->raw_to_pre_process_queue, last_item)) {
+        queue_enqueue(resources->free_sample_chunk_queue, last_item);
+    }
+}
+
+#ifdef __linux__
+/**
+ * @brief Publishes copy progress. The writer thread is idle during the copy, so
+ *        the reader reports on its behalf.
+ */
+static void _report_progress(AppResources* resources, long long bytes_copied) {
+    unsigned long long frames = (unsigned long long)bytes_copied / resources->input_bytes_per_sample_pair;
+
+    pthread_mutex_lock(&resources->progress_mutex);
+    resources->total_frames_read = frames;
+    resources->total_output_frames = frames;
+    pthread_mutex_unlock(&resources->progress_mutex);
+
+    if (resources->progress_callback) {
+        resources->progress_callback(frames, resources->expected_total_output_frames, bytes_copied, resources->progress_callback_udata);
+    }
+}
+
+bool input_passthrough_zero_copy(InputSourceContext* ctx, long long data_offset, long long data_length, bool* out_handled) {
+    const AppConfig* config = ctx->config;
+    AppResources* resources = ctx->resources;
+    FileWriterContext* writer = &resources->writer_ctx;
+    *out_handled = false;
+
+    if (!config->raw_passthrough || config->output_type != OUTPUT_TYPE_RAW ||
+        resources->input_format != config->output_format || !writer->ops.copy_from_fd) {
+        return true;
+    }
+
+    int in_fd = open(config->effective_input_filename, O_RDONLY | O_CLOEXEC);
+    if (in_fd < 0) {
+        log_debug("Zero-copy passthrough unavailable, cannot reopen input: %s", strerror(errno));
+        return true;
+    }
+    posix_fadvise(in_fd, (off_t)data_offset, (off_t)data_length, POSIX_FADV_SEQUENTIAL);
+
+    bool success = true;
+    long long copied_total = 0;
+    while (copied_total < data_length && !is_shutdown_requested() && !resources->error_occurred) {
+        long long remaining = data_length - copied_total;
+        size_t slice = (remaining > IO_ZERO_COPY_SLICE_BYTES) ? IO_ZERO_COPY_SLICE_BYTES : (size_t)remaining;
+
+        long long copied = writer->ops.copy_from_fd(writer, in_fd, data_offset + copied_total, slice);
+        if (copied < 0) {
+            if (errno == EINTR) continue;
+            if (copied_total == 0 && errno == EOPNOTSUPP) {
+                // Nothing has been written yet, so the normal read loop can take over.
+                log_debug("Zero-copy passthrough is not supported for this output, using buffered copy.");
+                close(in_fd);
+                return true;
+            }
+            char error_buf[256];
+            snprintf(error_buf, sizeof(error_buf), "Passthrough: Zero-copy write failed: %s", strerror(errno));
+            handle_fatal_thread_error(error_buf, resources);
+            success = false;
+            break;
+        }
+        if (copied == 0) {
+            break; // The input is shorter than its header claimed.
+        }
+        copied_total += copied;
+        _report_progress(resources, copied_total);
+    }
+    close(in_fd);
+
+    *out_handled = true;
+    if (success) {
+        log_debug("Zero-copy passthrough copied %lld bytes.", copied_total);
+        input_passthrough_send_end_of_stream(resources);
+    }
+    return success;
+}
+#else
+bool input_passthrough_zero_copy(InputSourceContext* ctx, long long data_offset, long long data_length, bool* out_handled) {
+    (void)ctx;
+    (void)data_offset;
+    (void)data_length;
+    *out_handled = false;
+    return true;
+}
+#endif
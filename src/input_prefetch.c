@@ -0,0 +1,169 @@
+// input_prefetch.c
+
+#ifdef __linux__
+#define _GNU_SOURCE // For readahead()
+#endif
+
+#include "input_prefetch.h"
+#include "constants.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#endif
+
+#ifndef _WIN32
+/**
+ * @brief Loads one range of the file into the page cache.
+ *
+ * On Linux, readahead() queues the reads without copying anything to user
+ * space. Elsewhere, or if the filesystem refuses it, the range is read into
+ * a scratch buffer and the data thrown away.
+ */
+static bool _prefetch_range(InputPrefetcher* prefetcher, long long offset, long long length) {
+#ifdef __linux__
+    if (readahead(prefetcher->fd, (off_t)offset, (size_t)length) == 0) {
+        return true;
+    }
+#endif
+    if (!prefetcher->scratch) {
+        prefetcher->scratch = (unsigned char*)malloc(IO_READ_AHEAD_STEP_BYTES);
+        if (!prefetcher->scratch) return false;
+    }
+    while (length > 0) {
+        size_t want = (length < IO_READ_AHEAD_STEP_BYTES) ? (size_t)length : IO_READ_AHEAD_STEP_BYTES;
+        ssize_t got = pread(prefetcher->fd, prefetcher->scratch, want, (off_t)offset);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        offset += got;
+        length -= got;
+    }
+    return true;
+}
+
+static void* _prefetch_thread_func(void* arg) {
+    InputPrefetcher* prefetcher = (InputPrefetcher*)arg;
+
+    pthread_mutex_lock(&prefetcher->mutex);
+    while (!prefetcher->stop_requested && prefetcher->prefetched < prefetcher->data_end) {
+        // The reader may outrun the prefetcher (e.g. a memory-mapped reader hands out
+        // slices instantly), in which case there is nothing to wait for.
+        if (prefetcher->prefetched - prefetcher->consumed >= prefetcher->window_bytes) {
+            pthread_cond_wait(&prefetcher->cond, &prefetcher->mutex);
+            continue;
+        }
+
+        long long offset = prefetcher->prefetched;
+        long long length = prefetcher->data_end - offset;
+        if (length > IO_READ_AHEAD_STEP_BYTES) length = IO_READ_AHEAD_STEP_BYTES;
+        pthread_mutex_unlock(&prefetcher->mutex);
+
+        bool ok = _prefetch_range(prefetcher, offset, length);
+
+        pthread_mutex_lock(&prefetcher->mutex);
+        if (!ok) {
+            // A prefetch failure is harmless: the reader reports any real read error.
+            log_debug("Input read-ahead stopped at offset %lld (%s).", offset, strerror(errno));
+            break;
+        }
+        prefetcher->prefetched = offset + length;
+    }
+    pthread_mutex_unlock(&prefetcher->mutex);
+    return NULL;
+}
+
+bool input_prefetch_start(InputPrefetcher* prefetcher, const char* path, long long data_offset, long long data_length, long long window_bytes) {
+    memset(prefetcher, 0, sizeof(*prefetcher));
+    prefetcher->fd = -1;
+    if (window_bytes <= 0 || data_offset < 0 || data_length <= 0) return false;
+
+    prefetcher->fd = open(path, O_RDONLY);
+    if (prefetcher->fd < 0) return false;
+
+    // Tell the kernel the access is sequential, which also widens its own read-ahead on this descriptor.
+    posix_fadvise(prefetcher->fd, (off_t)data_offset, (off_t)data_length, POSIX_FADV_SEQUENTIAL);
+
+    prefetcher->data_end = data_offset + data_length;
+    prefetcher->window_bytes = window_bytes;
+    prefetcher->consumed = data_offset;
+    prefetcher->prefetched = data_offset;
+
+    if (pthread_mutex_init(&prefetcher->mutex, NULL) != 0) {
+        goto cleanup;
+    }
+    if (pthread_cond_init(&prefetcher->cond, NULL) != 0) {
+        pthread_mutex_destroy(&prefetcher->mutex);
+        goto cleanup;
+    }
+    prefetcher->sync_initialized = true;
+
+    if (pthread_create(&prefetcher->thread, NULL, _prefetch_thread_func, prefetcher) != 0) {
+        log_debug("Could not start the input read-ahead thread, reading without it.");
+        goto cleanup;
+    }
+    prefetcher->thread_started = true;
+    log_debug("Input read-ahead started (%lld byte window).", window_bytes);
+    return true;
+
+cleanup:
+    if (prefetcher->sync_initialized) {
+        pthread_cond_destroy(&prefetcher->cond);
+        pthread_mutex_destroy(&prefetcher->mutex);
+        prefetcher->sync_initialized = false;
+    }
+    close(prefetcher->fd);
+    prefetcher->fd = -1;
+    return false;
+}
+
+void input_prefetch_advance(InputPrefetcher* prefetcher, long long bytes) {
+    if (!prefetcher->thread_started || bytes <= 0) return;
+    pthread_mutex_lock(&prefetcher->mutex);
+    prefetcher->consumed += bytes;
+    pthread_cond_signal(&prefetcher->cond);
+    pthread_mutex_unlock(&prefetcher->mutex);
+}
+
+void input_prefetch_stop(InputPrefetcher* prefetcher) {
+    if (!prefetcher->thread_started) return;
+
+    pthread_mutex_lock(&prefetcher->mutex);
+    prefetcher->stop_requested = true;
+    pthread_cond_signal(&prefetcher->cond);
+    pthread_mutex_unlock(&prefetcher->mutex);
+
+    // An in-flight range finishes first; ranges are small enough that this is quick.
+    pthread_join(prefetcher->thread, NULL);
+    prefetcher->thread_started = false;
+
+    pthread_cond_destroy(&prefetcher->cond);
+    pthread_mutex_destroy(&prefetcher->mutex);
+    prefetcher->sync_initialized = false;
+    close(prefetcher->fd);
+    prefetcher->fd = -1;
+    free(prefetcher->scratch);
+    prefetcher->scratch = NULL;
+}
+
+#else // _WIN32
+
+bool input_prefetch_start(InputPrefetcher* prefetcher, const char* path, long long data_offset, long long data_length, long long window_bytes) {
+    (void)path; (void)data_offset; (void)data_length; (void)window_bytes;
+    memset(prefetcher, 0, sizeof(*prefetcher));
+    return false;
+}
+
+void input_prefetch_advance(InputPrefetcher* prefetcher, long long bytes) {
+    (void)prefetcher; (void)bytes;
+}
+
+void input_prefetch_stop(InputPrefetcher* prefetcher) {
+    (void)prefetcher;
+}
+
+#endif // _WIN32
@@ -0,0 +1,160 @@
+// input_range.c
+
+#include "input_range.h"
+#include "constants.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#ifndef _WIN32
+#include <strings.h>
+#endif
+
+#ifdef _WIN32
+#define strcasecmp _stricmp
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+bool input_range_parse_time(const char* str, InputTimeSpec* out) {
+    memset(out, 0, sizeof(*out));
+    if (!str || !*str) return false;
+
+    char* end = NULL;
+    errno = 0;
+    double value = strtod(str, &end);
+    if (errno != 0 || end == str || !isfinite(value) || value < 0.0) return false;
+
+    if (strcasecmp(end, "smp") == 0 || strcasecmp(end, "samples") == 0) {
+        if (value != floor(value) || value > 9.0e18) return false;
+        out->in_samples = true;
+        out->samples = (long long)value;
+    } else {
+        // [[hh:]mm:]ss[.frac], each field but the first below 60
+        double seconds = value;
+        int fields = 1;
+        while (*end == ':' && fields < 3) {
+            if (seconds != floor(seconds)) return false;
+            const char* next = end + 1;
+            errno = 0;
+            double part = strtod(next, &end);
+            if (errno != 0 || end == next || part < 0.0 || part >= 60.0) return false;
+            seconds = seconds * 60.0 + part;
+            fields++;
+        }
+        if (strcasecmp(end, "s") != 0 && *end != '\0') return false;
+        out->seconds = seconds;
+    }
+    out->provided = true;
+    return true;
+}
+
+static int64_t _time_to_frames(const InputTimeSpec* spec, int sample_rate) {
+    if (spec->in_samples) return (int64_t)spec->samples;
+    double frames = spec->seconds * (double)sample_rate;
+    return (frames >= 9.0e18) ? INT64_MAX : (int64_t)llround(frames);
+}
+
+bool input_range_resolve(const AppConfig* config, AppResources* resources) {
+    resources->input_range_start_frame = 0;
+    resources->input_warmup_frames = 0;
+    const CheckpointState* checkpoint = &resources->checkpoint;
+    if (!config->range_start.provided && !config->range_duration.provided && !checkpoint->resuming) {
+        return true;
+    }
+
+    const int sample_rate = resources->source_info.samplerate;
+    const int64_t total_frames = resources->source_info.frames;
+    int64_t start = config->range_start.provided ? _time_to_frames(&config->range_start, sample_rate) : 0;
+    if (start >= total_frames) {
+        log_fatal("--start is past the end of the input (%lld frames, %.3f s).",
+                  (long long)total_frames, (double)total_frames / (double)sample_rate);
+        return false;
+    }
+
+    int64_t length = total_frames - start;
+    if (config->range_duration.provided) {
+        int64_t duration = _time_to_frames(&config->range_duration, sample_rate);
+        if (duration < length) {
+            length = duration;
+        } else if (duration > length) {
+            log_warn("--duration runs past the end of the input; processing the %.3f s that remain.",
+                     (double)length / (double)sample_rate);
+        }
+    }
+
+    // --resume continues from where the kept output ends, up to the same end.
+    if (checkpoint->resuming) {
+        int64_t end = start + length;
+        if (checkpoint->resume_input_frame >= end) {
+            log_fatal("The checkpoint is at the end of the input; there is nothing left to process.");
+            return false;
+        }
+        start = checkpoint->resume_input_frame;
+        length = end - start;
+    }
+
+    resources->input_range_start_frame = start;
+    resources->source_info.frames = length;
+    log_info("Processing input frames %lld to %lld (%.3f s from %.3f s).", (long long)start, (long long)(start + length),
+             (double)length / (double)sample_rate, (double)start / (double)sample_rate);
+    return true;
+}
+
+void input_range_plan_warmup(const AppConfig* config, AppResources* resources) {
+    resources->input_warmup_frames = 0;
+    resources->input_warmup_frames_uncounted = 0;
+    // Passthrough copies bytes, so there is nothing to settle.
+    if (resources->input_range_start_frame == 0 || config->raw_passthrough) {
+        return;
+    }
+
+    // Filter lengths are converted to input frames from the rate each filter runs at.
+    double input_rate = (double)resources->source_info.samplerate;
+    double out_to_in = (config->target_rate > 0.0) ? input_rate / config->target_rate : 1.0;
+    double cic_to_in = (resources->cic.decimation_factor > 0) ? (double)resources->cic.decimation_factor : 1.0;
+    double frames = INPUT_RANGE_WARMUP_MIN_FRAMES;
+
+    if (resources->user_filter_num_taps > 0) {
+        bool at_output_rate = resources->stage_plan.filter_post_resample && resources->merged_decimation_factor == 0;
+        frames += (double)resources->user_filter_num_taps * (at_output_rate ? out_to_in : cic_to_in);
+    }
+    unsigned int channel_taps = 0;
+    for (int i = 0; i < resources->num_channels; i++) {
+        if (resources->channels[i].channel_filter_taps > channel_taps) channel_taps = resources->channels[i].channel_filter_taps;
+    }
+    frames += (double)channel_taps * out_to_in;
+    if (config->dc_block.enable) {
+        // The IIR blocker's time constant, in samples.
+        frames += INPUT_RANGE_WARMUP_DC_BLOCK_TIME_CONSTANTS * input_rate / (2.0 * M_PI * DC_BLOCK_CUTOFF_HZ);
+    }
+
+    int64_t warmup = (int64_t)ceil(frames);
+    if (warmup > resources->input_range_start_frame) {
+        warmup = resources->input_range_start_frame;
+    }
+    resources->input_warmup_frames = warmup;
+    resources->input_warmup_frames_uncounted = warmup;
+    // The channel outputs were opened before the warm-up was known.
+    for (int i = 0; i < resources->num_channels; i++) {
+        resources->channels[i].sink.warmup_frames_to_drop = input_range_warmup_output_frames(resources, config->target_rate);
+    }
+    log_debug("Reading %lld frames ahead of --start for filter warm-up.", (long long)warmup);
+}
+
+unsigned long long input_range_warmup_output_frames(const AppResources* resources, double output_rate) {
+    if (resources->input_warmup_frames <= 0 || resources->source_info.samplerate <= 0) return 0;
+    return (unsigned long long)llround((double)resources->input_warmup_frames * output_rate / (double)resources->source_info.samplerate);
+}
+
+int64_t input_range_count_frames(AppResources* resources, int64_t frames) {
+    int64_t warmup = resources->input_warmup_frames_uncounted;
+    if (warmup <= 0 || frames <= 0) return frames;
+    int64_t skipped = (frames < warmup) ? frames : warmup;
+    resources->input_warmup_frames_uncounted = warmup - skipped;
+    return frames - skipped;
+}
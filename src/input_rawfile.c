@@ -9,6 +9,10 @@
 #include "platform.h"
 #include "sample_convert.h"
 #include "input_common.h"
+#include "input_passthrough.h"
+#include "input_mmap.h"
+#include "input_prefetch.h"
+#include "input_range.h"
 #include "memory_arena.h"
 #include "queue.h"
 #include <stdio.h>
@@ -41,6 +45,10 @@ static struct {
 
 typedef struct {
     SNDFILE *infile;
+    int64_t file_frames;            // Length of the whole file, before --start/--duration
+    long long bytes_remaining;      // Data left in the selected range
+    MappedInput mapped;
+    InputPrefetcher prefetch;
 } RawfilePrivateData;
 
 
@@ -136,6 +144,12 @@ static bool rawfile_initialize(InputSourceContext* ctx) {
         case CS32: format_code |= SF_FORMAT_PCM_32; break;
         case CU32: format_code |= SF_FORMAT_PCM_32; break;
         case CF32: format_code |= SF_FORMAT_FLOAT;  break;
+        case CS12:
+            // libsndfile has no packed 12-bit type. A 3-byte mono frame has the same
+            // size as one packed I/Q pair, so the file is opened that way and read raw.
+            format_code |= SF_FORMAT_PCM_24;
+            sfinfo.channels = 1;
+            break;
         default:
             log_fatal("Internal error: unhandled format enum in rawfile_initialize.");
             return false;
@@ -156,11 +170,12 @@ static bool rawfile_initialize(InputSourceContext* ctx) {
     sf_command(private_data->infile, SFC_GET_CURRENT_SF_INFO, &sfinfo, sizeof(sfinfo));
     resources->source_info.samplerate = sfinfo.samplerate;
     resources->source_info.frames = sfinfo.frames;
+    private_data->file_frames = sfinfo.frames;
 
     log_info("Opened raw file with format %s, rate %.0f Hz, and %lld frames.",
              s_rawfile_config.format_str, (double)resources->source_info.samplerate, (long long)resources->source_info.frames);
 
-    return true;
+    return input_range_resolve(config, resources);
 }
 
 static void* rawfile_start_stream(InputSourceContext* ctx) {
@@ -177,6 +192,37 @@ static void* rawfile_start_stream(InputSourceContext* ctx) {
         return NULL;
     }
 
+    // Read the range selected by --start/--duration, preceded by the filter warm-up.
+    long long bytes_per_frame = (long long)resources->input_bytes_per_sample_pair;
+    int64_t first_frame = resources->input_range_start_frame - resources->input_warmup_frames;
+    long long data_offset = first_frame * bytes_per_frame;
+    long long data_length = (resources->source_info.frames + resources->input_warmup_frames) * bytes_per_frame;
+    private_data->bytes_remaining = data_length;
+    if (first_frame > 0 && sf_seek(private_data->infile, (sf_count_t)first_frame, SEEK_SET) < 0) {
+        char error_buf[256];
+        snprintf(error_buf, sizeof(error_buf), "Error seeking in raw input file: %s", sf_strerror(private_data->infile));
+        handle_fatal_thread_error(error_buf, resources);
+        return NULL;
+    }
+
+    if (config->raw_passthrough) {
+        bool handled = false;
+        if (!input_passthrough_zero_copy(ctx, data_offset, data_length, &handled) || handled) {
+            return NULL;
+        }
+    }
+
+    // Large files are converted straight from a memory mapping instead of being copied into chunks.
+    bool is_mapped = false;
+#ifndef _WIN32
+    if (!config->raw_passthrough) {
+        size_t release_lag = PIPELINE_NUM_CHUNKS * resources->sample_chunk_pool[0].raw_input_capacity_bytes;
+        is_mapped = input_mmap_open(&private_data->mapped, config->effective_input_filename, data_offset, data_length, release_lag);
+    }
+    // Keep the data ahead of the reader loading in the background, so slow storage doesn't stall the pipeline.
+    input_prefetch_start(&private_data->prefetch, config->effective_input_filename, data_offset, data_length, (long long)config->read_ahead_mb * 1024 * 1024);
+#endif
+
     while (!is_shutdown_requested() && !resources->error_occurred) {
         SampleChunk *current_item = (SampleChunk*)queue_dequeue(resources->free_sample_chunk_queue);
         if (!current_item) {
@@ -187,38 +233,47 @@ static void* rawfile_start_stream(InputSourceContext* ctx) {
 
         void* target_buffer = config->raw_passthrough ? current_item->final_output_data : current_item->raw_input_data;
         size_t bytes_to_read = config->raw_passthrough ? current_item->final_output_capacity_bytes : current_item->raw_input_capacity_bytes;
-        
-        int64_t bytes_read = sf_read_raw(private_data->infile, target_buffer, bytes_to_read);
+        if ((long long)bytes_to_read > private_data->bytes_remaining) {
+            bytes_to_read = (size_t)private_data->bytes_remaining;
+        }
+
+        int64_t bytes_read;
+        if (bytes_to_read == 0) {
+            bytes_read = 0;
+        } else if (is_mapped) {
+            const void* mapped_slice;
+            bytes_read = (int64_t)input_mmap_next(&private_data->mapped, bytes_to_read, &mapped_slice);
+            current_item->mapped_input_data = mapped_slice;
+        } else {
+            current_item->mapped_input_data = NULL;
+            bytes_read = sf_read_raw(private_data->infile, target_buffer, bytes_to_read);
+        }
 
         if (bytes_read < 0) {
-            log_fatal("libsndfile read error: %s", sf_strerror(private_data->infile));
-            pthread_mutex_lock(&resources->progress_mutex);
-            resources->error_occurred = true;
-            pthread_mutex_unlock(&resources->progress_mutex);
-            request_shutdown();
+            char error_buf[256];
+            snprintf(error_buf, sizeof(error_buf), "libsndfile read error: %s", sf_strerror(private_data->infile));
+            handle_fatal_thread_error(error_buf, resources);
             queue_enqueue(resources->free_sample_chunk_queue, current_item);
             break;
         }
 
         if (bytes_read == 0) {
             // End of file. Send a final chunk with the is_last_chunk flag set.
+            // In passthrough, the post-processor ends the writer's stream when this arrives.
             current_item->is_last_chunk = true;
             current_item->frames_read = 0;
-            if (config->raw_passthrough) {
-                // In passthrough, we also need to signal the writer thread directly.
-                file_write_buffer_signal_end_of_stream(resources->file_write_buffer);
-                queue_enqueue(resources->free_sample_chunk_queue, current_item);
-            } else {
-                queue_enqueue(resources->raw_to_pre_process_queue, current_item);
-            }
+            queue_enqueue(resources->raw_to_pre_process_queue, current_item);
             break; 
         }
 
+        private_data->bytes_remaining -= bytes_read;
+        input_prefetch_advance(&private_data->prefetch, bytes_read);
         current_item->frames_read = bytes_read / resources->input_bytes_per_sample_pair;
         current_item->is_last_chunk = false;
         
+        int64_t frames_in_range = input_range_count_frames(resources, current_item->frames_read);
         pthread_mutex_lock(&resources->progress_mutex);
-        resources->total_frames_read += current_item->frames_read;
+        resources->total_frames_read += frames_in_range;
         pthread_mutex_unlock(&resources->progress_mutex);
 
         if (config->raw_passthrough) {
@@ -235,6 +290,7 @@ static void* rawfile_start_stream(InputSourceContext* ctx) {
         }
     }
 
+    input_prefetch_stop(&private_data->prefetch);
     return NULL;
 }
 
@@ -246,6 +302,8 @@ static void rawfile_cleanup(InputSourceContext* ctx) {
     AppResources *resources = ctx->resources;
     if (resources->input_module_private_data) {
         RawfilePrivateData* private_data = (RawfilePrivateData*)resources->input_module_private_data;
+        input_prefetch_stop(&private_data->prefetch);
+        input_mmap_close(&private_data->mapped);
         if (private_data->infile) {
             log_info("Closing raw input file.");
             sf_close(private_data->infile);
@@ -272,6 +330,8 @@ static void rawfile_get_summary_info(const InputSourceContext* ctx, InputSummary
     add_summary_item(info, "Input Rate", "%.0f Hz", s_rawfile_config.sample_rate_hz);
 
     char size_buf[40];
-    long long file_size_bytes = resources->source_info.frames * resources->input_bytes_per_sample_pair;
+    const RawfilePrivateData* private_data = (const RawfilePrivateData*)resources->input_module_private_data;
+    int64_t file_frames = private_data ? private_data->file_frames : resources->source_info.frames;
+    long long file_size_bytes = file_frames * (long long)resources->input_bytes_per_sample_pair;
     add_summary_item(info, "Input File Size", "%s", format_file_size(file_size_bytes, size_buf, sizeof(size_buf)));
 }
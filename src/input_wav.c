@@ -9,8 +9,13 @@
 #include "platform.h"
 #include "sample_convert.h"
 #include "input_common.h"
+#include "input_passthrough.h"
+#include "input_mmap.h"
+#include "input_prefetch.h"
+#include "input_range.h"
 #include "memory_arena.h"
 #include "queue.h"
+#include "wav_format.h"
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
@@ -19,8 +24,6 @@
 #include <stdarg.h>
 #include "argparse.h"
 
-#include <sndfile.h>
-
 #include <stdlib.h>
 #include <stdbool.h>
 #include <ctype.h>
@@ -62,11 +65,10 @@ typedef struct {
 } AttributeParser;
 
 static void XMLCALL expat_start_element_handler(void *userData, const XML_Char *name, const XML_Char **atts);
-static bool _parse_auxi_xml_expat(const unsigned char *chunk_data, sf_count_t chunk_size, SdrMetadata *metadata);
-static bool _parse_binary_auxi_data(const unsigned char *chunk_data, sf_count_t chunk_size, SdrMetadata *metadata);
+static bool _parse_auxi_xml_expat(const unsigned char *chunk_data, size_t chunk_size, SdrMetadata *metadata);
+static bool _parse_binary_auxi_data(const unsigned char *chunk_data, size_t chunk_size, SdrMetadata *metadata);
 static time_t timegm_portable(struct tm *tm);
 static void init_sdr_metadata(SdrMetadata *metadata);
-static bool parse_sdr_metadata_chunks(SNDFILE *infile, const SF_INFO *sfinfo, SdrMetadata *metadata, MemoryArena* arena);
 static bool parse_sdr_metadata_from_filename(const char* base_filename, SdrMetadata *metadata);
 
 #ifndef HAVE_STRCASESTR
@@ -92,48 +94,12 @@ static void init_sdr_metadata(SdrMetadata *metadata) {
     metadata->source_software = SDR_SOFTWARE_UNKNOWN;
 }
 
-static bool process_specific_chunk(SNDFILE *infile, SdrMetadata *metadata, const char* chunk_id_str, MemoryArena* arena) {
-    SF_CHUNK_ITERATOR *iterator = NULL;
-    SF_CHUNK_INFO chunk_info_filter, chunk_info_query;
-    unsigned char* chunk_data_buffer = NULL;
-    bool parsed_successfully = false;
-
-    memset(&chunk_info_filter, 0, sizeof(SF_CHUNK_INFO));
-    strncpy(chunk_info_filter.id, chunk_id_str, sizeof(chunk_info_filter.id) - 1);
-    chunk_info_filter.id[sizeof(chunk_info_filter.id) - 1] = '\0';
-
-    iterator = sf_get_chunk_iterator(infile, &chunk_info_filter);
-    if (!iterator) return false;
-
-    memset(&chunk_info_query, 0, sizeof(SF_CHUNK_INFO));
-    if (sf_get_chunk_size(iterator, &chunk_info_query) != SF_ERR_NO_ERROR) return false;
-    if (chunk_info_query.datalen == 0 || chunk_info_query.datalen > MAX_METADATA_CHUNK_SIZE) return false;
-
-    chunk_data_buffer = (unsigned char*)mem_arena_alloc(arena, chunk_info_query.datalen);
-    if (!chunk_data_buffer) {
-        return false;
-    }
-
-    chunk_info_query.data = chunk_data_buffer;
-    if (sf_get_chunk_data(iterator, &chunk_info_query) != SF_ERR_NO_ERROR) {
-        return false;
-    }
-
-    if (strcmp(chunk_id_str, SDRC_AUXI_CHUNK_ID_STR) == 0) {
-        if (!_parse_auxi_xml_expat(chunk_data_buffer, chunk_info_query.datalen, metadata)) {
-            parsed_successfully = _parse_binary_auxi_data(chunk_data_buffer, chunk_info_query.datalen, metadata);
-        } else {
-            parsed_successfully = true;
-        }
+static bool _parse_auxi_chunk(const unsigned char *chunk_data, size_t chunk_size, SdrMetadata *metadata) {
+    if (chunk_size == 0) return false;
+    if (_parse_auxi_xml_expat(chunk_data, chunk_size, metadata)) {
+        return true;
     }
-
-    return parsed_successfully;
-}
-
-static bool parse_sdr_metadata_chunks(SNDFILE *infile, const SF_INFO *sfinfo, SdrMetadata *metadata, MemoryArena* arena) {
-    if (!infile || !sfinfo || !metadata) return false;
-    (void)sfinfo;
-    return process_specific_chunk(infile, metadata, SDRC_AUXI_CHUNK_ID_STR, arena);
+    return _parse_binary_auxi_data(chunk_data, chunk_size, metadata);
 }
 
 static bool parse_sdr_metadata_from_filename(const char* base_filename, SdrMetadata *metadata) {
@@ -240,9 +206,9 @@ static time_t timegm_portable(struct tm *tm) {
 #endif
 }
 
-static bool _parse_binary_auxi_data(const unsigned char *chunk_data, sf_count_t chunk_size, SdrMetadata *metadata) {
+static bool _parse_binary_auxi_data(const unsigned char *chunk_data, size_t chunk_size, SdrMetadata *metadata) {
     const size_t min_req_size = sizeof(SdrUnoSystemTime) + 16 + 4;
-    if (!chunk_data || !metadata || chunk_size < (sf_count_t)min_req_size) {
+    if (!chunk_data || !metadata || chunk_size < min_req_size) {
         return false;
     }
     bool time_parsed = false;
@@ -353,14 +319,14 @@ static void XMLCALL expat_start_element_handler(void *userData, const XML_Char *
     }
 }
 
-static bool _parse_auxi_xml_expat(const unsigned char *chunk_data, sf_count_t chunk_size, SdrMetadata *metadata) {
-    if (!chunk_data || chunk_size <= 0 || !metadata) return false;
+static bool _parse_auxi_xml_expat(const unsigned char *chunk_data, size_t chunk_size, SdrMetadata *metadata) {
+    if (!chunk_data || chunk_size == 0 || chunk_size > INT_MAX || !metadata) return false;
     XML_Parser parser = XML_ParserCreate(NULL);
     if (!parser) return false;
 
     XML_SetUserData(parser, metadata);
     XML_SetElementHandler(parser, expat_start_element_handler, NULL);
-    XML_Parse(parser, (const char*)chunk_data, chunk_size, 1);
+    XML_Parse(parser, (const char*)chunk_data, (int)chunk_size, 1);
 
     bool any_data_parsed = metadata->software_name_present ||
                            metadata->radio_model_present ||
@@ -378,7 +344,11 @@ static bool _parse_auxi_xml_expat(const unsigned char *chunk_data, sf_count_t ch
 }
 
 typedef struct {
-    SNDFILE *infile;
+    FILE *infile;
+    WavFileLayout layout;
+    long long bytes_remaining;      // Sample data not yet read through `infile`
+    MappedInput mapped;
+    InputPrefetcher prefetch;
 } WavPrivateData;
 
 extern AppConfig g_config;
@@ -490,6 +460,73 @@ static void wav_get_summary_info(const InputSourceContext* ctx, InputSummaryInfo
     }
 }
 
+static bool _wav_seek(FILE* file, long long offset) {
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static long long _wav_file_size(FILE* file) {
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END) != 0) return -1;
+    return _ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END) != 0) return -1;
+    return (long long)ftello(file);
+#endif
+}
+
+/**
+ * @brief Reads up to `bytes` from `offset`. Returns the number of bytes read; short only at the end of the file.
+ */
+static size_t _wav_read_at(FILE* file, long long offset, unsigned char* buffer, size_t bytes) {
+    if (!_wav_seek(file, offset)) return 0;
+    return fread(buffer, 1, bytes, file);
+}
+
+/**
+ * @brief Locates the chunks of the file with as few reads as possible.
+ *
+ * The first read covers the start of the file, which is where the header
+ * chunks of every common writer are. Further reads are only needed when a
+ * large chunk comes before the data, or to look for an 'auxi' chunk after it.
+ */
+static bool _wav_scan_file(FILE* file, WavFileLayout* layout, MemoryArena* arena) {
+    unsigned char* region = (unsigned char*)mem_arena_alloc(arena, WAV_HEADER_SCAN_BYTES);
+    if (!region) return false;
+
+    long long region_offset = 0;
+    while (true) {
+        size_t got = _wav_read_at(file, region_offset, region, WAV_HEADER_SCAN_BYTES);
+        if (!wav_scan_chunks(layout, region, got, region_offset)) return false;
+
+        bool want_more = (layout->data_offset == 0) || (layout->auxi_offset == 0);
+        if (!want_more || layout->next_chunk_offset <= region_offset || layout->next_chunk_offset + 8 > layout->file_size) {
+            break;
+        }
+        region_offset = layout->next_chunk_offset;
+    }
+    return layout->data_offset > 0;
+}
+
+static int64_t _wav_read_data(WavPrivateData* private_data, void* buffer, size_t capacity) {
+    size_t want = capacity;
+    if ((long long)want > private_data->bytes_remaining) {
+        want = (size_t)private_data->bytes_remaining;
+    }
+    if (want == 0) return 0;
+
+    size_t got = fread(buffer, 1, want, private_data->infile);
+    if (got < want && ferror(private_data->infile)) {
+        return -1;
+    }
+    // A file that ends early simply ends the stream.
+    private_data->bytes_remaining = (got < want) ? 0 : private_data->bytes_remaining - (long long)got;
+    return (int64_t)got;
+}
+
 static bool wav_initialize(InputSourceContext* ctx) {
     const AppConfig *config = ctx->config;
     AppResources *resources = ctx->resources;
@@ -502,58 +539,74 @@ static bool wav_initialize(InputSourceContext* ctx) {
 
 #ifdef _WIN32
     log_info("Opening WAV input file: %s", config->effective_input_filename_utf8);
-    SF_INFO sfinfo;
-    memset(&sfinfo, 0, sizeof(SF_INFO));
-    private_data->infile = sf_wchar_open(config->effective_input_filename_w, SFM_READ, &sfinfo);
+    private_data->infile = _wfopen(config->effective_input_filename_w, L"rb");
 #else
     log_info("Opening WAV input file: %s", config->effective_input_filename);
-    SF_INFO sfinfo;
-    memset(&sfinfo, 0, sizeof(SF_INFO));
-    private_data->infile = sf_open(config->effective_input_filename, SFM_READ, &sfinfo);
+    private_data->infile = fopen(config->effective_input_filename, "rb");
 #endif
 
     if (!private_data->infile) {
-        log_fatal("Error opening input file: %s", sf_strerror(NULL));
+        log_fatal("Error opening input file: %s", strerror(errno));
         return false;
     }
 
-    if (sfinfo.channels != 2) {
-        log_fatal("Error: Input file must have 2 channels (I/Q), but found %d.", sfinfo.channels);
-        sf_close(private_data->infile);
-        private_data->infile = NULL;
-        return false;
+    WavFileLayout* layout = &private_data->layout;
+    layout->file_size = _wav_file_size(private_data->infile);
+    if (layout->file_size < 0 || !_wav_scan_file(private_data->infile, layout, &resources->setup_arena)) {
+        log_fatal("Error: Input file is not a valid WAV or RF64 file.");
+        goto cleanup;
+    }
+    if (!layout->fmt_found) {
+        log_fatal("Error: Input WAV file has no format ('fmt ') chunk.");
+        goto cleanup;
     }
 
-    int sf_subtype = (sfinfo.format & SF_FORMAT_SUBMASK);
-    switch (sf_subtype) {
-        case SF_FORMAT_PCM_16: resources->input_format = CS16; break;
-        case SF_FORMAT_PCM_U8: resources->input_format = CU8; break;
-        default:
-            log_fatal("Error: Input WAV file uses an unsupported PCM subtype (0x%04X). "
-                      "Supported WAV PCM subtypes are 16-bit Signed (cs16) and 8-bit Unsigned (cu8).", sf_subtype);
-            sf_close(private_data->infile);
-            private_data->infile = NULL;
-            return false;
+    if (layout->channels != 2) {
+        log_fatal("Error: Input file must have 2 channels (I/Q), but found %u.", layout->channels);
+        goto cleanup;
+    }
+
+    if (layout->format_tag == WAV_FORMAT_TAG_PCM && layout->bits_per_sample == 16) {
+        resources->input_format = CS16;
+    } else if (layout->format_tag == WAV_FORMAT_TAG_PCM && layout->bits_per_sample == 8) {
+        resources->input_format = CU8;
+    } else {
+        log_fatal("Error: Input WAV file uses an unsupported sample format (format tag 0x%04X, %u bits). "
+                  "Supported WAV PCM subtypes are 16-bit Signed (cs16) and 8-bit Unsigned (cu8).", layout->format_tag, layout->bits_per_sample);
+        goto cleanup;
     }
 
     resources->input_bytes_per_sample_pair = get_bytes_per_sample(resources->input_format);
 
-    if (sfinfo.samplerate <= 0) {
-        log_fatal("Error: Invalid input sample rate (%d Hz).", sfinfo.samplerate);
-        sf_close(private_data->infile);
-        private_data->infile = NULL;
-        return false;
+    if (layout->sample_rate == 0 || layout->sample_rate > INT_MAX) {
+        log_fatal("Error: Invalid input sample rate (%u Hz).", layout->sample_rate);
+        goto cleanup;
+    }
+
+    if (layout->data_length_clamped) {
+        log_warn("Warning: Input file is shorter than its header says; reading the data that is there.");
     }
 
-    if (sfinfo.frames == 0) {
+    // Stop at the last whole frame.
+    int64_t frames = layout->data_length / (long long)resources->input_bytes_per_sample_pair;
+    if (frames == 0) {
         log_warn("Warning: Input file appears to be empty (0 frames).");
     }
 
-    resources->source_info.samplerate = sfinfo.samplerate;
-    resources->source_info.frames = sfinfo.frames;
+    resources->source_info.samplerate = (int)layout->sample_rate;
+    resources->source_info.frames = frames;
+    if (!input_range_resolve(config, resources)) {
+        goto cleanup;
+    }
 
     init_sdr_metadata(&resources->sdr_info);
-    resources->sdr_info_present = parse_sdr_metadata_chunks(private_data->infile, &sfinfo, &resources->sdr_info, &resources->setup_arena);
+    // The metadata chunk is only read if the scan found one.
+    if (layout->auxi_offset > 0 && layout->auxi_length <= MAX_METADATA_CHUNK_SIZE) {
+        unsigned char* auxi = (unsigned char*)mem_arena_alloc(&resources->setup_arena, layout->auxi_length);
+        if (auxi && _wav_read_at(private_data->infile, layout->auxi_offset, auxi, layout->auxi_length) == layout->auxi_length) {
+            resources->sdr_info_present = _parse_auxi_chunk(auxi, layout->auxi_length, &resources->sdr_info);
+        }
+    }
 
     char basename_buffer[MAX_PATH_BUFFER];
     // MODIFIED: Pass the setup_arena to the basename parsing function.
@@ -564,12 +617,47 @@ static bool wav_initialize(InputSourceContext* ctx) {
     }
 
     return true;
+
+cleanup:
+    fclose(private_data->infile);
+    private_data->infile = NULL;
+    return false;
 }
 
 static void* wav_start_stream(InputSourceContext* ctx) {
     AppResources *resources = ctx->resources;
     WavPrivateData* private_data = (WavPrivateData*)resources->input_module_private_data;
 
+    // Read the range selected by --start/--duration, preceded by the filter warm-up.
+    long long bytes_per_frame = (long long)resources->input_bytes_per_sample_pair;
+    long long data_offset = private_data->layout.data_offset + (resources->input_range_start_frame - resources->input_warmup_frames) * bytes_per_frame;
+    long long data_length = (resources->source_info.frames + resources->input_warmup_frames) * bytes_per_frame;
+    private_data->bytes_remaining = data_length;
+    if (!_wav_seek(private_data->infile, data_offset)) {
+        char error_buf[256];
+        snprintf(error_buf, sizeof(error_buf), "Error seeking to the WAV sample data: %s", strerror(errno));
+        handle_fatal_thread_error(error_buf, resources);
+        return NULL;
+    }
+
+    bool is_mapped = false;
+#ifndef _WIN32
+
+    if (ctx->config->raw_passthrough) {
+        bool handled = false;
+        if (!input_passthrough_zero_copy(ctx, data_offset, data_length, &handled) || handled) {
+            return NULL;
+        }
+    }
+
+    // Large files are converted straight from a memory mapping instead of being copied into chunks.
+    size_t release_lag = PIPELINE_NUM_CHUNKS * resources->sample_chunk_pool[0].raw_input_capacity_bytes;
+    is_mapped = input_mmap_open(&private_data->mapped, ctx->config->effective_input_filename, data_offset, data_length, release_lag);
+
+    // Keep the data ahead of the reader loading in the background, so slow storage doesn't stall the pipeline.
+    input_prefetch_start(&private_data->prefetch, ctx->config->effective_input_filename, data_offset, data_length, (long long)ctx->config->read_ahead_mb * 1024 * 1024);
+#endif
+
     while (!is_shutdown_requested() && !resources->error_occurred) {
         SampleChunk *current_item = (SampleChunk*)queue_dequeue(resources->free_sample_chunk_queue);
         if (!current_item) {
@@ -578,25 +666,33 @@ static void* wav_start_stream(InputSourceContext* ctx) {
 
         current_item->stream_discontinuity_event = false;
 
-        int64_t bytes_read = sf_read_raw(private_data->infile, current_item->raw_input_data, current_item->raw_input_capacity_bytes);
+        int64_t bytes_read;
+        if (is_mapped) {
+            const void* mapped_slice;
+            bytes_read = (int64_t)input_mmap_next(&private_data->mapped, current_item->raw_input_capacity_bytes, &mapped_slice);
+            current_item->mapped_input_data = mapped_slice;
+        } else {
+            current_item->mapped_input_data = NULL;
+            bytes_read = _wav_read_data(private_data, current_item->raw_input_data, current_item->raw_input_capacity_bytes);
+        }
 
         if (bytes_read < 0) {
-            log_fatal("libsndfile read error: %s", sf_strerror(private_data->infile));
-            pthread_mutex_lock(&resources->progress_mutex);
-            resources->error_occurred = true;
-            pthread_mutex_unlock(&resources->progress_mutex);
-            request_shutdown();
+            char error_buf[256];
+            snprintf(error_buf, sizeof(error_buf), "Error reading input file: %s", strerror(errno));
+            handle_fatal_thread_error(error_buf, resources);
             queue_enqueue(resources->free_sample_chunk_queue, current_item);
             break;
         }
 
+        input_prefetch_advance(&private_data->prefetch, bytes_read);
         current_item->frames_read = bytes_read / resources->input_bytes_per_sample_pair;
         
         current_item->is_last_chunk = (current_item->frames_read == 0);
 
         if (!current_item->is_last_chunk) {
+            int64_t frames_in_range = input_range_count_frames(resources, current_item->frames_read);
             pthread_mutex_lock(&resources->progress_mutex);
-            resources->total_frames_read += current_item->frames_read;
+            resources->total_frames_read += frames_in_range;
             pthread_mutex_unlock(&resources->progress_mutex);
         }
 
@@ -609,6 +705,7 @@ static void* wav_start_stream(InputSourceContext* ctx) {
             break;
         }
     }
+    input_prefetch_stop(&private_data->prefetch);
     return NULL;
 }
 
@@ -620,9 +717,11 @@ static void wav_cleanup(InputSourceContext* ctx) {
     AppResources *resources = ctx->resources;
     if (resources->input_module_private_data) {
         WavPrivateData* private_data = (WavPrivateData*)resources->input_module_private_data;
+        input_prefetch_stop(&private_data->prefetch);
+        input_mmap_close(&private_data->mapped);
         if (private_data->infile) {
             log_info("Closing WAV input file.");
-            sf_close(private_data->infile);
+            fclose(private_data->infile);
             private_data->infile = NULL;
         }
         resources->input_module_private_data = NULL;
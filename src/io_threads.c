@@ -9,6 +9,8 @@
 #include "signal_handler.h"
 #include "log.h"
 #include "input_source.h"
+#include "output_branch.h"
+#include "checkpoint.h"
 #include "queue.h" // <-- MODIFIED: Added the missing include for queue functions
 #include <stdio.h>
 #include <string.h>
@@ -142,12 +144,12 @@ void* writer_thread_func(void* arg) {
             if (!item) break;
 
             if (item->stream_discontinuity_event) {
-                queue_enqueue(resources->free_sample_chunk_queue, item);
+                output_branch_release_chunk(resources, item);
                 continue;
             }
 
             if (item->is_last_chunk) {
-                queue_enqueue(resources->free_sample_chunk_queue, item);
+                output_branch_release_chunk(resources, item);
                 break;
             }
 
@@ -155,18 +157,21 @@ void* writer_thread_func(void* arg) {
             if (output_bytes_this_chunk > 0) {
                 size_t written_bytes = resources->writer_ctx.ops.write(&resources->writer_ctx, item->final_output_data, output_bytes_this_chunk);
                 if (written_bytes != output_bytes_this_chunk) {
-                    if (!is_shutdown_requested()) {
+                    if (resources->isolate_errors) {
+                        char error_buf[256];
+                        snprintf(error_buf, sizeof(error_buf), "Writer: stdout write error: %s", strerror(errno));
+                        handle_fatal_thread_error(error_buf, resources);
+                    } else if (!is_shutdown_requested()) {
+                        // A closed pipe on stdout is a normal way to end; it is not reported as an error.
                         log_debug("Writer: stdout write error: %s", strerror(errno));
                         request_shutdown();
                     }
-                    queue_enqueue(resources->free_sample_chunk_queue, item);
+                    output_branch_release_chunk(resources, item);
                     break;
                 }
             }
             
-            if (!queue_enqueue(resources->free_sample_chunk_queue, item)) {
-                break;
-            }
+            output_branch_release_chunk(resources, item);
         }
     } else {
         unsigned char* local_write_buffer = (unsigned char*)resources->writer_local_buffer;
@@ -201,9 +206,62 @@ void* writer_thread_func(void* arg) {
 
                 resources->progress_callback(current_frames, resources->expected_total_output_frames, current_bytes, resources->progress_callback_udata);
             }
+            checkpoint_on_output_written(resources);
         }
+        checkpoint_on_writer_exit(resources);
     }
 
     log_debug("Writer thread is exiting.");
     return NULL;
 }
+
+void* output_sink_writer_thread_func(void* arg) {
+#ifdef _WIN32
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST)) {
+        log_warn("Failed to set output writer thread priority to HIGHEST.");
+    }
+#endif
+
+    OutputSink* sink = (OutputSink*)arg;
+    AppResources* resources = sink->resources;
+    unsigned char* local_write_buffer = (unsigned char*)sink->writer_local_buffer;
+
+    while (true) {
+        size_t bytes_read = file_write_buffer_read(sink->write_buffer, local_write_buffer, IO_FILE_WRITER_CHUNK_SIZE);
+
+        if (bytes_read == 0) {
+            break; // End of stream or shutdown
+        }
+
+        size_t written_bytes = sink->writer_ctx.ops.write(&sink->writer_ctx, local_write_buffer, bytes_read);
+
+        if (written_bytes != bytes_read) {
+            char error_buf[MAX_PATH_BUFFER + 64];
+            snprintf(error_buf, sizeof(error_buf), "Writer: File write error on '%s': %s", sink->path, strerror(errno));
+            handle_fatal_thread_error(error_buf, resources);
+            break;
+        }
+
+        unsigned long long frames_now = (unsigned long long)sink->writer_ctx.ops.get_total_bytes_written(&sink->writer_ctx) / sink->bytes_per_sample_pair;
+        unsigned long long frames_delta = frames_now - sink->frames_written;
+        sink->frames_written = frames_now;
+        if (!sink->counts_toward_totals) continue;
+
+        // The totals cover all counted sinks. Only the first sink's writer reports
+        // progress, since the progress callback is not reentrant.
+        pthread_mutex_lock(&resources->progress_mutex);
+        resources->total_output_frames += frames_delta;
+        unsigned long long total_frames = resources->total_output_frames;
+        pthread_mutex_unlock(&resources->progress_mutex);
+
+        if (sink->index == 0 && resources->progress_callback) {
+            long long expected_total = (resources->expected_total_output_frames > 0)
+                                     ? resources->expected_total_output_frames * resources->num_channels
+                                     : -1;
+            resources->progress_callback(total_frames, expected_total, total_frames * sink->bytes_per_sample_pair, resources->progress_callback_udata);
+        }
+    }
+
+    log_debug("Writer thread for '%s' is exiting.", sink->path);
+    return NULL;
+}
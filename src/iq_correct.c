@@ -3,6 +3,7 @@
 #include "log.h"
 #include "config.h"
 #include "memory_arena.h" // <-- MODIFIED: Add the missing include
+#include "queue.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -27,6 +28,8 @@ static float _calculate_imbalance_metric(IqCorrectionResources* iq_res, const co
 static void _estimate_power(IqCorrectionResources* iq_res, const complex_float_t* signal_block);
 static float _get_random_direction(void);
 static void _calculate_power_spectrum(IqCorrectionResources* iq_res, const complex_float_t* signal_block, float gain_adj, float phase_adj);
+static void _run_stats_estimator(IqCorrectionResources* iq_res, const complex_float_t* signal_block);
+static void _publish_factors(IqCorrectionResources* iq_res, float gain, float phase);
 
 
 // --- Public API Functions ---
@@ -44,13 +47,13 @@ bool iq_correct_init(AppConfig* config, AppResources* resources, MemoryArena* ar
     resources->iq_correction.fft_shift_buffer = (complex_float_t*)mem_arena_alloc(arena, nfft * sizeof(complex_float_t));
     resources->iq_correction.spectrum_buffer = (float*)mem_arena_alloc(arena, nfft * sizeof(float));
     resources->iq_correction.window_coeffs = (float*)mem_arena_alloc(arena, nfft * sizeof(float));
-    resources->iq_correction.optimization_accum_buffer = (complex_float_t*)mem_arena_alloc(arena, IQ_CORRECTION_FFT_SIZE * sizeof(complex_float_t));
+    resources->iq_correction.snapshot_pool = (complex_float_t*)mem_arena_alloc(arena, (size_t)IQ_CORRECTION_SNAPSHOT_POOL_SIZE * nfft * sizeof(complex_float_t));
 
     if (!resources->iq_correction.fft_buffer ||
         !resources->iq_correction.fft_shift_buffer ||
         !resources->iq_correction.spectrum_buffer ||
         !resources->iq_correction.window_coeffs ||
-        !resources->iq_correction.optimization_accum_buffer) {
+        !resources->iq_correction.snapshot_pool) {
         // mem_arena_alloc logs the fatal error, so we just need to return
         return false;
     }
@@ -74,9 +77,13 @@ bool iq_correct_init(AppConfig* config, AppResources* resources, MemoryArena* ar
 
     resources->iq_correction.average_power = 0.0f;
     resources->iq_correction.power_range = 0.0f;
-    resources->iq_correction.samples_in_accum = 0;
+    resources->iq_correction.have_moments = false;
+    resources->iq_correction.pending_snapshot = NULL;
+    resources->iq_correction.pending_snapshot_fill = 0;
+    resources->iq_correction.samples_until_snapshot = 0; // Take the first snapshot right away
 
-    log_info("I/Q Correction enabled");
+    log_info("I/Q Correction enabled (%s estimator)",
+             config->iq_correction.method == IQ_CORRECTION_METHOD_STATS ? "closed-form" : "search");
     return true;
 }
 
@@ -90,11 +97,63 @@ void iq_correct_apply(AppResources* resources, complex_float_t* samples, int num
     _apply_correction_to_buffer(samples, num_samples, gain_adj, phase_adj);
 }
 
+void iq_correct_feed_optimizer(AppResources* resources, const complex_float_t* samples, int num_samples) {
+    IqCorrectionResources* iq_res = &resources->iq_correction;
+    int pos = 0;
+
+    while (pos < num_samples) {
+        if (!iq_res->pending_snapshot) {
+            unsigned long long remaining = (unsigned long long)(num_samples - pos);
+            if (iq_res->samples_until_snapshot >= remaining) {
+                iq_res->samples_until_snapshot -= remaining;
+                return;
+            }
+            pos += (int)iq_res->samples_until_snapshot;
+            iq_res->samples_until_snapshot = IQ_CORRECTION_DEFAULT_PERIOD;
+
+            // The optimizer may still hold every buffer; skip this snapshot rather than wait.
+            iq_res->pending_snapshot = (complex_float_t*)queue_try_dequeue(resources->iq_snapshot_free_queue);
+            iq_res->pending_snapshot_fill = 0;
+            if (!iq_res->pending_snapshot) {
+                log_debug("IQ_OPT_PROBE: Optimizer busy, skipping snapshot.");
+                continue;
+            }
+        }
+
+        unsigned int needed = IQ_CORRECTION_FFT_SIZE - iq_res->pending_snapshot_fill;
+        unsigned int available = (unsigned int)(num_samples - pos);
+        unsigned int to_copy = (available < needed) ? available : needed;
+        memcpy(iq_res->pending_snapshot + iq_res->pending_snapshot_fill, samples + pos, to_copy * sizeof(complex_float_t));
+        iq_res->pending_snapshot_fill += to_copy;
+        pos += (int)to_copy;
+
+        // Samples spent filling the snapshot count towards the next period.
+        if (iq_res->samples_until_snapshot > to_copy) {
+            iq_res->samples_until_snapshot -= to_copy;
+        } else {
+            iq_res->samples_until_snapshot = 0;
+        }
+
+        if (iq_res->pending_snapshot_fill == IQ_CORRECTION_FFT_SIZE) {
+            // The data queue holds at most the whole pool, so this cannot block.
+            if (!queue_enqueue(resources->iq_optimization_data_queue, iq_res->pending_snapshot)) {
+                queue_enqueue(resources->iq_snapshot_free_queue, iq_res->pending_snapshot);
+            }
+            iq_res->pending_snapshot = NULL;
+        }
+    }
+}
+
 void iq_correct_run_optimization(AppResources* resources, const complex_float_t* optimization_data) {
     if (!resources->config->iq_correction.enable) return;
 
     log_debug("IQ_OPT_PROBE: Optimization function was called.");
 
+    if (resources->config->iq_correction.method == IQ_CORRECTION_METHOD_STATS) {
+        _run_stats_estimator(&resources->iq_correction, optimization_data);
+        return;
+    }
+
     _estimate_power(&resources->iq_correction, optimization_data);
 
     const float absolute_peak_threshold_db = IQ_CORRECTION_PEAK_THRESHOLD_DB;
@@ -131,15 +190,11 @@ void iq_correct_run_optimization(AppResources* resources, const complex_float_t*
     log_debug("IQ_OPT_PROBE: Final raw params for this pass: mag=%.6f, phase=%.6f", current_gain, current_phase);
 
     int current_active_idx = atomic_load(&resources->iq_correction.active_buffer_idx);
-    int inactive_idx = 1 - current_active_idx;
 
     float smoothed_gain = ((1.0f - IQ_CORRECTION_SMOOTHING_FACTOR) * resources->iq_correction.factors_buffer[current_active_idx].mag) + (IQ_CORRECTION_SMOOTHING_FACTOR * current_gain);
     float smoothed_phase = ((1.0f - IQ_CORRECTION_SMOOTHING_FACTOR) * resources->iq_correction.factors_buffer[current_active_idx].phase) + (IQ_CORRECTION_SMOOTHING_FACTOR * current_phase);
 
-    resources->iq_correction.factors_buffer[inactive_idx].mag = smoothed_gain;
-    resources->iq_correction.factors_buffer[inactive_idx].phase = smoothed_phase;
-
-    atomic_store(&resources->iq_correction.active_buffer_idx, inactive_idx);
+    _publish_factors(&resources->iq_correction, smoothed_gain, smoothed_phase);
 
     log_debug("IQ_OPT_PROBE: Smoothed global params updated to: mag=%.6f, phase=%.6f", smoothed_gain, smoothed_phase);
 }
@@ -154,7 +209,8 @@ void iq_correct_cleanup(AppResources* resources) {
     resources->iq_correction.fft_shift_buffer = NULL;
     resources->iq_correction.spectrum_buffer = NULL;
     resources->iq_correction.window_coeffs = NULL;
-    resources->iq_correction.optimization_accum_buffer = NULL;
+    resources->iq_correction.snapshot_pool = NULL;
+    resources->iq_correction.pending_snapshot = NULL;
 }
 
 
@@ -242,6 +298,77 @@ static void _estimate_power(IqCorrectionResources* iq_res, const complex_float_t
     }
 }
 
+/**
+ * @brief Estimates the correction directly from running second-order statistics.
+ *
+ * For the correction I' = (1 + g) I, Q' = Q + p I, choosing p = -E[IQ] / E[I^2]
+ * makes I' and Q' uncorrelated, and g = sqrt(E[Q'^2] / E[I^2]) - 1 equalizes
+ * their powers. The statistics, not the factors, are smoothed across snapshots,
+ * so the first snapshot already yields a full estimate. Cost is O(N) with no
+ * FFT, logarithm or trigonometric function.
+ */
+static void _run_stats_estimator(IqCorrectionResources* iq_res, const complex_float_t* signal_block) {
+    const int n = IQ_CORRECTION_FFT_SIZE;
+    double sum_i = 0.0, sum_q = 0.0;
+    double sum_ii = 0.0, sum_qq = 0.0, sum_iq = 0.0;
+
+    for (int k = 0; k < n; k++) {
+        double i_val = crealf(signal_block[k]);
+        double q_val = cimagf(signal_block[k]);
+        sum_i += i_val;
+        sum_q += q_val;
+        sum_ii += i_val * i_val;
+        sum_qq += q_val * q_val;
+        sum_iq += i_val * q_val;
+    }
+
+    // Remove any residual DC so it does not bias the estimate.
+    double mean_i = sum_i / n, mean_q = sum_q / n;
+    double ii = sum_ii / n - mean_i * mean_i;
+    double qq = sum_qq / n - mean_q * mean_q;
+    double iq = sum_iq / n - mean_i * mean_q;
+
+    if (ii + qq < IQ_CORRECTION_STATS_MIN_POWER) {
+        log_debug("IQ_OPT_PROBE: Skipping statistics update, signal power too low.");
+        return;
+    }
+
+    if (iq_res->have_moments) {
+        const double alpha = IQ_CORRECTION_SMOOTHING_FACTOR;
+        iq_res->moment_ii += alpha * (ii - iq_res->moment_ii);
+        iq_res->moment_qq += alpha * (qq - iq_res->moment_qq);
+        iq_res->moment_iq += alpha * (iq - iq_res->moment_iq);
+    } else {
+        iq_res->moment_ii = ii;
+        iq_res->moment_qq = qq;
+        iq_res->moment_iq = iq;
+        iq_res->have_moments = true;
+    }
+
+    if (iq_res->moment_ii <= 0.0) return;
+
+    double phase = -iq_res->moment_iq / iq_res->moment_ii;
+    double q_orth_power = iq_res->moment_qq + phase * iq_res->moment_iq;
+    if (q_orth_power <= 0.0) return;
+    double gain = sqrt(q_orth_power / iq_res->moment_ii) - 1.0;
+
+    _publish_factors(iq_res, (float)gain, (float)phase);
+    log_debug("IQ_OPT_PROBE: Closed-form params updated to: mag=%.6f, phase=%.6f", gain, phase);
+}
+
+/**
+ * @brief Makes new correction factors visible to the pre-processor.
+ *
+ * Only the optimizer thread writes factors, so it can fill the inactive slot
+ * and then flip the index atomically.
+ */
+static void _publish_factors(IqCorrectionResources* iq_res, float gain, float phase) {
+    int inactive_idx = 1 - atomic_load(&iq_res->active_buffer_idx);
+    iq_res->factors_buffer[inactive_idx].mag = gain;
+    iq_res->factors_buffer[inactive_idx].phase = phase;
+    atomic_store(&iq_res->active_buffer_idx, inactive_idx);
+}
+
 static float _get_random_direction(void) {
     return (rand() > (RAND_MAX / 2)) ? 1.0f : -1.0f;
 }
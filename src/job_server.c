@@ -0,0 +1,582 @@
+// job_server.c
+
+#include "job_server.h"
+#include "constants.h"
+#include "cli.h"
+#include "setup.h"
+#include "signal_handler.h"
+#include "queue.h"
+#include "utils.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <stdarg.h>
+#include <stddef.h>
+#include <strings.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+// Linux reports a write to a closed connection with EPIPE when this flag is
+// given; elsewhere SO_NOSIGPIPE is set on the socket instead.
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef struct {
+    int fd;
+    unsigned long id;
+    time_t last_progress_time;
+
+    // Parsed from the request; the values point into `request`.
+    const char* input;
+    const char* output;
+    const char* preset;
+    const char* sample_format;
+    const char* container;
+    const char* start;
+    const char* duration;
+    float output_rate;
+    float gain;
+    bool output_rate_given;
+    bool gain_given;
+    bool overwrite;
+    bool client_gone;       // A reply failed; nothing more is sent to this client
+    time_t accepted_time;
+    size_t request_length;
+
+    char request[SERVER_MAX_REQUEST_BYTES + 1]; // Must stay last, see _accept_loop()
+} ServerJob;
+
+typedef struct {
+    const AppConfig* base_config;
+    struct InputSourceOps* input_ops;
+    int num_pipelines;
+    Queue free_jobs;
+    Queue pending_jobs;
+
+    // Held while a pipeline is set up or torn down: FFTW planning and
+    // liquid-dsp object creation are not thread-safe.
+    pthread_mutex_t mutex;
+} ServerState;
+
+typedef struct {
+    ServerState* server;
+    AppConfig config;
+    AppResources resources;
+    pthread_t thread;
+} ServerWorker;
+
+
+/**
+ * @brief Sends one formatted reply line. With `may_drop`, the line is dropped
+ * instead of waiting when the client is not reading, so a stalled client
+ * never holds up the writer thread.
+ */
+static void _send_text(ServerJob* job, char* line, int len, bool may_drop) {
+    if (job->client_gone || len < 0) return;
+    if ((size_t)len > MAX_PATH_BUFFER - 2) len = (int)(MAX_PATH_BUFFER - 2);
+    line[len++] = '\n';
+
+    int flags = MSG_NOSIGNAL | (may_drop ? MSG_DONTWAIT : 0);
+    size_t sent = 0;
+    while (sent < (size_t)len) {
+        ssize_t n = send(job->fd, line + sent, (size_t)len - sent, flags);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && sent == 0 && may_drop && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n <= 0) {
+            // Gone, timed out (SO_SNDTIMEO) or cut off mid-line: the client gets no further replies.
+            job->client_gone = true;
+            return;
+        }
+        sent += (size_t)n;
+    }
+}
+
+/**
+ * @brief Sends one reply line. A client that has gone away is not an error; the job still runs.
+ */
+static void _send_line(ServerJob* job, const char* fmt, ...) {
+    char line[MAX_PATH_BUFFER];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line) - 1, fmt, args);
+    va_end(args);
+    _send_text(job, line, len, false);
+}
+
+static void _job_progress_callback(unsigned long long current_output_frames, long long total_output_frames,
+                                   unsigned long long current_bytes_written, void* udata) {
+    if (PROGRESS_UPDATE_INTERVAL_SECONDS <= 0) return;
+    ServerJob* job = (ServerJob*)udata;
+    time_t now = time(NULL);
+    if (difftime(now, job->last_progress_time) < PROGRESS_UPDATE_INTERVAL_SECONDS) return;
+    job->last_progress_time = now;
+    char line[MAX_PATH_BUFFER];
+    int len = snprintf(line, sizeof(line) - 1, "PROGRESS %llu %lld %llu", current_output_frames,
+                       (total_output_frames > 0) ? total_output_frames : -1LL, current_bytes_written);
+    _send_text(job, line, len, true);
+}
+
+typedef enum {
+    REQUEST_INCOMPLETE,
+    REQUEST_COMPLETE,
+    REQUEST_FAILED
+} RequestStatus;
+
+/**
+ * @brief Reads what the client has sent of its job description so far, without waiting.
+ *
+ * The description ends at a blank line or when the client closes its side.
+ */
+static RequestStatus _read_request(ServerJob* job) {
+    while (job->request_length < SERVER_MAX_REQUEST_BYTES) {
+        ssize_t n = recv(job->fd, job->request + job->request_length,
+                         SERVER_MAX_REQUEST_BYTES - job->request_length, MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? REQUEST_INCOMPLETE : REQUEST_FAILED;
+        if (n == 0) return (job->request_length > 0) ? REQUEST_COMPLETE : REQUEST_FAILED;
+        job->request_length += (size_t)n;
+        job->request[job->request_length] = '\0';
+        if (strstr(job->request, "\n\n") || strstr(job->request, "\r\n\r\n")) return REQUEST_COMPLETE;
+    }
+    return REQUEST_FAILED; // Too long
+}
+
+static bool _parse_float(const char* value, float* out) {
+    char* end = NULL;
+    errno = 0;
+    float parsed = strtof(value, &end);
+    if (errno != 0 || end == value || *end != '\0') return false;
+    *out = parsed;
+    return true;
+}
+
+/**
+ * @brief Splits the request into its `key=value` lines, in place.
+ * @return NULL on success, otherwise the reason to send to the client.
+ */
+static const char* _parse_request(ServerJob* job) {
+    char* line = job->request;
+    while (line && *line) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        line[strcspn(line, "\r")] = '\0';
+        if (line[0] == '\0') break; // End of the job description
+        if (line[0] == '#') {
+            line = next;
+            continue;
+        }
+
+        char* value = strchr(line, '=');
+        if (!value) return "malformed line, expected key=value";
+        *value++ = '\0';
+
+        if (strcmp(line, "input") == 0) {
+            job->input = value;
+        } else if (strcmp(line, "output") == 0) {
+            job->output = value;
+        } else if (strcmp(line, "preset") == 0) {
+            job->preset = value;
+        } else if (strcmp(line, "output-sample-format") == 0) {
+            job->sample_format = value;
+        } else if (strcmp(line, "output-container") == 0) {
+            job->container = value;
+        } else if (strcmp(line, "start") == 0) {
+            job->start = value;
+        } else if (strcmp(line, "duration") == 0) {
+            job->duration = value;
+        } else if (strcmp(line, "output-rate") == 0) {
+            if (!_parse_float(value, &job->output_rate) || job->output_rate <= 0.0f) return "invalid output-rate";
+            job->output_rate_given = true;
+        } else if (strcmp(line, "gain-multiplier") == 0) {
+            if (!_parse_float(value, &job->gain) || job->gain <= 0.0f) return "invalid gain-multiplier";
+            job->gain_given = true;
+        } else if (strcmp(line, "overwrite") == 0) {
+            job->overwrite = (strcasecmp(value, "yes") == 0 || strcasecmp(value, "true") == 0 || strcmp(value, "1") == 0);
+        } else {
+            return "unknown key";
+        }
+        line = next;
+    }
+
+    if (!job->input || !job->input[0]) return "missing input";
+    if (!job->output || !job->output[0]) return "missing output";
+    return NULL;
+}
+
+static void _run_job(ServerWorker* worker, ServerJob* job) {
+    ServerState* server = worker->server;
+
+    if (is_shutdown_requested()) {
+        _send_line(job, "ERROR server is shutting down");
+        return;
+    }
+
+    // The server's options as given on its command line, overridden by the job's.
+    AppConfig* config = &worker->config;
+    *config = *server->base_config;
+    config->input_filename_arg = (char*)job->input;
+    config->output_filename_arg = (char*)job->output;
+    // A job's preset or output rate replaces whichever of the two the server was started with.
+    if (job->preset) {
+        config->preset_name = (char*)job->preset;
+        config->user_defined_target_rate_arg = 0.0f;
+    }
+    if (job->output_rate_given) {
+        config->user_defined_target_rate_arg = job->output_rate;
+        if (!job->preset) config->preset_name = NULL;
+    }
+    if (job->sample_format) config->sample_type_name = (char*)job->sample_format;
+    if (job->container) config->output_type_name = (char*)job->container;
+    if (job->start) config->start_arg = job->start;
+    if (job->duration) config->duration_arg = job->duration;
+    if (job->gain_given) config->gain = job->gain;
+
+    AppResources* resources = &worker->resources;
+    pipeline_resources_reset(resources);
+    resources->selected_input_ops = server->input_ops;
+    resources->batch_quiet = true;
+    resources->isolate_errors = true;
+    resources->concurrent_pipelines = server->num_pipelines;
+    resources->progress_callback = _job_progress_callback;
+    resources->progress_callback_udata = job;
+
+    const char* setup_error = NULL;
+    pthread_mutex_lock(&server->mutex);
+    if (!cli_validate_options(config, &resources->setup_arena)) {
+        setup_error = "invalid job options";
+    } else if (pipeline_find_existing_output(config, NULL, 0)) {
+        if (!job->overwrite) {
+            setup_error = "output file exists, send overwrite=yes to replace it";
+        } else {
+            pipeline_remove_outputs(config);
+            if (pipeline_find_existing_output(config, NULL, 0)) setup_error = "could not remove the existing output file";
+        }
+    }
+    if (!setup_error) {
+        if (initialize_application(config, resources)) {
+            signal_handler_track_resources(resources, true);
+        } else {
+            cleanup_application(config, resources);
+            pipeline_remove_outputs(config);
+            setup_error = "job could not be set up";
+        }
+    }
+    pthread_mutex_unlock(&server->mutex);
+
+    if (setup_error) {
+        log_error("Job %lu (%s): %s.", job->id, job->input, setup_error);
+        _send_line(job, "ERROR %s", setup_error);
+        return;
+    }
+
+    log_info("Job %lu: %s -> %s", job->id, job->input, job->output);
+    _send_line(job, "OK %lu", job->id);
+    resources->start_time = time(NULL);
+    bool processing_ok = run_processing_pipeline(config, resources);
+
+    pthread_mutex_lock(&server->mutex);
+    signal_handler_track_resources(resources, false);
+    cleanup_application(config, resources);
+    pthread_mutex_unlock(&server->mutex);
+
+    double duration_secs = difftime(time(NULL), resources->start_time);
+    if (processing_ok && resources->end_of_stream_reached) {
+        char size_buf[40];
+        format_file_size(resources->final_output_size_bytes, size_buf, sizeof(size_buf));
+        log_info("Job %lu: done (%s).", job->id, size_buf);
+        _send_line(job, "DONE %llu %lld %.0f", resources->total_output_frames,
+                   resources->final_output_size_bytes, duration_secs);
+        return;
+    }
+
+    // A job that did not complete leaves no partial output behind.
+    pipeline_remove_outputs(config);
+    if (!processing_ok) {
+        log_error("Job %lu: processing failed.", job->id);
+        _send_line(job, "ERROR processing failed, see the server log");
+    } else {
+        log_warn("Job %lu: cancelled, partial output removed.", job->id);
+        _send_line(job, "CANCELLED");
+    }
+}
+
+static void* _server_worker_thread(void* arg) {
+    ServerWorker* worker = (ServerWorker*)arg;
+    ServerState* server = worker->server;
+
+    // Jobs still queued at shutdown are dequeued too, so each client gets a reply.
+    ServerJob* job;
+    while ((job = (ServerJob*)queue_dequeue(&server->pending_jobs)) != NULL) {
+        _run_job(worker, job);
+        close(job->fd);
+        job->fd = -1;
+        queue_enqueue(&server->free_jobs, job);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Creates the listening socket, replacing a stale socket file left by a previous run.
+ */
+static int _open_listen_socket(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        log_fatal("Socket path '%s' is too long (at most %zu characters).", path, sizeof(addr.sun_path) - 1);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            log_fatal("'%s' exists and is not a socket.", path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        log_fatal("Failed to create socket: %s", strerror(errno));
+        return -1;
+    }
+    // Jobs can read and write any file the server can, so only its own user may
+    // connect. The umask keeps the socket private from the moment it exists; the
+    // chmod is a second guard. No other thread is running yet.
+    mode_t old_umask = umask(S_IRWXG | S_IRWXO);
+    int bind_result = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    int bind_errno = errno;
+    umask(old_umask);
+    if (bind_result != 0) {
+        log_fatal("Failed to bind socket '%s': %s", path, strerror(bind_errno));
+        close(fd);
+        return -1;
+    }
+    if (chmod(path, S_IRUSR | S_IWUSR) != 0 || listen(fd, SERVER_MAX_PENDING_JOBS) != 0) {
+        log_fatal("Failed to listen on socket '%s': %s", path, strerror(errno));
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    return fd;
+}
+
+static void _configure_client_socket(int fd) {
+    struct timeval timeout;
+    timeout.tv_sec = SERVER_REQUEST_TIMEOUT_SECONDS;
+    timeout.tv_usec = 0;
+    // Bounds the final replies; progress lines do not wait at all.
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+/**
+ * @brief Turns a client away with an error reply and frees its job slot.
+ */
+static void _reject_job(ServerState* server, ServerJob* job, const char* reason) {
+    char line[MAX_PATH_BUFFER];
+    int len = snprintf(line, sizeof(line) - 1, "ERROR %s", reason);
+    _send_text(job, line, len, true);
+    close(job->fd);
+    job->fd = -1;
+    queue_enqueue(&server->free_jobs, job);
+}
+
+/**
+ * @brief Queues a job whose description has been read, or rejects it.
+ */
+static void _dispatch_job(ServerState* server, ServerJob* job, RequestStatus status) {
+    const char* error = (status == REQUEST_COMPLETE) ? _parse_request(job) : "no complete job description received";
+    if (!error && queue_enqueue(&server->pending_jobs, job)) return;
+    _reject_job(server, job, error ? error : "server is shutting down");
+}
+
+/**
+ * @brief Accepts clients, reads their job descriptions and queues complete jobs
+ * for the workers until a shutdown is requested.
+ *
+ * Descriptions are read here rather than on a worker, so a client that
+ * connects and sends nothing never holds up a pipeline.
+ */
+static void _accept_loop(ServerState* server, int listen_fd) {
+    unsigned long next_job_id = 1;
+    // Entry 0 is the listening socket; the others are clients still sending their job.
+    struct pollfd pfds[1 + SERVER_MAX_PENDING_JOBS];
+    ServerJob* reading[SERVER_MAX_PENDING_JOBS];
+    int num_reading = 0;
+
+    while (!is_shutdown_requested()) {
+        pfds[0].fd = listen_fd;
+        pfds[0].events = POLLIN;
+        pfds[0].revents = 0;
+        for (int i = 0; i < num_reading; i++) {
+            pfds[1 + i].fd = reading[i]->fd;
+            pfds[1 + i].events = POLLIN;
+            pfds[1 + i].revents = 0;
+        }
+        int ready = poll(pfds, (nfds_t)(1 + num_reading), SERVER_POLL_INTERVAL_MS);
+        if (ready < 0 && errno != EINTR) {
+            log_error("Server: poll failed: %s", strerror(errno));
+            break;
+        }
+
+        time_t now = time(NULL);
+        int still_reading = 0;
+        for (int i = 0; i < num_reading; i++) {
+            ServerJob* job = reading[i];
+            RequestStatus status = REQUEST_INCOMPLETE;
+            if (ready > 0 && pfds[1 + i].revents != 0) {
+                status = _read_request(job);
+            }
+            if (status == REQUEST_INCOMPLETE && difftime(now, job->accepted_time) >= SERVER_REQUEST_TIMEOUT_SECONDS) {
+                status = REQUEST_FAILED;
+            }
+            if (status == REQUEST_INCOMPLETE) {
+                reading[still_reading++] = job;
+            } else {
+                _dispatch_job(server, job, status);
+            }
+        }
+        num_reading = still_reading;
+
+        if (ready <= 0 || !(pfds[0].revents & POLLIN)) continue;
+
+        int client_fd = accept(listen_fd, NULL, NULL);
+        if (client_fd < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != ECONNABORTED) {
+                log_error("Server: accept failed: %s", strerror(errno));
+            }
+            continue;
+        }
+        _configure_client_socket(client_fd);
+
+        ServerJob* job = (ServerJob*)queue_try_dequeue(&server->free_jobs);
+        if (!job) {
+            ServerJob busy;
+            busy.fd = client_fd;
+            busy.client_gone = false;
+            _send_line(&busy, "ERROR server busy, try again later");
+            close(client_fd);
+            continue;
+        }
+
+        // Everything but the request buffer starts from zero.
+        memset(job, 0, offsetof(ServerJob, request));
+        job->request[0] = '\0';
+        job->fd = client_fd;
+        job->id = next_job_id++;
+        job->accepted_time = now;
+        reading[num_reading++] = job;
+    }
+
+    for (int i = 0; i < num_reading; i++) {
+        _reject_job(server, reading[i], "server is shutting down");
+    }
+}
+
+bool job_server_run(const AppConfig* config, AppResources* resources) {
+    ServerState server;
+    memset(&server, 0, sizeof(server));
+    server.base_config = config->server_base_config;
+    server.input_ops = resources->selected_input_ops;
+    MemoryArena* arena = &resources->setup_arena;
+
+    ServerJob* jobs = (ServerJob*)mem_arena_alloc(arena, SERVER_MAX_PENDING_JOBS * sizeof(ServerJob));
+    if (!jobs) return false;
+    if (!queue_init(&server.free_jobs, SERVER_MAX_PENDING_JOBS, arena)) return false;
+    if (!queue_init(&server.pending_jobs, SERVER_MAX_PENDING_JOBS, arena)) {
+        queue_destroy(&server.free_jobs);
+        return false;
+    }
+    for (int i = 0; i < SERVER_MAX_PENDING_JOBS; i++) {
+        jobs[i].fd = -1;
+        queue_enqueue(&server.free_jobs, &jobs[i]);
+    }
+
+    bool success = false;
+    bool mutex_initialized = false;
+    int workers_started = 0;
+    int listen_fd = -1;
+    int num_workers = (config->batch_jobs_arg > 0) ? config->batch_jobs_arg : 1;
+    server.num_pipelines = num_workers;
+
+    ServerWorker* workers = (ServerWorker*)mem_arena_alloc(arena, (size_t)num_workers * sizeof(ServerWorker));
+    if (!workers) goto cleanup;
+    if (pthread_mutex_init(&server.mutex, NULL) != 0) {
+        log_fatal("Failed to initialize server mutex: %s", strerror(errno));
+        goto cleanup;
+    }
+    mutex_initialized = true;
+
+    listen_fd = _open_listen_socket(config->serve_socket_arg);
+    if (listen_fd < 0) goto cleanup;
+
+    for (int i = 0; i < num_workers; i++) {
+        ServerWorker* worker = &workers[i];
+        worker->server = &server;
+        worker->resources.reuse.enabled = true;
+        if (!mem_arena_init(&worker->resources.setup_arena, MEM_ARENA_SIZE_BYTES)) {
+            break;
+        }
+        if (pthread_create(&worker->thread, NULL, _server_worker_thread, worker) != 0) {
+            log_error("Failed to start server pipeline %d, continuing with %d.", i + 1, workers_started);
+            mem_arena_destroy(&worker->resources.setup_arena);
+            break;
+        }
+        workers_started++;
+    }
+    if (workers_started == 0) {
+        log_fatal("Failed to start any server pipeline.");
+        goto cleanup;
+    }
+
+    log_info("Serving jobs on '%s' with %d pipeline%s. Press Ctrl+C to stop.",
+             config->serve_socket_arg, workers_started, (workers_started == 1) ? "" : "s");
+    _accept_loop(&server, listen_fd);
+    success = true;
+
+cleanup:
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(config->serve_socket_arg);
+    }
+    queue_signal_shutdown(&server.pending_jobs);
+    for (int i = 0; i < workers_started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        pipeline_reuse_release(&workers[i].resources.reuse);
+        mem_arena_destroy(&workers[i].resources.setup_arena);
+    }
+    if (mutex_initialized) pthread_mutex_destroy(&server.mutex);
+    queue_destroy(&server.pending_jobs);
+    queue_destroy(&server.free_jobs);
+    if (success) log_info("Job server stopped.");
+    return success;
+}
+
+#else // _WIN32
+
+bool job_server_run(const AppConfig* config, AppResources* resources) {
+    (void)config;
+    (void)resources;
+    log_fatal("Server mode is not supported on Windows.");
+    return false;
+}
+
+#endif // _WIN32
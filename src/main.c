@@ -36,6 +36,8 @@
 #include "dc_block.h"
 #include "io_threads.h"
 #include "processing_threads.h"
+#include "batch.h"
+#include "job_server.h"
 
 
 // --- Global Variable Definitions ---
@@ -84,6 +86,7 @@ int main(int argc, char *argv[]) {
 
     input_manager_apply_defaults(&g_config, &resources.setup_arena);
     g_config.gain = 1.0f;
+    g_config.read_ahead_mb = IO_READ_AHEAD_DEFAULT_MB;
 
 #ifndef _WIN32
     pthread_t sig_thread_id;
@@ -130,6 +133,16 @@ int main(int argc, char *argv[]) {
         goto cleanup;
     }
 
+    if (g_config.batch_mode) {
+        exit_status = batch_run(&g_config, &resources) ? EXIT_SUCCESS : EXIT_FAILURE;
+        goto cleanup;
+    }
+
+    if (g_config.server_mode) {
+        exit_status = job_server_run(&g_config, &resources) ? EXIT_SUCCESS : EXIT_FAILURE;
+        goto cleanup;
+    }
+
     if (!initialize_application(&g_config, &resources)) {
         goto cleanup;
     }
@@ -140,44 +153,7 @@ int main(int argc, char *argv[]) {
 
     resources.start_time = time(NULL);
 
-    static PipelineContext thread_args;
-    thread_args.config = &g_config;
-    thread_args.resources = &resources;
-
-    log_debug("Starting processing threads...");
-
-    if (resources.pipeline_mode == PIPELINE_MODE_BUFFERED_SDR) {
-        if (pthread_create(&resources.sdr_capture_thread_handle, NULL, sdr_capture_thread_func, &thread_args) != 0) {
-            handle_fatal_thread_error("In Main: Failed to create SDR capture thread.", &resources);
-        }
-    }
-
-    if (pthread_create(&resources.reader_thread_handle, NULL, reader_thread_func, &thread_args) != 0 ||
-        pthread_create(&resources.pre_processor_thread_handle, NULL, pre_processor_thread_func, &thread_args) != 0 ||
-        pthread_create(&resources.resampler_thread_handle, NULL, resampler_thread_func, &thread_args) != 0 ||
-        pthread_create(&resources.post_processor_thread_handle, NULL, post_processor_thread_func, &thread_args) != 0 ||
-        pthread_create(&resources.writer_thread_handle, NULL, writer_thread_func, &thread_args) != 0 ||
-        (g_config.iq_correction.enable && pthread_create(&resources.iq_optimization_thread_handle, NULL, iq_optimization_thread_func, &thread_args) != 0))
-    {
-        handle_fatal_thread_error("In Main: Failed to create one or more processing threads.", &resources);
-    }
-
-    pthread_join(resources.post_processor_thread_handle, NULL);
-    pthread_join(resources.writer_thread_handle, NULL);
-    pthread_join(resources.resampler_thread_handle, NULL);
-    pthread_join(resources.pre_processor_thread_handle, NULL);
-    if (g_config.iq_correction.enable) {
-        pthread_join(resources.iq_optimization_thread_handle, NULL);
-    }
-    pthread_join(resources.reader_thread_handle, NULL);
-
-    if (resources.pipeline_mode == PIPELINE_MODE_BUFFERED_SDR) {
-        pthread_join(resources.sdr_capture_thread_handle, NULL);
-    }
-
-    log_debug("All processing threads have joined.");
-
-    bool processing_ok = !resources.error_occurred;
+    bool processing_ok = run_processing_pipeline(&g_config, &resources);
     exit_status = (processing_ok || is_shutdown_requested()) ? EXIT_SUCCESS : EXIT_FAILURE;
 
 cleanup:
@@ -275,6 +251,14 @@ static void print_final_summary(const AppConfig *config, const AppResources *res
         fprintf(stderr, "%-*s %s\n", label_width, "Final Output Size:", size_buf);
         fprintf(stderr, "%-*s %.2f MB/s\n", label_width, "Average Write Speed:", avg_write_speed_mbps);
     }
+
+    for (int i = 0; i < resources->num_output_branches; i++) {
+        const OutputSink* sink = &resources->output_branches[i].sink;
+        char output_label[40];
+        snprintf(output_label, sizeof(output_label), "Output %u Size:", sink->index);
+        format_file_size(sink->writer_ctx.total_bytes_written, size_buf, sizeof(size_buf));
+        fprintf(stderr, "%-*s %s (%s)\n", label_width, output_label, size_buf, sink->path);
+    }
 }
 
 static void console_lock_function(bool lock, void *udata) {
@@ -46,6 +46,17 @@ void* mem_arena_alloc(MemoryArena* arena, size_t size) {
     return ptr;
 }
 
+/**
+ * @brief Discards every allocation made from the arena, keeping its memory block.
+ * Pointers previously returned by mem_arena_alloc() must no longer be used.
+ * @param arena Pointer to the initialized MemoryArena.
+ */
+void mem_arena_reset(MemoryArena* arena) {
+    if (arena) {
+        arena->offset = 0;
+    }
+}
+
 /**
  * @brief Destroys a memory arena, freeing its main memory block.
  * @param arena Pointer to the MemoryArena to destroy.
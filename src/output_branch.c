@@ -0,0 +1,179 @@
+// output_branch.c
+
+#include "output_branch.h"
+#include "output_sink.h"
+#include "constants.h"
+#include "log.h"
+#include "queue.h"
+#include "sample_convert.h"
+#include "memory_arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <liquid.h>
+#else
+#include <liquid/liquid.h>
+#endif
+
+bool output_branches_create(AppConfig* config, AppResources* resources) {
+    resources->output_branches = NULL;
+    resources->num_output_branches = 0;
+    if (config->num_extra_outputs == 0) return true;
+
+    MemoryArena* arena = &resources->setup_arena;
+    double input_rate = (double)resources->source_info.samplerate;
+
+    resources->output_branches = (OutputBranch*)mem_arena_alloc(arena, (size_t)config->num_extra_outputs * sizeof(OutputBranch));
+    if (!resources->output_branches) return false;
+
+    for (int i = 0; i < config->num_extra_outputs; i++) {
+        const ExtraOutputConfig* extra = &config->extra_outputs[i];
+        OutputBranch* branch = &resources->output_branches[i];
+        int output_number = i + 2;
+        // Count each branch as soon as it exists, so a failure part-way is fully cleaned up.
+        resources->num_output_branches = i + 1;
+
+        // The branch's config is the main one with this output's destination, container, format and rate.
+        branch->config = (AppConfig*)mem_arena_alloc(arena, sizeof(AppConfig));
+        if (!branch->config) return false;
+        *branch->config = *config;
+        branch->config->output_to_stdout = false;
+        branch->config->output_filename_arg = (char*)extra->filename_arg;
+        branch->config->output_type_name = (char*)extra->output_type_name;
+        branch->config->sample_type_name = (char*)extra->sample_type_name;
+        branch->config->output_type = extra->output_type;
+        branch->config->output_format = extra->output_format;
+        branch->config->target_rate = (extra->target_rate_arg > 0.0f) ? (double)extra->target_rate_arg : config->target_rate;
+
+        branch->sink.resources = resources;
+        branch->sink.index = (unsigned int)output_number;
+        int written = snprintf(branch->sink.path, sizeof(branch->sink.path), "%s", extra->filename_arg);
+        if (written < 0 || (size_t)written >= sizeof(branch->sink.path)) {
+            log_fatal("Output path for output %d is too long.", output_number);
+            return false;
+        }
+
+        double ratio = branch->config->target_rate / input_rate;
+        if (!isfinite(ratio) || ratio < MIN_ACCEPTABLE_RATIO || ratio > MAX_ACCEPTABLE_RATIO) {
+            log_fatal("Error: Resampling ratio for output %d (%.6f) is invalid or outside acceptable range.", output_number, ratio);
+            return false;
+        }
+        if (fabs(ratio - 1.0) > 1e-9) {
+            branch->resampler = msresamp_crcf_create((float)ratio, RESAMPLER_QUALITY_ATTENUATION_DB);
+            if (!branch->resampler) {
+                log_fatal("Failed to create the resampler for output %d.", output_number);
+                return false;
+            }
+        }
+
+        // A branch handles one chunk at a time, so a single set of working buffers suffices.
+        size_t capacity = (size_t)ceil((double)resources->max_out_samples * fmax(1.0, ratio)) + RESAMPLER_OUTPUT_SAFETY_MARGIN;
+        branch->resampled_buffer = (complex_float_t*)malloc(capacity * sizeof(complex_float_t));
+        branch->output_buffer = (unsigned char*)malloc(capacity * get_bytes_per_sample(extra->output_format));
+        if (!branch->resampled_buffer || !branch->output_buffer) {
+            log_fatal("Failed to allocate buffers for output %d.", output_number);
+            return false;
+        }
+
+        branch->input_queue = (Queue*)mem_arena_alloc(arena, sizeof(Queue));
+        if (!branch->input_queue || !queue_init(branch->input_queue, PIPELINE_NUM_CHUNKS, arena)) return false;
+    }
+    return true;
+}
+
+bool output_branches_open(AppResources* resources) {
+    for (int i = 0; i < resources->num_output_branches; i++) {
+        OutputBranch* branch = &resources->output_branches[i];
+        if (!output_sink_open(&branch->sink, branch->config, IO_OUTPUT_SINK_BUFFER_BYTES)) return false;
+    }
+    return true;
+}
+
+bool output_branch_fan_out(AppResources* resources, SampleChunk* item) {
+    if (resources->num_output_branches > 0 && !item->is_last_chunk) {
+        // Take every branch's reference before any branch can release one.
+        pthread_mutex_lock(&resources->chunk_ref_mutex);
+        item->ref_count = resources->num_output_branches;
+        pthread_mutex_unlock(&resources->chunk_ref_mutex);
+
+        for (int i = 0; i < resources->num_output_branches; i++) {
+            if (!queue_enqueue(resources->output_branches[i].input_queue, item)) {
+                output_branch_release_chunk(resources, item);
+            }
+        }
+    }
+    return queue_enqueue(resources->pre_process_to_resampler_queue, item);
+}
+
+void output_branches_end_of_input(AppResources* resources) {
+    for (int i = 0; i < resources->num_output_branches; i++) {
+        if (resources->output_branches[i].input_queue) {
+            queue_signal_shutdown(resources->output_branches[i].input_queue);
+        }
+    }
+}
+
+void output_branch_release_chunk(AppResources* resources, SampleChunk* item) {
+    if (resources->num_output_branches > 0) {
+        pthread_mutex_lock(&resources->chunk_ref_mutex);
+        bool still_held = (item->ref_count > 0);
+        if (still_held) item->ref_count--;
+        pthread_mutex_unlock(&resources->chunk_ref_mutex);
+        if (still_held) return;
+    }
+    queue_enqueue(resources->free_sample_chunk_queue, item);
+}
+
+bool output_branch_process_chunk(OutputBranch* branch, const SampleChunk* item) {
+    unsigned int frames_in = (unsigned int)item->frames_read;
+    complex_float_t* samples = item->complex_pre_resample_data;
+    unsigned int frames_out = frames_in;
+
+    if (branch->resampler) {
+        msresamp_crcf_execute(branch->resampler, (liquid_float_complex*)samples, frames_in, (liquid_float_complex*)branch->resampled_buffer, &frames_out);
+        samples = branch->resampled_buffer;
+    }
+    if (frames_out == 0) return true;
+
+    if (!convert_cf32_to_block(samples, branch->output_buffer, frames_out, branch->config->output_format)) {
+        return false;
+    }
+    output_sink_write(&branch->sink, branch->output_buffer, frames_out);
+    return true;
+}
+
+void output_branch_reset(OutputBranch* branch) {
+    if (branch->resampler) {
+        msresamp_crcf_reset(branch->resampler);
+    }
+}
+
+void output_branches_signal_shutdown(AppResources* resources) {
+    for (int i = 0; i < resources->num_output_branches; i++) {
+        OutputBranch* branch = &resources->output_branches[i];
+        if (branch->input_queue) queue_signal_shutdown(branch->input_queue);
+        output_sink_signal_shutdown(&branch->sink);
+    }
+}
+
+void output_branches_destroy(AppResources* resources) {
+    for (int i = 0; i < resources->num_output_branches; i++) {
+        OutputBranch* branch = &resources->output_branches[i];
+        output_sink_close(&branch->sink);
+        if (branch->resampler) {
+            msresamp_crcf_destroy(branch->resampler);
+            branch->resampler = NULL;
+        }
+        free(branch->resampled_buffer);
+        branch->resampled_buffer = NULL;
+        free(branch->output_buffer);
+        branch->output_buffer = NULL;
+        if (branch->input_queue) {
+            queue_destroy(branch->input_queue);
+            branch->input_queue = NULL;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+// output_sink.c
+
+#include "output_sink.h"
+#include "constants.h"
+#include "log.h"
+#include "file_writer.h"
+#include "memory_arena.h"
+#include "sample_convert.h"
+#include "input_range.h"
+
+#ifdef _WIN32
+#include "platform.h"
+#endif
+
+bool output_sink_open(OutputSink* sink, AppConfig* sink_config, size_t buffer_bytes) {
+    AppResources* resources = sink->resources;
+
+#ifdef _WIN32
+    if (!get_absolute_path_windows(sink->path,
+                                   sink_config->effective_output_filename_w, MAX_PATH_BUFFER,
+                                   sink_config->effective_output_filename_utf8, MAX_PATH_BUFFER)) {
+        return false;
+    }
+#else
+    sink_config->effective_output_filename = sink->path;
+#endif
+
+    if (!file_writer_init(&sink->writer_ctx, sink_config)) return false;
+    if (!sink->writer_ctx.ops.open(&sink->writer_ctx, sink_config, resources, &resources->setup_arena)) return false;
+    sink->bytes_per_sample_pair = get_bytes_per_sample(sink_config->output_format);
+    sink->warmup_frames_to_drop = input_range_warmup_output_frames(resources, sink_config->target_rate);
+
+    sink->write_buffer = file_write_buffer_create(buffer_bytes);
+    if (!sink->write_buffer) {
+        log_fatal("Failed to create I/O output buffer for '%s'.", sink->path);
+        return false;
+    }
+    sink->writer_local_buffer = mem_arena_alloc(&resources->setup_arena, IO_FILE_WRITER_CHUNK_SIZE);
+    if (!sink->writer_local_buffer) return false;
+    return true;
+}
+
+void output_sink_write(OutputSink* sink, const void* data, unsigned int num_frames) {
+    if (sink->warmup_frames_to_drop > 0) {
+        unsigned int drop = (sink->warmup_frames_to_drop < num_frames) ? (unsigned int)sink->warmup_frames_to_drop : num_frames;
+        sink->warmup_frames_to_drop -= drop;
+        data = (const unsigned char*)data + (size_t)drop * sink->bytes_per_sample_pair;
+        num_frames -= drop;
+    }
+    size_t bytes = (size_t)num_frames * sink->bytes_per_sample_pair;
+    if (bytes > 0) {
+        file_write_buffer_write(sink->write_buffer, data, bytes);
+    }
+}
+
+void output_sink_signal_end_of_stream(OutputSink* sink) {
+    if (sink->write_buffer) {
+        file_write_buffer_signal_end_of_stream(sink->write_buffer);
+    }
+}
+
+void output_sink_signal_shutdown(OutputSink* sink) {
+    if (sink->write_buffer) {
+        file_write_buffer_signal_shutdown(sink->write_buffer);
+    }
+}
+
+long long output_sink_close(OutputSink* sink) {
+    if (sink->writer_ctx.ops.close) {
+        sink->writer_ctx.ops.close(&sink->writer_ctx);
+    }
+    if (sink->write_buffer) {
+        file_write_buffer_destroy(sink->write_buffer);
+        sink->write_buffer = NULL;
+    }
+    return sink->writer_ctx.ops.get_total_bytes_written ? sink->writer_ctx.ops.get_total_bytes_written(&sink->writer_ctx) : 0;
+}
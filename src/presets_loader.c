@@ -67,6 +67,7 @@ static char* arena_strdup(MemoryArena* arena, const char* s) {
 bool presets_load_from_file(AppConfig* config, MemoryArena* arena) {
     config->presets = NULL;
     config->num_presets = 0;
+    config->presets_dir = NULL;
 
     char full_path_buffer[MAX_PATH_BUFFER];
     
@@ -184,6 +185,20 @@ bool presets_load_from_file(AppConfig* config, MemoryArena* arena) {
         return false;
     }
 
+    // Remember the directory of the presets file for other persistent state.
+    char* presets_dir = arena_strdup(arena, found_preset_files[0]);
+    if (presets_dir) {
+        char* last_sep = strrchr(presets_dir, '/');
+#ifdef _WIN32
+        char* last_backslash = strrchr(presets_dir, '\\');
+        if (last_backslash && (!last_sep || last_backslash > last_sep)) last_sep = last_backslash;
+#endif
+        if (last_sep) {
+            *last_sep = '\0';
+            config->presets_dir = presets_dir;
+        }
+    }
+
     char line[MAX_LINE_LENGTH];
     PresetDefinition* current_preset = NULL;
     int capacity = 8;
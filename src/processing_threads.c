@@ -13,6 +13,13 @@
 #include "dc_block.h"
 #include "iq_correct.h"
 #include "filter.h"
+#include "filter_pool.h"
+#include "channelizer.h"
+#include "cic_decimator.h"
+#include "output_branch.h"
+#include "output_sink.h"
+#include "stage_planner.h"
+#include "input_range.h"
 #include "queue.h"
 #include "memory_arena.h"
 #include <stdio.h>
@@ -34,8 +41,10 @@
  * working buffer to combine leftover samples from the previous call with new
  * incoming samples, creating a single contiguous stream for processing.
  *
- * @param filter_object         The liquid-dsp fftfilt_crcf or fftfilt_cccf object.
+ * @param filter_object_slot    Pointer to the block-based filter object (liquid-dsp fftfilt or FFTW
+ *                              engine). A worker pool may replace the object with an equivalent one.
  * @param filter_type           The type of the filter, to select the correct execute function.
+ * @param pool                  Optional worker pool to split the blocks across, or NULL.
  * @param input_buffer          A pointer to the incoming sample data. This buffer is NOT modified.
  * @param frames_in             The number of valid frames in the input_buffer.
  * @param output_buffer         A buffer to store the filtered output blocks. Must be large enough.
@@ -49,8 +58,9 @@
  */
 static unsigned int
 _execute_fft_filter_pass(
-    void* filter_object,
+    void** filter_object_slot,
     FilterImplementationType filter_type,
+    FilterPool* pool,
     const complex_float_t* input_buffer,
     unsigned int frames_in,
     complex_float_t* output_buffer,
@@ -69,14 +79,17 @@ _execute_fft_filter_pass(
     // Stage 2: Process full blocks from the assembled stream.
     unsigned int processed_frames = 0;
     unsigned int total_output_frames = 0;
-    while (total_frames_to_process - processed_frames >= block_size) {
-        if (filter_type == FILTER_IMPL_FFT_SYMMETRIC) {
-            fftfilt_crcf_execute((fftfilt_crcf)filter_object, scratch_buffer + processed_frames, output_buffer + total_output_frames);
-        } else {
-            fftfilt_cccf_execute((fftfilt_cccf)filter_object, scratch_buffer + processed_frames, output_buffer + total_output_frames);
+    if (pool) {
+        unsigned int num_blocks = total_frames_to_process / block_size;
+        filter_pool_execute(pool, filter_object_slot, scratch_buffer, num_blocks, output_buffer);
+        processed_frames = num_blocks * block_size;
+        total_output_frames = processed_frames;
+    } else {
+        while (total_frames_to_process - processed_frames >= block_size) {
+            filter_execute_block(*filter_object_slot, filter_type, scratch_buffer + processed_frames, output_buffer + total_output_frames);
+            processed_frames += block_size;
+            total_output_frames += block_size;
         }
-        processed_frames += block_size;
-        total_output_frames += block_size;
     }
 
     // Stage 3: Save the new remainder for the next call.
@@ -88,6 +101,78 @@ _execute_fft_filter_pass(
     return total_output_frames;
 }
 
+/**
+ * @brief Executes one pass of an integer-factor polyphase decimator on a stream.
+ *
+ * The decimator consumes exactly `factor` input samples per output sample, so
+ * any trailing partial block is held in the remainder buffer and completed with
+ * the first samples of the next call. Only the retained output samples are computed.
+ *
+ * @param decimator_object      The liquid-dsp firdecim_crcf or firdecim_cccf object.
+ * @param filter_type           The type of the decimator, to select the correct execute function.
+ * @param factor                The integer decimation factor.
+ * @param input_buffer          A pointer to the incoming sample data.
+ * @param frames_in             The number of valid frames in the input_buffer.
+ * @param output_buffer         A buffer to store the decimated output.
+ * @param remainder_buffer      The buffer for storing a partial input block between calls.
+ *                              Must hold at least `factor` samples.
+ * @param remainder_len_ptr     A pointer to the variable holding the current number of samples
+ *                              in the remainder buffer. This value is read and updated.
+ * @return The number of output frames written to the output_buffer.
+ */
+static unsigned int
+_execute_decimator_pass(
+    void* decimator_object,
+    FilterImplementationType filter_type,
+    unsigned int factor,
+    complex_float_t* input_buffer,
+    unsigned int frames_in,
+    complex_float_t* output_buffer,
+    complex_float_t* remainder_buffer,
+    unsigned int* remainder_len_ptr
+) {
+    unsigned int remainder_len = *remainder_len_ptr;
+    unsigned int consumed_frames = 0;
+    unsigned int output_frames = 0;
+
+    // Stage 1: Complete a partial block left over from the previous call.
+    if (remainder_len > 0) {
+        unsigned int needed = factor - remainder_len;
+        if (frames_in < needed) {
+            memcpy(remainder_buffer + remainder_len, input_buffer, frames_in * sizeof(complex_float_t));
+            *remainder_len_ptr = remainder_len + frames_in;
+            return 0;
+        }
+        memcpy(remainder_buffer + remainder_len, input_buffer, needed * sizeof(complex_float_t));
+        if (filter_type == FILTER_IMPL_DECIM_SYMMETRIC) {
+            firdecim_crcf_execute((firdecim_crcf)decimator_object, remainder_buffer, output_buffer);
+        } else {
+            firdecim_cccf_execute((firdecim_cccf)decimator_object, remainder_buffer, output_buffer);
+        }
+        consumed_frames = needed;
+        output_frames = 1;
+    }
+
+    // Stage 2: Decimate all full blocks directly from the input buffer.
+    unsigned int num_blocks = (frames_in - consumed_frames) / factor;
+    if (num_blocks > 0) {
+        if (filter_type == FILTER_IMPL_DECIM_SYMMETRIC) {
+            firdecim_crcf_execute_block((firdecim_crcf)decimator_object, input_buffer + consumed_frames, num_blocks, output_buffer + output_frames);
+        } else {
+            firdecim_cccf_execute_block((firdecim_cccf)decimator_object, input_buffer + consumed_frames, num_blocks, output_buffer + output_frames);
+        }
+        consumed_frames += num_blocks * factor;
+        output_frames += num_blocks;
+    }
+
+    // Stage 3: Save the trailing partial block for the next call.
+    remainder_len = frames_in - consumed_frames;
+    memcpy(remainder_buffer, input_buffer + consumed_frames, remainder_len * sizeof(complex_float_t));
+    *remainder_len_ptr = remainder_len;
+
+    return output_frames;
+}
+
 
 void* pre_processor_thread_func(void* arg) {
 #ifdef _WIN32
@@ -102,10 +187,11 @@ void* pre_processor_thread_func(void* arg) {
 
     unsigned int remainder_len = 0;
     bool is_pre_fft = false;
+    bool is_pre_dc_block = (config->dc_block.enable &&
+                            !stage_plan_is_post_resample(&resources->stage_plan, PLAN_STAGE_DC_BLOCK));
 
-    if (resources->user_fir_filter_object && !config->apply_user_filter_post_resample) {
-        is_pre_fft = (resources->user_filter_type_actual == FILTER_IMPL_FFT_SYMMETRIC || 
-                      resources->user_filter_type_actual == FILTER_IMPL_FFT_ASYMMETRIC);
+    if (resources->user_fir_filter_object && !resources->stage_plan.filter_post_resample) {
+        is_pre_fft = filter_is_block_based(resources->user_filter_type_actual);
     }
 
     SampleChunk* item;
@@ -117,70 +203,92 @@ void* pre_processor_thread_func(void* arg) {
                 memset(item->complex_pre_resample_data, 0, item->complex_buffer_capacity_samples * sizeof(complex_float_t));
                 memcpy(item->complex_pre_resample_data, resources->pre_fft_remainder_buffer, remainder_len * sizeof(complex_float_t));
                 
-                if (resources->user_filter_type_actual == FILTER_IMPL_FFT_SYMMETRIC) {
-                    fftfilt_crcf_execute((fftfilt_crcf)resources->user_fir_filter_object, item->complex_pre_resample_data, item->complex_pre_resample_data);
-                } else {
-                    fftfilt_cccf_execute((fftfilt_cccf)resources->user_fir_filter_object, item->complex_pre_resample_data, item->complex_pre_resample_data);
-                }
+                filter_execute_block(resources->user_fir_filter_object, resources->user_filter_type_actual, item->complex_pre_resample_data, item->complex_pre_resample_data);
                 item->frames_read = resources->user_filter_block_size;
                 item->is_last_chunk = false;
                 
-                queue_enqueue(resources->pre_process_to_resampler_queue, item);
+                output_branch_fan_out(resources, item);
 
                 // Enqueue a final marker chunk after the flushed data.
                 SampleChunk* final_marker = (SampleChunk*)queue_dequeue(resources->free_sample_chunk_queue);
                 if (final_marker) {
                     final_marker->is_last_chunk = true;
                     final_marker->frames_read = 0;
-                    queue_enqueue(resources->pre_process_to_resampler_queue, final_marker);
+                    output_branch_fan_out(resources, final_marker);
                 }
             } else {
                 // No flush needed, just pass the end-of-stream marker.
-                queue_enqueue(resources->pre_process_to_resampler_queue, item);
+                output_branch_fan_out(resources, item);
             }
             break;
         }
 
         if (item->stream_discontinuity_event) {
             freq_shift_reset_nco(resources->pre_resample_nco);
-            if (resources->user_fir_filter_object) {
-                switch (resources->user_filter_type_actual) {
-                    case FILTER_IMPL_FIR_SYMMETRIC: firfilt_crcf_reset((firfilt_crcf)resources->user_fir_filter_object); break;
-                    case FILTER_IMPL_FIR_ASYMMETRIC: firfilt_cccf_reset((firfilt_cccf)resources->user_fir_filter_object); break;
-                    case FILTER_IMPL_FFT_SYMMETRIC: fftfilt_crcf_reset((fftfilt_crcf)resources->user_fir_filter_object); break;
-                    case FILTER_IMPL_FFT_ASYMMETRIC: fftfilt_cccf_reset((fftfilt_cccf)resources->user_fir_filter_object); break;
-                    default: break;
-                }
+            cic_decimator_reset(resources);
+            if (resources->user_fir_filter_object && resources->merged_decimation_factor == 0) {
+                filter_reset(resources->user_fir_filter_object, resources->user_filter_type_actual);
             }
             if (is_pre_fft) {
                 memset(resources->pre_fft_remainder_buffer, 0, resources->user_filter_block_size * sizeof(complex_float_t));
                 remainder_len = 0;
             }
-            if (!queue_enqueue(resources->pre_process_to_resampler_queue, item)) {
-                queue_enqueue(resources->free_sample_chunk_queue, item);
+            if (!output_branch_fan_out(resources, item)) {
+                output_branch_release_chunk(resources, item);
                 break;
             }
             continue;
         }
 
-        if (!convert_raw_to_cf32(item->raw_input_data, item->complex_pre_resample_data, item->frames_read, resources->input_format, config->gain)) {
+        // Convert and condition the chunk one cache-sized tile at a time, so the
+        // DC block and I/Q correction read samples the conversion just wrote.
+        // With the CIC front end, each raw tile yields a shorter decimated tile.
+        bool convert_ok = true;
+        bool is_cic = (resources->cic.decimation_factor > 0);
+        size_t chunk_frames = (item->frames_read > 0) ? (size_t)item->frames_read : 0;
+        size_t converted_frames = 0;
+        const void* raw_samples = item->mapped_input_data ? item->mapped_input_data : item->raw_input_data;
+        for (size_t tile_start = 0; tile_start < chunk_frames; tile_start += PRE_PROCESS_TILE_SAMPLES) {
+            size_t tile_len = chunk_frames - tile_start;
+            if (tile_len > PRE_PROCESS_TILE_SAMPLES) tile_len = PRE_PROCESS_TILE_SAMPLES;
+            const unsigned char* raw_tile = (const unsigned char*)raw_samples + tile_start * resources->input_bytes_per_sample_pair;
+            complex_float_t* tile = item->complex_pre_resample_data + converted_frames;
+
+            if (is_cic) {
+                tile_len = cic_decimator_process(resources, raw_tile, tile_len, tile);
+            } else if (!convert_raw_to_cf32(raw_tile, tile, tile_len, resources->input_format, config->gain)) {
+                convert_ok = false;
+                break;
+            }
+            converted_frames += tile_len;
+
+            if (is_pre_dc_block) {
+                dc_block_apply(resources, tile, (int)tile_len);
+            }
+
+            if (config->iq_correction.enable) {
+                // The optimizer searches for absolute corrections, so it sees the samples before they are applied.
+                iq_correct_feed_optimizer(resources, tile, (int)tile_len);
+                iq_correct_apply(resources, tile, (int)tile_len);
+            }
+        }
+        if (!convert_ok) {
             handle_fatal_thread_error("Pre-Processor: Failed to convert samples.", resources);
-            queue_enqueue(resources->free_sample_chunk_queue, item);
+            output_branch_release_chunk(resources, item);
             continue;
         }
+        item->frames_read = (int64_t)converted_frames;
 
-        if (config->dc_block.enable) {
-            dc_block_apply(resources, item->complex_pre_resample_data, item->frames_read);
-        }
-
-        if (config->iq_correction.enable) {
-            // IQ correction logic...
+        // The filter is specified relative to the shifted signal, so the shift comes first.
+        if (resources->pre_resample_nco) {
+            freq_shift_apply(resources->pre_resample_nco, resources->actual_nco_shift_hz, item->complex_pre_resample_data, item->complex_pre_resample_data, item->frames_read);
         }
 
         if (is_pre_fft) {
             unsigned int output_frames = _execute_fft_filter_pass(
-                resources->user_fir_filter_object,
+                &resources->user_fir_filter_object,
                 resources->user_filter_type_actual,
+                resources->user_filter_pool,
                 item->complex_pre_resample_data,
                 (unsigned int)item->frames_read,
                 item->complex_scratch_data,
@@ -191,24 +299,24 @@ void* pre_processor_thread_func(void* arg) {
             );
             memcpy(item->complex_pre_resample_data, item->complex_scratch_data, output_frames * sizeof(complex_float_t));
             item->frames_read = output_frames;
-        } else if (resources->user_fir_filter_object && !config->apply_user_filter_post_resample) {
+        } else if (resources->user_fir_filter_object && !resources->stage_plan.filter_post_resample) {
             firfilt_crcf_execute_block((firfilt_crcf)resources->user_fir_filter_object, item->complex_pre_resample_data, item->frames_read, item->complex_pre_resample_data);
         }
 
-        if (resources->pre_resample_nco) {
-            freq_shift_apply(resources->pre_resample_nco, resources->actual_nco_shift_hz, item->complex_pre_resample_data, item->complex_pre_resample_data, item->frames_read);
-        }
-
         if (item->frames_read > 0) {
-            if (!queue_enqueue(resources->pre_process_to_resampler_queue, item)) {
-                queue_enqueue(resources->free_sample_chunk_queue, item);
+            if (!output_branch_fan_out(resources, item)) {
+                output_branch_release_chunk(resources, item);
                 break;
             }
         } else {
-            queue_enqueue(resources->free_sample_chunk_queue, item);
+            output_branch_release_chunk(resources, item);
         }
     }
 
+    // Let the optimizer and the additional outputs drain their queues and exit.
+    queue_signal_shutdown(resources->iq_optimization_data_queue);
+    output_branches_end_of_input(resources);
+
     log_debug("Pre-processor thread is exiting.");
     return NULL;
 }
@@ -217,9 +325,13 @@ void* resampler_thread_func(void* arg) {
     PipelineContext* args = (PipelineContext*)arg;
     AppResources* resources = args->resources;
 
+    unsigned int decimator_remainder_len = 0;
+    bool is_merged_decimator = (resources->merged_decimation_factor > 0 && resources->user_fir_filter_object);
+
     SampleChunk* item;
     while ((item = (SampleChunk*)queue_dequeue(resources->pre_process_to_resampler_queue)) != NULL) {
         if (item->is_last_chunk) {
+            channelizer_signal_end_of_stream(resources);
             queue_enqueue(resources->resampler_to_post_process_queue, item);
             break;
         }
@@ -228,24 +340,49 @@ void* resampler_thread_func(void* arg) {
             if (resources->resampler) {
                 msresamp_crcf_reset(resources->resampler);
             }
+            if (is_merged_decimator) {
+                filter_reset(resources->user_fir_filter_object, resources->user_filter_type_actual);
+                decimator_remainder_len = 0;
+            }
+            channelizer_reset(resources);
             if (!queue_enqueue(resources->resampler_to_post_process_queue, item)) {
-                queue_enqueue(resources->free_sample_chunk_queue, item);
+                output_branch_release_chunk(resources, item);
                 break;
             }
             continue;
         }
 
+        if (resources->num_channels > 0) {
+            // Channelizer mode: every channel is extracted and queued for its own writer here.
+            if (!channelizer_process_chunk(args->config, resources, item)) {
+                handle_fatal_thread_error("Resampler: Failed to convert channel samples.", resources);
+            }
+            output_branch_release_chunk(resources, item);
+            continue;
+        }
+
         unsigned int output_frames_this_chunk = 0;
         if (resources->is_passthrough) {
             output_frames_this_chunk = (unsigned int)item->frames_read;
             memcpy(item->complex_resampled_data, item->complex_pre_resample_data, output_frames_this_chunk * sizeof(complex_float_t));
+        } else if (is_merged_decimator) {
+            output_frames_this_chunk = _execute_decimator_pass(
+                resources->user_fir_filter_object,
+                resources->user_filter_type_actual,
+                resources->merged_decimation_factor,
+                item->complex_pre_resample_data,
+                (unsigned int)item->frames_read,
+                item->complex_resampled_data,
+                resources->decimator_remainder_buffer,
+                &decimator_remainder_len
+            );
         } else {
             msresamp_crcf_execute(resources->resampler, (liquid_float_complex*)item->complex_pre_resample_data, (unsigned int)item->frames_read, (liquid_float_complex*)item->complex_resampled_data, &output_frames_this_chunk);
         }
         item->frames_to_write = output_frames_this_chunk;
 
         if (!queue_enqueue(resources->resampler_to_post_process_queue, item)) {
-            queue_enqueue(resources->free_sample_chunk_queue, item);
+            output_branch_release_chunk(resources, item);
             break;
         }
     }
@@ -267,11 +404,19 @@ void* post_processor_thread_func(void* arg) {
     unsigned int remainder_len = 0;
     bool is_post_fft = false;
 
-    if (resources->user_fir_filter_object && config->apply_user_filter_post_resample) {
-        is_post_fft = (resources->user_filter_type_actual == FILTER_IMPL_FFT_SYMMETRIC || 
-                       resources->user_filter_type_actual == FILTER_IMPL_FFT_ASYMMETRIC);
+    bool is_post_dc_block = (config->dc_block.enable &&
+                             stage_plan_is_post_resample(&resources->stage_plan, PLAN_STAGE_DC_BLOCK));
+
+    // A merged decimator already applied the user filter in the resampler thread.
+    bool is_post_filter = (resources->user_fir_filter_object && resources->stage_plan.filter_post_resample &&
+                           resources->merged_decimation_factor == 0);
+
+    if (is_post_filter) {
+        is_post_fft = filter_is_block_based(resources->user_filter_type_actual);
     }
 
+    unsigned long long warmup_frames_to_drop = input_range_warmup_output_frames(resources, config->target_rate);
+
     SampleChunk* item;
     while ((item = (SampleChunk*)queue_dequeue(resources->resampler_to_post_process_queue)) != NULL) {
         
@@ -281,20 +426,11 @@ void* post_processor_thread_func(void* arg) {
                 memset(item->complex_resampled_data, 0, item->complex_buffer_capacity_samples * sizeof(complex_float_t));
                 memcpy(item->complex_resampled_data, resources->post_fft_remainder_buffer, remainder_len * sizeof(complex_float_t));
                 
-                if (resources->user_filter_type_actual == FILTER_IMPL_FFT_SYMMETRIC) {
-                    fftfilt_crcf_execute((fftfilt_crcf)resources->user_fir_filter_object, item->complex_resampled_data, item->complex_resampled_data);
-                } else {
-                    fftfilt_cccf_execute((fftfilt_cccf)resources->user_fir_filter_object, item->complex_resampled_data, item->complex_resampled_data);
-                }
+                filter_execute_block(resources->user_fir_filter_object, resources->user_filter_type_actual, item->complex_resampled_data, item->complex_resampled_data);
                 item->frames_to_write = resources->user_filter_block_size;
                 item->is_last_chunk = false;
 
-                complex_float_t* data_in = item->complex_resampled_data;
-                if (resources->post_resample_nco) {
-                    freq_shift_apply(resources->post_resample_nco, resources->actual_nco_shift_hz, data_in, item->complex_scratch_data, item->frames_to_write);
-                    data_in = item->complex_scratch_data;
-                }
-                if (!convert_cf32_to_block(data_in, item->final_output_data, item->frames_to_write, config->output_format)) {
+                if (!convert_cf32_to_block(item->complex_resampled_data, item->final_output_data, item->frames_to_write, config->output_format)) {
                     handle_fatal_thread_error("Post-Processor: Failed to convert final flushed samples.", resources);
                 } else {
                     if (config->output_to_stdout) {
@@ -302,7 +438,7 @@ void* post_processor_thread_func(void* arg) {
                     } else {
                         size_t bytes_to_write = item->frames_to_write * resources->output_bytes_per_sample_pair;
                         file_write_buffer_write(resources->file_write_buffer, item->final_output_data, bytes_to_write);
-                        queue_enqueue(resources->free_sample_chunk_queue, item);
+                        output_branch_release_chunk(resources, item);
                     }
                 }
                 
@@ -321,8 +457,11 @@ void* post_processor_thread_func(void* arg) {
             if (config->output_to_stdout) {
                 queue_enqueue(resources->stdout_queue, item);
             } else {
-                file_write_buffer_signal_end_of_stream(resources->file_write_buffer);
-                queue_enqueue(resources->free_sample_chunk_queue, item);
+                // In channelizer mode the resampler thread has already ended each channel's stream.
+                if (resources->file_write_buffer) {
+                    file_write_buffer_signal_end_of_stream(resources->file_write_buffer);
+                }
+                output_branch_release_chunk(resources, item);
             }
             break;
         }
@@ -335,19 +474,28 @@ void* post_processor_thread_func(void* arg) {
             }
             if (config->output_to_stdout) {
                 if (!queue_enqueue(resources->stdout_queue, item)) {
-                    queue_enqueue(resources->free_sample_chunk_queue, item);
+                    output_branch_release_chunk(resources, item);
                     break;
                 }
             } else {
-                queue_enqueue(resources->free_sample_chunk_queue, item);
+                output_branch_release_chunk(resources, item);
             }
             continue;
         }
 
+        // DC block and shift run before the filter, which is specified relative to the shifted signal.
+        if (is_post_dc_block) {
+            dc_block_apply(resources, item->complex_resampled_data, (int)item->frames_to_write);
+        }
+        if (resources->post_resample_nco) {
+            freq_shift_apply(resources->post_resample_nco, resources->actual_nco_shift_hz, item->complex_resampled_data, item->complex_resampled_data, item->frames_to_write);
+        }
+
         if (is_post_fft) {
             unsigned int output_frames = _execute_fft_filter_pass(
-                resources->user_fir_filter_object,
+                &resources->user_fir_filter_object,
                 resources->user_filter_type_actual,
+                resources->user_filter_pool,
                 item->complex_resampled_data,
                 item->frames_to_write,
                 item->complex_scratch_data,
@@ -364,9 +512,7 @@ void* post_processor_thread_func(void* arg) {
             complex_float_t* current_data_ptr = item->complex_resampled_data;
             complex_float_t* workspace_ptr = item->complex_scratch_data;
 
-            bool is_fir_filter_active = resources->user_fir_filter_object && 
-                                        config->apply_user_filter_post_resample && 
-                                        !is_post_fft;
+            bool is_fir_filter_active = is_post_filter && !is_post_fft;
 
             if (is_fir_filter_active) {
                 if (resources->user_filter_type_actual == FILTER_IMPL_FIR_SYMMETRIC) {
@@ -379,22 +525,23 @@ void* post_processor_thread_func(void* arg) {
                 workspace_ptr = temp_ptr;
             }
 
-            if (resources->post_resample_nco) {
-                freq_shift_apply(resources->post_resample_nco, resources->actual_nco_shift_hz, current_data_ptr, workspace_ptr, item->frames_to_write);
-                complex_float_t* temp_ptr = current_data_ptr;
-                current_data_ptr = workspace_ptr;
-                workspace_ptr = temp_ptr;
+            // The output of the input read ahead of --start only served to settle the filters.
+            if (warmup_frames_to_drop > 0) {
+                unsigned int drop = (warmup_frames_to_drop < item->frames_to_write) ? (unsigned int)warmup_frames_to_drop : item->frames_to_write;
+                warmup_frames_to_drop -= drop;
+                current_data_ptr += drop;
+                item->frames_to_write -= drop;
             }
 
             if (!convert_cf32_to_block(current_data_ptr, item->final_output_data, item->frames_to_write, config->output_format)) {
                 handle_fatal_thread_error("Post-Processor: Failed to convert samples.", resources);
-                queue_enqueue(resources->free_sample_chunk_queue, item);
+                output_branch_release_chunk(resources, item);
                 break;
             }
 
             if (config->output_to_stdout) {
                 if (!queue_enqueue(resources->stdout_queue, item)) {
-                    queue_enqueue(resources->free_sample_chunk_queue, item);
+                    output_branch_release_chunk(resources, item);
                     break;
                 }
             } else {
@@ -402,10 +549,10 @@ void* post_processor_thread_func(void* arg) {
                 if (bytes_to_write > 0) {
                     file_write_buffer_write(resources->file_write_buffer, item->final_output_data, bytes_to_write);
                 }
-                queue_enqueue(resources->free_sample_chunk_queue, item);
+                output_branch_release_chunk(resources, item);
             }
         } else {
-            queue_enqueue(resources->free_sample_chunk_queue, item);
+            output_branch_release_chunk(resources, item);
         }
     }
 
@@ -417,11 +564,34 @@ void* iq_optimization_thread_func(void* arg) {
     PipelineContext* args = (PipelineContext*)arg;
     AppResources* resources = args->resources;
 
-    SampleChunk* item;
-    while ((item = (SampleChunk*)queue_dequeue(resources->iq_optimization_data_queue)) != NULL) {
-        iq_correct_run_optimization(resources, item->complex_pre_resample_data);
-        queue_enqueue(resources->free_sample_chunk_queue, item);
+    complex_float_t* snapshot;
+    while ((snapshot = (complex_float_t*)queue_dequeue(resources->iq_optimization_data_queue)) != NULL) {
+        iq_correct_run_optimization(resources, snapshot);
+        queue_enqueue(resources->iq_snapshot_free_queue, snapshot);
     }
     log_debug("I/Q optimization thread is exiting.");
     return NULL;
 }
+
+void* output_branch_thread_func(void* arg) {
+    OutputBranch* branch = (OutputBranch*)arg;
+    AppResources* resources = branch->sink.resources;
+
+    SampleChunk* item;
+    while ((item = (SampleChunk*)queue_dequeue(branch->input_queue)) != NULL) {
+        if (item->stream_discontinuity_event) {
+            output_branch_reset(branch);
+        } else if (item->frames_read > 0) {
+            if (!output_branch_process_chunk(branch, item)) {
+                handle_fatal_thread_error("Output Branch: Failed to convert samples.", resources);
+            }
+        }
+        output_branch_release_chunk(resources, item);
+    }
+
+    // The pre-processor has finished (or the pipeline is shutting down); end this output's stream.
+    output_sink_signal_end_of_stream(&branch->sink);
+
+    log_debug("Output %u branch thread is exiting.", branch->sink.index);
+    return NULL;
+}
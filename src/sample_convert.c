@@ -30,10 +30,111 @@
 #include <math.h>
 #include <limits.h>
 
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+/*
+ * Packed 12-bit complex (cs12) stores each I/Q pair in 3 bytes, little-endian:
+ *   byte 0 = I[7:0], byte 1 = Q[3:0] << 4 | I[11:8], byte 2 = Q[11:4]
+ * The full-scale value is 2048, as for 12-bit ADCs in 16-bit containers (sc16q11).
+ */
+
+/**
+ * @brief Sign-extends a 12-bit two's complement value.
+ */
+static inline int _sign_extend_12(unsigned int v) {
+    return (int)(v ^ 0x800u) - 0x800;
+}
+
+/**
+ * @brief Unpacks cs12 samples into scaled complex floats.
+ */
+static void _unpack_cs12_to_cf32(const uint8_t* in, complex_float_t* out, size_t num_frames, float scale) {
+    size_t i = 0;
+#if defined(__SSSE3__)
+    // Four frames (12 bytes) per iteration. Each 16-bit lane gathers the two bytes
+    // holding one value; I sits in the low 12 bits, Q in the high 12 bits. The
+    // 16-byte load reads past the 4 frames, so stop while 16 bytes remain.
+    const __m128i gather = _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m128i i_lanes = _mm_set1_epi32(0x0000FFFF);
+    const __m128 scale_v = _mm_set1_ps(scale);
+    for (; i + 6 <= num_frames; i += 4) {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + i * 3)), gather);
+        __m128i i_vals = _mm_srai_epi16(_mm_slli_epi16(v, 4), 4);
+        __m128i q_vals = _mm_srai_epi16(v, 4);
+        v = _mm_or_si128(_mm_and_si128(i_lanes, i_vals), _mm_andnot_si128(i_lanes, q_vals));
+
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps((float*)&out[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), scale_v));
+        _mm_storeu_ps((float*)&out[i + 2], _mm_mul_ps(_mm_cvtepi32_ps(hi), scale_v));
+    }
+#endif
+    for (; i < num_frames; ++i) {
+        const uint8_t* p = in + i * 3;
+        int i_val = _sign_extend_12((unsigned int)p[0] | ((unsigned int)(p[1] & 0x0F) << 8));
+        int q_val = _sign_extend_12((unsigned int)(p[1] >> 4) | ((unsigned int)p[2] << 4));
+        out[i] = ((float)i_val * scale) + I * ((float)q_val * scale);
+    }
+}
+
+/**
+ * @brief Packs normalized complex floats into cs12 samples, clipping at full scale.
+ */
+static void _pack_cf32_to_cs12(const complex_float_t* in, uint8_t* out, size_t num_frames) {
+    size_t i = 0;
+#if defined(__SSSE3__)
+    // Four frames per iteration. Each 32-bit lane becomes Q << 12 | I, whose low
+    // three bytes are the packed pair. The 16-byte store writes 4 bytes past the
+    // 4 frames, which the next iteration or the scalar tail overwrites.
+    const __m128 full_scale = _mm_set1_ps(2047.0f);
+    const __m128 max_v = _mm_set1_ps(2047.0f);
+    const __m128 min_v = _mm_set1_ps(-2048.0f);
+    const __m128 sign_bit = _mm_set1_ps(-0.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128i mask_12 = _mm_set1_epi32(0x00000FFF);
+    const __m128i compact = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    for (; i + 6 <= num_frames; i += 4) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps((const float*)&in[i]), full_scale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps((const float*)&in[i + 2]), full_scale);
+        a = _mm_max_ps(_mm_min_ps(a, max_v), min_v);
+        b = _mm_max_ps(_mm_min_ps(b, max_v), min_v);
+        // Round half away from zero, as the scalar tail does: add +/-0.5, then truncate.
+        a = _mm_add_ps(a, _mm_or_ps(half, _mm_and_ps(a, sign_bit)));
+        b = _mm_add_ps(b, _mm_or_ps(half, _mm_and_ps(b, sign_bit)));
+        __m128i v = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)); // I0 Q0 I1 Q1 ... as int16
+
+        __m128i i_vals = _mm_and_si128(v, mask_12);
+        __m128i q_vals = _mm_and_si128(_mm_srli_epi32(v, 16), mask_12);
+        __m128i packed = _mm_or_si128(i_vals, _mm_slli_epi32(q_vals, 12));
+        _mm_storeu_si128((__m128i*)(out + i * 3), _mm_shuffle_epi8(packed, compact));
+    }
+#endif
+    for (; i < num_frames; ++i) {
+        float i_val = crealf(in[i]) * 2047.0f;
+        float q_val = cimagf(in[i]) * 2047.0f;
+
+        if (i_val > 2047.0f) i_val = 2047.0f;
+        else if (i_val < -2048.0f) i_val = -2048.0f;
+
+        if (q_val > 2047.0f) q_val = 2047.0f;
+        else if (q_val < -2048.0f) q_val = -2048.0f;
+
+        unsigned int i_bits = (unsigned int)(int)(i_val > 0.0f ? i_val + 0.5f : i_val - 0.5f) & 0xFFFu;
+        unsigned int q_bits = (unsigned int)(int)(q_val > 0.0f ? q_val + 0.5f : q_val - 0.5f) & 0xFFFu;
+
+        uint8_t* p = out + i * 3;
+        p[0] = (uint8_t)(i_bits & 0xFF);
+        p[1] = (uint8_t)((i_bits >> 8) | ((q_bits & 0x0F) << 4));
+        p[2] = (uint8_t)(q_bits >> 4);
+    }
+}
+
 /**
  * @brief Gets the number of bytes for a single sample of the given format.
  */
@@ -54,6 +155,7 @@ size_t get_bytes_per_sample(format_t format) {
         case CU32: return sizeof(uint32_t) * 2;
         case CF32: return sizeof(complex_float_t);
         case SC16Q11: return sizeof(int16_t) * 2;
+        case CS12: return 3; // Two 12-bit values packed into 3 bytes
         default:   return 0;
     }
 }
@@ -105,6 +207,10 @@ bool convert_raw_to_cf32(const void* input_buffer, complex_float_t* output_buffe
             }
             break;
         }
+        case CS12: {
+            _unpack_cs12_to_cf32((const uint8_t*)input_buffer, output_buffer, num_frames, gain / 2048.0f);
+            break;
+        }
         case CU16: {
             const uint16_t* in = (const uint16_t*)input_buffer;
             const float normalizer = 1.0f / ((float)SHRT_MAX + 1.0f);
@@ -227,6 +333,10 @@ bool convert_cf32_to_block(const complex_float_t* input_buffer, void* output_buf
             }
             break;
         }
+        case CS12: {
+            _pack_cf32_to_cs12(input_buffer, (uint8_t*)output_buffer, num_frames);
+            break;
+        }
         case CU16: {
             uint16_t* out = (uint16_t*)output_buffer;
             for (i = 0; i < num_frames; ++i) {
@@ -14,8 +14,18 @@
 #include "iq_correct.h"
 #include "dc_block.h"
 #include "filter.h"
+#include "channelizer.h"
+#include "cic_decimator.h"
+#include "output_branch.h"
+#include "stage_planner.h"
+#include "input_range.h"
+#include "checkpoint.h"
 #include "memory_arena.h"
 #include "queue.h"
+#include "signal_handler.h"
+#include "pipeline_context.h"
+#include "io_threads.h"
+#include "processing_threads.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -63,11 +73,27 @@ static bool create_frequency_shifter(AppConfig *config, AppResources *resources)
 }
 
 static bool create_resampler(AppConfig *config, AppResources *resources, float resample_ratio) {
-    (void)config; // config is not used in this specific function but kept for consistency
     if (resources->is_passthrough) {
         resources->resampler = NULL;
         return true;
     }
+    if (resources->merged_decimation_factor > 0) {
+        // The polyphase decimator built by filter_create() replaces the resampler.
+        resources->resampler = NULL;
+        return true;
+    }
+    if (config->num_channels > 0) {
+        // Each channel resamples its own down-converted stream.
+        resources->resampler = NULL;
+        return true;
+    }
+    // A resampler left by the previous file of a batch only needs its state cleared.
+    if (resources->reuse.resampler && resources->reuse.resampler_ratio == resample_ratio) {
+        resources->resampler = resources->reuse.resampler;
+        resources->reuse.resampler = NULL;
+        msresamp_crcf_reset(resources->resampler);
+        return true;
+    }
     resources->resampler = msresamp_crcf_create(resample_ratio, RESAMPLER_QUALITY_ATTENUATION_DB);
     if (!resources->resampler) {
         log_fatal("Error: Failed to create liquid-dsp resampler object.");
@@ -140,62 +166,12 @@ bool calculate_and_validate_resample_ratio(AppConfig *config, AppResources *reso
     return true;
 }
 
-bool validate_and_configure_filter_stage(AppConfig *config, AppResources *resources) {
-    config->apply_user_filter_post_resample = false;
-
-    if (config->num_filter_requests == 0 || config->no_resample || config->raw_passthrough) {
-        return true;
-    }
-
-    double input_rate = (double)resources->source_info.samplerate;
-    double output_rate = config->target_rate;
-
-    if (output_rate < input_rate) {
-        float max_filter_freq_hz = 0.0f;
-
-        for (int i = 0; i < config->num_filter_requests; i++) {
-            const FilterRequest* req = &config->filter_requests[i];
-            float current_max = 0.0f;
-            switch (req->type) {
-                case FILTER_TYPE_LOWPASS:
-                case FILTER_TYPE_HIGHPASS:
-                    current_max = fabsf(req->freq1_hz);
-                    break;
-                case FILTER_TYPE_PASSBAND:
-                case FILTER_TYPE_STOPBAND:
-                    current_max = fabsf(req->freq1_hz) + (req->freq2_hz / 2.0f);
-                    break;
-                default:
-                    break;
-            }
-            if (current_max > max_filter_freq_hz) {
-                max_filter_freq_hz = current_max;
-            }
-        }
-
-        double output_nyquist = output_rate / 2.0;
-
-        if (max_filter_freq_hz > output_nyquist) {
-            log_fatal("Filter configuration is incompatible with the output sample rate.");
-            log_error("The specified filter chain extends to %.0f Hz, but the output rate of %.0f Hz can only support frequencies up to %.0f Hz.",
-                      max_filter_freq_hz, output_rate, output_nyquist);
-            return false;
-        } else {
-            log_debug("Filter will be applied efficiently after resampling to avoid excessive CPU usage.");
-            config->apply_user_filter_post_resample = true;
-        }
-    }
-    return true;
-}
-
-
 bool allocate_processing_buffers(AppConfig *config, AppResources *resources, float resample_ratio) {
     if (!config || !resources) return false;
 
     size_t max_pre_resample_chunk_size = PIPELINE_CHUNK_BASE_SAMPLES;
-    bool is_pre_fft_filter = (resources->user_fir_filter_object && !config->apply_user_filter_post_resample &&
-                             (resources->user_filter_type_actual == FILTER_IMPL_FFT_SYMMETRIC ||
-                              resources->user_filter_type_actual == FILTER_IMPL_FFT_ASYMMETRIC));
+    bool is_pre_fft_filter = (resources->user_fir_filter_object && !resources->stage_plan.filter_post_resample &&
+                              filter_is_block_based(resources->user_filter_type_actual));
 
     if (is_pre_fft_filter) {
         if (resources->user_filter_block_size > max_pre_resample_chunk_size) {
@@ -206,9 +182,8 @@ bool allocate_processing_buffers(AppConfig *config, AppResources *resources, flo
     size_t resampler_output_capacity = (size_t)ceil((double)max_pre_resample_chunk_size * fmax(1.0, (double)resample_ratio)) + RESAMPLER_OUTPUT_SAFETY_MARGIN;
     size_t required_capacity = (max_pre_resample_chunk_size > resampler_output_capacity) ? max_pre_resample_chunk_size : resampler_output_capacity;
 
-    bool is_post_fft_filter = (resources->user_fir_filter_object && config->apply_user_filter_post_resample &&
-                              (resources->user_filter_type_actual == FILTER_IMPL_FFT_SYMMETRIC ||
-                               resources->user_filter_type_actual == FILTER_IMPL_FFT_ASYMMETRIC));
+    bool is_post_fft_filter = (resources->user_fir_filter_object && resources->stage_plan.filter_post_resample &&
+                               filter_is_block_based(resources->user_filter_type_actual));
 
     if (is_post_fft_filter) {
         if (resources->user_filter_block_size > required_capacity) {
@@ -234,10 +209,19 @@ bool allocate_processing_buffers(AppConfig *config, AppResources *resources, flo
                                    (complex_bytes_per_chunk * 4) + // pre, resampled, post, scratch
                                    final_output_bytes_per_chunk;
 
-    resources->pipeline_chunk_data_pool = malloc(PIPELINE_NUM_CHUNKS * total_bytes_per_chunk);
-    if (!resources->pipeline_chunk_data_pool) {
-        log_fatal("Error: Failed to allocate the main pipeline chunk data pool.");
-        return false;
+    size_t pool_bytes = PIPELINE_NUM_CHUNKS * total_bytes_per_chunk;
+    if (resources->reuse.chunk_data_pool && resources->reuse.chunk_data_pool_bytes >= pool_bytes) {
+        resources->pipeline_chunk_data_pool = resources->reuse.chunk_data_pool;
+        resources->pipeline_chunk_data_pool_bytes = resources->reuse.chunk_data_pool_bytes;
+        resources->reuse.chunk_data_pool = NULL;
+        resources->reuse.chunk_data_pool_bytes = 0;
+    } else {
+        resources->pipeline_chunk_data_pool = malloc(pool_bytes);
+        if (!resources->pipeline_chunk_data_pool) {
+            log_fatal("Error: Failed to allocate the main pipeline chunk data pool.");
+            return false;
+        }
+        resources->pipeline_chunk_data_pool_bytes = pool_bytes;
     }
 
     resources->sample_chunk_pool = (SampleChunk*)mem_arena_alloc(&resources->setup_arena, PIPELINE_NUM_CHUNKS * sizeof(SampleChunk));
@@ -290,9 +274,22 @@ bool create_threading_components(AppResources *resources) {
 
     if (resources->config->iq_correction.enable) {
         resources->iq_optimization_data_queue = (Queue*)mem_arena_alloc(arena, sizeof(Queue));
-        if (!queue_init(resources->iq_optimization_data_queue, PIPELINE_NUM_CHUNKS, arena)) return false;
+        resources->iq_snapshot_free_queue = (Queue*)mem_arena_alloc(arena, sizeof(Queue));
+        if (!resources->iq_optimization_data_queue || !resources->iq_snapshot_free_queue) return false;
+        if (!queue_init(resources->iq_optimization_data_queue, IQ_CORRECTION_SNAPSHOT_POOL_SIZE, arena) ||
+            !queue_init(resources->iq_snapshot_free_queue, IQ_CORRECTION_SNAPSHOT_POOL_SIZE, arena)) {
+            return false;
+        }
+        for (size_t i = 0; i < IQ_CORRECTION_SNAPSHOT_POOL_SIZE; ++i) {
+            complex_float_t* snapshot = resources->iq_correction.snapshot_pool + i * IQ_CORRECTION_FFT_SIZE;
+            if (!queue_enqueue(resources->iq_snapshot_free_queue, snapshot)) {
+                log_fatal("Failed to populate I/Q snapshot queue.");
+                return false;
+            }
+        }
     } else {
         resources->iq_optimization_data_queue = NULL;
+        resources->iq_snapshot_free_queue = NULL;
     }
 
     for (size_t i = 0; i < PIPELINE_NUM_CHUNKS; ++i) {
@@ -306,6 +303,10 @@ bool create_threading_components(AppResources *resources) {
         log_fatal("Failed to initialize progress mutex: %s", strerror(errno));
         return false;
     }
+    if (pthread_mutex_init(&resources->chunk_ref_mutex, NULL) != 0) {
+        log_fatal("Failed to initialize chunk reference mutex: %s", strerror(errno));
+        return false;
+    }
 
     return true;
 }
@@ -317,7 +318,9 @@ void destroy_threading_components(AppResources *resources) {
     if(resources->resampler_to_post_process_queue) queue_destroy(resources->resampler_to_post_process_queue);
     if(resources->stdout_queue) queue_destroy(resources->stdout_queue);
     if(resources->iq_optimization_data_queue) queue_destroy(resources->iq_optimization_data_queue);
+    if(resources->iq_snapshot_free_queue) queue_destroy(resources->iq_snapshot_free_queue);
     pthread_mutex_destroy(&resources->progress_mutex);
+    pthread_mutex_destroy(&resources->chunk_ref_mutex);
 }
 
 void print_configuration_summary(const AppConfig *config, const AppResources *resources) {
@@ -340,7 +343,7 @@ void print_configuration_summary(const AppConfig *config, const AppResources *re
 
     const char* base_output_labels[] = {
         "Container Type", "Sample Type", "Output Rate", "Gain Multiplier", "Frequency Shift",
-        "Resampling", "Output Target", "FIR Filter", "FFT Filter"
+        "Resampling", "Stage Plan", "Output Target", "FIR Filter", "FFT Filter"
     };
     for (size_t i = 0; i < sizeof(base_output_labels) / sizeof(base_output_labels[0]); i++) {
         int len = (int)strlen(base_output_labels[i]);
@@ -361,9 +364,19 @@ void print_configuration_summary(const AppConfig *config, const AppResources *re
             fprintf(stderr, " %-*s : %s\n", max_label_len, summary_info.items[i].label, summary_info.items[i].value);
         }
     }
+    if (config->range_start.provided || config->range_duration.provided || resources->checkpoint.resuming) {
+        double rate = (double)resources->source_info.samplerate;
+        char range_buf[128];
+        char duration_buf[40];
+        format_duration((double)resources->source_info.frames / rate, duration_buf, sizeof(duration_buf));
+        snprintf(range_buf, sizeof(range_buf), "%s from %.3f s", duration_buf, (double)resources->input_range_start_frame / rate);
+        fprintf(stderr, " %-*s : %s\n", max_label_len, "Input Range", range_buf);
+    }
     
-    fprintf(stderr, " %-*s : %s\n", max_label_len, "I/Q Correction", config->iq_correction.enable ? "Enabled" : "Disabled");
-    fprintf(stderr, " %-*s : %s\n", max_label_len, "DC Block", config->dc_block.enable ? "Enabled" : "Disabled");
+    fprintf(stderr, " %-*s : %s\n", max_label_len, "I/Q Correction", !config->iq_correction.enable ? "Disabled" :
+            (config->iq_correction.method == IQ_CORRECTION_METHOD_STATS ? "Enabled (Closed-Form)" : "Enabled"));
+    fprintf(stderr, " %-*s : %s\n", max_label_len, "DC Block", !config->dc_block.enable ? "Disabled" :
+            stage_plan_is_post_resample(&resources->stage_plan, PLAN_STAGE_DC_BLOCK) ? "Enabled (Post-Resample)" : "Enabled");
 
 
     fprintf(stderr, "--- Output Details ---\n");
@@ -387,7 +400,7 @@ void print_configuration_summary(const AppConfig *config, const AppResources *re
     }
     if (fabs(resources->actual_nco_shift_hz) > 1e-9) {
         char shift_buf[64];
-        snprintf(shift_buf, sizeof(shift_buf), "%+.2f Hz%s", resources->actual_nco_shift_hz, config->shift_after_resample ? " (Post-Resample)" : "");
+        snprintf(shift_buf, sizeof(shift_buf), "%+.2f Hz%s", resources->actual_nco_shift_hz, resources->stage_plan.shift_post_resample ? " (Post-Resample)" : "");
         fprintf(stderr, " %-*s : %s\n", max_label_len, "Frequency Shift", shift_buf);
     }
 
@@ -398,10 +411,14 @@ void print_configuration_summary(const AppConfig *config, const AppResources *re
         switch (resources->user_filter_type_actual) {
             case FILTER_IMPL_FIR_SYMMETRIC:
             case FILTER_IMPL_FIR_ASYMMETRIC:
+            case FILTER_IMPL_DECIM_SYMMETRIC:
+            case FILTER_IMPL_DECIM_ASYMMETRIC:
                 filter_label = "FIR Filter";
                 break;
             case FILTER_IMPL_FFT_SYMMETRIC:
             case FILTER_IMPL_FFT_ASYMMETRIC:
+            case FILTER_IMPL_FFTW_SYMMETRIC:
+            case FILTER_IMPL_FFTW_ASYMMETRIC:
                 filter_label = "FFT Filter";
                 break;
             default:
@@ -410,7 +427,8 @@ void print_configuration_summary(const AppConfig *config, const AppResources *re
         }
         
         char filter_buf[256] = {0};
-        const char* stage = config->apply_user_filter_post_resample ? " (Post-Resample)" : "";
+        const char* stage = (resources->merged_decimation_factor > 0) ? " (Merged Into Decimator)" :
+                            resources->stage_plan.filter_post_resample ? " (Post-Resample)" : "";
         strncat(filter_buf, "Enabled: ", sizeof(filter_buf) - strlen(filter_buf) - 1);
         for (int i = 0; i < config->num_filter_requests; i++) {
             char current_filter_desc[128];
@@ -429,7 +447,25 @@ void print_configuration_summary(const AppConfig *config, const AppResources *re
         fprintf(stderr, " %-*s : %s\n", max_label_len, filter_label, filter_buf);
     }
 
-    fprintf(stderr, " %-*s : %s\n", max_label_len, "Resampling", resources->is_passthrough ? "Disabled (Passthrough Mode)" : "Enabled");
+    if (resources->merged_decimation_factor > 0) {
+        char resample_buf[64];
+        snprintf(resample_buf, sizeof(resample_buf), "Enabled (Polyphase Decimator, Factor %u)", resources->merged_decimation_factor);
+        fprintf(stderr, " %-*s : %s\n", max_label_len, "Resampling", resample_buf);
+    } else if (resources->cic.decimation_factor > 0) {
+        char resample_buf[64];
+        snprintf(resample_buf, sizeof(resample_buf), "Enabled (CIC Decimator, Factor %u + Resampler)", resources->cic.decimation_factor);
+        fprintf(stderr, " %-*s : %s\n", max_label_len, "Resampling", resample_buf);
+    } else {
+        fprintf(stderr, " %-*s : %s\n", max_label_len, "Resampling", resources->is_passthrough ? "Disabled (Passthrough Mode)" : "Enabled");
+    }
+    if (!config->raw_passthrough) {
+        char plan_desc[128];
+        char plan_buf[192];
+        stage_planner_describe(config, resources, plan_desc, sizeof(plan_desc));
+        snprintf(plan_buf, sizeof(plan_buf), "%s (~%.0f MACs/sample, %s)", plan_desc,
+                 resources->stage_plan.estimated_macs_per_sample, resources->stage_plan.forced ? "forced" : "auto");
+        fprintf(stderr, " %-*s : %s\n", max_label_len, "Stage Plan", plan_buf);
+    }
 
     const char* output_path_for_messages;
 #ifdef _WIN32
@@ -437,7 +473,48 @@ void print_configuration_summary(const AppConfig *config, const AppResources *re
 #else
     output_path_for_messages = config->effective_output_filename;
 #endif
+    if (resources->num_channels > 0) {
+        for (int i = 0; i < resources->num_channels; i++) {
+            const ChannelOutput* ch = &resources->channels[i];
+            char channel_label[32];
+            char channel_buf[128];
+            snprintf(channel_label, sizeof(channel_label), "Channel %d", i + 1);
+            snprintf(channel_buf, sizeof(channel_buf), "%+.0f Hz, BW %.0f Hz (%u taps)", ch->offset_hz, ch->bandwidth_hz, ch->channel_filter_taps);
+            fprintf(stderr, " %-*s : %s\n", max_label_len, channel_label, channel_buf);
+        }
+        fprintf(stderr, " %-*s : %s (one file per channel, suffixed _ch<N>)\n", max_label_len, "Output Files", output_path_for_messages);
+        return;
+    }
     fprintf(stderr, " %-*s : %s\n", max_label_len, config->output_to_stdout ? "Output Target" : "Output File", config->output_to_stdout ? "<stdout>" : output_path_for_messages);
+    if (config->segment_size_mb_arg > 0.0f || config->segment_duration_sec_arg > 0.0f) {
+        char segment_buf[96];
+        if (config->segment_size_mb_arg > 0.0f && config->segment_duration_sec_arg > 0.0f) {
+            snprintf(segment_buf, sizeof(segment_buf), "every %.0f MB or %.0f s, suffixed _<NNNN>", config->segment_size_mb_arg, config->segment_duration_sec_arg);
+        } else if (config->segment_size_mb_arg > 0.0f) {
+            snprintf(segment_buf, sizeof(segment_buf), "every %.0f MB, suffixed _<NNNN>", config->segment_size_mb_arg);
+        } else {
+            snprintf(segment_buf, sizeof(segment_buf), "every %.0f s, suffixed _<NNNN>", config->segment_duration_sec_arg);
+        }
+        fprintf(stderr, " %-*s : %s\n", max_label_len, "Segments", segment_buf);
+    }
+    if (resources->checkpoint.enabled) {
+        char checkpoint_buf[MAX_PATH_BUFFER + 64];
+        snprintf(checkpoint_buf, sizeof(checkpoint_buf), "%s, every %d s%s", resources->checkpoint.path,
+                 CHECKPOINT_INTERVAL_SECONDS, resources->checkpoint.resuming ? " (resumed)" : "");
+        fprintf(stderr, " %-*s : %s\n", max_label_len, "Checkpoint", checkpoint_buf);
+    }
+
+    for (int i = 0; i < resources->num_output_branches; i++) {
+        const OutputBranch* branch = &resources->output_branches[i];
+        char output_label[32];
+        char output_buf[MAX_PATH_BUFFER + 128];
+        snprintf(output_label, sizeof(output_label), "Output %u", branch->sink.index);
+        snprintf(output_buf, sizeof(output_buf), "%s, %s, %.0f Hz -> %s",
+                 (branch->config->output_type == OUTPUT_TYPE_RAW) ? "RAW" :
+                 (branch->config->output_type == OUTPUT_TYPE_WAV) ? "WAV" : "WAV (RF64)",
+                 branch->config->sample_type_name, branch->config->target_rate, branch->sink.path);
+        fprintf(stderr, " %-*s : %s\n", max_label_len, output_label, output_buf);
+    }
 }
 
 bool prepare_output_stream(AppConfig *config, AppResources *resources) {
@@ -476,25 +553,30 @@ bool initialize_application(AppConfig *config, AppResources *resources) {
 
     // STEP 2: Initialize hardware and file handles
     if (!resolve_file_paths(config)) goto cleanup;
+    if (!checkpoint_init(config, resources)) goto cleanup;
     if (!resources->selected_input_ops->initialize(&ctx)) goto cleanup;
 
     // STEP 3: Perform initial calculations and validations
     if (!calculate_and_validate_resample_ratio(config, resources, &resample_ratio)) goto cleanup;
-    if (!validate_and_configure_filter_stage(config, resources)) goto cleanup;
+    if (!stage_planner_plan(config, resources)) goto cleanup;
     
-    // STEP 4: Initialize all individual DSP components in a consistent, logical order
+    // STEP 4: Initialize all individual DSP components in a consistent, logical order.
+    // The CIC front end sets the rate of everything after it, so it comes before the
+    // DC blocker and resampler, but needs to know whether a pre-resample shift exists.
+    if (!create_frequency_shifter(config, resources)) goto cleanup;
+    if (!cic_decimator_create(config, resources, &resample_ratio)) goto cleanup;
     if (!create_dc_blocker(config, resources)) goto cleanup;
     if (!create_iq_corrector(config, resources)) goto cleanup;
-    if (!create_frequency_shifter(config, resources)) goto cleanup;
     if (!create_resampler(config, resources, resample_ratio)) goto cleanup;
     if (!create_filter(config, resources)) goto cleanup;
+    if (!channelizer_create(config, resources, resample_ratio)) goto cleanup;
+    input_range_plan_warmup(config, resources);
+    if (!checkpoint_prepare(config, resources)) goto cleanup;
     
     // Conditionally allocate FFT remainder buffers from the arena if needed.
-    if (resources->user_fir_filter_object &&
-       (resources->user_filter_type_actual == FILTER_IMPL_FFT_SYMMETRIC ||
-        resources->user_filter_type_actual == FILTER_IMPL_FFT_ASYMMETRIC))
+    if (resources->user_fir_filter_object && filter_is_block_based(resources->user_filter_type_actual))
     {
-        if (config->apply_user_filter_post_resample) {
+        if (resources->stage_plan.filter_post_resample) {
             // FFT filter is in the post-processor thread
             resources->post_fft_remainder_buffer = (complex_float_t*)mem_arena_alloc(
                 &resources->setup_arena,
@@ -510,10 +592,20 @@ bool initialize_application(AppConfig *config, AppResources *resources) {
             if (!resources->pre_fft_remainder_buffer) goto cleanup;
         }
     }
+
+    // A merged decimator carries up to (factor - 1) input samples between chunks.
+    if (resources->merged_decimation_factor > 0) {
+        resources->decimator_remainder_buffer = (complex_float_t*)mem_arena_alloc(
+            &resources->setup_arena,
+            resources->merged_decimation_factor * sizeof(complex_float_t)
+        );
+        if (!resources->decimator_remainder_buffer) goto cleanup;
+    }
     
     // STEP 5: Allocate all memory pools and threading components
     if (!allocate_processing_buffers(config, resources, resample_ratio)) goto cleanup;
     if (!create_threading_components(resources)) goto cleanup;
+    if (!output_branches_create(config, resources)) goto cleanup;
 
     // STEP 6: Create large I/O ring buffers (if needed)
     if (resources->pipeline_mode == PIPELINE_MODE_BUFFERED_SDR) {
@@ -523,29 +615,34 @@ bool initialize_application(AppConfig *config, AppResources *resources) {
             goto cleanup;
         }
     }
-    if (!config->output_to_stdout) {
+    if (!config->output_to_stdout && config->num_channels == 0 && resources->reuse.file_write_buffer) {
+        resources->file_write_buffer = resources->reuse.file_write_buffer;
+        resources->reuse.file_write_buffer = NULL;
+        file_write_buffer_reset(resources->file_write_buffer);
+    } else if (!config->output_to_stdout && config->num_channels == 0) {
         resources->file_write_buffer = file_write_buffer_create(IO_FILE_WRITER_BUFFER_BYTES);
         if (!resources->file_write_buffer) {
             log_fatal("Failed to create I/O output buffer.");
             goto cleanup;
         }
     } else {
+        // Stdout has no ring buffer, and in channelizer mode each channel has its own.
         resources->file_write_buffer = NULL;
     }
 
     // STEP 7: Final checks, summary print, and output stream preparation
-    if (!config->output_to_stdout) {
+    if (!config->output_to_stdout && !resources->batch_quiet) {
         print_configuration_summary(config, resources);
 
         if (fabs(resources->actual_nco_shift_hz) > 1e-9) {
-            double rate_for_shift_check = config->shift_after_resample ? config->target_rate : (double)resources->source_info.samplerate;
+            double rate_for_shift_check = resources->stage_plan.shift_post_resample ? config->target_rate : (double)resources->source_info.samplerate;
             if (!utils_check_nyquist_warning(fabs(resources->actual_nco_shift_hz), rate_for_shift_check, "Frequency Shift")) {
                 goto cleanup;
             }
         }
 
         if (config->num_filter_requests > 0) {
-            double rate_for_filter_check = config->apply_user_filter_post_resample ? config->target_rate : (double)resources->source_info.samplerate;
+            double rate_for_filter_check = resources->stage_plan.filter_post_resample ? config->target_rate : (double)resources->source_info.samplerate;
             for (int i = 0; i < config->num_filter_requests; i++) {
                 const FilterRequest* req = &config->filter_requests[i];
                 double freq_to_check = 0.0;
@@ -570,14 +667,19 @@ bool initialize_application(AppConfig *config, AppResources *resources) {
         }
     }
 
-    if (!prepare_output_stream(config, resources)) goto cleanup;
+    if (config->num_channels > 0) {
+        if (!channelizer_open_outputs(config, resources)) goto cleanup;
+    } else {
+        if (!prepare_output_stream(config, resources)) goto cleanup;
+    }
+    if (!output_branches_open(resources)) goto cleanup;
 
     success = true;
 
 cleanup:
     if (!success) {
         // Let main() handle the destruction of the arena.
-    } else if (!config->output_to_stdout) {
+    } else if (!config->output_to_stdout && !resources->batch_quiet) {
         bool source_has_known_length = resources->selected_input_ops->has_known_length();
         if (!source_has_known_length) {
             log_info("Starting SDR capture...");
@@ -588,6 +690,80 @@ cleanup:
     return success;
 }
 
+bool run_processing_pipeline(AppConfig *config, AppResources *resources) {
+    PipelineContext thread_args;
+    thread_args.config = config;
+    thread_args.resources = resources;
+
+    log_debug("Starting processing threads...");
+
+    if (resources->pipeline_mode == PIPELINE_MODE_BUFFERED_SDR) {
+        if (pthread_create(&resources->sdr_capture_thread_handle, NULL, sdr_capture_thread_func, &thread_args) != 0) {
+            handle_fatal_thread_error("In Pipeline: Failed to create SDR capture thread.", resources);
+        }
+    }
+
+    if (pthread_create(&resources->reader_thread_handle, NULL, reader_thread_func, &thread_args) != 0 ||
+        pthread_create(&resources->pre_processor_thread_handle, NULL, pre_processor_thread_func, &thread_args) != 0 ||
+        pthread_create(&resources->resampler_thread_handle, NULL, resampler_thread_func, &thread_args) != 0 ||
+        pthread_create(&resources->post_processor_thread_handle, NULL, post_processor_thread_func, &thread_args) != 0 ||
+        (resources->num_channels == 0 && pthread_create(&resources->writer_thread_handle, NULL, writer_thread_func, &thread_args) != 0) ||
+        (config->iq_correction.enable && pthread_create(&resources->iq_optimization_thread_handle, NULL, iq_optimization_thread_func, &thread_args) != 0))
+    {
+        handle_fatal_thread_error("In Pipeline: Failed to create one or more processing threads.", resources);
+    }
+
+    int channel_writers_started = 0;
+    for (int i = 0; i < resources->num_channels; i++) {
+        if (pthread_create(&resources->channels[i].sink.writer_thread_handle, NULL, output_sink_writer_thread_func, &resources->channels[i].sink) != 0) {
+            handle_fatal_thread_error("In Pipeline: Failed to create a channel writer thread.", resources);
+            break;
+        }
+        channel_writers_started++;
+    }
+
+    int branches_started = 0;
+    for (int i = 0; i < resources->num_output_branches; i++) {
+        OutputBranch* branch = &resources->output_branches[i];
+        if (pthread_create(&branch->thread_handle, NULL, output_branch_thread_func, branch) != 0) {
+            handle_fatal_thread_error("In Pipeline: Failed to create an output branch thread.", resources);
+            break;
+        }
+        if (pthread_create(&branch->sink.writer_thread_handle, NULL, output_sink_writer_thread_func, &branch->sink) != 0) {
+            handle_fatal_thread_error("In Pipeline: Failed to create an output writer thread.", resources);
+            pthread_join(branch->thread_handle, NULL);
+            break;
+        }
+        branches_started++;
+    }
+
+    pthread_join(resources->post_processor_thread_handle, NULL);
+    if (resources->num_channels == 0) {
+        pthread_join(resources->writer_thread_handle, NULL);
+    }
+    for (int i = 0; i < channel_writers_started; i++) {
+        pthread_join(resources->channels[i].sink.writer_thread_handle, NULL);
+    }
+    for (int i = 0; i < branches_started; i++) {
+        pthread_join(resources->output_branches[i].thread_handle, NULL);
+        pthread_join(resources->output_branches[i].sink.writer_thread_handle, NULL);
+    }
+    pthread_join(resources->resampler_thread_handle, NULL);
+    pthread_join(resources->pre_processor_thread_handle, NULL);
+    if (config->iq_correction.enable) {
+        pthread_join(resources->iq_optimization_thread_handle, NULL);
+    }
+    pthread_join(resources->reader_thread_handle, NULL);
+
+    if (resources->pipeline_mode == PIPELINE_MODE_BUFFERED_SDR) {
+        pthread_join(resources->sdr_capture_thread_handle, NULL);
+    }
+
+    log_debug("All processing threads have joined.");
+
+    return !resources->error_occurred;
+}
+
 void cleanup_application(AppConfig *config, AppResources *resources) {
     if (!resources) return;
     InputSourceContext ctx = { .config = config, .resources = resources };
@@ -600,7 +776,15 @@ void cleanup_application(AppConfig *config, AppResources *resources) {
     }
     filter_destroy(resources);
     freq_shift_destroy_ncos(resources);
-    if (resources->resampler) {
+    cic_decimator_destroy(resources);
+    if (resources->resampler && resources->reuse.enabled) {
+        if (resources->reuse.resampler) {
+            msresamp_crcf_destroy(resources->reuse.resampler);
+        }
+        resources->reuse.resampler = resources->resampler;
+        resources->reuse.resampler_ratio = msresamp_crcf_get_rate(resources->resampler);
+        resources->resampler = NULL;
+    } else if (resources->resampler) {
         msresamp_crcf_destroy(resources->resampler);
         resources->resampler = NULL;
     }
@@ -615,23 +799,158 @@ void cleanup_application(AppConfig *config, AppResources *resources) {
     if (resources->writer_ctx.ops.get_total_bytes_written) {
         resources->final_output_size_bytes = resources->writer_ctx.ops.get_total_bytes_written(&resources->writer_ctx);
     }
+    checkpoint_finish(resources);
+    channelizer_destroy(resources);
+    output_branches_destroy(resources);
 
     if (resources->sdr_input_buffer) {
         file_write_buffer_destroy(resources->sdr_input_buffer);
         resources->sdr_input_buffer = NULL;
     }
 
-    if (resources->file_write_buffer) {
+    if (resources->file_write_buffer && resources->reuse.enabled && !resources->reuse.file_write_buffer) {
+        resources->reuse.file_write_buffer = resources->file_write_buffer;
+        resources->file_write_buffer = NULL;
+    } else if (resources->file_write_buffer) {
         file_write_buffer_destroy(resources->file_write_buffer);
         resources->file_write_buffer = NULL;
     }
 
     destroy_threading_components(resources);
 
-    if (resources->pipeline_chunk_data_pool) {
+    if (resources->pipeline_chunk_data_pool && resources->reuse.enabled &&
+        resources->pipeline_chunk_data_pool_bytes > resources->reuse.chunk_data_pool_bytes) {
+        free(resources->reuse.chunk_data_pool);
+        resources->reuse.chunk_data_pool = resources->pipeline_chunk_data_pool;
+        resources->reuse.chunk_data_pool_bytes = resources->pipeline_chunk_data_pool_bytes;
+        resources->pipeline_chunk_data_pool = NULL;
+    } else if (resources->pipeline_chunk_data_pool) {
         free(resources->pipeline_chunk_data_pool);
         resources->pipeline_chunk_data_pool = NULL;
     }
 
     // The memory arena is destroyed in main(), not here.
 }
+
+void pipeline_resources_reset(AppResources *resources) {
+    // Everything but the arena and the objects kept from the previous run starts from zero.
+    MemoryArena arena = resources->setup_arena;
+    PipelineReuse reuse = resources->reuse;
+    memset(resources, 0, sizeof(AppResources));
+    resources->setup_arena = arena;
+    mem_arena_reset(&resources->setup_arena);
+    resources->reuse = reuse;
+}
+
+static bool _output_file_exists(const char* path) {
+#ifdef _WIN32
+    wchar_t path_w[MAX_PATH_BUFFER];
+    char path_utf8[MAX_PATH_BUFFER];
+    if (!get_absolute_path_windows(path, path_w, MAX_PATH_BUFFER, path_utf8, sizeof(path_utf8))) return false;
+    DWORD attrs = GetFileAttributesW(path_w);
+    return (attrs != INVALID_FILE_ATTRIBUTES && !(attrs & FILE_ATTRIBUTE_DIRECTORY));
+#else
+    struct stat st;
+    return stat(path, &st) == 0 && !S_ISDIR(st.st_mode);
+#endif
+}
+
+/**
+ * @brief Calls `visit` for each output file of the run that exists on disk, until it returns false.
+ *
+ * The files are named as the writers name them: the main output, or one
+ * "_ch<N>" file per channel, then each additional output. With segments,
+ * each of those is a run of "_<NNNN>" files starting at 1.
+ */
+static void _for_each_existing_output(const AppConfig *config, bool (*visit)(const char* path, void* udata), void* udata) {
+    const bool segmented = (config->segment_size_mb_arg > 0.0f || config->segment_duration_sec_arg > 0.0f);
+    const int num_bases = 1 + config->num_extra_outputs;
+    char base[MAX_PATH_BUFFER];
+    char path[MAX_PATH_BUFFER];
+
+    for (int b = 0; b < num_bases; b++) {
+        int num_files = 1;
+        const char* base_arg = config->output_filename_arg;
+        if (b > 0) {
+            base_arg = config->extra_outputs[b - 1].filename_arg;
+        } else if (config->output_to_stdout) {
+            continue;
+        } else if (config->num_channels > 0) {
+            num_files = config->num_channels;
+        }
+        if (!base_arg || !base_arg[0]) continue;
+
+        for (int f = 0; f < num_files; f++) {
+            bool fits = (b == 0 && config->num_channels > 0)
+                ? channelizer_make_channel_path(base_arg, (unsigned int)f + 1, base, sizeof(base))
+                : ((size_t)snprintf(base, sizeof(base), "%s", base_arg) < sizeof(base));
+            if (!fits) continue;
+
+            if (!segmented) {
+                if (_output_file_exists(base) && !visit(base, udata)) return;
+                continue;
+            }
+            for (unsigned int number = 1; file_writer_make_segment_path(base, number, path, sizeof(path)) &&
+                                          _output_file_exists(path); number++) {
+                if (!visit(path, udata)) return;
+            }
+        }
+    }
+}
+
+typedef struct {
+    char* found;
+    size_t found_size;
+    bool any;
+} _ExistingOutputSearch;
+
+static bool _note_existing_output(const char* path, void* udata) {
+    _ExistingOutputSearch* search = (_ExistingOutputSearch*)udata;
+    search->any = true;
+    if (search->found && search->found_size > 0) snprintf(search->found, search->found_size, "%s", path);
+    return false;
+}
+
+static bool _remove_output(const char* path, void* udata) {
+    (void)udata;
+#ifdef _WIN32
+    wchar_t path_w[MAX_PATH_BUFFER];
+    char path_utf8[MAX_PATH_BUFFER];
+    if (get_absolute_path_windows(path, path_w, MAX_PATH_BUFFER, path_utf8, sizeof(path_utf8))) _wremove(path_w);
+#else
+    remove(path);
+#endif
+    return true;
+}
+
+/**
+ * @brief Checks whether any output file of the run already exists.
+ * @param found Receives the first existing path (may be NULL).
+ */
+bool pipeline_find_existing_output(const AppConfig *config, char *found, size_t found_size) {
+    _ExistingOutputSearch search = { found, found_size, false };
+    _for_each_existing_output(config, _note_existing_output, &search);
+    return search.any;
+}
+
+/**
+ * @brief Removes every output file a run that did not complete may have written.
+ */
+void pipeline_remove_outputs(const AppConfig *config) {
+    _for_each_existing_output(config, _remove_output, NULL);
+}
+
+void pipeline_reuse_release(PipelineReuse *reuse) {
+    if (!reuse) return;
+    if (reuse->resampler) {
+        msresamp_crcf_destroy(reuse->resampler);
+        reuse->resampler = NULL;
+    }
+    if (reuse->file_write_buffer) {
+        file_write_buffer_destroy(reuse->file_write_buffer);
+        reuse->file_write_buffer = NULL;
+    }
+    free(reuse->chunk_data_pool);
+    reuse->chunk_data_pool = NULL;
+    reuse->chunk_data_pool_bytes = 0;
+}
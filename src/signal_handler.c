@@ -2,7 +2,10 @@
 #include "log.h"
 #include "types.h"
 #include "input_source.h"
+#include "channelizer.h"
+#include "output_branch.h"
 #include "queue.h" // <-- MODIFIED: Added the missing include
+#include "constants.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -25,6 +28,13 @@ extern pthread_mutex_t g_console_mutex;
 static AppResources *g_resources_for_signal_handler = NULL;
 static volatile sig_atomic_t g_shutdown_flag = 0;
 
+// Pipelines started in addition to the main one (batch mode), also woken on shutdown.
+static pthread_mutex_t g_tracked_resources_mutex = PTHREAD_MUTEX_INITIALIZER;
+static AppResources *g_tracked_resources[BATCH_MAX_JOBS];
+static int g_num_tracked_resources = 0;
+
+static void _wake_pipeline(AppResources* r);
+
 
 #ifdef _WIN32
 static BOOL WINAPI console_ctrl_handler(DWORD dwCtrlType) {
@@ -100,6 +110,27 @@ void reset_shutdown_flag(void) {
     g_shutdown_flag = 0;
 }
 
+void signal_handler_track_resources(AppResources *resources, bool track) {
+    pthread_mutex_lock(&g_tracked_resources_mutex);
+    if (track) {
+        if (g_num_tracked_resources < BATCH_MAX_JOBS) {
+            g_tracked_resources[g_num_tracked_resources++] = resources;
+        }
+        // A pipeline registered after the shutdown request would otherwise never be woken.
+        if (g_shutdown_flag) {
+            _wake_pipeline(resources);
+        }
+    } else {
+        for (int i = 0; i < g_num_tracked_resources; i++) {
+            if (g_tracked_resources[i] == resources) {
+                g_tracked_resources[i] = g_tracked_resources[--g_num_tracked_resources];
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_tracked_resources_mutex);
+}
+
 void request_shutdown(void) {
     if (g_shutdown_flag) {
         return;
@@ -107,39 +138,55 @@ void request_shutdown(void) {
     g_shutdown_flag = 1;
 
     if (g_resources_for_signal_handler) {
-        AppResources* r = g_resources_for_signal_handler;
-
-        // Special case for RTL-SDR to unblock its synchronous read loop
-        if (r->config && r->config->input_type_str && strcasecmp(r->config->input_type_str, "rtlsdr") == 0) {
-            if (r->selected_input_ops && r->selected_input_ops->stop_stream) {
-                log_debug("Signal handler is calling stop_stream for RTL-SDR to unblock reader thread.");
-                InputSourceContext ctx = { .config = r->config, .resources = r };
-                r->selected_input_ops->stop_stream(&ctx);
-            }
-        }
+        _wake_pipeline(g_resources_for_signal_handler);
+    }
 
-        // Signal all queues to wake up any waiting threads
-        if (r->free_sample_chunk_queue)
-            queue_signal_shutdown(r->free_sample_chunk_queue);
-        if (r->raw_to_pre_process_queue)
-            queue_signal_shutdown(r->raw_to_pre_process_queue);
-        if (r->pre_process_to_resampler_queue)
-            queue_signal_shutdown(r->pre_process_to_resampler_queue);
-        if (r->resampler_to_post_process_queue)
-            queue_signal_shutdown(r->resampler_to_post_process_queue);
-        if (r->stdout_queue)
-            queue_signal_shutdown(r->stdout_queue);
-        if (r->iq_optimization_data_queue)
-            queue_signal_shutdown(r->iq_optimization_data_queue);
-        
-        // Signal all ring buffers to wake up any waiting threads
-        if (r->file_write_buffer)
-            file_write_buffer_signal_shutdown(r->file_write_buffer);
-        
-        // Also signal the SDR input buffer to unblock the reader thread in buffered mode.
-        if (r->sdr_input_buffer)
-            file_write_buffer_signal_shutdown(r->sdr_input_buffer);
+    // Held while signalling so a pipeline can't be torn down underneath us.
+    pthread_mutex_lock(&g_tracked_resources_mutex);
+    for (int i = 0; i < g_num_tracked_resources; i++) {
+        _wake_pipeline(g_tracked_resources[i]);
     }
+    pthread_mutex_unlock(&g_tracked_resources_mutex);
+}
+
+/**
+ * @brief Stops the input and wakes every thread of one pipeline waiting on its queues or ring buffers.
+ */
+static void _wake_pipeline(AppResources* r) {
+    // Special case for RTL-SDR to unblock its synchronous read loop
+    if (r->config && r->config->input_type_str && strcasecmp(r->config->input_type_str, "rtlsdr") == 0) {
+        if (r->selected_input_ops && r->selected_input_ops->stop_stream) {
+            log_debug("Signal handler is calling stop_stream for RTL-SDR to unblock reader thread.");
+            InputSourceContext ctx = { .config = r->config, .resources = r };
+            r->selected_input_ops->stop_stream(&ctx);
+        }
+    }
+
+    // Signal all queues to wake up any waiting threads
+    if (r->free_sample_chunk_queue)
+        queue_signal_shutdown(r->free_sample_chunk_queue);
+    if (r->raw_to_pre_process_queue)
+        queue_signal_shutdown(r->raw_to_pre_process_queue);
+    if (r->pre_process_to_resampler_queue)
+        queue_signal_shutdown(r->pre_process_to_resampler_queue);
+    if (r->resampler_to_post_process_queue)
+        queue_signal_shutdown(r->resampler_to_post_process_queue);
+    if (r->stdout_queue)
+        queue_signal_shutdown(r->stdout_queue);
+    if (r->iq_optimization_data_queue)
+        queue_signal_shutdown(r->iq_optimization_data_queue);
+    if (r->iq_snapshot_free_queue)
+        queue_signal_shutdown(r->iq_snapshot_free_queue);
+    
+    // Signal all ring buffers to wake up any waiting threads
+    if (r->file_write_buffer)
+        file_write_buffer_signal_shutdown(r->file_write_buffer);
+    channelizer_signal_shutdown(r);
+    output_branches_signal_shutdown(r);
+    
+    // Also signal the SDR input buffer to unblock the reader thread in buffered mode.
+    if (r->sdr_input_buffer)
+        file_write_buffer_signal_shutdown(r->sdr_input_buffer);
 }
 
 void handle_fatal_thread_error(const char* context_msg, AppResources* resources) {
@@ -152,5 +199,12 @@ void handle_fatal_thread_error(const char* context_msg, AppResources* resources)
     pthread_mutex_unlock(&resources->progress_mutex);
 
     log_fatal("%s", context_msg);
+    if (resources->isolate_errors) {
+        // Server mode: only this job's pipeline stops, the others keep running.
+        pthread_mutex_lock(&g_tracked_resources_mutex);
+        _wake_pipeline(resources);
+        pthread_mutex_unlock(&g_tracked_resources_mutex);
+        return;
+    }
     request_shutdown();
 }
@@ -0,0 +1,344 @@
+// stage_planner.c
+
+#include "stage_planner.h"
+#include "constants.h"
+#include "log.h"
+#include "filter.h"
+#include "frequency_shift.h"
+#include "cic_decimator.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+static const char* const stage_option_names[PLAN_STAGE_COUNT] = { "dc", "shift", "filter" };
+static const char* const stage_display_names[PLAN_STAGE_COUNT] = { "DC Block", "Shift", "Filter" };
+
+/**
+ * @brief Everything about the run that decides which plans are legal and what they cost.
+ */
+typedef struct {
+    bool active[PLAN_STAGE_COUNT];
+    bool all_pre_required;          // Channels and additional outputs read the pre-resample stream
+    double input_rate;
+    double output_rate;
+    double shift_hz;
+    bool band_known;                // The filter chain limits the band of interest
+    double band_low_hz;             // Band of interest, in output (shifted) coordinates
+    double band_high_hz;
+    unsigned int merge_factor;      // Integer decimation factor the filter can be merged into, or 0
+    unsigned int cic_factor;        // CIC front end factor if nothing before the resampler rules it out, or 0
+} PlanContext;
+
+bool stage_plan_is_post_resample(const StagePlan* plan, PlanStage stage) {
+    return plan->stages_before_resample <= (int)stage;
+}
+
+bool stage_planner_parse_order(const char* order_str, StagePlacement out_requests[PLAN_STAGE_COUNT]) {
+    for (int k = 0; k < PLAN_STAGE_COUNT; k++) out_requests[k] = STAGE_PLACEMENT_AUTO;
+
+    char list_buf[MAX_LINE_LENGTH];
+    if (strlen(order_str) >= sizeof(list_buf)) {
+        log_fatal("The --stage-order list is too long.");
+        return false;
+    }
+    strcpy(list_buf, order_str);
+
+    bool seen_resample = false;
+    int last_stage = -1;
+    char* next_entry = list_buf;
+    while (next_entry) {
+        char* entry = next_entry;
+        char* comma = strchr(entry, ',');
+        if (comma) {
+            *comma = '\0';
+            next_entry = comma + 1;
+        } else {
+            next_entry = NULL;
+        }
+
+        if (strcasecmp(entry, "resample") == 0) {
+            if (seen_resample) {
+                log_fatal("Stage 'resample' appears more than once in --stage-order.");
+                return false;
+            }
+            seen_resample = true;
+            continue;
+        }
+
+        int stage = -1;
+        for (int k = 0; k < PLAN_STAGE_COUNT; k++) {
+            if (strcasecmp(entry, stage_option_names[k]) == 0) stage = k;
+        }
+        if (stage < 0) {
+            log_fatal("Invalid stage '%s' in --stage-order. Must be 'dc', 'shift', 'filter' or 'resample'.", entry);
+            return false;
+        }
+        if (stage <= last_stage) {
+            log_fatal("Invalid --stage-order '%s'. The DC block, shift and filter always run in that order, each at most once.", order_str);
+            return false;
+        }
+        last_stage = stage;
+        out_requests[stage] = seen_resample ? STAGE_PLACEMENT_POST_RESAMPLE : STAGE_PLACEMENT_PRE_RESAMPLE;
+    }
+
+    if (!seen_resample) {
+        log_fatal("Option --stage-order must include 'resample'.");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Narrows the band of interest to what the filter chain passes, in output coordinates.
+ */
+static void _find_band_of_interest(const AppConfig* config, PlanContext* ctx) {
+    ctx->band_known = false;
+    ctx->band_low_hz = -INFINITY;
+    ctx->band_high_hz = INFINITY;
+
+    for (int i = 0; i < config->num_filter_requests; i++) {
+        const FilterRequest* req = &config->filter_requests[i];
+        double low, high;
+        switch (req->type) {
+            case FILTER_TYPE_LOWPASS:
+                low = -fabs(req->freq1_hz);
+                high = fabs(req->freq1_hz);
+                break;
+            case FILTER_TYPE_PASSBAND:
+                low = req->freq1_hz - req->freq2_hz / 2.0;
+                high = req->freq1_hz + req->freq2_hz / 2.0;
+                break;
+            default:
+                continue; // High-pass and stop-band stages keep the rest of the spectrum.
+        }
+        ctx->band_known = true;
+        if (low > ctx->band_low_hz) ctx->band_low_hz = low;
+        if (high < ctx->band_high_hz) ctx->band_high_hz = high;
+    }
+}
+
+/**
+ * @brief Checks that a plan gives the same result as running every stage before the resampler.
+ */
+static bool _is_plan_legal(const AppConfig* config, const PlanContext* ctx, int before, bool merged) {
+    for (int k = 0; k < PLAN_STAGE_COUNT; k++) {
+        if (!ctx->active[k]) continue;
+        bool is_post = (before <= k);
+        if (is_post && ctx->all_pre_required) return false;
+        if (is_post && config->stage_placement_request[k] == STAGE_PLACEMENT_PRE_RESAMPLE) return false;
+        if (!is_post && config->stage_placement_request[k] == STAGE_PLACEMENT_POST_RESAMPLE) return false;
+    }
+
+    // The I/Q corrector expects the DC offset to be gone already, and it stays before the resampler.
+    if (ctx->active[PLAN_STAGE_DC_BLOCK] && before <= PLAN_STAGE_DC_BLOCK && config->iq_correction.enable) {
+        return false;
+    }
+
+    // After a late shift, everything the resampler kept wraps around the output band, so
+    // the filter has to limit the band and the resampler has to pass it unshifted. A shift
+    // placed after the resampler on the command line is taken as-is.
+    if (ctx->active[PLAN_STAGE_SHIFT] && before <= PLAN_STAGE_SHIFT &&
+        config->stage_placement_request[PLAN_STAGE_SHIFT] != STAGE_PLACEMENT_POST_RESAMPLE) {
+        double usable_half_bw = fmin(ctx->input_rate, ctx->output_rate) * PLANNER_RESAMPLER_USABLE_BANDWIDTH / 2.0;
+        if (!ctx->band_known ||
+            ctx->band_low_hz - ctx->shift_hz < -usable_half_bw ||
+            ctx->band_high_hz - ctx->shift_hz > usable_half_bw) {
+            return false;
+        }
+    }
+
+    // A merged decimator filters at the resampler, so the shift must already be done.
+    if (merged) {
+        return ctx->active[PLAN_STAGE_FILTER] && ctx->merge_factor > 0 && before == PLAN_STAGE_FILTER;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the CIC front end factor a plan gets: only when no shift or filter runs before the resampler.
+ */
+static unsigned int _plan_cic_factor(const PlanContext* ctx, int before, bool merged) {
+    if (merged) return 0;
+    if (ctx->active[PLAN_STAGE_SHIFT] && before > PLAN_STAGE_SHIFT) return 0;
+    if (ctx->active[PLAN_STAGE_FILTER] && before > PLAN_STAGE_FILTER) return 0;
+    return ctx->cic_factor;
+}
+
+/**
+ * @brief Estimates a plan's real multiply-accumulates per input sample.
+ */
+static double _estimate_plan_cost(const AppConfig* config, const AppResources* resources, const PlanContext* ctx,
+                                  int before, bool merged) {
+    double post_rate_factor = ctx->output_rate / ctx->input_rate;
+    double pre_rate_factor = 1.0; // Rate of the stages before the resampler, relative to the input
+    double cost = 0.0;
+
+    unsigned int cic_factor = _plan_cic_factor(ctx, before, merged);
+    if (cic_factor > 0) {
+        pre_rate_factor = 1.0 / (double)cic_factor;
+        cost += PLANNER_CIC_ADDS_PER_SAMPLE + (PLANNER_CIC_ADDS_PER_SAMPLE + PLANNER_CIC_COMPENSATOR_MACS) * pre_rate_factor;
+    }
+    if (ctx->active[PLAN_STAGE_DC_BLOCK]) {
+        cost += PLANNER_DC_BLOCK_MACS_PER_SAMPLE * (before <= PLAN_STAGE_DC_BLOCK ? post_rate_factor : pre_rate_factor);
+    }
+    if (ctx->active[PLAN_STAGE_SHIFT]) {
+        cost += PLANNER_NCO_MACS_PER_SAMPLE * (before <= PLAN_STAGE_SHIFT ? post_rate_factor : pre_rate_factor);
+    }
+    if (merged) {
+        // The polyphase decimator replaces both the resampler and the separate filter.
+        return cost + filter_estimate_macs_per_sample(config, ctx->input_rate, ctx->merge_factor);
+    }
+    if (ctx->active[PLAN_STAGE_FILTER]) {
+        if (before <= PLAN_STAGE_FILTER) {
+            cost += filter_estimate_macs_per_sample(config, ctx->output_rate, 0) * post_rate_factor;
+        } else {
+            cost += filter_estimate_macs_per_sample(config, ctx->input_rate, 0);
+        }
+    }
+    if (!resources->is_passthrough) {
+        cost += PLANNER_RESAMPLER_MACS_PER_SAMPLE * fmax(ctx->input_rate * pre_rate_factor, ctx->output_rate) / ctx->input_rate;
+    }
+    return cost;
+}
+
+bool stage_planner_plan(const AppConfig* config, AppResources* resources) {
+    StagePlan* plan = &resources->stage_plan;
+    memset(plan, 0, sizeof(*plan));
+    plan->stages_before_resample = PLAN_STAGE_COUNT;
+    resources->merged_decimation_factor = 0;
+
+    if (!freq_shift_resolve(config, resources)) return false;
+
+    PlanContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.input_rate = (double)resources->source_info.samplerate;
+    ctx.output_rate = config->target_rate;
+    ctx.shift_hz = resources->actual_nco_shift_hz;
+    ctx.active[PLAN_STAGE_DC_BLOCK] = config->dc_block.enable;
+    ctx.active[PLAN_STAGE_SHIFT] = (fabs(ctx.shift_hz) > 1e-9);
+    ctx.active[PLAN_STAGE_FILTER] = (config->num_filter_requests > 0);
+    ctx.all_pre_required = (config->num_channels > 0 || config->num_extra_outputs > 0);
+    _find_band_of_interest(config, &ctx);
+
+    for (int k = 0; k < PLAN_STAGE_COUNT; k++) {
+        if (config->stage_placement_request[k] != STAGE_PLACEMENT_AUTO) plan->forced = true;
+    }
+
+    if (config->raw_passthrough) {
+        // No DSP stage runs at all.
+        return true;
+    }
+    ctx.cic_factor = cic_decimator_plan_factor(config, resources);
+
+    if (ctx.active[PLAN_STAGE_FILTER]) {
+        // Wherever the filter runs, its band has to survive to the output, up or down.
+        float max_filter_freq_hz = 0.0f;
+        for (int i = 0; i < config->num_filter_requests; i++) {
+            const FilterRequest* req = &config->filter_requests[i];
+            float current_max = 0.0f;
+            switch (req->type) {
+                case FILTER_TYPE_LOWPASS:
+                case FILTER_TYPE_HIGHPASS:
+                    current_max = fabsf(req->freq1_hz);
+                    break;
+                case FILTER_TYPE_PASSBAND:
+                case FILTER_TYPE_STOPBAND:
+                    current_max = fabsf(req->freq1_hz) + (req->freq2_hz / 2.0f);
+                    break;
+                default:
+                    break;
+            }
+            if (current_max > max_filter_freq_hz) {
+                max_filter_freq_hz = current_max;
+            }
+        }
+
+        double output_nyquist = ctx.output_rate / 2.0;
+        if (max_filter_freq_hz > output_nyquist) {
+            log_fatal("Filter configuration is incompatible with the output sample rate.");
+            log_error("The specified filter chain extends to %.0f Hz, but the output rate of %.0f Hz can only support frequencies up to %.0f Hz.",
+                      max_filter_freq_hz, ctx.output_rate, output_nyquist);
+            return false;
+        }
+    }
+
+    if (ctx.active[PLAN_STAGE_FILTER] && ctx.output_rate < ctx.input_rate) {
+        // For integer decimation, the user filter can be folded into the anti-alias prototype
+        // of a single polyphase decimator, which only computes the samples it keeps. An
+        // explicit request for the FFT filter method is honored by keeping the separate stages.
+        double ratio = ctx.input_rate / ctx.output_rate;
+        double factor = round(ratio);
+        bool fft_forced = (config->filter_type_str_arg != NULL && config->filter_type_request == FILTER_TYPE_FFT);
+        if (!fft_forced && !resources->is_passthrough && fabs(ratio - factor) < 1e-9 &&
+            factor >= 2.0 && factor <= (double)MERGED_DECIMATOR_MAX_FACTOR) {
+            ctx.merge_factor = (unsigned int)factor;
+        }
+    }
+
+    // Plans are tried from "everything before the resampler" down, so ties keep stages early.
+    bool found = false;
+    for (int before = PLAN_STAGE_COUNT; before >= 0; before--) {
+        for (int m = 0; m <= 1; m++) {
+            bool merged = (m == 1);
+            if (!_is_plan_legal(config, &ctx, before, merged)) continue;
+            double cost = _estimate_plan_cost(config, resources, &ctx, before, merged);
+            log_debug("Stage plan candidate: %d stage(s) before resampling%s, ~%.1f MACs/sample.",
+                      before, merged ? " (merged decimator)" : "", cost);
+            if (!found || cost < plan->estimated_macs_per_sample) {
+                found = true;
+                plan->stages_before_resample = before;
+                plan->filter_merged = merged;
+                plan->estimated_macs_per_sample = cost;
+            }
+        }
+    }
+
+    if (!found) {
+        if (ctx.all_pre_required) {
+            log_fatal("With --channels or additional outputs, every stage must run before resampling.");
+        } else if (config->iq_correction.enable && config->stage_placement_request[PLAN_STAGE_DC_BLOCK] == STAGE_PLACEMENT_POST_RESAMPLE) {
+            log_fatal("The DC block cannot run after resampling when --iq-correction is enabled.");
+        } else {
+            log_fatal("The requested --stage-order cannot be applied to this configuration.");
+        }
+        return false;
+    }
+
+    plan->shift_post_resample = ctx.active[PLAN_STAGE_SHIFT] && stage_plan_is_post_resample(plan, PLAN_STAGE_SHIFT);
+    plan->filter_post_resample = ctx.active[PLAN_STAGE_FILTER] && stage_plan_is_post_resample(plan, PLAN_STAGE_FILTER);
+    if (plan->filter_merged) {
+        resources->merged_decimation_factor = ctx.merge_factor;
+        log_debug("Filter will be merged into a polyphase decimator with factor %u.", resources->merged_decimation_factor);
+    }
+
+    char description[128];
+    stage_planner_describe(config, resources, description, sizeof(description));
+    log_debug("Stage plan: %s (~%.1f MACs/sample%s).", description, plan->estimated_macs_per_sample, plan->forced ? ", forced" : "");
+    return true;
+}
+
+void stage_planner_describe(const AppConfig* config, const AppResources* resources, char* buffer, size_t buffer_size) {
+    const StagePlan* plan = &resources->stage_plan;
+    bool active[PLAN_STAGE_COUNT] = {
+        config->dc_block.enable,
+        fabs(resources->actual_nco_shift_hz) > 1e-9,
+        config->num_filter_requests > 0
+    };
+
+    buffer[0] = '\0';
+    for (int k = 0; k <= PLAN_STAGE_COUNT; k++) {
+        const char* name = NULL;
+        if (k == plan->stages_before_resample) {
+            name = plan->filter_merged ? "Resample+Filter (Merged)" : "Resample";
+        }
+        if (name) {
+            if (buffer[0] != '\0') strncat(buffer, " -> ", buffer_size - strlen(buffer) - 1);
+            strncat(buffer, name, buffer_size - strlen(buffer) - 1);
+        }
+        if (k == PLAN_STAGE_COUNT || !active[k]) continue;
+        if (k == PLAN_STAGE_FILTER && plan->filter_merged) continue;
+        if (buffer[0] != '\0') strncat(buffer, " -> ", buffer_size - strlen(buffer) - 1);
+        strncat(buffer, stage_display_names[k], buffer_size - strlen(buffer) - 1);
+    }
+}
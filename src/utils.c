@@ -19,6 +19,7 @@
 #else
 #include <libgen.h>
 #include <strings.h>
+#include <unistd.h>
 #endif
 
 // --- The Single Source of Truth for Sample Formats ---
@@ -44,6 +45,7 @@ static const SampleFormatInfo format_table[] = {
     { CS32,    "cs32",    "cs32 (Signed 32-bit Complex)" },
     { CF32,    "cf32",    "cf32 (32-bit Float Complex)" },
     { SC16Q11, "sc16q11", "sc16q11 (16-bit Signed Complex Q4.11)" },
+    { CS12,    "cs12",    "cs12 (12-bit Signed Complex, packed)" },
 };
 static const int num_formats = sizeof(format_table) / sizeof(format_table[0]);
 
@@ -235,3 +237,14 @@ bool utils_check_file_exists(const char* full_path) {
     }
     return false;
 }
+
+unsigned int utils_get_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO sys_info;
+    GetSystemInfo(&sys_info);
+    return (sys_info.dwNumberOfProcessors > 0) ? (unsigned int)sys_info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (unsigned int)count : 1;
+#endif
+}
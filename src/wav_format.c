@@ -0,0 +1,215 @@
+// wav_format.c
+
+#include "wav_format.h"
+#include <string.h>
+#include <limits.h>
+
+#define WAV_DS64_CHUNK_BYTES 28     // riffSize, dataSize, sampleCount (64-bit each), tableLength
+#define WAV_FMT_CHUNK_BYTES 16      // WAVE_FORMAT_PCM
+#define WAV_AUXI_CHUNK_BYTES 164    // Two SYSTEMTIMEs, nine DWORDs, 96-byte next file name
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+static unsigned char* _put_tag(unsigned char* p, const char* tag) {
+    memcpy(p, tag, 4);
+    return p + 4;
+}
+
+static unsigned char* _put_le16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)(v >> 8);
+    return p + 2;
+}
+
+static unsigned char* _put_le32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+    return p + 4;
+}
+
+static unsigned char* _put_le64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (unsigned char)(v >> (8 * i));
+    return p + 8;
+}
+
+/**
+ * @brief Writes a Windows SYSTEMTIME (UTC) for an auxi chunk. Zeros if the time is unknown.
+ */
+static unsigned char* _put_systemtime(unsigned char* p, bool present, time_t t) {
+    struct tm tm_utc;
+    bool valid = false;
+    if (present) {
+#ifdef _WIN32
+        valid = (gmtime_s(&tm_utc, &t) == 0);
+#else
+        valid = (gmtime_r(&t, &tm_utc) != NULL);
+#endif
+    }
+    if (!valid) {
+        memset(p, 0, 16);
+        return p + 16;
+    }
+    p = _put_le16(p, (uint16_t)(tm_utc.tm_year + 1900));
+    p = _put_le16(p, (uint16_t)(tm_utc.tm_mon + 1));
+    p = _put_le16(p, (uint16_t)tm_utc.tm_wday);
+    p = _put_le16(p, (uint16_t)tm_utc.tm_mday);
+    p = _put_le16(p, (uint16_t)tm_utc.tm_hour);
+    p = _put_le16(p, (uint16_t)tm_utc.tm_min);
+    p = _put_le16(p, (uint16_t)tm_utc.tm_sec);
+    return _put_le16(p, 0);
+}
+
+size_t wav_header_size(const WavHeaderInfo* info) {
+    size_t size = 12 + (8 + WAV_DS64_CHUNK_BYTES) + (8 + WAV_FMT_CHUNK_BYTES) + 8;
+    if (info->has_auxi) size += 8 + WAV_AUXI_CHUNK_BYTES;
+    return size;
+}
+
+size_t wav_header_build(const WavHeaderInfo* info, long long data_bytes, unsigned char* out, bool* out_is_rf64) {
+    const uint16_t channels = 2;
+    const uint16_t block_align = (uint16_t)(channels * (info->bits_per_sample / 8));
+    size_t header_bytes = wav_header_size(info);
+    uint64_t data_size = (data_bytes > 0) ? (uint64_t)data_bytes : 0;
+    uint64_t riff_size = (uint64_t)header_bytes - 8 + data_size + (data_size & 1);
+    bool rf64 = info->rf64 || riff_size > UINT32_MAX;
+
+    memset(out, 0, header_bytes);
+    unsigned char* p = out;
+
+    p = _put_tag(p, rf64 ? "RF64" : "RIFF");
+    p = _put_le32(p, rf64 ? UINT32_MAX : (uint32_t)riff_size);
+    p = _put_tag(p, "WAVE");
+
+    // ds64 holds the real sizes of an RF64 file. In a plain WAV file the same
+    // space is a JUNK chunk, reserved so the file can still become RF64.
+    p = _put_tag(p, rf64 ? "ds64" : "JUNK");
+    p = _put_le32(p, WAV_DS64_CHUNK_BYTES);
+    if (rf64) {
+        p = _put_le64(p, riff_size);
+        p = _put_le64(p, data_size);
+        p = _put_le64(p, data_size / block_align);
+        p = _put_le32(p, 0); // No table entries
+    } else {
+        p += WAV_DS64_CHUNK_BYTES;
+    }
+
+    p = _put_tag(p, "fmt ");
+    p = _put_le32(p, WAV_FMT_CHUNK_BYTES);
+    p = _put_le16(p, WAV_FORMAT_TAG_PCM);
+    p = _put_le16(p, channels);
+    p = _put_le32(p, info->sample_rate);
+    p = _put_le32(p, info->sample_rate * block_align);
+    p = _put_le16(p, block_align);
+    p = _put_le16(p, info->bits_per_sample);
+
+    if (info->has_auxi) {
+        // The stop time follows from the start time and the amount of data written.
+        time_t stop_time = info->start_time;
+        if (info->sample_rate > 0) {
+            stop_time += (time_t)(data_size / block_align / info->sample_rate);
+        }
+        double center = info->center_freq_hz;
+        uint32_t center_hz = (center > 0.0 && center < (double)UINT32_MAX) ? (uint32_t)(center + 0.5) : 0;
+
+        p = _put_tag(p, "auxi");
+        p = _put_le32(p, WAV_AUXI_CHUNK_BYTES);
+        unsigned char* auxi = p;
+        p = _put_systemtime(p, info->start_time_present, info->start_time);
+        p = _put_systemtime(p, info->start_time_present, stop_time);
+        p = _put_le32(p, center_hz);            // CenterFreq
+        p = _put_le32(p, info->sample_rate);    // ADFrequency
+        p = _put_le32(p, 0);                    // IFFrequency
+        p = _put_le32(p, info->sample_rate);    // Bandwidth
+        p = _put_le32(p, 0);                    // IQOffset
+        p = auxi + WAV_AUXI_CHUNK_BYTES;        // Unused fields and next file name stay zero
+    }
+
+    p = _put_tag(p, "data");
+    p = _put_le32(p, rf64 ? UINT32_MAX : (uint32_t)data_size);
+
+    if (out_is_rf64) *out_is_rf64 = rf64;
+    return (size_t)(p - out);
+}
+
+static uint16_t _get_le16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t _get_le32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t _get_le64(const unsigned char* p) {
+    return (uint64_t)_get_le32(p) | ((uint64_t)_get_le32(p + 4) << 32);
+}
+
+static bool _parse_fmt_chunk(WavFileLayout* layout, const unsigned char* p, uint32_t size) {
+    if (size < WAV_FMT_CHUNK_BYTES) return false;
+    layout->format_tag = _get_le16(p);
+    layout->channels = _get_le16(p + 2);
+    layout->sample_rate = _get_le32(p + 4);
+    layout->block_align = _get_le16(p + 12);
+    layout->bits_per_sample = _get_le16(p + 14);
+    // WAVE_FORMAT_EXTENSIBLE keeps the real format tag at the start of its subformat GUID.
+    if (layout->format_tag == WAV_FORMAT_EXTENSIBLE && size >= 40) {
+        layout->format_tag = _get_le16(p + 24);
+    }
+    layout->fmt_found = true;
+    return true;
+}
+
+bool wav_scan_chunks(WavFileLayout* layout, const unsigned char* region, size_t region_bytes, long long region_offset) {
+    long long pos = layout->next_chunk_offset;
+    if (pos == 0) {
+        if (region_offset != 0 || region_bytes < 12 || memcmp(region + 8, "WAVE", 4) != 0) return false;
+        if (memcmp(region, "RF64", 4) == 0) {
+            layout->rf64 = true;
+        } else if (memcmp(region, "RIFF", 4) != 0) {
+            return false;
+        }
+        pos = 12;
+    }
+
+    const long long region_end = region_offset + (long long)region_bytes;
+    while (pos >= region_offset && pos + 8 <= region_end && pos + 8 <= layout->file_size) {
+        const unsigned char* chunk = region + (pos - region_offset);
+        uint32_t size = _get_le32(chunk + 4);
+        long long body = pos + 8;
+        // Small chunks are only parsed if their contents are in the region.
+        bool body_in_region = (body + (long long)size <= region_end);
+        bool header_chunk = (memcmp(chunk, "fmt ", 4) == 0 || memcmp(chunk, "ds64", 4) == 0);
+        if (header_chunk && !body_in_region) {
+            // Stop here so the caller reads again from this chunk, unless it already started the region.
+            if (pos == region_offset) return false;
+            break;
+        }
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (!_parse_fmt_chunk(layout, chunk + 8, size)) return false;
+        } else if (memcmp(chunk, "ds64", 4) == 0) {
+            if (size < 24) return false;
+            layout->ds64_data_size = _get_le64(chunk + 16);
+        } else if (memcmp(chunk, "auxi", 4) == 0) {
+            layout->auxi_offset = body;
+            layout->auxi_length = size;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            long long length = (long long)size;
+            if (layout->rf64 && size == UINT32_MAX) {
+                length = (layout->ds64_data_size <= (uint64_t)LLONG_MAX) ? (long long)layout->ds64_data_size : LLONG_MAX;
+            } else if (size == 0 || size == UINT32_MAX) {
+                // Left unfinalized by a recorder that was interrupted: the data runs to the end of the file.
+                length = LLONG_MAX;
+            }
+            if (length > layout->file_size - body) {
+                layout->data_length_clamped = (length != LLONG_MAX);
+                length = layout->file_size - body;
+            }
+            layout->data_offset = body;
+            layout->data_length = length;
+            pos = body + length + (length & 1);
+            continue;
+        }
+        // Chunks are padded to an even length.
+        pos = body + (long long)size + (size & 1);
+    }
+    layout->next_chunk_offset = pos;
+    return true;
+}
@@ -0,0 +1,205 @@
+// test_batch.c: Batch input collection, output naming, and the output files a run owns.
+
+#include "test_common.h"
+#include "batch.h"
+#include "setup.h"
+#include "log.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define test_mkdir(path) _mkdir(path)
+#else
+#define test_mkdir(path) mkdir(path, 0755)
+#endif
+
+static AppConfig config;
+static char work_dir[MAX_PATH_BUFFER];
+
+static void _work_path(const char* name, char* buf, size_t buf_size) {
+    int written = snprintf(buf, buf_size, "%s/%s", work_dir, name);
+    CHECK(written > 0 && (size_t)written < buf_size);
+}
+
+static bool _exists(const char* name) {
+    char path[MAX_PATH_BUFFER];
+    _work_path(name, path, sizeof(path));
+    FILE* fp = fopen(path, "rb");
+    if (fp) fclose(fp);
+    return fp != NULL;
+}
+
+static void _touch(const char* name) {
+    char path[MAX_PATH_BUFFER];
+    _work_path(name, path, sizeof(path));
+    CHECK(test_write_file(path, "x", 1));
+}
+
+static void _remove(const char* name) {
+    char path[MAX_PATH_BUFFER];
+    _work_path(name, path, sizeof(path));
+    remove(path);
+}
+
+static void _check_expansion(const char* template_str, const char* input_path, int index, int count, const char* expected) {
+    char out[MAX_PATH_BUFFER];
+    bool ok = batch_expand_output_template(template_str, input_path, index, count, out, sizeof(out));
+    CHECK(ok);
+    CHECK(ok && strcmp(out, expected) == 0);
+    if (ok && strcmp(out, expected) != 0) {
+        fprintf(stderr, "  '%s' with '%s' gave '%s', expected '%s'\n", template_str, input_path, out, expected);
+    }
+}
+
+static void test_template_expansion(void) {
+    _check_expansion("{name}.wav", "/data/rec/capture_01.cs16", 0, 3, "capture_01.wav");
+    _check_expansion("out/{index}_{name}.cs8", "capture.cs16", 0, 5, "out/0001_capture.cs8");
+    _check_expansion("{index}", "x", 41, 12345, "00042");
+    _check_expansion("{name}-{name}", "a.b.c", 0, 1, "a.b-a.b");
+    _check_expansion("{name}.wav", "dir.x/file", 0, 1, "file.wav");
+    _check_expansion("{name}.wav", "/data/.hidden", 0, 1, ".hidden.wav");
+    _check_expansion("{other}/{name", "f.raw", 0, 1, "{other}/{name");
+    _check_expansion("fixed.wav", "f.raw", 2, 3, "fixed.wav");
+
+    // The output buffer must hold the whole path and its terminator.
+    char out[8];
+    CHECK(batch_expand_output_template("{name}.x", "abcde.raw", 0, 1, out, sizeof(out)));
+    CHECK(strcmp(out, "abcde.x") == 0);
+    CHECK(!batch_expand_output_template("{name}.xy", "abcde.raw", 0, 1, out, sizeof(out)));
+    CHECK(!batch_expand_output_template("{index}", "f", 0, 1, out, 4));
+}
+
+static void test_collect_inputs(void) {
+    MemoryArena arena;
+    CHECK(mem_arena_init(&arena, 1024 * 1024));
+
+    _touch("b.cs16");
+    _touch("a.cs16");
+    _touch("c.txt");
+    char pattern[MAX_PATH_BUFFER];
+    _work_path("*.cs16", pattern, sizeof(pattern));
+    char list_path[MAX_PATH_BUFFER];
+    _work_path("inputs.txt", list_path, sizeof(list_path));
+    static const char list[] = "# recordings\n\nlisted_1.cs16\r\nlisted_2.cs16\n";
+    CHECK(test_write_file(list_path, list, sizeof(list) - 1));
+
+    // Literal paths, then each pattern's sorted matches, then the list, in that order.
+    memset(&config, 0, sizeof(config));
+    config.batch_list_arg = list_path;
+    const char* args[] = { "literal.cs16", pattern };
+    bool ok = batch_collect_inputs(&config, 2, args, &arena);
+    CHECK(ok);
+    CHECK(config.batch_mode);
+    CHECK_EQ(config.num_batch_inputs, 5);
+    if (ok && config.num_batch_inputs == 5) {
+        char expected[MAX_PATH_BUFFER];
+        CHECK(strcmp(config.batch_inputs[0], "literal.cs16") == 0);
+        CHECK(strcmp(config.input_filename_arg, "literal.cs16") == 0);
+#ifndef _WIN32
+        _work_path("a.cs16", expected, sizeof(expected));
+        CHECK(strcmp(config.batch_inputs[1], expected) == 0);
+        _work_path("b.cs16", expected, sizeof(expected));
+        CHECK(strcmp(config.batch_inputs[2], expected) == 0);
+#endif
+        CHECK(strcmp(config.batch_inputs[3], "listed_1.cs16") == 0);
+        CHECK(strcmp(config.batch_inputs[4], "listed_2.cs16") == 0);
+    }
+
+    // A pattern that matches nothing, a missing list and no inputs at all are errors.
+    char no_match[MAX_PATH_BUFFER];
+    _work_path("*.none", no_match, sizeof(no_match));
+    const char* no_match_args[] = { no_match };
+    memset(&config, 0, sizeof(config));
+    CHECK(!batch_collect_inputs(&config, 1, no_match_args, &arena));
+
+    memset(&config, 0, sizeof(config));
+    _work_path("missing_list.txt", list_path, sizeof(list_path));
+    config.batch_list_arg = list_path;
+    CHECK(!batch_collect_inputs(&config, 0, NULL, &arena));
+
+    memset(&config, 0, sizeof(config));
+    CHECK(!batch_collect_inputs(&config, 0, NULL, &arena));
+
+    _remove("a.cs16");
+    _remove("b.cs16");
+    _remove("c.txt");
+    _remove("inputs.txt");
+    mem_arena_destroy(&arena);
+}
+
+static void test_existing_outputs(void) {
+    char output[MAX_PATH_BUFFER];
+    char extra[MAX_PATH_BUFFER];
+    char found[MAX_PATH_BUFFER];
+    char expected[MAX_PATH_BUFFER];
+    _work_path("out.wav", output, sizeof(output));
+    _work_path("extra.cs8", extra, sizeof(extra));
+
+    // Plain output.
+    memset(&config, 0, sizeof(config));
+    config.output_filename_arg = output;
+    CHECK(!pipeline_find_existing_output(&config, found, sizeof(found)));
+    _touch("out.wav");
+    CHECK(pipeline_find_existing_output(&config, found, sizeof(found)));
+    CHECK(strcmp(found, output) == 0);
+    pipeline_remove_outputs(&config);
+    CHECK(!_exists("out.wav"));
+
+    // Segments are numbered from 1; the base name itself is never written.
+    config.segment_size_mb_arg = 100.0f;
+    _touch("out.wav");
+    CHECK(!pipeline_find_existing_output(&config, NULL, 0));
+    _touch("out_0001.wav");
+    _touch("out_0002.wav");
+    CHECK(pipeline_find_existing_output(&config, found, sizeof(found)));
+    _work_path("out_0001.wav", expected, sizeof(expected));
+    CHECK(strcmp(found, expected) == 0);
+    pipeline_remove_outputs(&config);
+    CHECK(!_exists("out_0001.wav"));
+    CHECK(!_exists("out_0002.wav"));
+    CHECK(_exists("out.wav"));
+    _remove("out.wav");
+
+    // Channels, each segmented, and an additional output.
+    config.num_channels = 2;
+    config.extra_outputs[0].filename_arg = extra;
+    config.num_extra_outputs = 1;
+    _touch("out_ch2_0001.wav");
+    CHECK(pipeline_find_existing_output(&config, found, sizeof(found)));
+    _work_path("out_ch2_0001.wav", expected, sizeof(expected));
+    CHECK(strcmp(found, expected) == 0);
+    _touch("out_ch1_0001.wav");
+    _touch("extra_0001.cs8");
+    _touch("extra_0002.cs8");
+    pipeline_remove_outputs(&config);
+    CHECK(!_exists("out_ch1_0001.wav"));
+    CHECK(!_exists("out_ch2_0001.wav"));
+    CHECK(!_exists("extra_0001.cs8"));
+    CHECK(!_exists("extra_0002.cs8"));
+
+    // Without segments, and with the main output on stdout, only the additional output is a file.
+    config.segment_size_mb_arg = 0.0f;
+    config.num_channels = 0;
+    config.output_to_stdout = true;
+    _touch("out.wav");
+    CHECK(!pipeline_find_existing_output(&config, NULL, 0));
+    _touch("extra.cs8");
+    CHECK(pipeline_find_existing_output(&config, found, sizeof(found)));
+    CHECK(strcmp(found, extra) == 0);
+    pipeline_remove_outputs(&config);
+    CHECK(!_exists("extra.cs8"));
+    CHECK(_exists("out.wav"));
+    _remove("out.wav");
+}
+
+int main(void) {
+    log_set_quiet(true);
+    test_temp_path("batch_work", work_dir, sizeof(work_dir));
+    test_mkdir(work_dir);
+    test_template_expansion();
+    test_collect_inputs();
+    test_existing_outputs();
+    return test_result("test_batch");
+}
@@ -0,0 +1,244 @@
+// test_checkpoint.c: Checkpoint alignment, configuration hash, save/resume, and NCO advance.
+
+#include "test_common.h"
+#include "checkpoint.h"
+#include "constants.h"
+#include "frequency_shift.h"
+#include "input_range.h"
+#include "log.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static AppConfig config;
+static AppResources resources;
+static char input_path[MAX_PATH_BUFFER];
+static char output_path[MAX_PATH_BUFFER];
+static long long fake_bytes_written;
+
+static long long _fake_total_bytes_written(const FileWriterContext* ctx) {
+    (void)ctx;
+    return fake_bytes_written;
+}
+
+static bool _fake_sync(FileWriterContext* ctx) {
+    (void)ctx;
+    return true;
+}
+
+static void _reset(double input_rate, double output_rate) {
+    memset(&config, 0, sizeof(config));
+    memset(&resources, 0, sizeof(resources));
+    config.checkpoint = true;
+    config.target_rate = output_rate;
+    config.gain = 1.0f;
+    config.effective_input_filename = input_path;
+    config.effective_output_filename = output_path;
+    resources.config = &config;
+    resources.source_info.samplerate = (int)input_rate;
+    resources.source_info.frames = 100000000;
+    resources.input_format = CS16;
+    resources.output_bytes_per_sample_pair = 4;
+    resources.writer_ctx.ops.get_total_bytes_written = _fake_total_bytes_written;
+    resources.writer_ctx.ops.sync = _fake_sync;
+}
+
+static uint64_t _prepared_hash(void) {
+    CHECK(checkpoint_init(&config, &resources));
+    CHECK(checkpoint_prepare(&config, &resources));
+    return resources.checkpoint.config_hash;
+}
+
+static void test_alignment(void) {
+    // 2.048 MHz to 48 kHz: every 128 input frames give exactly 3 output frames.
+    _reset(2048000.0, 48000.0);
+    _prepared_hash();
+    CHECK(resources.checkpoint.aligned);
+    CHECK_EQ(resources.checkpoint.align_input_frames, 128);
+    CHECK_EQ(resources.checkpoint.align_output_frames, 3);
+
+    // Decimators widen the period so they restart in phase too.
+    _reset(2048000.0, 48000.0);
+    resources.cic.decimation_factor = 10;
+    _prepared_hash();
+    CHECK_EQ(resources.checkpoint.align_input_frames, 640);
+    CHECK_EQ(resources.checkpoint.align_output_frames, 15);
+
+    _reset(2048000.0, 48000.0);
+    resources.merged_decimation_factor = 7;
+    _prepared_hash();
+    CHECK_EQ(resources.checkpoint.align_input_frames, 896);
+    CHECK_EQ(resources.checkpoint.align_output_frames, 21);
+
+    // The period is at least CHECKPOINT_ALIGN_MIN_FRAMES.
+    _reset(96000.0, 48000.0);
+    _prepared_hash();
+    CHECK_EQ(resources.checkpoint.align_input_frames, 64);
+    CHECK_EQ(resources.checkpoint.align_output_frames, 32);
+
+    // Without a short common period, positions are rounded instead.
+    _reset(2048000.0, 48000.5);
+    _prepared_hash();
+    CHECK(!resources.checkpoint.aligned);
+
+    _reset(1000003.0, 48000.0);
+    _prepared_hash();
+    CHECK(!resources.checkpoint.aligned);
+}
+
+static void test_config_hash(void) {
+    static const char first_input[] = "first version of the input";
+    CHECK(test_write_file(input_path, first_input, sizeof(first_input)));
+
+    _reset(2048000.0, 48000.0);
+    uint64_t base = _prepared_hash();
+    CHECK_EQ(_prepared_hash(), base);
+
+    _reset(2048000.0, 48000.0);
+    config.target_rate = 24000.0;
+    CHECK(_prepared_hash() != base);
+
+    _reset(2048000.0, 48000.0);
+    config.gain = 2.0f;
+    CHECK(_prepared_hash() != base);
+
+    _reset(2048000.0, 48000.0);
+    resources.actual_nco_shift_hz = 1000.0;
+    CHECK(_prepared_hash() != base);
+
+    _reset(2048000.0, 48000.0);
+    resources.stage_plan.filter_post_resample = true;
+    CHECK(_prepared_hash() != base);
+
+    // A different or modified input file changes the hash, whatever the options.
+    static const char second_input[] = "second, longer version of the input";
+    CHECK(test_write_file(input_path, second_input, sizeof(second_input)));
+    _reset(2048000.0, 48000.0);
+    CHECK(_prepared_hash() != base);
+
+    remove(input_path);
+    _reset(2048000.0, 48000.0);
+    CHECK(_prepared_hash() != base);
+}
+
+static void test_save_and_resume(void) {
+    static const char input[] = "input";
+    CHECK(test_write_file(input_path, input, sizeof(input)));
+    char checkpoint_path[MAX_PATH_BUFFER + 8];
+    snprintf(checkpoint_path, sizeof(checkpoint_path), "%s%s", output_path, CHECKPOINT_FILE_SUFFIX);
+    remove(checkpoint_path);
+
+    // The first run stops with 3001 frames written; the checkpoint falls on the last grid point.
+    _reset(2048000.0, 48000.0);
+    CHECK(input_range_resolve(&config, &resources));
+    _prepared_hash();
+    fake_bytes_written = 3001 * 4;
+    resources.error_occurred = true;
+    checkpoint_on_writer_exit(&resources);
+    CHECK(resources.checkpoint.saved);
+    FILE* fp = fopen(checkpoint_path, "r");
+    CHECK(fp != NULL);
+    if (fp) fclose(fp);
+
+    // The resumed run continues from there, with the warm-up rounded up onto the grid.
+    _reset(2048000.0, 48000.0);
+    config.resume = true;
+    CHECK(checkpoint_init(&config, &resources));
+    CHECK(resources.checkpoint.resuming);
+    CHECK_EQ(resources.checkpoint.resume_input_frame, 128000);
+    CHECK_EQ(resources.checkpoint.resume_output_frames, 3000);
+    CHECK_EQ(resources.checkpoint.resume_output_bytes, 12000);
+    CHECK(input_range_resolve(&config, &resources));
+    CHECK_EQ(resources.input_range_start_frame, 128000);
+    resources.input_warmup_frames = 1000;
+    CHECK(checkpoint_prepare(&config, &resources));
+    CHECK_EQ(resources.input_warmup_frames, 1024);
+    CHECK_EQ(resources.checkpoint.run_first_frame, 128000 - 1024);
+    CHECK_EQ(resources.checkpoint.run_warmup_output_frames, 24);
+
+    // Other options do not match the checkpoint.
+    _reset(2048000.0, 48000.0);
+    config.resume = true;
+    config.gain = 0.5f;
+    CHECK(checkpoint_init(&config, &resources));
+    CHECK(input_range_resolve(&config, &resources));
+    CHECK(!checkpoint_prepare(&config, &resources));
+
+    // A completed run removes the checkpoint.
+    _reset(2048000.0, 48000.0);
+    CHECK(checkpoint_init(&config, &resources));
+    resources.end_of_stream_reached = true;
+    checkpoint_finish(&resources);
+    fp = fopen(checkpoint_path, "r");
+    CHECK(fp == NULL);
+    if (fp) fclose(fp);
+
+    // Nothing to resume from.
+    _reset(2048000.0, 48000.0);
+    config.resume = true;
+    CHECK(!checkpoint_init(&config, &resources));
+    remove(input_path);
+}
+
+/**
+ * @brief Returns the difference between two phases, wrapped to [-pi, pi].
+ */
+static double _phase_difference(double a, double b) {
+    return remainder(a - b, 2.0 * M_PI);
+}
+
+static void _check_advance_matches_stepping(double shift_hz, double rate, unsigned long long num_frames, double tolerance) {
+    _reset(rate, rate);
+    config.freq_shift_requested = true;
+    config.freq_shift_hz = shift_hz;
+    CHECK(freq_shift_create_ncos(&config, &resources));
+    nco_crcf stepped = resources.pre_resample_nco;
+    resources.pre_resample_nco = NULL;
+    CHECK(freq_shift_create_ncos(&config, &resources));
+    nco_crcf advanced = resources.pre_resample_nco;
+    CHECK(stepped != NULL && advanced != NULL);
+    if (!stepped || !advanced) return;
+
+    for (unsigned long long i = 0; i < num_frames; i++) {
+        nco_crcf_step(stepped);
+    }
+    freq_shift_advance_nco(advanced, shift_hz, rate, num_frames);
+    double difference = _phase_difference(nco_crcf_get_phase(stepped), nco_crcf_get_phase(advanced));
+    CHECK(fabs(difference) <= tolerance);
+    if (fabs(difference) > tolerance) {
+        fprintf(stderr, "  shift %.3f Hz at %.0f Hz after %llu frames: phases differ by %g rad\n",
+                shift_hz, rate, num_frames, difference);
+    }
+
+    nco_crcf_destroy(stepped);
+    freq_shift_destroy_ncos(&resources);
+}
+
+static void test_nco_advance_matches_stepping(void) {
+    const double shifts[] = { 100000.0, -37500.5, 1234.567, -3.0 };
+    const double rates[] = { 2048000.0, 48000.0 };
+    for (size_t s = 0; s < sizeof(shifts) / sizeof(shifts[0]); s++) {
+        for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            _check_advance_matches_stepping(shifts[s], rates[r], 0, 1e-6);
+            _check_advance_matches_stepping(shifts[s], rates[r], 1, 1e-5);
+            _check_advance_matches_stepping(shifts[s], rates[r], 777, 1e-4);
+            // Long enough for the accumulator to wrap many times.
+            _check_advance_matches_stepping(shifts[s], rates[r], 100000, 1e-3);
+        }
+    }
+}
+
+int main(void) {
+    log_set_quiet(true);
+    test_temp_path("checkpoint_input.bin", input_path, sizeof(input_path));
+    test_temp_path("checkpoint_output.cs16", output_path, sizeof(output_path));
+    test_alignment();
+    test_config_hash();
+    test_save_and_resume();
+    test_nco_advance_matches_stepping();
+    return test_result("test_checkpoint");
+}
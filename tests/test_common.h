@@ -0,0 +1,58 @@
+// test_common.h
+
+#ifndef TEST_COMMON_H_
+#define TEST_COMMON_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief Number of failed checks so far. A test's main() returns test_result().
+ */
+extern int g_test_failures;
+
+/**
+ * @def CHECK
+ * @brief Records a failure, with the location and the condition, if `cond` is false.
+ */
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_test_failures++; \
+        } \
+    } while (0)
+
+/**
+ * @def CHECK_EQ
+ * @brief Like CHECK(actual == expected), but also prints both values as integers.
+ */
+#define CHECK_EQ(actual, expected) \
+    do { \
+        long long actual_ = (long long)(actual); \
+        long long expected_ = (long long)(expected); \
+        if (actual_ != expected_) { \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", \
+                    __FILE__, __LINE__, #actual, #expected, actual_, expected_); \
+            g_test_failures++; \
+        } \
+    } while (0)
+
+/**
+ * @brief Builds the path of a scratch file in the test build directory.
+ */
+void test_temp_path(const char* name, char* buf, size_t buf_size);
+
+/**
+ * @brief Writes `size` bytes to a new file, replacing any existing one.
+ * @return false if the file could not be written.
+ */
+bool test_write_file(const char* path, const void* data, size_t size);
+
+/**
+ * @brief Prints a summary line and returns the exit status for main().
+ */
+int test_result(const char* test_name);
+
+#endif // TEST_COMMON_H_
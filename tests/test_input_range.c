@@ -0,0 +1,188 @@
+// test_input_range.c: --start/--duration parsing and range resolution.
+
+#include "test_common.h"
+#include "input_range.h"
+#include "log.h"
+#include <string.h>
+
+static AppConfig config;
+static AppResources resources;
+
+static void _reset(int sample_rate, int64_t frames) {
+    memset(&config, 0, sizeof(config));
+    memset(&resources, 0, sizeof(resources));
+    resources.source_info.samplerate = sample_rate;
+    resources.source_info.frames = frames;
+}
+
+static void _check_seconds(const char* str, double expected) {
+    InputTimeSpec spec;
+    bool ok = input_range_parse_time(str, &spec);
+    CHECK(ok);
+    if (!ok) {
+        fprintf(stderr, "  input was '%s'\n", str);
+        return;
+    }
+    CHECK(spec.provided);
+    CHECK(!spec.in_samples);
+    CHECK(spec.seconds == expected);
+}
+
+static void _check_rejected(const char* str) {
+    InputTimeSpec spec;
+    bool ok = input_range_parse_time(str, &spec);
+    CHECK(!ok);
+    if (ok) fprintf(stderr, "  input was '%s'\n", str);
+}
+
+static void test_parse_seconds_and_clock_time(void) {
+    _check_seconds("90", 90.0);
+    _check_seconds("90.5", 90.5);
+    _check_seconds("90s", 90.0);
+    _check_seconds("90.25S", 90.25);
+    _check_seconds("0", 0.0);
+    _check_seconds("1:30", 90.0);
+    _check_seconds("1:02:03.5", 3723.5);
+    _check_seconds("100:00", 6000.0);
+    _check_seconds("0:00:59.75s", 59.75);
+}
+
+static void test_parse_sample_counts(void) {
+    InputTimeSpec spec;
+    CHECK(input_range_parse_time("4800000smp", &spec));
+    CHECK(spec.provided);
+    CHECK(spec.in_samples);
+    CHECK_EQ(spec.samples, 4800000);
+
+    CHECK(input_range_parse_time("12samples", &spec));
+    CHECK(spec.in_samples);
+    CHECK_EQ(spec.samples, 12);
+}
+
+static void test_parse_rejects_malformed_values(void) {
+    _check_rejected("");
+    _check_rejected("abc");
+    _check_rejected("-5");
+    _check_rejected("1.5smp");
+    _check_rejected("1:60");
+    _check_rejected("1:-1");
+    _check_rejected("1.5:30");
+    _check_rejected("1:2:3:4");
+    _check_rejected("10ms");
+    _check_rejected("10 s");
+    _check_rejected("inf");
+    _check_rejected("nan");
+
+    InputTimeSpec spec;
+    CHECK(!input_range_parse_time(NULL, &spec));
+    CHECK(!spec.provided);
+}
+
+static void test_resolve_whole_file(void) {
+    _reset(48000, 480000);
+    CHECK(input_range_resolve(&config, &resources));
+    CHECK_EQ(resources.input_range_start_frame, 0);
+    CHECK_EQ(resources.source_info.frames, 480000);
+}
+
+static void test_resolve_start_and_duration(void) {
+    _reset(48000, 480000);
+    CHECK(input_range_parse_time("2.5", &config.range_start));
+    CHECK(input_range_parse_time("0:03", &config.range_duration));
+    CHECK(input_range_resolve(&config, &resources));
+    CHECK_EQ(resources.input_range_start_frame, 120000);
+    CHECK_EQ(resources.source_info.frames, 144000);
+
+    // Sample counts are taken as-is.
+    _reset(48000, 480000);
+    CHECK(input_range_parse_time("1000smp", &config.range_start));
+    CHECK(input_range_parse_time("10smp", &config.range_duration));
+    CHECK(input_range_resolve(&config, &resources));
+    CHECK_EQ(resources.input_range_start_frame, 1000);
+    CHECK_EQ(resources.source_info.frames, 10);
+}
+
+static void test_resolve_limits(void) {
+    // A duration past the end keeps what remains.
+    _reset(48000, 480000);
+    CHECK(input_range_parse_time("8", &config.range_start));
+    CHECK(input_range_parse_time("1:00", &config.range_duration));
+    CHECK(input_range_resolve(&config, &resources));
+    CHECK_EQ(resources.input_range_start_frame, 384000);
+    CHECK_EQ(resources.source_info.frames, 96000);
+
+    // A start at or past the end is an error.
+    _reset(48000, 480000);
+    CHECK(input_range_parse_time("10", &config.range_start));
+    CHECK(!input_range_resolve(&config, &resources));
+}
+
+static void test_resolve_resumed_run(void) {
+    // --resume continues from the checkpoint up to the same end.
+    _reset(48000, 480000);
+    CHECK(input_range_parse_time("1", &config.range_start));
+    CHECK(input_range_parse_time("5", &config.range_duration));
+    resources.checkpoint.resuming = true;
+    resources.checkpoint.resume_input_frame = 100000;
+    CHECK(input_range_resolve(&config, &resources));
+    CHECK_EQ(resources.input_range_start_frame, 100000);
+    CHECK_EQ(resources.source_info.frames, 48000 + 240000 - 100000);
+
+    // Nothing is left when the checkpoint is at the end.
+    _reset(48000, 480000);
+    CHECK(input_range_parse_time("1", &config.range_start));
+    CHECK(input_range_parse_time("5", &config.range_duration));
+    resources.checkpoint.resuming = true;
+    resources.checkpoint.resume_input_frame = 288000;
+    CHECK(!input_range_resolve(&config, &resources));
+}
+
+static void test_warmup(void) {
+    // The warm-up is limited to the input before the range.
+    _reset(48000, 480000);
+    config.target_rate = 48000.0;
+    resources.input_range_start_frame = 10;
+    resources.user_filter_num_taps = 1001;
+    input_range_plan_warmup(&config, &resources);
+    CHECK_EQ(resources.input_warmup_frames, 10);
+
+    resources.input_range_start_frame = 100000;
+    input_range_plan_warmup(&config, &resources);
+    CHECK(resources.input_warmup_frames >= 1001);
+    CHECK(resources.input_warmup_frames < 100000);
+
+    // Output running at a quarter of the input rate drops a quarter as many frames.
+    resources.input_warmup_frames = 4000;
+    CHECK_EQ(input_range_warmup_output_frames(&resources, 12000.0), 1000);
+
+    // Nothing is read ahead from the start of the file.
+    resources.input_range_start_frame = 0;
+    input_range_plan_warmup(&config, &resources);
+    CHECK_EQ(resources.input_warmup_frames, 0);
+    CHECK_EQ(input_range_warmup_output_frames(&resources, 12000.0), 0);
+}
+
+static void test_count_frames(void) {
+    // Warm-up frames read ahead of the range are not counted, however the reads split them.
+    _reset(48000, 480000);
+    resources.input_warmup_frames_uncounted = 250;
+    CHECK_EQ(input_range_count_frames(&resources, 100), 0);
+    CHECK_EQ(input_range_count_frames(&resources, 100), 0);
+    CHECK_EQ(input_range_count_frames(&resources, 100), 50);
+    CHECK_EQ(input_range_count_frames(&resources, 100), 100);
+    CHECK_EQ(resources.input_warmup_frames_uncounted, 0);
+}
+
+int main(void) {
+    log_set_quiet(true);
+    test_parse_seconds_and_clock_time();
+    test_parse_sample_counts();
+    test_parse_rejects_malformed_values();
+    test_resolve_whole_file();
+    test_resolve_start_and_duration();
+    test_resolve_limits();
+    test_resolve_resumed_run();
+    test_warmup();
+    test_count_frames();
+    return test_result("test_input_range");
+}
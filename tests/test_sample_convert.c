@@ -0,0 +1,149 @@
+// test_sample_convert.c: Packed 12-bit (cs12) conversion.
+//
+// Whole buffers go through the vectorized loop where the build has one;
+// single frames always take the scalar tail. Both must agree bit for bit.
+
+#include "test_common.h"
+#include "sample_convert.h"
+#include <math.h>
+#include <string.h>
+
+#define NUM_FRAMES 203
+
+/**
+ * @brief The 12-bit code a normalized value packs to: scaled by 2047, clipped, rounded half away from zero.
+ */
+static unsigned int _expected_code(float value) {
+    float scaled = value * 2047.0f;
+    if (scaled > 2047.0f) scaled = 2047.0f;
+    else if (scaled < -2048.0f) scaled = -2048.0f;
+    return (unsigned int)lroundf(scaled) & 0xFFFu;
+}
+
+static unsigned int _unpacked_i(const uint8_t* p) {
+    return (unsigned int)p[0] | ((unsigned int)(p[1] & 0x0F) << 8);
+}
+
+static unsigned int _unpacked_q(const uint8_t* p) {
+    return (unsigned int)(p[1] >> 4) | ((unsigned int)p[2] << 4);
+}
+
+static void test_pack_matches_scalar(void) {
+    complex_float_t in[NUM_FRAMES];
+    size_t num_halves = 0;
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        float re = sinf(0.37f * (float)i) * 1.2f;
+        float im = cosf(0.11f * (float)i) * 0.9f;
+        // Every few frames, a value that scales to exactly k + 0.5, of either sign.
+        float half = ((float)(i * 13 % 2047) + 0.5f) / 2047.0f;
+        if (i % 3 == 0 && half * 2047.0f == (float)(i * 13 % 2047) + 0.5f) {
+            re = (i % 2) ? -half : half;
+            num_halves++;
+        }
+        in[i] = re + I * im;
+    }
+    CHECK(num_halves > 10);
+
+    uint8_t bulk[NUM_FRAMES * 3 + 16];
+    uint8_t single[NUM_FRAMES * 3 + 16];
+    memset(bulk, 0xAA, sizeof(bulk));
+    memset(single, 0x55, sizeof(single));
+    CHECK(convert_cf32_to_block(in, bulk, NUM_FRAMES, CS12));
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        CHECK(convert_cf32_to_block(&in[i], single + i * 3, 1, CS12));
+    }
+    CHECK(memcmp(bulk, single, NUM_FRAMES * 3) == 0);
+
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        CHECK_EQ(_unpacked_i(bulk + i * 3), _expected_code(crealf(in[i])));
+        CHECK_EQ(_unpacked_q(bulk + i * 3), _expected_code(cimagf(in[i])));
+    }
+}
+
+static void test_pack_rounds_half_away_from_zero(void) {
+    // 0.5 and 1.5 LSB, of both signs, in every lane of a vector block.
+    const float lsb = 1.0f / 2047.0f;
+    complex_float_t in[8];
+    for (int i = 0; i < 8; i++) {
+        float magnitude = (i < 4) ? 0.5f * lsb : 1.5f * lsb;
+        in[i] = ((i % 2) ? -magnitude : magnitude) + I * ((i % 2) ? magnitude : -magnitude);
+    }
+    uint8_t out[8 * 3 + 16];
+    CHECK(convert_cf32_to_block(in, out, 8, CS12));
+    for (int i = 0; i < 8; i++) {
+        // Only where the scaled value is exactly a half does the rounding direction show.
+        float scaled = fabsf(crealf(in[i])) * 2047.0f;
+        if (scaled != 0.5f && scaled != 1.5f) continue;
+        unsigned int magnitude_code = (scaled == 0.5f) ? 1u : 2u;
+        unsigned int positive = magnitude_code;
+        unsigned int negative = (0x1000u - magnitude_code) & 0xFFFu;
+        CHECK_EQ(_unpacked_i(out + i * 3), (i % 2) ? negative : positive);
+        CHECK_EQ(_unpacked_q(out + i * 3), (i % 2) ? positive : negative);
+    }
+}
+
+static void test_pack_clips(void) {
+    complex_float_t in[8];
+    for (int i = 0; i < 8; i++) {
+        in[i] = ((i % 2) ? -1.5f : 1.5f) + I * ((i % 2) ? 3.0f : -3.0f);
+    }
+    uint8_t out[8 * 3 + 16];
+    CHECK(convert_cf32_to_block(in, out, 8, CS12));
+    for (int i = 0; i < 8; i++) {
+        CHECK_EQ(_unpacked_i(out + i * 3), (i % 2) ? 0x800u : 0x7FFu);
+        CHECK_EQ(_unpacked_q(out + i * 3), (i % 2) ? 0x7FFu : 0x800u);
+    }
+}
+
+static void test_unpack_every_code(void) {
+    // Each 12-bit code appears once as I and once as Q.
+    static uint8_t packed[4096 * 3 + 16];
+    for (unsigned int code = 0; code < 4096; code++) {
+        unsigned int q = (code * 7 + 3) & 0xFFFu;
+        uint8_t* p = packed + code * 3;
+        p[0] = (uint8_t)(code & 0xFF);
+        p[1] = (uint8_t)((code >> 8) | ((q & 0x0F) << 4));
+        p[2] = (uint8_t)(q >> 4);
+    }
+
+    static complex_float_t bulk[4096];
+    CHECK(convert_raw_to_cf32(packed, bulk, 4096, CS12, 1.0f));
+    for (unsigned int code = 0; code < 4096; code++) {
+        complex_float_t single;
+        CHECK(convert_raw_to_cf32(packed + code * 3, &single, 1, CS12, 1.0f));
+        CHECK(memcmp(&single, &bulk[code], sizeof(single)) == 0);
+
+        unsigned int q = (code * 7 + 3) & 0xFFFu;
+        int i_val = (code >= 0x800u) ? (int)code - 0x1000 : (int)code;
+        int q_val = (q >= 0x800u) ? (int)q - 0x1000 : (int)q;
+        CHECK(crealf(bulk[code]) == (float)i_val / 2048.0f);
+        CHECK(cimagf(bulk[code]) == (float)q_val / 2048.0f);
+    }
+}
+
+static void test_round_trip(void) {
+    // Codes survive unpack then pack, apart from the 2047/2048 scale difference at the extremes.
+    uint8_t packed[64 * 3 + 16];
+    for (unsigned int i = 0; i < 64; i++) {
+        unsigned int code_i = (i * 61) & 0xFFFu;
+        unsigned int code_q = (0x1000u - i * 37) & 0xFFFu;
+        packed[i * 3] = (uint8_t)(code_i & 0xFF);
+        packed[i * 3 + 1] = (uint8_t)((code_i >> 8) | ((code_q & 0x0F) << 4));
+        packed[i * 3 + 2] = (uint8_t)(code_q >> 4);
+    }
+    complex_float_t samples[64];
+    CHECK(convert_raw_to_cf32(packed, samples, 64, CS12, 2048.0f / 2047.0f));
+    uint8_t repacked[64 * 3 + 16];
+    CHECK(convert_cf32_to_block(samples, repacked, 64, CS12));
+    CHECK(memcmp(packed, repacked, 64 * 3) == 0);
+}
+
+int main(void) {
+    CHECK_EQ(get_bytes_per_sample(CS12), 3);
+    test_pack_matches_scalar();
+    test_pack_rounds_half_away_from_zero();
+    test_pack_clips();
+    test_unpack_every_code();
+    test_round_trip();
+    return test_result("test_sample_convert");
+}
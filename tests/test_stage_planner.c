@@ -0,0 +1,192 @@
+// test_stage_planner.c: Placement of the resampler among the DC block, shift and filter.
+
+#include "test_common.h"
+#include "stage_planner.h"
+#include "constants.h"
+#include "log.h"
+#include <math.h>
+#include <string.h>
+
+static AppConfig config;
+static AppResources resources;
+
+static void _reset(double input_rate, double output_rate, format_t input_format) {
+    memset(&config, 0, sizeof(config));
+    memset(&resources, 0, sizeof(resources));
+    config.target_rate = output_rate;
+    resources.source_info.samplerate = (int)input_rate;
+    resources.input_format = input_format;
+}
+
+static void _add_filter(FilterType type, float freq1_hz, float freq2_hz) {
+    FilterRequest* req = &config.filter_requests[config.num_filter_requests++];
+    req->type = type;
+    req->freq1_hz = freq1_hz;
+    req->freq2_hz = freq2_hz;
+}
+
+static void _set_shift(double shift_hz) {
+    config.freq_shift_requested = true;
+    config.freq_shift_hz = shift_hz;
+}
+
+static void test_parse_order(void) {
+    StagePlacement requests[PLAN_STAGE_COUNT];
+    CHECK(stage_planner_parse_order("dc,resample,shift,filter", requests));
+    CHECK_EQ(requests[PLAN_STAGE_DC_BLOCK], STAGE_PLACEMENT_PRE_RESAMPLE);
+    CHECK_EQ(requests[PLAN_STAGE_SHIFT], STAGE_PLACEMENT_POST_RESAMPLE);
+    CHECK_EQ(requests[PLAN_STAGE_FILTER], STAGE_PLACEMENT_POST_RESAMPLE);
+
+    // Stages left out stay with the planner.
+    CHECK(stage_planner_parse_order("Shift,RESAMPLE", requests));
+    CHECK_EQ(requests[PLAN_STAGE_DC_BLOCK], STAGE_PLACEMENT_AUTO);
+    CHECK_EQ(requests[PLAN_STAGE_SHIFT], STAGE_PLACEMENT_PRE_RESAMPLE);
+    CHECK_EQ(requests[PLAN_STAGE_FILTER], STAGE_PLACEMENT_AUTO);
+
+    CHECK(!stage_planner_parse_order("dc,shift", requests));
+    CHECK(!stage_planner_parse_order("shift,dc,resample", requests));
+    CHECK(!stage_planner_parse_order("dc,resample,dc", requests));
+    CHECK(!stage_planner_parse_order("resample,resample", requests));
+    CHECK(!stage_planner_parse_order("dc,resample,fft", requests));
+}
+
+static void test_channels_keep_every_stage_early(void) {
+    _reset(2048000.0, 48000.0, CS16);
+    config.dc_block.enable = true;
+    _set_shift(100000.0);
+    _add_filter(FILTER_TYPE_LOWPASS, 10000.0f, 0.0f);
+    config.num_channels = 2;
+    CHECK(stage_planner_plan(&config, &resources));
+    CHECK_EQ(resources.stage_plan.stages_before_resample, PLAN_STAGE_COUNT);
+    CHECK(!resources.stage_plan.shift_post_resample);
+    CHECK(!resources.stage_plan.filter_post_resample);
+    CHECK_EQ(resources.merged_decimation_factor, 0);
+
+    // Nothing can be forced after the resampler then.
+    config.stage_placement_request[PLAN_STAGE_FILTER] = STAGE_PLACEMENT_POST_RESAMPLE;
+    CHECK(!stage_planner_plan(&config, &resources));
+}
+
+static void test_filter_moves_after_resampler(void) {
+    // Decimating by a non-integer ratio: the filter is cheaper at the output rate, while a
+    // shift that moves the band out of the resampler's passband has to stay early.
+    _reset(2048000.0, 48000.0, CS16);
+    _set_shift(100000.0);
+    _add_filter(FILTER_TYPE_LOWPASS, 10000.0f, 0.0f);
+    CHECK(stage_planner_plan(&config, &resources));
+    CHECK_EQ(resources.stage_plan.stages_before_resample, PLAN_STAGE_FILTER);
+    CHECK(!resources.stage_plan.shift_post_resample);
+    CHECK(resources.stage_plan.filter_post_resample);
+    CHECK(!resources.stage_plan.forced);
+    CHECK(resources.actual_nco_shift_hz == 100000.0);
+}
+
+static void test_forced_placement(void) {
+    _reset(2048000.0, 48000.0, CS16);
+    _set_shift(1000.0);
+    config.stage_placement_request[PLAN_STAGE_SHIFT] = STAGE_PLACEMENT_POST_RESAMPLE;
+    CHECK(stage_planner_plan(&config, &resources));
+    CHECK(resources.stage_plan.forced);
+    CHECK(resources.stage_plan.shift_post_resample);
+    CHECK(!resources.stage_plan.filter_post_resample);
+
+    // The I/Q corrector needs the DC block ahead of it, before the resampler.
+    _reset(2048000.0, 48000.0, CS16);
+    config.dc_block.enable = true;
+    config.iq_correction.enable = true;
+    config.stage_placement_request[PLAN_STAGE_DC_BLOCK] = STAGE_PLACEMENT_POST_RESAMPLE;
+    CHECK(!stage_planner_plan(&config, &resources));
+}
+
+static void test_filter_band_against_output_nyquist(void) {
+    // Decimating.
+    _reset(2048000.0, 48000.0, CS16);
+    _add_filter(FILTER_TYPE_LOWPASS, 30000.0f, 0.0f);
+    CHECK(!stage_planner_plan(&config, &resources));
+
+    // Interpolating: the band still has to fit below the output Nyquist.
+    _reset(48000.0, 96000.0, CS16);
+    _add_filter(FILTER_TYPE_LOWPASS, 60000.0f, 0.0f);
+    CHECK(!stage_planner_plan(&config, &resources));
+
+    _reset(48000.0, 96000.0, CS16);
+    _add_filter(FILTER_TYPE_PASSBAND, 40000.0f, 20000.0f);
+    CHECK(!stage_planner_plan(&config, &resources));
+
+    _reset(48000.0, 96000.0, CS16);
+    _add_filter(FILTER_TYPE_LOWPASS, 20000.0f, 0.0f);
+    CHECK(stage_planner_plan(&config, &resources));
+}
+
+static void test_cic_front_end_is_costed(void) {
+    // Integer samples decimated far enough get the CIC front end, which makes the resampler cheaper.
+    _reset(2048000.0, 48000.0, CS16);
+    CHECK(stage_planner_plan(&config, &resources));
+    double with_cic = resources.stage_plan.estimated_macs_per_sample;
+    CHECK(with_cic < PLANNER_RESAMPLER_MACS_PER_SAMPLE);
+
+    // Float input has no CIC front end: the resampler runs at the full input rate.
+    _reset(2048000.0, 48000.0, CF32);
+    CHECK(stage_planner_plan(&config, &resources));
+    CHECK(fabs(resources.stage_plan.estimated_macs_per_sample - PLANNER_RESAMPLER_MACS_PER_SAMPLE) < 1e-9);
+
+    // A shift before the resampler rules the CIC front end out.
+    _reset(2048000.0, 48000.0, CS16);
+    _set_shift(300000.0);
+    config.stage_placement_request[PLAN_STAGE_SHIFT] = STAGE_PLACEMENT_PRE_RESAMPLE;
+    CHECK(stage_planner_plan(&config, &resources));
+    CHECK(resources.stage_plan.estimated_macs_per_sample > PLANNER_RESAMPLER_MACS_PER_SAMPLE);
+}
+
+/**
+ * @brief Checks that the planner's choice costs no more than any placement that can be forced.
+ */
+static void _check_auto_plan_is_cheapest(void) {
+    StagePlacement saved[PLAN_STAGE_COUNT];
+    memcpy(saved, config.stage_placement_request, sizeof(saved));
+    for (int k = 0; k < PLAN_STAGE_COUNT; k++) config.stage_placement_request[k] = STAGE_PLACEMENT_AUTO;
+    CHECK(stage_planner_plan(&config, &resources));
+    double best = resources.stage_plan.estimated_macs_per_sample;
+
+    // Every combination of auto, early and late for the three stages.
+    for (int combo = 0; combo < 27; combo++) {
+        for (int k = 0, c = combo; k < PLAN_STAGE_COUNT; k++, c /= 3) {
+            config.stage_placement_request[k] = (c % 3 == 0) ? STAGE_PLACEMENT_AUTO
+                                              : (c % 3 == 1) ? STAGE_PLACEMENT_PRE_RESAMPLE : STAGE_PLACEMENT_POST_RESAMPLE;
+        }
+        if (stage_planner_plan(&config, &resources)) {
+            CHECK(resources.stage_plan.estimated_macs_per_sample >= best - 1e-9);
+        }
+    }
+    memcpy(config.stage_placement_request, saved, sizeof(saved));
+}
+
+static void test_auto_plan_is_cheapest(void) {
+    _reset(2048000.0, 48000.0, CS16);
+    config.dc_block.enable = true;
+    _set_shift(5000.0);
+    _add_filter(FILTER_TYPE_LOWPASS, 12000.0f, 0.0f);
+    _check_auto_plan_is_cheapest();
+
+    _reset(480000.0, 48000.0, CS8);
+    _add_filter(FILTER_TYPE_PASSBAND, 3000.0f, 8000.0f);
+    _check_auto_plan_is_cheapest();
+
+    _reset(250000.0, 1000000.0, CF32);
+    config.dc_block.enable = true;
+    _set_shift(-20000.0);
+    _add_filter(FILTER_TYPE_LOWPASS, 40000.0f, 0.0f);
+    _check_auto_plan_is_cheapest();
+}
+
+int main(void) {
+    log_set_quiet(true);
+    test_parse_order();
+    test_channels_keep_every_stage_early();
+    test_filter_moves_after_resampler();
+    test_forced_placement();
+    test_filter_band_against_output_nyquist();
+    test_cic_front_end_is_costed();
+    test_auto_plan_is_cheapest();
+    return test_result("test_stage_planner");
+}
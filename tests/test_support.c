@@ -0,0 +1,32 @@
+// test_support.c
+
+#include "test_common.h"
+#include "types.h"
+#include <pthread.h>
+
+// Defined by main.c in the application.
+pthread_mutex_t g_console_mutex = PTHREAD_MUTEX_INITIALIZER;
+AppConfig g_config;
+
+int g_test_failures = 0;
+
+void test_temp_path(const char* name, char* buf, size_t buf_size) {
+    snprintf(buf, buf_size, "%s/%s", TEST_TMP_DIR, name);
+}
+
+bool test_write_file(const char* path, const void* data, size_t size) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+    bool ok = (size == 0 || fwrite(data, 1, size, fp) == size);
+    if (fclose(fp) != 0) ok = false;
+    return ok;
+}
+
+int test_result(const char* test_name) {
+    if (g_test_failures > 0) {
+        fprintf(stderr, "%s: %d check(s) failed.\n", test_name, g_test_failures);
+        return 1;
+    }
+    printf("%s: all checks passed.\n", test_name);
+    return 0;
+}
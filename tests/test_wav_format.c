@@ -0,0 +1,352 @@
+// test_wav_format.c: WAV/RF64 header building and chunk scanning.
+
+#include "test_common.h"
+#include "wav_format.h"
+#include <string.h>
+
+static uint16_t _le16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t _le32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void _put32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+/**
+ * @brief Appends a chunk with a zeroed body to a hand-built file. Returns the new length.
+ */
+static size_t _add_chunk(unsigned char* file, size_t len, const char* tag, uint32_t size, uint32_t body_bytes) {
+    memcpy(file + len, tag, 4);
+    _put32(file + len + 4, size);
+    memset(file + len + 8, 0, body_bytes);
+    return len + 8 + body_bytes + (body_bytes & 1);
+}
+
+/**
+ * @brief Appends a 16-bit stereo PCM 'fmt ' chunk. Returns the new length.
+ */
+static size_t _add_fmt_chunk(unsigned char* file, size_t len, uint32_t sample_rate) {
+    size_t body = len + 8;
+    len = _add_chunk(file, len, "fmt ", 16, 16);
+    file[body] = WAV_FORMAT_TAG_PCM;
+    file[body + 2] = 2;
+    _put32(file + body + 4, sample_rate);
+    _put32(file + body + 8, sample_rate * 4);
+    file[body + 12] = 4;
+    file[body + 14] = 16;
+    return len;
+}
+
+static size_t _start_riff(unsigned char* file) {
+    memcpy(file, "RIFF", 4);
+    _put32(file + 4, 0);
+    memcpy(file + 8, "WAVE", 4);
+    return 12;
+}
+
+/**
+ * @brief Scans a header built for `data_bytes` of samples, as if it started a file of that size.
+ */
+static bool _scan_header(const unsigned char* header, size_t header_len, long long data_bytes, WavFileLayout* layout) {
+    memset(layout, 0, sizeof(*layout));
+    layout->file_size = (long long)header_len + data_bytes;
+    return wav_scan_chunks(layout, header, header_len, 0);
+}
+
+static void test_plain_wav_round_trip(void) {
+    WavHeaderInfo info;
+    memset(&info, 0, sizeof(info));
+    info.sample_rate = 2048000;
+    info.bits_per_sample = 16;
+
+    unsigned char header[WAV_HEADER_MAX_BYTES];
+    bool is_rf64 = true;
+    size_t empty_len = wav_header_build(&info, 0, header, &is_rf64);
+    CHECK_EQ(empty_len, wav_header_size(&info));
+    CHECK(!is_rf64);
+
+    // The header written at close has the same length as the one written at open.
+    const long long data_bytes = 4000;
+    size_t len = wav_header_build(&info, data_bytes, header, &is_rf64);
+    CHECK_EQ(len, empty_len);
+    CHECK(!is_rf64);
+    CHECK(memcmp(header, "RIFF", 4) == 0);
+    CHECK_EQ(_le32(header + 4), len - 8 + data_bytes);
+    CHECK(memcmp(header + 8, "WAVE", 4) == 0);
+    CHECK(memcmp(header + 12, "JUNK", 4) == 0);
+
+    WavFileLayout layout;
+    CHECK(_scan_header(header, len, data_bytes, &layout));
+    CHECK(layout.fmt_found);
+    CHECK(!layout.rf64);
+    CHECK_EQ(layout.format_tag, WAV_FORMAT_TAG_PCM);
+    CHECK_EQ(layout.channels, 2);
+    CHECK_EQ(layout.sample_rate, 2048000);
+    CHECK_EQ(layout.block_align, 4);
+    CHECK_EQ(layout.bits_per_sample, 16);
+    CHECK_EQ(layout.data_offset, len);
+    CHECK_EQ(layout.data_length, data_bytes);
+    CHECK(!layout.data_length_clamped);
+    CHECK_EQ(layout.auxi_offset, 0);
+}
+
+static void test_odd_data_size_is_padded(void) {
+    WavHeaderInfo info;
+    memset(&info, 0, sizeof(info));
+    info.sample_rate = 48000;
+    info.bits_per_sample = 8;
+
+    unsigned char header[WAV_HEADER_MAX_BYTES];
+    size_t len = wav_header_build(&info, 1001, header, NULL);
+    // The RIFF size counts the pad byte that follows an odd-sized data chunk.
+    CHECK_EQ(_le32(header + 4), len - 8 + 1001 + 1);
+
+    WavFileLayout layout;
+    CHECK(_scan_header(header, len, 1001, &layout));
+    CHECK_EQ(layout.block_align, 2);
+    CHECK_EQ(layout.bits_per_sample, 8);
+    CHECK_EQ(layout.data_length, 1001);
+}
+
+static void test_auxi_chunk(void) {
+    WavHeaderInfo info;
+    memset(&info, 0, sizeof(info));
+    info.sample_rate = 250000;
+    info.bits_per_sample = 16;
+    info.has_auxi = true;
+    info.center_freq_hz = 100123456.4;
+    info.start_time_present = true;
+    info.start_time = 1700000000; // 2023-11-14 22:13:20 UTC
+
+    WavHeaderInfo plain = info;
+    plain.has_auxi = false;
+    CHECK_EQ(wav_header_size(&info), wav_header_size(&plain) + 8 + 164);
+
+    // Ten seconds of data.
+    const long long data_bytes = 10LL * 250000 * 4;
+    unsigned char header[WAV_HEADER_MAX_BYTES];
+    size_t len = wav_header_build(&info, data_bytes, header, NULL);
+    CHECK(len <= WAV_HEADER_MAX_BYTES);
+
+    WavFileLayout layout;
+    CHECK(_scan_header(header, len, data_bytes, &layout));
+    CHECK(layout.auxi_offset > 0);
+    CHECK_EQ(layout.auxi_length, 164);
+    CHECK_EQ(layout.data_offset, len);
+    CHECK_EQ(layout.data_length, data_bytes);
+
+    const unsigned char* auxi = header + layout.auxi_offset;
+    // Start time: year, month, day of week, day, hour, minute, second.
+    CHECK_EQ(_le16(auxi + 0), 2023);
+    CHECK_EQ(_le16(auxi + 2), 11);
+    CHECK_EQ(_le16(auxi + 6), 14);
+    CHECK_EQ(_le16(auxi + 8), 22);
+    CHECK_EQ(_le16(auxi + 10), 13);
+    CHECK_EQ(_le16(auxi + 12), 20);
+    // The stop time is ten seconds later.
+    CHECK_EQ(_le16(auxi + 16 + 12), 30);
+    CHECK_EQ(_le32(auxi + 32), 100123456);
+    CHECK_EQ(_le32(auxi + 36), 250000);
+}
+
+static void test_promotion_to_rf64(void) {
+    WavHeaderInfo info;
+    memset(&info, 0, sizeof(info));
+    info.sample_rate = 20000000;
+    info.bits_per_sample = 16;
+
+    unsigned char header[WAV_HEADER_MAX_BYTES];
+    size_t small_len = wav_header_build(&info, 0, header, NULL);
+
+    // Past 4 GB the same header space becomes RF64 with a ds64 chunk.
+    const long long data_bytes = 5000000000LL;
+    bool is_rf64 = false;
+    size_t len = wav_header_build(&info, data_bytes, header, &is_rf64);
+    CHECK(is_rf64);
+    CHECK_EQ(len, small_len);
+    CHECK(memcmp(header, "RF64", 4) == 0);
+    CHECK_EQ(_le32(header + 4), UINT32_MAX);
+    CHECK(memcmp(header + 12, "ds64", 4) == 0);
+
+    WavFileLayout layout;
+    CHECK(_scan_header(header, len, data_bytes, &layout));
+    CHECK(layout.rf64);
+    CHECK_EQ(layout.ds64_data_size, data_bytes);
+    CHECK_EQ(layout.data_offset, len);
+    CHECK_EQ(layout.data_length, data_bytes);
+}
+
+static void test_forced_rf64(void) {
+    WavHeaderInfo info;
+    memset(&info, 0, sizeof(info));
+    info.sample_rate = 96000;
+    info.bits_per_sample = 16;
+    info.rf64 = true;
+
+    unsigned char header[WAV_HEADER_MAX_BYTES];
+    bool is_rf64 = false;
+    size_t len = wav_header_build(&info, 4096, header, &is_rf64);
+    CHECK(is_rf64);
+
+    WavFileLayout layout;
+    CHECK(_scan_header(header, len, 4096, &layout));
+    CHECK(layout.rf64);
+    CHECK_EQ(layout.data_length, 4096);
+}
+
+static void test_header_chunk_across_regions(void) {
+    // A large LIST chunk pushes 'fmt ' across the end of the first read.
+    static unsigned char file[70000];
+    size_t len = _start_riff(file);
+    len = _add_chunk(file, len, "LIST", 65504, 65504);
+    size_t fmt_pos = len;
+    len = _add_fmt_chunk(file, len, 192000);
+    size_t data_pos = len;
+    len = _add_chunk(file, len, "data", 400, 400);
+
+    WavFileLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.file_size = (long long)len;
+    const size_t first_read = 65536;
+    CHECK(fmt_pos < first_read && fmt_pos + 8 + 16 > first_read);
+
+    // The scan stops at the chunk whose contents were cut off ...
+    CHECK(wav_scan_chunks(&layout, file, first_read, 0));
+    CHECK(!layout.fmt_found);
+    CHECK_EQ(layout.next_chunk_offset, fmt_pos);
+
+    // ... and a read starting there picks it up.
+    long long offset = layout.next_chunk_offset;
+    CHECK(wav_scan_chunks(&layout, file + offset, len - (size_t)offset, offset));
+    CHECK(layout.fmt_found);
+    CHECK_EQ(layout.sample_rate, 192000);
+    CHECK_EQ(layout.data_offset, data_pos + 8);
+    CHECK_EQ(layout.data_length, 400);
+}
+
+static void test_truncated_header_chunk(void) {
+    // A 'fmt ' chunk cut off at the start of the region cannot be read by reading again.
+    unsigned char file[64];
+    size_t len = _start_riff(file);
+    len = _add_fmt_chunk(file, len, 48000);
+
+    WavFileLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.file_size = (long long)len;
+    CHECK(wav_scan_chunks(&layout, file, 12, 0));
+    CHECK_EQ(layout.next_chunk_offset, 12);
+    CHECK(!wav_scan_chunks(&layout, file + 12, 16, 12));
+}
+
+static void test_not_a_wav_file(void) {
+    unsigned char file[64];
+    size_t len = _start_riff(file);
+    len = _add_fmt_chunk(file, len, 48000);
+
+    WavFileLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.file_size = (long long)len;
+    CHECK(!wav_scan_chunks(&layout, file, 8, 0));
+    CHECK(!wav_scan_chunks(&layout, file, len, 4));
+
+    memcpy(file + 8, "AVI ", 4);
+    memset(&layout, 0, sizeof(layout));
+    layout.file_size = (long long)len;
+    CHECK(!wav_scan_chunks(&layout, file, len, 0));
+
+    memcpy(file, "FORM", 4);
+    memcpy(file + 8, "WAVE", 4);
+    memset(&layout, 0, sizeof(layout));
+    layout.file_size = (long long)len;
+    CHECK(!wav_scan_chunks(&layout, file, len, 0));
+}
+
+static void test_unfinalized_and_truncated_data(void) {
+    unsigned char file[256];
+    size_t len = _start_riff(file);
+    len = _add_fmt_chunk(file, len, 48000);
+    size_t data_pos = len;
+
+    // A recorder that never finalized the header leaves a data size of 0: the data runs to the end.
+    size_t unfinalized_len = _add_chunk(file, len, "data", 0, 100);
+    WavFileLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.file_size = (long long)unfinalized_len;
+    CHECK(wav_scan_chunks(&layout, file, unfinalized_len, 0));
+    CHECK_EQ(layout.data_offset, data_pos + 8);
+    CHECK_EQ(layout.data_length, 100);
+    CHECK(!layout.data_length_clamped);
+
+    // A size past the end of the file is clamped to what is there, and flagged.
+    size_t truncated_len = _add_chunk(file, len, "data", 1000, 100);
+    memset(&layout, 0, sizeof(layout));
+    layout.file_size = (long long)truncated_len;
+    CHECK(wav_scan_chunks(&layout, file, truncated_len, 0));
+    CHECK_EQ(layout.data_length, 100);
+    CHECK(layout.data_length_clamped);
+}
+
+static void test_chunk_after_data(void) {
+    // An odd-sized data chunk, its pad byte, then an 'auxi' chunk.
+    unsigned char file[512];
+    size_t len = _start_riff(file);
+    len = _add_fmt_chunk(file, len, 48000);
+    len = _add_chunk(file, len, "data", 101, 101);
+    size_t auxi_pos = len;
+    len = _add_chunk(file, len, "auxi", 164, 164);
+
+    // Only the start of the file has been read; the scan skips the data and stops after it.
+    WavFileLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.file_size = (long long)len;
+    CHECK(wav_scan_chunks(&layout, file, 64, 0));
+    CHECK_EQ(layout.data_length, 101);
+    CHECK_EQ(layout.auxi_offset, 0);
+    CHECK_EQ(layout.next_chunk_offset, auxi_pos);
+
+    long long offset = layout.next_chunk_offset;
+    CHECK(wav_scan_chunks(&layout, file + offset, len - (size_t)offset, offset));
+    CHECK_EQ(layout.auxi_offset, auxi_pos + 8);
+    CHECK_EQ(layout.auxi_length, 164);
+}
+
+static void test_extensible_format(void) {
+    unsigned char file[128];
+    size_t len = _start_riff(file);
+    size_t body = len + 8;
+    len = _add_chunk(file, len, "fmt ", 40, 40);
+    file[body] = 0xFE; // WAVE_FORMAT_EXTENSIBLE
+    file[body + 1] = 0xFF;
+    file[body + 2] = 2;
+    _put32(file + body + 4, 96000);
+    file[body + 12] = 4;
+    file[body + 14] = 16;
+    file[body + 24] = WAV_FORMAT_TAG_PCM; // Subformat GUID
+    len = _add_chunk(file, len, "data", 16, 16);
+
+    WavFileLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.file_size = (long long)len;
+    CHECK(wav_scan_chunks(&layout, file, len, 0));
+    CHECK_EQ(layout.format_tag, WAV_FORMAT_TAG_PCM);
+    CHECK_EQ(layout.sample_rate, 96000);
+}
+
+int main(void) {
+    test_plain_wav_round_trip();
+    test_odd_data_size_is_padded();
+    test_auxi_chunk();
+    test_promotion_to_rf64();
+    test_forced_rf64();
+    test_header_chunk_across_regions();
+    test_truncated_header_chunk();
+    test_not_a_wav_file();
+    test_unfinalized_and_truncated_data();
+    test_chunk_after_data();
+    test_extensible_format();
+    return test_result("test_wav_format");
+}